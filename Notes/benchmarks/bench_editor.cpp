@@ -0,0 +1,102 @@
+#include <QImage>
+#include <QScrollBar>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QTextFrame>
+#include <QtTest>
+
+#include "benchmarks.h"
+#include "customtextedit.h"
+#include "noteformatting.h"
+
+// Editor hot paths on a real CustomTextEdit: painting with the ruled/grid
+// background, formatting a large selection and inserting a large table.
+class EditorBench : public QObject {
+    Q_OBJECT
+
+private:
+    static QString paragraphs(int count) {
+        QString text;
+        for (int i = 0; i < count; ++i) {
+            text += QString("Paragraph %1: the teacher said photosynthesis turns light into chemical energy "
+                            "stored in glucose.\n").arg(i);
+        }
+        return text;
+    }
+
+private slots:
+    void paintEvent_data() {
+        QTest::addColumn<int>("style");
+        QTest::addColumn<QSize>("viewport");
+        const QSize sizes[] = { QSize(640, 480), QSize(1280, 800), QSize(2560, 1440) };
+        for (const QSize &size : sizes) {
+            const QByteArray dimensions = QByteArray::number(size.width()) + "x" + QByteArray::number(size.height());
+            QTest::newRow(("plain " + dimensions).constData()) << int(PageBackground::Plain) << size;
+            QTest::newRow(("ruled " + dimensions).constData()) << int(PageBackground::Ruled) << size;
+            QTest::newRow(("grid " + dimensions).constData()) << int(PageBackground::Grid) << size;
+        }
+    }
+    void paintEvent() {
+        QFETCH(int, style);
+        QFETCH(QSize, viewport);
+
+        CustomTextEdit edit;
+        edit.setPlainText(paragraphs(2000));
+        edit.setRuledPage(style == PageBackground::Ruled);
+        if (style == PageBackground::Grid) {
+            edit.setGridPage(true);
+        }
+        edit.resize(viewport);
+        edit.show();
+        QVERIFY(QTest::qWaitForWindowExposed(&edit));
+        // Mid-document, so the lines are offset from the tile grid
+        edit.verticalScrollBar()->setValue(edit.verticalScrollBar()->maximum() / 2 + 7);
+
+        QImage target(edit.viewport()->size(), QImage::Format_ARGB32_Premultiplied);
+        QBENCHMARK {
+            edit.viewport()->render(&target); // Goes through CustomTextEdit::paintEvent()
+        }
+    }
+
+    void applyFormat_data() {
+        QTest::addColumn<int>("paragraphCount");
+        QTest::newRow("100 paragraphs") << 100;
+        QTest::newRow("10k paragraphs") << 10000;
+        QTest::newRow("50k paragraphs") << 50000;
+    }
+    void applyFormat() {
+        QFETCH(int, paragraphCount);
+        CustomTextEdit edit;
+        edit.setPlainText(paragraphs(paragraphCount));
+        edit.resize(800, 600);
+        BenchReport::setBytesProcessed(qint64(edit.document()->characterCount()) * 2);
+
+        // What NotesApp::setBold() does with the whole note selected
+        QTextCursor cursor = edit.textCursor();
+        cursor.select(QTextCursor::Document);
+        edit.setTextCursor(cursor);
+        QBENCHMARK {
+            const QTextCharFormat format = NoteFormatting::toggledBold(edit.currentCharFormat());
+            QTextCursor selection = edit.textCursor();
+            NoteFormatting::applyFormat(selection, format);
+            edit.mergeCurrentCharFormat(format);
+        }
+    }
+
+    void insertTable() {
+        CustomTextEdit edit;
+        edit.resize(800, 600);
+        QBENCHMARK {
+            edit.clear();
+            QTextCursor cursor = edit.textCursor();
+            QVERIFY(NoteFormatting::insertTable(cursor, 100, 100));
+        }
+        QCOMPARE(edit.document()->rootFrame()->childFrames().size(), 1);
+    }
+};
+
+QObject *createEditorBench() {
+    return new EditorBench;
+}
+
+#include "bench_editor.moc"
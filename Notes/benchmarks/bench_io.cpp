@@ -0,0 +1,146 @@
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QtTest>
+
+#include "benchmarks.h"
+#include "noteloader.h"
+#include "notesaver.h"
+#include "pnoteformat.h"
+
+// Open and save throughput along the editor's own paths: NoteLoader chunks
+// inserted the way NotesApp::insertLoadedChunk() does, NoteSaver from a raw
+// text snapshot, and the .pnote equivalents.
+class IOBench : public QObject {
+    Q_OBJECT
+
+private:
+    QTemporaryDir directory;
+
+    static void addSizes() {
+        QTest::addColumn<qint64>("bytes");
+        QTest::newRow("1 KB") << qint64(1024);
+        QTest::newRow("1 MB") << qint64(1024 * 1024);
+        QTest::newRow("10 MB") << qint64(10 * 1024 * 1024);
+        QTest::newRow("100 MB") << qint64(100 * 1024 * 1024);
+    }
+
+    // Transcript-like text of roughly the given size in UTF-8
+    static QString sampleText(qint64 bytes) {
+        const QString line = "The teacher said photosynthesis turns light into chemical energy stored in glucose.\n";
+        QString text;
+        text.reserve(int(bytes));
+        while (text.size() + line.size() <= bytes) {
+            text += line;
+        }
+        text += line.left(int(bytes - text.size()));
+        return text;
+    }
+
+    QString writeSample(qint64 bytes, const char *suffix) {
+        const QString path = directory.filePath(QString("sample-%1.%2").arg(bytes).arg(suffix));
+        if (QFile::exists(path)) {
+            return path;
+        }
+        QTextDocument document;
+        document.setPlainText(sampleText(bytes));
+        QFile file(path);
+        if (file.open(QIODevice::WriteOnly)) {
+            if (qstrcmp(suffix, "pnote") == 0) {
+                PNoteFormat::write(&document, &file);
+            } else {
+                file.write(document.toPlainText().toUtf8());
+            }
+        }
+        return path;
+    }
+
+private slots:
+    void openNote_data() { addSizes(); }
+    void openNote() {
+        QFETCH(qint64, bytes);
+        const QString path = writeSample(bytes, "txt");
+        BenchReport::setBytesProcessed(QFileInfo(path).size());
+
+        QTextDocument document;
+        QBENCHMARK {
+            document.clear();
+            document.setUndoRedoEnabled(false);
+            NoteLoader loader(path);
+            connect(&loader, &NoteLoader::chunkLoaded, this, [&](const QString &text) {
+                QTextCursor cursor(&document);
+                cursor.movePosition(QTextCursor::End);
+                cursor.beginEditBlock();
+                cursor.insertText(text);
+                cursor.endEditBlock();
+                loader.chunkConsumed();
+            });
+            QEventLoop loop;
+            connect(&loader, &NoteLoader::loadFinished, &loop, &QEventLoop::quit);
+            loader.start();
+            loop.exec();
+        }
+        QCOMPARE(qint64(document.characterCount() - 1), bytes);
+    }
+
+    void saveNote_data() { addSizes(); }
+    void saveNote() {
+        QFETCH(qint64, bytes);
+        QTextDocument document;
+        document.setPlainText(sampleText(bytes));
+        const QString path = directory.filePath("saved.txt");
+        BenchReport::setBytesProcessed(bytes);
+
+        QString error;
+        QBENCHMARK {
+            // The snapshot is part of what the GUI thread pays for
+            NoteSaver saver(path, document.toRawText());
+            connect(&saver, &NoteSaver::saveFailed, this, [&error](const QString &message) { error = message; });
+            QEventLoop loop;
+            connect(&saver, &QThread::finished, &loop, &QEventLoop::quit);
+            saver.start();
+            loop.exec();
+        }
+        QVERIFY2(error.isEmpty(), qPrintable(error));
+        QCOMPARE(QFileInfo(path).size(), bytes);
+    }
+
+    void openPNote_data() { addSizes(); }
+    void openPNote() {
+        QFETCH(qint64, bytes);
+        const QString path = writeSample(bytes, "pnote");
+        BenchReport::setBytesProcessed(QFileInfo(path).size());
+
+        QTextDocument document;
+        QBENCHMARK {
+            QVERIFY(PNoteFormat::load(path, &document));
+        }
+        QCOMPARE(qint64(document.characterCount() - 1), bytes);
+    }
+
+    void savePNote_data() { addSizes(); }
+    void savePNote() {
+        QFETCH(qint64, bytes);
+        QTextDocument source;
+        source.setPlainText(sampleText(bytes));
+        const QString path = directory.filePath("saved.pnote");
+
+        QBENCHMARK {
+            NoteSaver saver(path, source.clone());
+            QEventLoop loop;
+            connect(&saver, &QThread::finished, &loop, &QEventLoop::quit);
+            saver.start();
+            loop.exec();
+        }
+        BenchReport::setBytesProcessed(QFileInfo(path).size());
+        QVERIFY(QFileInfo(path).size() > bytes);
+    }
+};
+
+QObject *createIOBench() {
+    return new IOBench;
+}
+
+#include "bench_io.moc"
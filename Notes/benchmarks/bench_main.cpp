@@ -0,0 +1,151 @@
+#include <QApplication>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QScopedPointer>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QXmlStreamReader>
+#include <QtTest>
+
+#include "benchmarks.h"
+
+// Runs every benchmark object with QtTest's XML logger next to the usual
+// text output, then folds the XML into one JSON report:
+//
+//   notes_bench [--json notes_bench.json] [QtTest options...]
+//
+// {"suite": "notes_bench", "qt": ..., "results": [{"benchmark": "IOBench::openNote",
+//  "tag": "1 MB", "metric": "WalltimeMilliseconds", "value": 12.5, "iterations": 1,
+//  "bytes": 1048576, "mbPerSecond": 80.0}, ...], "failures": [...]}
+
+namespace {
+
+QString currentTestCase;
+QHash<QString, qint64> bytesByTest;
+
+QString key(const QString &testCase, const QString &function, const QString &tag) {
+    return testCase + "::" + function + "/" + tag;
+}
+
+// Appends the results and failures of one QtTest XML log
+bool collect(const QString &xmlPath, QJsonArray &results, QJsonArray &failures) {
+    QFile file(xmlPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QXmlStreamReader xml(&file);
+    QString testCase;
+    QString function;
+    while (!xml.atEnd()) {
+        if (xml.readNext() != QXmlStreamReader::StartElement) {
+            continue;
+        }
+        const QXmlStreamAttributes attributes = xml.attributes();
+        if (xml.name() == QLatin1String("TestCase")) {
+            testCase = attributes.value("name").toString();
+        } else if (xml.name() == QLatin1String("TestFunction")) {
+            function = attributes.value("name").toString();
+        } else if (xml.name() == QLatin1String("BenchmarkResult")) {
+            const QString tag = attributes.value("tag").toString();
+            const double value = attributes.value("value").toDouble(); // Per iteration
+            QJsonObject result{
+                { "benchmark", testCase + "::" + function },
+                { "tag", tag },
+                { "metric", attributes.value("metric").toString() },
+                { "value", value },
+                { "iterations", attributes.value("iterations").toInt() },
+            };
+            const qint64 bytes = BenchReport::bytesProcessed(testCase, function, tag);
+            if (bytes > 0) {
+                result.insert("bytes", double(bytes));
+                if (attributes.value("metric") == QLatin1String("WalltimeMilliseconds") && value > 0) {
+                    result.insert("mbPerSecond", (bytes / (1024.0 * 1024.0)) / (value / 1000.0));
+                }
+            }
+            results.append(result);
+        } else if (xml.name() == QLatin1String("Incident")) {
+            const QString type = attributes.value("type").toString();
+            if (type == QLatin1String("fail") || type == QLatin1String("xpass")) {
+                QJsonObject failure{ { "benchmark", testCase + "::" + function } };
+                while (xml.readNextStartElement()) {
+                    if (xml.name() == QLatin1String("DataTag")) {
+                        failure.insert("tag", xml.readElementText());
+                    } else if (xml.name() == QLatin1String("Description")) {
+                        failure.insert("description", xml.readElementText());
+                    } else {
+                        xml.skipCurrentElement();
+                    }
+                }
+                failures.append(failure);
+            }
+        }
+    }
+    return !xml.hasError();
+}
+
+} // namespace
+
+void BenchReport::setBytesProcessed(qint64 bytes) {
+    bytesByTest.insert(key(currentTestCase, QTest::currentTestFunction(), QTest::currentDataTag()), bytes);
+}
+
+qint64 BenchReport::bytesProcessed(const QString &testCase, const QString &function, const QString &tag) {
+    return bytesByTest.value(key(testCase, function, tag));
+}
+
+int main(int argc, char *argv[]) {
+    // Paint benchmarks need widgets, but never a screen
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+
+    QStringList testArguments = { app.arguments().value(0) };
+    QString jsonPath = "notes_bench.json";
+    const QStringList arguments = app.arguments();
+    for (int i = 1; i < arguments.size(); ++i) {
+        if (arguments.at(i) == "--json" && i + 1 < arguments.size()) {
+            jsonPath = arguments.at(++i);
+        } else {
+            testArguments.append(arguments.at(i));
+        }
+    }
+
+    QTemporaryDir logs;
+    QJsonArray results;
+    QJsonArray failures;
+    int failed = 0;
+    QObject *(*const factories[])() = { createIOBench, createEditorBench, createPNoteBench };
+    for (auto factory : factories) {
+        QScopedPointer<QObject> bench(factory());
+        currentTestCase = bench->metaObject()->className();
+        const QString xmlPath = logs.filePath(currentTestCase + ".xml");
+        failed += QTest::qExec(bench.data(), testArguments + QStringList{ "-o", xmlPath + ",xml", "-o", "-,txt" });
+        if (!collect(xmlPath, results, failures)) {
+            failures.append(QJsonObject{ { "benchmark", currentTestCase }, { "description", "No readable QtTest log" } });
+            ++failed;
+        }
+    }
+
+    const QJsonObject report{
+        { "suite", "notes_bench" },
+        { "qt", qVersion() },
+        { "platform", QGuiApplication::platformName() },
+        { "cpu", QSysInfo::currentCpuArchitecture() },
+        { "results", results },
+        { "failures", failures },
+    };
+    QFile json(jsonPath);
+    if (!json.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning().noquote() << "Could not write" << jsonPath << json.errorString();
+        return 1;
+    }
+    json.write(QJsonDocument(report).toJson());
+    qInfo().noquote() << "Wrote" << results.size() << "results to" << QDir::current().absoluteFilePath(jsonPath);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,159 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QTextList>
+#include <QTextTable>
+
+#include <limits>
+
+#include "benchmarks.h"
+#include "pnoteformat.h"
+
+// Building a document from .pnote against setHtml() on the same content
+class PNoteBench : public QObject {
+    Q_OBJECT
+
+private:
+    static void addSizes() {
+        QTest::addColumn<int>("paragraphs");
+        QTest::newRow("1k paragraphs") << 1000;
+        QTest::newRow("10k paragraphs") << 10000;
+    }
+
+    // Lecture-like note: formatted runs, a bullet list every 50 paragraphs
+    // and a 4x4 table every 200
+    static void fillSample(QTextDocument *document, int paragraphs) {
+        QTextCharFormat plain;
+        QTextCharFormat bold;
+        bold.setFontWeight(QFont::Bold);
+        QTextCharFormat italic;
+        italic.setFontItalic(true);
+        italic.setForeground(QColor(0, 90, 160));
+
+        QTextCursor cursor(document);
+        cursor.beginEditBlock();
+        for (int i = 0; i < paragraphs; ++i) {
+            if (i > 0) {
+                cursor.insertBlock();
+            }
+            cursor.insertText(QString("Paragraph %1: the teacher said ").arg(i), plain);
+            cursor.insertText("photosynthesis", bold);
+            cursor.insertText(" turns light into ", plain);
+            cursor.insertText("chemical energy", italic);
+            cursor.insertText(" stored in glucose.", plain);
+
+            if (i % 50 == 49) {
+                cursor.insertList(QTextListFormat::ListDisc);
+                for (int item = 0; item < 5; ++item) {
+                    if (item > 0) {
+                        cursor.insertBlock(); // Stays in the list
+                    }
+                    cursor.insertText(QString("Point %1").arg(item), item % 2 ? bold : plain);
+                }
+                cursor.insertBlock(QTextBlockFormat());
+            }
+            if (i % 200 == 199) {
+                QTextTableFormat tableFormat;
+                tableFormat.setBorder(1);
+                QTextTable *table = cursor.insertTable(4, 4, tableFormat);
+                for (int cell = 0; cell < 16; ++cell) {
+                    QTextCursor cellCursor = table->cellAt(cell / 4, cell % 4).firstCursorPosition();
+                    cellCursor.insertText(QString::number(cell * i), cell % 3 ? plain : bold);
+                }
+                cursor.setPosition(table->lastPosition() + 1);
+            }
+        }
+        cursor.endEditBlock();
+    }
+
+private slots:
+    void readPNote_data() { addSizes(); }
+    void readPNote() {
+        QFETCH(int, paragraphs);
+        QTextDocument source;
+        fillSample(&source, paragraphs);
+        const QByteArray bytes = PNoteFormat::serialize(&source);
+
+        QTextDocument document;
+        QBENCHMARK {
+            PNoteFormat::read(reinterpret_cast<const uchar *>(bytes.constData()), bytes.size(), &document);
+        }
+        QCOMPARE(document.toPlainText(), source.toPlainText());
+        QCOMPARE(document.characterCount(), source.characterCount());
+    }
+
+    void setHtml_data() { addSizes(); }
+    void setHtml() {
+        QFETCH(int, paragraphs);
+        QTextDocument source;
+        fillSample(&source, paragraphs);
+        const QString html = source.toHtml();
+
+        QTextDocument document;
+        QBENCHMARK {
+            document.setHtml(html);
+        }
+    }
+
+    // The point of the format: fails if reading .pnote is not faster than
+    // setHtml() on the same note. Best of a few runs each, to ride out noise.
+    void readPNoteBeatsSetHtml() {
+        QTextDocument source;
+        fillSample(&source, 10000);
+        const QByteArray bytes = PNoteFormat::serialize(&source);
+        const QString html = source.toHtml();
+
+        const int runs = 5;
+        qint64 pnoteBest = std::numeric_limits<qint64>::max();
+        qint64 htmlBest = std::numeric_limits<qint64>::max();
+        for (int i = 0; i < runs; ++i) {
+            QTextDocument pnoteDocument;
+            QElapsedTimer clock;
+            clock.start();
+            QVERIFY(PNoteFormat::read(reinterpret_cast<const uchar *>(bytes.constData()), bytes.size(), &pnoteDocument));
+            pnoteBest = qMin(pnoteBest, clock.nsecsElapsed());
+
+            QTextDocument htmlDocument;
+            clock.restart();
+            htmlDocument.setHtml(html);
+            htmlBest = qMin(htmlBest, clock.nsecsElapsed());
+        }
+        qInfo("pnote %.1f ms, setHtml %.1f ms", pnoteBest / 1e6, htmlBest / 1e6);
+        QVERIFY2(pnoteBest < htmlBest,
+                 qPrintable(QString("reading .pnote took %1 ms, setHtml() %2 ms")
+                                .arg(pnoteBest / 1e6, 0, 'f', 1)
+                                .arg(htmlBest / 1e6, 0, 'f', 1)));
+    }
+
+    void serializePNote_data() { addSizes(); }
+    void serializePNote() {
+        QFETCH(int, paragraphs);
+        QTextDocument source;
+        fillSample(&source, paragraphs);
+
+        QByteArray bytes;
+        QBENCHMARK {
+            bytes = PNoteFormat::serialize(&source);
+        }
+        QVERIFY(!bytes.isEmpty());
+    }
+
+    void toHtml_data() { addSizes(); }
+    void toHtml() {
+        QFETCH(int, paragraphs);
+        QTextDocument source;
+        fillSample(&source, paragraphs);
+
+        QString html;
+        QBENCHMARK {
+            html = source.toHtml();
+        }
+    }
+};
+
+QObject *createPNoteBench() {
+    return new PNoteBench;
+}
+
+#include "bench_pnote.moc"
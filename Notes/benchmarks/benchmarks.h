@@ -0,0 +1,22 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <QObject>
+#include <QString>
+
+// Every benchmark object in notes_bench; bench_main.cpp runs them in turn
+QObject *createIOBench();
+QObject *createEditorBench();
+QObject *createPNoteBench();
+
+// Extra facts for the JSON report that QtTest does not carry
+namespace BenchReport {
+
+// Bytes processed per iteration by the current test function and data row;
+// the report turns them into MB/s
+void setBytesProcessed(qint64 bytes);
+qint64 bytesProcessed(const QString &testCase, const QString &function, const QString &tag);
+
+} // namespace BenchReport
+
+#endif // BENCHMARKS_H
@@ -0,0 +1,247 @@
+#include <QAtomicInt>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QHash>
+#include <QMutex>
+#include <QRunnable>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QTextDocumentFragment>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QVector>
+
+#include "noteio.h"
+#include "pnoteformat.h"
+
+#include <cstdio>
+
+// Batch conversion of notes without a window:
+//
+//   notes-cli convert --to pnote --output-dir out/ notes/...
+//   notes-cli export --to pdf --output-dir out/ notes/...
+//   notes-cli merge --output all.pnote a.pnote b.txt ...
+//
+// Every note is loaded, converted and written on its own pool thread;
+// merge loads its inputs in parallel and appends them in order.
+
+namespace {
+
+struct Input {
+    QString path;
+    QString relativePath; // Below the directory it was found in, if any
+};
+
+// Directories are searched recursively for anything NoteIO can read
+QVector<Input> collectInputs(const QStringList &arguments) {
+    QVector<Input> inputs;
+    const QStringList noteFilters = { "*.txt", "*.pnote", "*.html", "*.htm", "*.md", "*.markdown" };
+    for (const QString &argument : arguments) {
+        const QFileInfo info(argument);
+        if (!info.isDir()) {
+            inputs.append({ argument, info.fileName() });
+            continue;
+        }
+        const QDir root(argument);
+        QDirIterator it(argument, noteFilters, QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            const QString path = it.next();
+            inputs.append({ path, root.relativeFilePath(path) });
+        }
+    }
+    return inputs;
+}
+
+class Errors {
+public:
+    void add(const QString &path, const QString &message) {
+        QMutexLocker locker(&mutex);
+        messages.append(path + ": " + message);
+    }
+    QStringList all() {
+        QMutexLocker locker(&mutex);
+        return messages;
+    }
+
+private:
+    QMutex mutex;
+    QStringList messages;
+};
+
+int convert(const QVector<Input> &inputs, NoteIO::Format format, const QString &outputDir, QThreadPool *pool,
+            QTextStream &out) {
+    // a/x.txt and a/x.md, or the same relative path under two roots, would
+    // end up in one file written by two jobs at once; refuse before any runs
+    QVector<QString> targets;
+    QHash<QString, QString> sources;
+    bool clash = false;
+    for (const Input &input : inputs) {
+        const QFileInfo relative(input.relativePath);
+        const QString target = QDir::cleanPath(QDir(outputDir).filePath(
+            QDir(relative.path()).filePath(relative.completeBaseName() + "." + NoteIO::suffixFor(format))));
+        const auto first = sources.constFind(target);
+        if (first != sources.constEnd()) {
+            out << "error: " << target << ": written by both " << *first << " and " << input.path << "\n";
+            clash = true;
+        } else {
+            sources.insert(target, input.path);
+        }
+        targets.append(target);
+    }
+    if (clash) {
+        return 1;
+    }
+
+    Errors errors;
+    QAtomicInt converted(0);
+    QElapsedTimer clock;
+    clock.start();
+
+    for (int i = 0; i < inputs.size(); ++i) {
+        const Input input = inputs.at(i);
+        const QString target = targets.at(i);
+        pool->start(QRunnable::create([&errors, &converted, input, target, format] {
+            QTextDocument document;
+            QString error;
+            if (!NoteIO::load(input.path, &document, &error)) {
+                errors.add(input.path, error);
+                return;
+            }
+            QDir().mkpath(QFileInfo(target).path());
+            if (!NoteIO::save(&document, target, format, &error)) {
+                errors.add(target, error);
+                return;
+            }
+            converted.fetchAndAddRelaxed(1);
+        }));
+    }
+    pool->waitForDone();
+
+    const QStringList failures = errors.all();
+    for (const QString &failure : failures) {
+        out << "error: " << failure << "\n";
+    }
+    const double seconds = clock.nsecsElapsed() / 1e9;
+    out << QString("Converted %1 of %2 notes in %3 s (%4 notes/s) on %5 threads\n")
+               .arg(converted.loadRelaxed())
+               .arg(inputs.size())
+               .arg(seconds, 0, 'f', 2)
+               .arg(seconds > 0 ? converted.loadRelaxed() / seconds : 0, 0, 'f', 0)
+               .arg(pool->maxThreadCount());
+    return failures.isEmpty() ? 0 : 1;
+}
+
+int merge(const QVector<Input> &inputs, const QString &output, QThreadPool *pool, QTextStream &out) {
+    // Parsing is the expensive part and runs in parallel; each note comes
+    // back as .pnote bytes so that no document crosses threads
+    QVector<QByteArray> parts(inputs.size());
+    Errors errors;
+    QElapsedTimer clock;
+    clock.start();
+    for (int i = 0; i < inputs.size(); ++i) {
+        const QString path = inputs.at(i).path;
+        QByteArray *part = &parts[i];
+        pool->start(QRunnable::create([&errors, path, part] {
+            QTextDocument document;
+            QString error;
+            if (!NoteIO::load(path, &document, &error)) {
+                errors.add(path, error);
+                return;
+            }
+            *part = PNoteFormat::serialize(&document);
+        }));
+    }
+    pool->waitForDone();
+
+    const QStringList failures = errors.all();
+    if (!failures.isEmpty()) {
+        for (const QString &failure : failures) {
+            out << "error: " << failure << "\n";
+        }
+        return 1;
+    }
+
+    QTextDocument merged;
+    QTextCursor cursor(&merged);
+    cursor.beginEditBlock();
+    for (int i = 0; i < parts.size(); ++i) {
+        QTextDocument part;
+        PNoteFormat::read(reinterpret_cast<const uchar *>(parts.at(i).constData()), parts.at(i).size(), &part);
+        if (i > 0) {
+            cursor.insertBlock();
+        }
+        cursor.insertFragment(QTextDocumentFragment(&part));
+    }
+    cursor.endEditBlock();
+
+    QString error;
+    if (!NoteIO::save(&merged, output, NoteIO::formatFor(output), &error)) {
+        out << "error: " << output << ": " << error << "\n";
+        return 1;
+    }
+    out << QString("Merged %1 notes into %2 in %3 s\n")
+               .arg(inputs.size())
+               .arg(output)
+               .arg(clock.nsecsElapsed() / 1e9, 0, 'f', 2);
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    // QTextDocument needs a GUI application for fonts and layout, but never a screen
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+    QGuiApplication::setApplicationName("notes-cli");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Converts, exports and merges notes in parallel.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("command", "convert, export or merge");
+    parser.addPositionalArgument("inputs", "Note files or directories of notes", "inputs...");
+    QCommandLineOption toOption("to", "Output format: txt, pnote, html, md or pdf.", "format");
+    QCommandLineOption outputDirOption("output-dir", "Directory for converted notes.", "dir", ".");
+    QCommandLineOption outputOption("output", "File to merge into; the format follows the suffix.", "file");
+    QCommandLineOption jobsOption({ "j", "jobs" }, "Worker threads (default: one per core).", "count");
+    parser.addOptions({ toOption, outputDirOption, outputOption, jobsOption });
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QStringList arguments = parser.positionalArguments();
+    if (arguments.size() < 2) {
+        parser.showHelp(2);
+    }
+    const QString command = arguments.takeFirst();
+    const QVector<Input> inputs = collectInputs(arguments);
+
+    QThreadPool pool;
+    if (parser.isSet(jobsOption)) {
+        pool.setMaxThreadCount(qMax(1, parser.value(jobsOption).toInt()));
+    }
+
+    if (command == "convert" || command == "export") {
+        // export defaults to HTML, convert to the native format
+        NoteIO::Format format = command == "export" ? NoteIO::Html : NoteIO::PNote;
+        if (parser.isSet(toOption) && !NoteIO::parseFormat(parser.value(toOption).toLower(), &format)) {
+            out << "Unknown format: " << parser.value(toOption) << "\n";
+            return 2;
+        }
+        return convert(inputs, format, parser.value(outputDirOption), &pool, out);
+    }
+    if (command == "merge") {
+        if (!parser.isSet(outputOption)) {
+            out << "merge needs --output\n";
+            return 2;
+        }
+        return merge(inputs, parser.value(outputOption), &pool, out);
+    }
+
+    out << "Unknown command: " << command << "\n";
+    return 2;
+}
@@ -0,0 +1,163 @@
+#include "customtextedit.h"
+
+#include "wordtimeindex.h"
+
+#include <QApplication>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QScrollBar>
+#include <QTextCursor>
+
+namespace {
+
+// Below this much room after the end of the note, the hypothesis starts on
+// a line of its own
+const int MinimumPartialWidth = 48;
+
+} // namespace
+
+CustomTextEdit::CustomTextEdit(QWidget *parent) : QTextEdit(parent) {
+    connect(document(), &QTextDocument::contentsChanged, this, [this] {
+        if (!partialText.isEmpty()) {
+            // The end of the note moved; repaint where the overlay was and is
+            const QRect before = partialRect();
+            partialLayoutDirty = true;
+            viewport()->update(QRegion(before).united(partialRect()));
+        }
+    });
+}
+
+void CustomTextEdit::setRuledPage(bool enabled) {
+    // Turns off grid if ruled is selected
+    background.setStyle(enabled ? PageBackground::Ruled : PageBackground::Plain);
+    viewport()->update(); // Trigger repaint
+}
+
+void CustomTextEdit::setGridPage(bool enabled) {
+    // Turns off ruled if grid is selected
+    background.setStyle(enabled ? PageBackground::Grid : PageBackground::Plain);
+    viewport()->update(); // Trigger repaint
+}
+
+void CustomTextEdit::paintEvent(QPaintEvent *event) {
+    if (background.style() != PageBackground::Plain) {
+        // Paint the lines under the text, only where the viewport is exposed,
+        // in document coordinates so that they scroll with the note
+        QPainter painter(viewport());
+        painter.setClipRegion(event->region());
+        const QPoint documentOffset(horizontalScrollBar()->value(), verticalScrollBar()->value());
+        background.paint(&painter, event->rect(), documentOffset,
+                         palette().color(QPalette::Base), palette().color(QPalette::Text),
+                         viewport()->devicePixelRatioF());
+    }
+
+    QTextEdit::paintEvent(event); // Call the base class's paintEvent
+
+    if (!partialText.isEmpty() && event->rect().intersects(partialRect())) {
+        // Overlay pass: muted italic text after the end of the note
+        QPainter painter(viewport());
+        painter.setClipRegion(event->region());
+        const QColor base = palette().color(QPalette::Base);
+        const QColor text = palette().color(QPalette::Text);
+        painter.setPen(QColor::fromRgbF((base.redF() + text.redF()) / 2, (base.greenF() + text.greenF()) / 2,
+                                        (base.blueF() + text.blueF()) / 2));
+        partialLayout.draw(&painter, partialOrigin - QPoint(horizontalScrollBar()->value(), verticalScrollBar()->value()));
+    }
+}
+
+void CustomTextEdit::setPartialHypothesis(const QString &text) {
+    if (text == partialText) {
+        return;
+    }
+    const QRect before = partialText.isEmpty() ? QRect() : partialRect();
+    partialText = text;
+    partialLayoutDirty = true;
+    const QRect after = partialText.isEmpty() ? QRect() : partialRect();
+    viewport()->update(QRegion(before).united(after));
+}
+
+void CustomTextEdit::resizeEvent(QResizeEvent *event) {
+    QTextEdit::resizeEvent(event);
+    partialLayoutDirty = true; // Wrap width changed
+}
+
+void CustomTextEdit::mousePressEvent(QMouseEvent *event) {
+    pressPosition = event->pos();
+    QTextEdit::mousePressEvent(event);
+}
+
+void CustomTextEdit::mouseReleaseEvent(QMouseEvent *event) {
+    QTextEdit::mouseReleaseEvent(event);
+    if (!wordTimes || event->button() != Qt::LeftButton || textCursor().hasSelection()
+        || (event->pos() - pressPosition).manhattanLength() >= QApplication::startDragDistance()) {
+        return; // Not a plain click
+    }
+
+    // A click on the right half of a word's last letter lands after it
+    const int position = cursorForPosition(event->pos()).position();
+    int word = wordTimes->wordAt(position);
+    if (word < 0) {
+        word = wordTimes->wordAt(position - 1);
+    }
+    if (word >= 0) {
+        emit audioSeekRequested(wordTimes->startMs(word));
+    }
+}
+
+// Overlay bounds in viewport coordinates
+QRect CustomTextEdit::partialRect() {
+    if (partialLayoutDirty) {
+        layoutPartial();
+    }
+    const QPoint scroll(horizontalScrollBar()->value(), verticalScrollBar()->value());
+    return partialLayout.boundingRect().translated(partialOrigin - scroll).toAlignedRect().adjusted(-1, -1, 1, 1);
+}
+
+// Wraps the hypothesis like note text: the first line continues after the
+// last character of the note, the others span the page
+void CustomTextEdit::layoutPartial() {
+    partialLayoutDirty = false;
+
+    QTextCursor end(document());
+    end.movePosition(QTextCursor::End);
+    const QRect caret = cursorRect(end);
+    const int margin = int(document()->documentMargin());
+    const int width = qMax(1, viewport()->width() - 2 * margin);
+
+    QFont font = end.charFormat().font();
+    font.setItalic(true);
+    partialLayout.setFont(font);
+    partialLayout.setText(partialText);
+
+    const QFontMetrics metrics(font);
+    qreal x = caret.left() + horizontalScrollBar()->value() - margin;
+    if (!end.atBlockStart()) {
+        x += metrics.horizontalAdvance(QLatin1Char(' '));
+    }
+    qreal y = 0;
+    if (width - x < MinimumPartialWidth) {
+        x = 0;
+        y = caret.height();
+    }
+
+    partialLayout.beginLayout();
+    for (QTextLine line = partialLayout.createLine(); line.isValid(); line = partialLayout.createLine()) {
+        line.setLineWidth(qMax<qreal>(1, width - x));
+        line.setPosition(QPointF(x, y));
+        y += line.height();
+        x = 0;
+    }
+    partialLayout.endLayout();
+
+    partialOrigin = QPoint(margin, caret.top() + verticalScrollBar()->value());
+}
+
+void CustomTextEdit::changeEvent(QEvent *event) {
+    QTextEdit::changeEvent(event);
+    if (event->type() == QEvent::PaletteChange) {
+        viewport()->update(); // Line colour follows the light/dark palette
+    } else if (event->type() == QEvent::FontChange) {
+        partialLayoutDirty = true;
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef CUSTOMTEXTEDIT_H
+#define CUSTOMTEXTEDIT_H
+
+#include <QTextEdit>
+#include <QTextLayout>
+
+#include "pagebackground.h"
+
+class WordTimeIndex;
+
+// Custom QTextEdit class
+class CustomTextEdit : public QTextEdit {
+    Q_OBJECT
+
+public:
+    CustomTextEdit(QWidget *parent = nullptr);
+
+    PageBackground::Style pageStyle() const { return background.style(); }
+    bool isRuledPageEnabled() const { return background.style() == PageBackground::Ruled; }
+    bool isGridPageEnabled() const { return background.style() == PageBackground::Grid; }
+
+    void setRuledPage(bool enabled);
+    void setGridPage(bool enabled);
+
+    // Speech that the recognizer may still revise, drawn after the end of
+    // the note on top of the text. It is never put into the document, so an
+    // update repaints a small rectangle instead of relaying out the note.
+    QString partialHypothesis() const { return partialText; }
+    void setPartialHypothesis(const QString &text);
+
+    // Clicking a transcribed word asks for its audio
+    void setWordTimeIndex(const WordTimeIndex *index) { wordTimes = index; }
+
+signals:
+    void audioSeekRequested(qint64 ms);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void changeEvent(QEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+
+private:
+    QRect partialRect();
+    void layoutPartial();
+
+    PageBackground background;
+
+    QString partialText;
+    QTextLayout partialLayout;
+    QPoint partialOrigin; // Viewport position of the layout, in document coordinates
+    bool partialLayoutDirty = true;
+
+    const WordTimeIndex *wordTimes = nullptr;
+    QPoint pressPosition;
+};
+
+#endif // CUSTOMTEXTEDIT_H
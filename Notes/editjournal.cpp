@@ -0,0 +1,328 @@
+#include "editjournal.h"
+
+#include "pnoteformat.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTextBlock>
+#include <QTextDocument>
+#include <QTextFormat>
+#include <QtEndian>
+
+#if defined(Q_OS_UNIX)
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <io.h>
+#endif
+
+namespace {
+
+void putU32(QByteArray &out, quint32 value) {
+    const quint32 le = qToLittleEndian(value);
+    out.append(reinterpret_cast<const char *>(&le), sizeof(le));
+}
+
+void pad(QByteArray &out) {
+    out.append(JournalFormat::padded(out.size()) - out.size(), '\0');
+}
+
+void putUtf16(QByteArray &out, const QString &text) {
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    out.append(reinterpret_cast<const char *>(text.utf16()), text.size() * 2);
+#else
+    for (const QChar c : text) {
+        const quint16 le = qToLittleEndian(c.unicode());
+        out.append(reinterpret_cast<const char *>(&le), sizeof(le));
+    }
+#endif
+}
+
+QByteArray header(quint32 magic, quint32 generation) {
+    QByteArray out;
+    putU32(out, magic);
+    putU32(out, JournalFormat::Version);
+    putU32(out, generation);
+    putU32(out, 0);
+    return out;
+}
+
+} // namespace
+
+quint32 JournalFormat::crc32(const char *data, qsizetype size) {
+    static quint32 table[256];
+    static const bool tableReady = [] {
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        return true;
+    }();
+    Q_UNUSED(tableReady);
+
+    quint32 crc = 0xffffffffu;
+    for (qsizetype i = 0; i < size; ++i) {
+        crc = table[(crc ^ quint8(data[i])) & 0xff] ^ (crc >> 8);
+    }
+    return crc ^ 0xffffffffu;
+}
+
+// Lives on the journal's worker thread; owns the files.
+class JournalWriter : public QObject {
+public:
+    JournalWriter(const QString &snapshotPath, const QString &journalPath)
+        : snapshotPath(snapshotPath), journal(journalPath) {}
+
+    void restart(quint32 generation, const QByteArray &snapshot) {
+        journal.close();
+
+        // The snapshot goes first: if we crash before the new journal is in
+        // place, the old journal has an older generation and gets ignored.
+        QSaveFile file(snapshotPath);
+        if (file.open(QIODevice::WriteOnly)) {
+            QByteArray out = header(JournalFormat::SnapshotMagic, generation);
+            putU32(out, quint32(snapshot.size()));
+            putU32(out, 0);
+            file.write(out);
+            file.write(snapshot);
+            out.clear();
+            out.append(JournalFormat::padded(snapshot.size()) - snapshot.size(), '\0');
+            putU32(out, JournalFormat::crc32(snapshot.constData(), snapshot.size()));
+            file.write(out);
+            file.commit();
+        }
+
+        QSaveFile fresh(journal.fileName());
+        if (fresh.open(QIODevice::WriteOnly)) {
+            fresh.write(header(JournalFormat::JournalMagic, generation));
+            fresh.commit();
+        }
+        journal.open(QIODevice::WriteOnly | QIODevice::Append);
+    }
+
+    void append(const QByteArray &records) {
+        if (!journal.isOpen()) {
+            return;
+        }
+        journal.write(records);
+        journal.flush();
+#if defined(Q_OS_UNIX)
+        ::fsync(journal.handle());
+#elif defined(Q_OS_WIN)
+        ::_commit(journal.handle());
+#endif
+    }
+
+    void discard() {
+        journal.close();
+        QFile::remove(journal.fileName());
+        QFile::remove(snapshotPath);
+    }
+
+private:
+    QString snapshotPath;
+    QFile journal;
+};
+
+EditJournal::EditJournal(QTextDocument *document, const QString &directory, QObject *parent)
+    : QObject(parent),
+      document(document),
+      directory(directory),
+      lock(directory + "/session.lock"),
+      writer(nullptr),
+      generation(0),
+      journalBytes(0),
+      characterCount(document->characterCount()),
+      ignoring(false) {
+    QDir().mkpath(directory);
+    if (!lock.tryLock(0)) {
+        return; // Another instance owns this journal
+    }
+
+    writer = new JournalWriter(snapshotPath(), journalPath());
+    writer->moveToThread(&writerThread);
+    connect(&writerThread, &QThread::finished, writer, &QObject::deleteLater);
+    writerThread.start(QThread::LowPriority);
+
+    syncTimer.setSingleShot(true);
+    syncTimer.setInterval(SyncInterval);
+    connect(&syncTimer, &QTimer::timeout, this, &EditJournal::flush);
+    connect(document, &QTextDocument::contentsChange, this, &EditJournal::recordChange);
+}
+
+EditJournal::~EditJournal() {
+    if (writer) {
+        // Make sure the last batch is on disk before the thread stops
+        QByteArray records;
+        records.swap(pending);
+        JournalWriter *w = writer;
+        QMetaObject::invokeMethod(writer, [w, records] { w->append(records); }, Qt::BlockingQueuedConnection);
+        writerThread.quit();
+        writerThread.wait();
+    }
+}
+
+QString EditJournal::defaultDirectory() {
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/autosave";
+}
+
+QString EditJournal::snapshotPath() const {
+    return directory + "/session.snapshot";
+}
+
+QString EditJournal::journalPath() const {
+    return directory + "/session.journal";
+}
+
+void EditJournal::restart() {
+    if (!writer) {
+        return;
+    }
+
+    // Records still pending are already part of the snapshot
+    pending.clear();
+    syncTimer.stop();
+    writtenFormats.clear();
+    journalBytes = 0;
+    characterCount = document->characterCount();
+
+    const quint32 next = ++generation;
+    // Serialized here, as the document lives on this thread; keeps formats,
+    // lists and tables, and positions match the records that follow
+    const QByteArray snapshot = PNoteFormat::serialize(document);
+    JournalWriter *w = writer;
+    QMetaObject::invokeMethod(writer, [w, next, snapshot] { w->restart(next, snapshot); }, Qt::QueuedConnection);
+}
+
+void EditJournal::discard() {
+    if (!writer) {
+        return;
+    }
+    pending.clear();
+    syncTimer.stop();
+    ignoring = true;
+    JournalWriter *w = writer;
+    QMetaObject::invokeMethod(writer, [w] { w->discard(); }, Qt::BlockingQueuedConnection);
+}
+
+void EditJournal::recordChange(int position, int charsRemoved, int charsAdded) {
+    const int before = characterCount;
+    characterCount = document->characterCount();
+    if (ignoring || !writer) {
+        return;
+    }
+
+    // contentsChange() may count the document's final paragraph separator,
+    // which is never really removed or inserted; clip it off both sides
+    const int removed = qBound(0, charsRemoved, before - 1 - position);
+    const int added = qBound(0, charsAdded, characterCount - 1 - position);
+    if (removed == 0 && added == 0) {
+        return;
+    }
+
+    // Collect the inserted text as runs of equal character format. Frame
+    // boundaries come out as plain paragraph separators, so a table or list
+    // inserted after the last snapshot is recovered as plain paragraphs.
+    QByteArray runs;
+    quint32 runCount = 0;
+    int runFormat = -1;
+    QString runText;
+    auto endRun = [&] {
+        if (runText.isEmpty()) {
+            return;
+        }
+        appendFormat(runFormat);
+        putU32(runs, quint32(runFormat));
+        putU32(runs, quint32(runText.size()));
+        putUtf16(runs, runText);
+        pad(runs);
+        ++runCount;
+        runText.clear();
+    };
+    auto addText = [&](int format, const QString &text) {
+        if (format != runFormat) {
+            endRun();
+            runFormat = format;
+        }
+        runText += text;
+    };
+
+    const int end = position + added;
+    for (QTextBlock block = document->findBlock(position); block.isValid() && block.position() < end; block = block.next()) {
+        for (QTextBlock::iterator it = block.begin(); !it.atEnd(); ++it) {
+            const QTextFragment fragment = it.fragment();
+            const int from = qMax(position, fragment.position());
+            const int to = qMin(end, fragment.position() + fragment.length());
+            if (from < to) {
+                addText(fragment.charFormatIndex(), fragment.text().mid(from - fragment.position(), to - from));
+            }
+        }
+        const int separator = block.position() + block.length() - 1;
+        if (separator >= position && separator < end) {
+            addText(block.charFormatIndex(), QString(QChar::ParagraphSeparator));
+        }
+    }
+    endRun();
+
+    QByteArray payload;
+    putU32(payload, quint32(position));
+    putU32(payload, quint32(removed));
+    putU32(payload, runCount);
+    payload.append(runs);
+    appendRecord(JournalFormat::EditRecord, payload);
+}
+
+void EditJournal::appendFormat(int formatIndex) {
+    if (writtenFormats.contains(formatIndex)) {
+        return;
+    }
+    writtenFormats.insert(formatIndex);
+
+    QTextFormat format = document->allFormats().value(formatIndex);
+    format.setObjectIndex(-1); // Object indexes only mean something inside this document
+
+    QByteArray bytes;
+    QDataStream stream(&bytes, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_15);
+    stream << format;
+
+    QByteArray payload;
+    putU32(payload, quint32(formatIndex));
+    putU32(payload, quint32(bytes.size()));
+    payload.append(bytes);
+    pad(payload);
+    appendRecord(JournalFormat::FormatRecord, payload);
+}
+
+void EditJournal::appendRecord(quint32 type, const QByteArray &payload) {
+    putU32(pending, quint32(payload.size()));
+    const qsizetype checked = pending.size();
+    putU32(pending, type);
+    pending.append(payload);
+    putU32(pending, JournalFormat::crc32(pending.constData() + checked, pending.size() - checked));
+
+    if (!syncTimer.isActive()) {
+        syncTimer.start();
+    }
+}
+
+void EditJournal::flush() {
+    if (pending.isEmpty() || !writer) {
+        return;
+    }
+
+    QByteArray records;
+    records.swap(pending);
+    journalBytes += records.size();
+    JournalWriter *w = writer;
+    QMetaObject::invokeMethod(writer, [w, records] { w->append(records); }, Qt::QueuedConnection);
+
+    if (journalBytes > CompactThreshold) {
+        restart();
+    }
+}
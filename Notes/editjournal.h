@@ -0,0 +1,99 @@
+#ifndef EDITJOURNAL_H
+#define EDITJOURNAL_H
+
+#include <QByteArray>
+#include <QLockFile>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QThread>
+#include <QTimer>
+
+class QTextDocument;
+class JournalWriter;
+
+// On-disk layout shared by the journal writer and the recovery code.
+// Everything is little-endian and 4-byte aligned so that a mapped file can
+// be read in place.
+//
+//   snapshot: Magic Version Generation Reserved, u32 size, u32 reserved,
+//             the document as .pnote (padded), u32 crc of the .pnote bytes
+//   journal:  JournalMagic Version Generation Reserved, then records
+//   record:   u32 payload size, u32 type, payload (padded), u32 crc of
+//             type + payload
+//
+// Format records carry a document format index and its QDataStream
+// serialized QTextCharFormat. Edit records carry position, chars removed and
+// the inserted text as runs of (format index, length, UTF-16 text).
+namespace JournalFormat {
+const quint32 SnapshotMagic = 0x31534e50; // "PNS1"
+const quint32 JournalMagic = 0x314a4e50; // "PNJ1"
+const quint32 Version = 2;
+const int HeaderSize = 16;
+const int SnapshotDataOffset = HeaderSize + 8; // 8-byte aligned, as .pnote sections expect
+
+enum RecordType : quint32 {
+    FormatRecord = 1,
+    EditRecord = 2,
+};
+
+quint32 crc32(const char *data, qsizetype size);
+inline qsizetype padded(qsizetype size) { return (size + 3) & ~qsizetype(3); }
+}
+
+// Autosave journal: appends a compact binary delta for every change of the
+// document instead of rewriting the whole note. Records are encoded on the
+// GUI thread, written and synced on a worker thread once per SyncInterval,
+// and the journal is compacted into a fresh snapshot in the background once
+// it grows past CompactThreshold.
+class EditJournal : public QObject {
+    Q_OBJECT
+
+public:
+    static const int SyncInterval = 1000; // ms
+    static const qint64 CompactThreshold = 4 * 1024 * 1024;
+
+    EditJournal(QTextDocument *document, const QString &directory, QObject *parent = nullptr);
+    ~EditJournal() override;
+
+    static QString defaultDirectory();
+
+    // False when another instance already journals into the same directory
+    bool isActive() const { return writer != nullptr; }
+
+    QString snapshotPath() const;
+    QString journalPath() const;
+
+    // Changes are ignored while paused, e.g. while a note streams in
+    void setPaused(bool paused) { ignoring = paused; }
+
+    // Snapshots the document and starts an empty journal from it
+    void restart();
+
+    // Clean shutdown: removes the snapshot and the journal
+    void discard();
+
+private slots:
+    void recordChange(int position, int charsRemoved, int charsAdded);
+    void flush();
+
+private:
+    void appendRecord(quint32 type, const QByteArray &payload);
+    void appendFormat(int formatIndex);
+
+    QTextDocument *document;
+    QString directory;
+    QLockFile lock;
+    QThread writerThread;
+    JournalWriter *writer;
+    QTimer syncTimer;
+
+    QByteArray pending;
+    QSet<int> writtenFormats;
+    quint32 generation;
+    qint64 journalBytes;
+    int characterCount;
+    bool ignoring;
+};
+
+#endif // EDITJOURNAL_H
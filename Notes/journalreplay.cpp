@@ -0,0 +1,168 @@
+#include "journalreplay.h"
+
+#include "editjournal.h"
+#include "pnoteformat.h"
+
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QTextFormat>
+#include <QtEndian>
+
+namespace {
+
+quint32 u32At(const uchar *p) {
+    return qFromLittleEndian<quint32>(p);
+}
+
+// UTF-16LE text inside a mapped file. Offsets in both files are 4-byte
+// aligned, so on little-endian hosts the mapping is used in place.
+QString textAt(const uchar *p, quint32 length) {
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    return QString::fromRawData(reinterpret_cast<const QChar *>(p), length);
+#else
+    QString text(length, Qt::Uninitialized);
+    for (quint32 i = 0; i < length; ++i) {
+        text[i] = QChar(qFromLittleEndian<quint16>(p + 2 * i));
+    }
+    return text;
+#endif
+}
+
+struct Header {
+    quint32 magic;
+    quint32 version;
+    quint32 generation;
+};
+
+bool readHeader(const uchar *data, qint64 size, quint32 magic, Header &header) {
+    if (size < JournalFormat::HeaderSize) {
+        return false;
+    }
+    header.magic = u32At(data);
+    header.version = u32At(data + 4);
+    header.generation = u32At(data + 8);
+    return header.magic == magic && header.version == JournalFormat::Version;
+}
+
+} // namespace
+
+JournalReplay::JournalReplay(QTextDocument *document)
+    : document(document), edits(0), journalSize(0), torn(false), elapsed(0) {}
+
+double JournalReplay::millisecondsPerMegabyte() const {
+    if (journalSize <= 0) {
+        return 0;
+    }
+    return (elapsed / 1e6) / (journalSize / (1024.0 * 1024.0));
+}
+
+bool JournalReplay::replay(const QString &snapshotPath, const QString &journalPath) {
+    QElapsedTimer clock;
+    clock.start();
+
+    QFile snapshotFile(snapshotPath);
+    if (!snapshotFile.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const qint64 snapshotSize = snapshotFile.size();
+    const uchar *snapshot = snapshotFile.map(0, snapshotSize);
+    Header snapshotHeader;
+    if (!snapshot || !readHeader(snapshot, snapshotSize, JournalFormat::SnapshotMagic, snapshotHeader)
+        || snapshotSize < JournalFormat::SnapshotDataOffset) {
+        return false;
+    }
+    const quint32 length = u32At(snapshot + JournalFormat::HeaderSize);
+    const qint64 dataOffset = JournalFormat::SnapshotDataOffset;
+    if (dataOffset + JournalFormat::padded(length) + 4 > snapshotSize
+        || u32At(snapshot + dataOffset + JournalFormat::padded(length))
+               != JournalFormat::crc32(reinterpret_cast<const char *>(snapshot + dataOffset), length)) {
+        return false;
+    }
+
+    const bool undo = document->isUndoRedoEnabled();
+    document->setUndoRedoEnabled(false);
+    if (!PNoteFormat::read(snapshot + dataOffset, length, document)) {
+        document->setUndoRedoEnabled(undo);
+        return false;
+    }
+    QTextCursor cursor(document);
+    cursor.beginEditBlock();
+
+    // The journal only counts if it continues from this very snapshot
+    QFile journalFile(journalPath);
+    const uchar *journal = nullptr;
+    Header journalHeader;
+    if (journalFile.open(QIODevice::ReadOnly)) {
+        journalSize = journalFile.size();
+        journal = journalFile.map(0, journalSize);
+    }
+    if (journal && readHeader(journal, journalSize, JournalFormat::JournalMagic, journalHeader)
+        && journalHeader.generation == snapshotHeader.generation) {
+        QHash<quint32, QTextCharFormat> formats;
+        qint64 at = JournalFormat::HeaderSize;
+        while (at < journalSize) {
+            // Size and type, payload, crc; anything short of that is a torn write
+            if (at + 12 > journalSize) {
+                torn = true;
+                break;
+            }
+            const quint32 payloadSize = u32At(journal + at);
+            const qint64 recordEnd = at + 8 + qint64(payloadSize) + 4;
+            if (payloadSize % 4 != 0 || recordEnd > journalSize
+                || u32At(journal + recordEnd - 4)
+                       != JournalFormat::crc32(reinterpret_cast<const char *>(journal + at + 4), payloadSize + 4)) {
+                torn = true;
+                break;
+            }
+
+            const quint32 type = u32At(journal + at + 4);
+            const uchar *payload = journal + at + 8;
+            const uchar *payloadEnd = payload + payloadSize;
+            if (type == JournalFormat::FormatRecord && payloadSize >= 8) {
+                const quint32 index = u32At(payload);
+                const quint32 size = u32At(payload + 4);
+                if (size <= payloadSize - 8) {
+                    QDataStream stream(QByteArray::fromRawData(reinterpret_cast<const char *>(payload + 8), int(size)));
+                    stream.setVersion(QDataStream::Qt_5_15);
+                    QTextFormat format;
+                    stream >> format;
+                    formats.insert(index, format.toCharFormat());
+                }
+            } else if (type == JournalFormat::EditRecord && payloadSize >= 12) {
+                const int characters = document->characterCount() - 1;
+                const int position = int(qMin<quint32>(u32At(payload), quint32(characters)));
+                const int removed = int(qMin<quint32>(u32At(payload + 4), quint32(characters - position)));
+                const quint32 runCount = u32At(payload + 8);
+
+                cursor.setPosition(position);
+                cursor.setPosition(position + removed, QTextCursor::KeepAnchor);
+                cursor.removeSelectedText();
+
+                const uchar *run = payload + 12;
+                for (quint32 i = 0; i < runCount && run + 8 <= payloadEnd; ++i) {
+                    const quint32 format = u32At(run);
+                    const quint32 runLength = u32At(run + 4);
+                    const qint64 runBytes = JournalFormat::padded(qint64(runLength) * 2);
+                    if (runBytes > payloadEnd - (run + 8)) {
+                        break;
+                    }
+                    cursor.insertText(textAt(run + 8, runLength), formats.value(format));
+                    run += 8 + runBytes;
+                }
+                ++edits;
+            }
+            at = recordEnd;
+        }
+    }
+
+    cursor.endEditBlock();
+    document->setUndoRedoEnabled(undo);
+    document->setModified(true);
+
+    elapsed = clock.nsecsElapsed();
+    return true;
+}
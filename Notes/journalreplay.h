@@ -0,0 +1,37 @@
+#ifndef JOURNALREPLAY_H
+#define JOURNALREPLAY_H
+
+#include <QString>
+#include <QtGlobal>
+
+class QTextDocument;
+
+// Restores a document from the snapshot and journal left behind by an
+// EditJournal that did not shut down cleanly. Both files are mapped and
+// read in place; the snapshot is a .pnote, so formats, lists and tables
+// come back with it, and all deltas go into the document as one edit block,
+// so the layout runs once at the end instead of once per delta.
+// Every record is checked against its CRC and replay stops at the first
+// torn or corrupt record.
+class JournalReplay {
+public:
+    explicit JournalReplay(QTextDocument *document);
+
+    bool replay(const QString &snapshotPath, const QString &journalPath);
+
+    int editsApplied() const { return edits; }
+    qint64 journalBytes() const { return journalSize; }
+    bool stoppedAtTornRecord() const { return torn; }
+    qint64 elapsedNanoseconds() const { return elapsed; }
+    // Replay time per megabyte of journal, in milliseconds
+    double millisecondsPerMegabyte() const;
+
+private:
+    QTextDocument *document;
+    int edits;
+    qint64 journalSize;
+    bool torn;
+    qint64 elapsed;
+};
+
+#endif // JOURNALREPLAY_H
@@ -4,8 +4,6 @@
 #include <QMenuBar>
 #include <QFileDialog>
 #include <QMessageBox>
-#include <QFile>
-#include <QTextStream>
 #include <QToolBar>
 #include <QAction>
 #include <QFontDialog>
@@ -17,61 +15,32 @@
 #include <QTextTable>
 #include <QTextTableFormat>
 #include <QPainter>
+#include <QScrollBar>
 #include <QWidgetAction>
 #include <QPen>
-
-// Custom QTextEdit class
-class CustomTextEdit : public QTextEdit {
-    Q_OBJECT
-
-public:
-    CustomTextEdit(QWidget *parent = nullptr) : QTextEdit(parent), ruledPage(false), gridPage(false) {}
-
-    bool isRuledPageEnabled() const { return ruledPage; }
-    bool isGridPageEnabled() const { return gridPage; }
-
-    void setRuledPage(bool enabled) {
-        ruledPage = enabled;
-        gridPage = false; // Turn off grid if ruled is selected
-        viewport()->update(); // Trigger repaint
-    }
-
-    void setGridPage(bool enabled) {
-        gridPage = enabled;
-        ruledPage = false; // Turn off ruled if grid is selected
-        viewport()->update(); // Trigger repaint
-    }
-
-protected:
-    void paintEvent(QPaintEvent *event) override {
-        QTextEdit::paintEvent(event); // Call the base class's paintEvent
-
-        if (ruledPage || gridPage) {
-            QPainter painter(viewport()); // Use viewport for custom painting on the textEdit
-            QPen pen(QColor(192, 192, 192)); // Light gray for ruled/grid lines
-            painter.setPen(pen);
-
-            if (ruledPage) {
-                int lineHeight = 20; // Space between lines
-                for (int y = lineHeight; y < viewport()->height(); y += lineHeight) {
-                    painter.drawLine(0, y, viewport()->width(), y);
-                }
-            } else if (gridPage) {
-                int gridSize = 20; // Space for grid cells
-                for (int y = gridSize; y < viewport()->height(); y += gridSize) {
-                    painter.drawLine(0, y, viewport()->width(), y); // Horizontal lines
-                }
-                for (int x = gridSize; x < viewport()->width(); x += gridSize) {
-                    painter.drawLine(x, 0, x, viewport()->height()); // Vertical lines
-                }
-            }
-        }
-    }
-
-private:
-    bool ruledPage;
-    bool gridPage;
-};
+#include <QStatusBar>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QPointer>
+#include <QLabel>
+#include <QFile>
+#include <QFileInfo>
+#include <QDebug>
+#include <QTime>
+
+#include "customtextedit.h"
+#include "editjournal.h"
+#include "journalreplay.h"
+#include "noteformatting.h"
+#include "noteloader.h"
+#include "notesaver.h"
+#include "pnoteformat.h"
+#ifdef NOTES_HAVE_TRANSCRIPT_CHANNEL
+#include "transcriptchannel.h"
+#endif
+#include "transcriptingestor.h"
+#include "transcriptviewer.h"
+#include "wordtimeindex.h"
 
 // Main NotesApp class
 class NotesApp : public QMainWindow {
@@ -84,74 +53,312 @@ public:
 
         createMenus();
         createToolbar();
+        createStatusBar();
+
+        // Autosave: every edit is appended to a journal next to a snapshot
+        journal = new EditJournal(textEdit->document(), EditJournal::defaultDirectory(), this);
+        recoverUncleanSession();
+        journal->restart();
+
+        // Live transcript from the pen, appended at most once per frame
+        ingestor = new TranscriptIngestor(textEdit->document(), this);
+        connect(ingestor, &TranscriptIngestor::aboutToFlush, this, &NotesApp::keepViewBeforeTranscript);
+        connect(ingestor, &TranscriptIngestor::flushed, this, &NotesApp::restoreViewAfterTranscript);
+        connect(ingestor, &TranscriptIngestor::partialHypothesisChanged, textEdit, &CustomTextEdit::setPartialHypothesis);
+#ifdef NOTES_HAVE_TRANSCRIPT_CHANNEL
+        transcriptChannel = new TranscriptChannel(ingestor, this);
+        connect(transcriptChannel, &TranscriptChannel::disconnected, this, [this] {
+            statusBar()->showMessage("Pen receiver disconnected", 5000);
+        });
+#endif
+
+        // Audio time of every transcribed word, for click-to-replay
+        wordTimes = new WordTimeIndex(textEdit->document(), this);
+        ingestor->setWordIndex(wordTimes);
+        textEdit->setWordTimeIndex(wordTimes);
+        connect(textEdit, &CustomTextEdit::audioSeekRequested, this, &NotesApp::seekAudio);
 
         setWindowTitle("Notes App");
         resize(800, 600);
         applyLightMode();
     }
 
+    ~NotesApp() override {
+        journal->discard(); // Clean exit, nothing to recover
+    }
+
+    // Appends recognized speech to the note; safe to call from any thread
+    void ingestTranscript(const QString &text) {
+        ingestor->append(text);
+    }
+
+    // Same, with each word's audio time for click-to-replay
+    void ingestTranscriptWords(const QVector<TranscriptWord> &words) {
+        ingestor->appendWords(words);
+    }
+
+    // Shows the recognizer's running guess after the note without
+    // committing it; the next final result replaces it. Any thread.
+    void showPartialTranscript(const QString &text) {
+        ingestor->setPartial(text);
+    }
+
+    TranscriptIngestor *transcriptIngestor() const { return ingestor; }
+    const WordTimeIndex *wordTimeIndex() const { return wordTimes; }
+
+signals:
+    // For the audio player: play the recording from ms
+    void audioSeekRequested(qint64 ms);
+
 private slots:
+    void seekAudio(qint64 ms) {
+        const QTime time = QTime(0, 0).addMSecs(int(ms));
+        statusBar()->showMessage("Audio at " + time.toString(ms >= 3600000 ? "h:mm:ss.z" : "m:ss.z"), 3000);
+        emit audioSeekRequested(ms);
+    }
+
     void newNote() {
+        cancelLoading();
         textEdit->clear();
     }
 
     void openNote() {
-        QString fileName = QFileDialog::getOpenFileName(this, "Open Note", "", "Text Files (*.txt);;All Files (*)");
+        QString fileName = QFileDialog::getOpenFileName(this, "Open Note", "", noteFileFilter());
         if (!fileName.isEmpty()) {
-            QFile file(fileName);
-            if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-                QTextStream in(&file);
-                textEdit->setText(in.readAll());
-                file.close();
-            } else {
-                QMessageBox::warning(this, "Error", "Could not open file.");
+            if (!PNoteFormat::isPNote(fileName) && QFileInfo(fileName).size() >= TranscriptViewerThreshold) {
+                openTranscript(fileName); // Too large to edit
+                return;
             }
+            startLoading(fileName);
+        }
+    }
+
+#ifdef NOTES_HAVE_TRANSCRIPT_CHANNEL
+    // Transcript straight from a local pen-receiverd --publish
+    void connectPenReceiver() {
+        bool ok = false;
+        const QString path = QInputDialog::getText(this, "Connect to Pen Receiver", "Transcript socket:",
+                                                   QLineEdit::Normal, TranscriptChannel::defaultSocketPath(), &ok);
+        if (!ok || path.isEmpty()) {
+            return;
+        }
+        QString error;
+        if (!transcriptChannel->connectTo(path, &error)) {
+            QMessageBox::warning(this, "Error", "Could not connect to the pen receiver.\n" + error);
+            return;
+        }
+        statusBar()->showMessage("Receiving the transcript from " + path, 5000);
+    }
+#endif
+
+    void openTranscriptArchive() {
+        QString fileName = QFileDialog::getOpenFileName(this, "Open Transcript", "", "Transcripts (*.txt *.log);;All Files (*)");
+        if (!fileName.isEmpty()) {
+            openTranscript(fileName);
+        }
+    }
+
+    // Transcript archives are viewed read-only in their own window, straight
+    // from a memory mapping, instead of being loaded into the editor
+    void openTranscript(const QString &fileName) {
+        TranscriptViewer *viewer = new TranscriptViewer(this);
+        viewer->setWindowFlag(Qt::Window);
+        viewer->setAttribute(Qt::WA_DeleteOnClose);
+        QString error;
+        if (!viewer->open(fileName, &error)) {
+            delete viewer;
+            QMessageBox::warning(this, "Error", "Could not open file.\n" + error);
+            return;
+        }
+        applyPageStyle(viewer);
+        viewer->resize(size());
+        viewer->show();
+    }
+
+    // Streaming open: the note is read and decoded on a worker thread and
+    // appended chunk by chunk, so the first screen shows up right away
+    void startLoading(const QString &fileName) {
+        cancelLoading();
+
+        if (PNoteFormat::isPNote(fileName)) {
+            loadPNote(fileName);
+            return;
+        }
+
+        // finishLoading(false) drops it again if the load does not complete
+        currentFile = fileName;
+        textEdit->clear();
+        journal->setPaused(true); // Journaled as one snapshot once loaded
+        ingestor->setPaused(true); // Live text goes after the loaded note
+        textEdit->document()->setUndoRedoEnabled(false);
+        textEdit->setReadOnly(true);
+
+        loader = new NoteLoader(fileName, this);
+        connect(loader, &NoteLoader::chunkLoaded, this, &NotesApp::insertLoadedChunk);
+        connect(loader, &NoteLoader::loadFailed, this, &NotesApp::loadFailed);
+        connect(loader, &NoteLoader::loadFinished, this, &NotesApp::loadFinished);
+        connect(loader, &QThread::finished, loader, &QObject::deleteLater);
+
+        loadProgress->setValue(0);
+        loadProgress->show();
+        cancelLoadButton->show();
+        statusBar()->showMessage("Loading " + fileName + "...");
+        loader->start();
+    }
+
+    // Native notes are mapped and built in a single edit block; that is
+    // fast enough to do in place, with formatting, lists and tables intact.
+    // A file that does not read leaves the document untouched, so the open
+    // note stays as it was, under its own name.
+    void loadPNote(const QString &fileName) {
+        QTextDocument *document = textEdit->document();
+        journal->setPaused(true);
+        document->setUndoRedoEnabled(false);
+        QString error;
+        const bool loaded = PNoteFormat::load(fileName, document, &error);
+        document->setUndoRedoEnabled(true);
+        journal->setPaused(false);
+        if (!loaded) {
+            QMessageBox::warning(this, "Error", "Could not open file.\n" + error);
+            return;
+        }
+
+        currentFile = fileName;
+        document->setModified(false);
+        textEdit->setTextCursor(QTextCursor(document));
+        journal->restart();
+        statusBar()->showMessage("Loaded", 3000);
+    }
+
+    void insertLoadedChunk(const QString &text, qint64 bytesRead, qint64 bytesTotal) {
+        if (sender() != loader) {
+            return; // Queued by a load that has been cancelled since
+        }
+
+        const bool firstChunk = textEdit->document()->isEmpty();
+        QTextCursor cursor(textEdit->document());
+        cursor.movePosition(QTextCursor::End);
+        cursor.beginEditBlock();
+        cursor.insertText(text);
+        cursor.endEditBlock();
+        if (firstChunk) {
+            textEdit->setTextCursor(QTextCursor(textEdit->document())); // Keep the caret at the top
+        }
+
+        if (bytesTotal > 0) {
+            loadProgress->setValue(int(qMin<qint64>(1000, bytesRead * 1000 / bytesTotal)));
+        }
+        loader->chunkConsumed();
+    }
+
+    void loadFailed(const QString &message) {
+        if (sender() != loader) {
+            return;
+        }
+        finishLoading(false);
+        QMessageBox::warning(this, "Error", "Could not open file.\n" + message);
+    }
+
+    void loadFinished(bool cancelled) {
+        if (sender() != loader) {
+            return;
+        }
+        finishLoading(!cancelled);
+        statusBar()->showMessage(cancelled ? "Loading cancelled" : "Loaded", 3000);
+    }
+
+    void cancelLoading() {
+        if (loader) {
+            loader->cancel();
+            finishLoading(false);
+            statusBar()->showMessage("Loading cancelled", 3000);
         }
     }
 
     void saveNote() {
-        QString fileName = QFileDialog::getSaveFileName(this, "Save Note", "", "Text Files (*.txt);;All Files (*)");
+        QString fileName = QFileDialog::getSaveFileName(this, "Save Note", currentFile, noteFileFilter());
         if (!fileName.isEmpty()) {
-            QFile file(fileName);
-            if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-                QTextStream out(&file);
-                out << textEdit->toPlainText();
-                file.close();
-            } else {
-                QMessageBox::warning(this, "Error", "Could not save file.");
+            currentFile = fileName;
+            startSaving(fileName);
+        }
+    }
+
+    // Non-blocking save: snapshot the raw text here, convert and write it on
+    // a worker thread. A save requested while one is running waits for it.
+    void startSaving(const QString &fileName) {
+        NoteSaver *job = PNoteFormat::isPNote(fileName)
+                             ? new NoteSaver(fileName, textEdit->document()->clone(), this)
+                             : new NoteSaver(fileName, textEdit->document()->toRawText(), this);
+        connect(job, &NoteSaver::saved, this, &NotesApp::noteSaved);
+        connect(job, &NoteSaver::saveFailed, this, &NotesApp::saveFailed);
+        connect(job, &QThread::finished, this, &NotesApp::startPendingSave);
+        connect(job, &QThread::finished, job, &QObject::deleteLater);
+        job->setDocumentWasModified(textEdit->document()->isModified());
+        textEdit->document()->setModified(false);
+
+        if (saver) {
+            if (pendingSaver && pendingSaver->documentWasModified()) {
+                job->setDocumentWasModified(true); // Its changes were never written
             }
+            delete pendingSaver; // Superseded by the newer snapshot
+            pendingSaver = job;
+            saveStatus->setText("Save queued");
+            return;
+        }
+        saver = job;
+        saveStatus->setText("Saving...");
+        saver->start();
+    }
+
+    void startPendingSave() {
+        if (sender() != saver) {
+            return;
+        }
+        saver = pendingSaver;
+        pendingSaver = nullptr;
+        if (saver) {
+            saveStatus->setText("Saving...");
+            saver->start();
         }
     }
 
+    void noteSaved(qint64 bytesWritten, qint64 latencyMs) {
+        saveStatus->setText(QString("Saved %1 in %2 ms")
+                                .arg(locale().formattedDataSize(bytesWritten))
+                                .arg(latencyMs));
+    }
+
+    void saveFailed(const QString &message) {
+        NoteSaver *job = qobject_cast<NoteSaver *>(sender());
+        saveStatus->setText("Save failed");
+        // Edits made since the snapshot have marked the document already
+        if (!job || job->documentWasModified()) {
+            textEdit->document()->setModified(true);
+        }
+        QMessageBox::warning(this, "Error", "Could not save file.\n" + (job ? job->fileName() + ": " : QString()) + message);
+    }
+
     void quitApp() {
         QApplication::quit();
     }
 
     // Formatting slots
     void setBold() {
-        QTextCharFormat format;
-        format.setFontWeight(textEdit->fontWeight() == QFont::Bold ? QFont::Normal : QFont::Bold);
-        applyFormat(format);
+        applyFormat(NoteFormatting::toggledBold(textEdit->currentCharFormat()));
     }
 
     void setItalic() {
-        QTextCharFormat format;
-        format.setFontItalic(!textEdit->fontItalic());
-        applyFormat(format);
+        applyFormat(NoteFormatting::toggledItalic(textEdit->currentCharFormat()));
     }
 
     void setUnderline() {
-        QTextCharFormat format;
-        format.setFontUnderline(!textEdit->fontUnderline());
-        applyFormat(format);
+        applyFormat(NoteFormatting::toggledUnderline(textEdit->currentCharFormat()));
     }
 
     void setTextColor() {
         QColor color = QColorDialog::getColor(textEdit->textColor(), this, "Choose Text Color");
         if (color.isValid()) {
-            QTextCharFormat format;
-            format.setForeground(color);
-            applyFormat(format);
+            applyFormat(NoteFormatting::textColor(color));
         }
     }
 
@@ -159,9 +366,7 @@ private slots:
         bool ok;
         QFont font = QFontDialog::getFont(&ok, textEdit->currentFont(), this);
         if (ok) {
-            QTextCharFormat format;
-            format.setFont(font);
-            applyFormat(format);
+            applyFormat(NoteFormatting::font(font));
         }
     }
 
@@ -173,19 +378,17 @@ private slots:
         if (!ok) return;
 
         QTextCursor cursor = textEdit->textCursor();
-        QTextTableFormat tableFormat;
-        tableFormat.setBorder(1);
-        cursor.insertTable(rows, columns, tableFormat);
+        NoteFormatting::insertTable(cursor, rows, columns);
     }
 
     void insertBulletList() {
         QTextCursor cursor = textEdit->textCursor();
-        cursor.insertList(QTextListFormat::ListDisc);
+        NoteFormatting::insertList(cursor, QTextListFormat::ListDisc);
     }
 
     void insertNumberedList() {
         QTextCursor cursor = textEdit->textCursor();
-        cursor.insertList(QTextListFormat::ListDecimal);
+        NoteFormatting::insertList(cursor, QTextListFormat::ListDecimal);
     }
 
     void insertEquation() {
@@ -193,16 +396,19 @@ private slots:
         QString equation = QInputDialog::getText(this, "Insert Equation", "Enter equation (LaTeX format):", QLineEdit::Normal, "", &ok);
 
         if (ok && !equation.isEmpty()) {
-            textEdit->textCursor().insertText("$$ " + equation + " $$");
+            QTextCursor cursor = textEdit->textCursor();
+            NoteFormatting::insertEquation(cursor, equation);
         }
     }
 
     void toggleRuledPage() {
         textEdit->setRuledPage(!textEdit->isRuledPageEnabled());
+        updateTranscriptViewers();
     }
 
     void toggleGridPage() {
         textEdit->setGridPage(!textEdit->isGridPageEnabled());
+        updateTranscriptViewers();
     }
 
     void toggleLightMode() {
@@ -217,6 +423,136 @@ private slots:
 private:
     CustomTextEdit *textEdit;
     bool lightMode;
+    EditJournal *journal;
+    QPointer<NoteLoader> loader;
+    QProgressBar *loadProgress;
+    QPushButton *cancelLoadButton;
+    QPointer<NoteSaver> saver;
+    QPointer<NoteSaver> pendingSaver;
+    QLabel *saveStatus;
+    QString currentFile;
+    TranscriptIngestor *ingestor;
+#ifdef NOTES_HAVE_TRANSCRIPT_CHANNEL
+    TranscriptChannel *transcriptChannel;
+#endif
+    WordTimeIndex *wordTimes;
+    QLabel *transcriptStatus;
+    int keptAnchor = 0;
+    int keptPosition = 0;
+    int keptScroll = 0;
+    bool followTranscript = false;
+
+    // Text files from this size on open in the read-only transcript viewer
+    static const qint64 TranscriptViewerThreshold = 64 * 1024 * 1024;
+
+    // A snapshot left in the journal directory means the last session did
+    // not exit cleanly; bring its note back before journaling starts again
+    void recoverUncleanSession() {
+        if (!journal->isActive() || !QFile::exists(journal->snapshotPath())) {
+            return;
+        }
+
+        journal->setPaused(true);
+        JournalReplay replay(textEdit->document());
+        const bool recovered = replay.replay(journal->snapshotPath(), journal->journalPath());
+        journal->setPaused(false);
+        if (!recovered) {
+            return;
+        }
+
+        const QString report = QString("Recovered unsaved note: %1 edits from %2 of journal in %3 ms (%4 ms/MB)%5")
+                                   .arg(replay.editsApplied())
+                                   .arg(locale().formattedDataSize(replay.journalBytes()))
+                                   .arg(replay.elapsedNanoseconds() / 1e6, 0, 'f', 1)
+                                   .arg(replay.millisecondsPerMegabyte(), 0, 'f', 1)
+                                   .arg(replay.stoppedAtTornRecord() ? ", stopped at a torn record" : "");
+        qInfo().noquote() << report;
+        statusBar()->showMessage(report, 10000);
+    }
+
+    // Transcript viewers follow the editor's page style and light/dark mode
+    void applyPageStyle(TranscriptViewer *viewer) {
+        viewer->setPageStyle(textEdit->pageStyle());
+        viewer->setPalette(textEdit->palette());
+    }
+
+    void updateTranscriptViewers() {
+        for (TranscriptViewer *viewer : findChildren<TranscriptViewer *>(QString(), Qt::FindDirectChildrenOnly)) {
+            applyPageStyle(viewer);
+        }
+    }
+
+    static QString noteFileFilter() {
+        return "Notes (*.pnote *.txt);;Pen-Pad Notes (*.pnote);;Text Files (*.txt);;All Files (*)";
+    }
+
+    void createStatusBar() {
+        loadProgress = new QProgressBar(this);
+        loadProgress->setRange(0, 1000);
+        loadProgress->setTextVisible(false);
+        loadProgress->setMaximumWidth(160);
+        loadProgress->hide();
+        statusBar()->addPermanentWidget(loadProgress);
+
+        cancelLoadButton = new QPushButton("Cancel", this);
+        connect(cancelLoadButton, &QPushButton::clicked, this, &NotesApp::cancelLoading);
+        cancelLoadButton->hide();
+        statusBar()->addPermanentWidget(cancelLoadButton);
+
+        saveStatus = new QLabel(this);
+        statusBar()->addPermanentWidget(saveStatus);
+
+        transcriptStatus = new QLabel(this);
+        transcriptStatus->hide();
+        statusBar()->addPermanentWidget(transcriptStatus);
+    }
+
+    // A load that was cancelled or failed leaves only part of the note; it is
+    // dropped, so it can neither be saved over the file nor journaled as it
+    void finishLoading(bool complete) {
+        // The loader deletes itself once its thread has stopped
+        loader = nullptr;
+        loadProgress->hide();
+        cancelLoadButton->hide();
+        if (!complete) {
+            textEdit->clear();
+            currentFile.clear();
+        }
+        textEdit->setReadOnly(false);
+        textEdit->document()->setUndoRedoEnabled(true);
+        textEdit->document()->setModified(false);
+        journal->setPaused(false);
+        journal->restart();
+        ingestor->setPaused(false);
+    }
+
+    // Transcript text goes to the end of the note; the caret, the selection
+    // and the scroll position stay put unless the view was following the end
+    void keepViewBeforeTranscript() {
+        const QTextCursor cursor = textEdit->textCursor();
+        keptAnchor = cursor.anchor();
+        keptPosition = cursor.position();
+        const QScrollBar *scrollBar = textEdit->verticalScrollBar();
+        keptScroll = scrollBar->value();
+        followTranscript = scrollBar->value() == scrollBar->maximum();
+    }
+
+    void restoreViewAfterTranscript() {
+        QTextCursor cursor = textEdit->textCursor();
+        if (cursor.anchor() != keptAnchor || cursor.position() != keptPosition) {
+            cursor.setPosition(keptAnchor);
+            cursor.setPosition(keptPosition, QTextCursor::KeepAnchor);
+            textEdit->setTextCursor(cursor);
+        }
+        QScrollBar *scrollBar = textEdit->verticalScrollBar();
+        scrollBar->setValue(followTranscript ? scrollBar->maximum() : keptScroll);
+
+        transcriptStatus->setText(QString("Live: %1 words/s, flush %2 ms, latency %3 ms")
+                                      .arg(ingestor->wordsPerSecond(), 0, 'f', 1)
+                                      .arg(ingestor->lastFlushMs(), 0, 'f', 2)
+                                      .arg(ingestor->lastLatencyMs(), 0, 'f', 1));
+        transcriptStatus->show();
+    }
 
     void createMenus() {
         QMenu *fileMenu = menuBar()->addMenu("File");
@@ -229,6 +565,16 @@ private:
         connect(openAction, &QAction::triggered, this, &NotesApp::openNote);
         fileMenu->addAction(openAction);
 
+        QAction *openTranscriptAction = new QAction("Open Transcript (Read-Only)", this);
+        connect(openTranscriptAction, &QAction::triggered, this, &NotesApp::openTranscriptArchive);
+        fileMenu->addAction(openTranscriptAction);
+
+#ifdef NOTES_HAVE_TRANSCRIPT_CHANNEL
+        QAction *connectReceiverAction = new QAction("Connect to Pen Receiver...", this);
+        connect(connectReceiverAction, &QAction::triggered, this, &NotesApp::connectPenReceiver);
+        fileMenu->addAction(connectReceiverAction);
+#endif
+
         QAction *saveAction = new QAction("Save", this);
         connect(saveAction, &QAction::triggered, this, &NotesApp::saveNote);
         fileMenu->addAction(saveAction);
@@ -304,6 +650,7 @@ private:
         palette.setColor(QPalette::Base, Qt::white);
         palette.setColor(QPalette::Text, Qt::black);
         textEdit->setPalette(palette);
+        updateTranscriptViewers();
     }
 
     void applyDarkMode() {
@@ -311,11 +658,12 @@ private:
         palette.setColor(QPalette::Base, Qt::black);
         palette.setColor(QPalette::Text, Qt::white);
         textEdit->setPalette(palette);
+        updateTranscriptViewers();
     }
 
     void applyFormat(const QTextCharFormat &format) {
         QTextCursor cursor = textEdit->textCursor();
-        cursor.mergeCharFormat(format);
+        NoteFormatting::applyFormat(cursor, format);
         textEdit->mergeCurrentCharFormat(format);
     }
 };
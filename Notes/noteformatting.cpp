@@ -0,0 +1,55 @@
+#include "noteformatting.h"
+
+#include <QColor>
+#include <QFont>
+#include <QTextCursor>
+#include <QTextTable>
+#include <QTextTableFormat>
+
+QTextCharFormat NoteFormatting::toggledBold(const QTextCharFormat &current) {
+    QTextCharFormat format;
+    format.setFontWeight(current.fontWeight() == QFont::Bold ? QFont::Normal : QFont::Bold);
+    return format;
+}
+
+QTextCharFormat NoteFormatting::toggledItalic(const QTextCharFormat &current) {
+    QTextCharFormat format;
+    format.setFontItalic(!current.fontItalic());
+    return format;
+}
+
+QTextCharFormat NoteFormatting::toggledUnderline(const QTextCharFormat &current) {
+    QTextCharFormat format;
+    format.setFontUnderline(!current.fontUnderline());
+    return format;
+}
+
+QTextCharFormat NoteFormatting::textColor(const QColor &color) {
+    QTextCharFormat format;
+    format.setForeground(color);
+    return format;
+}
+
+QTextCharFormat NoteFormatting::font(const QFont &font) {
+    QTextCharFormat format;
+    format.setFont(font);
+    return format;
+}
+
+void NoteFormatting::applyFormat(QTextCursor &cursor, const QTextCharFormat &format) {
+    cursor.mergeCharFormat(format);
+}
+
+QTextTable *NoteFormatting::insertTable(QTextCursor &cursor, int rows, int columns) {
+    QTextTableFormat tableFormat;
+    tableFormat.setBorder(1);
+    return cursor.insertTable(rows, columns, tableFormat);
+}
+
+void NoteFormatting::insertList(QTextCursor &cursor, QTextListFormat::Style style) {
+    cursor.insertList(style);
+}
+
+void NoteFormatting::insertEquation(QTextCursor &cursor, const QString &latex) {
+    cursor.insertText("$$ " + latex + " $$");
+}
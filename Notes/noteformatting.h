@@ -0,0 +1,33 @@
+#ifndef NOTEFORMATTING_H
+#define NOTEFORMATTING_H
+
+#include <QTextCharFormat>
+#include <QTextListFormat>
+
+class QColor;
+class QFont;
+class QTextCursor;
+class QTextTable;
+
+// The editor's formatting commands, on a cursor instead of a widget, so
+// that they can be scripted and benchmarked without a window.
+namespace NoteFormatting {
+
+// Formats to merge into the selection; the toggles flip whatever the
+// current format has
+QTextCharFormat toggledBold(const QTextCharFormat &current);
+QTextCharFormat toggledItalic(const QTextCharFormat &current);
+QTextCharFormat toggledUnderline(const QTextCharFormat &current);
+QTextCharFormat textColor(const QColor &color);
+QTextCharFormat font(const QFont &font);
+
+void applyFormat(QTextCursor &cursor, const QTextCharFormat &format);
+
+QTextTable *insertTable(QTextCursor &cursor, int rows, int columns);
+void insertList(QTextCursor &cursor, QTextListFormat::Style style);
+// Equations are kept as LaTeX between $$ markers
+void insertEquation(QTextCursor &cursor, const QString &latex);
+
+} // namespace NoteFormatting
+
+#endif // NOTEFORMATTING_H
@@ -0,0 +1,179 @@
+#include "noteio.h"
+
+#include "pnoteformat.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QPdfWriter>
+#include <QSaveFile>
+#include <QStringView>
+#include <QTextDocument>
+#include <QTextStream>
+
+namespace {
+
+// Characters converted and encoded per step
+const int ChunkSize = 64 * 1024;
+
+// Same mapping as QTextDocument::toPlainText(), applied to a slice of the
+// raw document text without detaching the shared snapshot.
+void toPlainText(QStringView raw, QString &out) {
+    out.resize(raw.size());
+    QChar *dst = out.data();
+    for (const QChar c : raw) {
+        switch (c.unicode()) {
+        case 0xfdd0: // QTextBeginningOfFrame
+        case 0xfdd1: // QTextEndOfFrame
+        case QChar::ParagraphSeparator:
+        case QChar::LineSeparator:
+            *dst++ = QLatin1Char('\n');
+            break;
+        case QChar::Nbsp:
+            *dst++ = QLatin1Char(' ');
+            break;
+        default:
+            *dst++ = c;
+            break;
+        }
+    }
+}
+
+void setError(QString *error, const QString &message) {
+    if (error) {
+        *error = message;
+    }
+}
+
+} // namespace
+
+NoteIO::Format NoteIO::formatFor(const QString &fileName) {
+    Format format = PlainText;
+    parseFormat(QFileInfo(fileName).suffix().toLower(), &format);
+    return format;
+}
+
+QString NoteIO::suffixFor(Format format) {
+    switch (format) {
+    case PNote:
+        return PNoteFormat::suffix();
+    case Html:
+        return "html";
+    case Markdown:
+        return "md";
+    case Pdf:
+        return "pdf";
+    case PlainText:
+        break;
+    }
+    return "txt";
+}
+
+bool NoteIO::parseFormat(const QString &name, Format *format) {
+    static const Format all[] = { PlainText, PNote, Html, Markdown, Pdf };
+    for (const Format candidate : all) {
+        if (name == suffixFor(candidate) || (candidate == Html && name == "htm")
+            || (candidate == Markdown && name == "markdown")) {
+            *format = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool NoteIO::load(const QString &fileName, QTextDocument *document, QString *error) {
+    const Format format = formatFor(fileName);
+    if (format == PNote) {
+        return PNoteFormat::load(fileName, document, error);
+    }
+    if (format == Pdf) {
+        setError(error, "PDF notes cannot be read");
+        return false;
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        setError(error, file.errorString());
+        return false;
+    }
+    QTextStream in(&file);
+    const QString text = in.readAll();
+    switch (format) {
+    case Html:
+        document->setHtml(text);
+        break;
+    case Markdown:
+        document->setMarkdown(text);
+        break;
+    default:
+        document->setPlainText(text);
+        break;
+    }
+    return true;
+}
+
+bool NoteIO::save(const QTextDocument *document, const QString &fileName, Format format, QString *error) {
+    if (format == Pdf) {
+        QFile file(fileName);
+        if (!file.open(QIODevice::WriteOnly)) {
+            setError(error, file.errorString());
+            return false;
+        }
+        {
+            QPdfWriter writer(&file);
+            writer.setTitle(QFileInfo(fileName).completeBaseName());
+            // print() lays out a copy, so the document itself stays untouched
+            document->print(&writer);
+        } // The writer finishes the file when it goes away
+        file.close();
+        if (file.error() != QFileDevice::NoError) {
+            setError(error, file.errorString());
+            return false;
+        }
+        return true;
+    }
+
+    QSaveFile file(fileName);
+    if (!file.open(format == PNote ? QIODevice::WriteOnly : QIODevice::WriteOnly | QIODevice::Text)) {
+        setError(error, file.errorString());
+        return false;
+    }
+
+    bool written = true;
+    switch (format) {
+    case PNote:
+        written = PNoteFormat::write(document, &file);
+        break;
+    case PlainText:
+        written = writePlainText(document->toRawText(), &file);
+        break;
+    case Html:
+    case Markdown: {
+        QTextStream out(&file);
+        out << (format == Html ? document->toHtml() : document->toMarkdown());
+        out.flush();
+        written = out.status() == QTextStream::Ok;
+        break;
+    }
+    case Pdf:
+        break;
+    }
+
+    // commit() flushes to disk and renames over the old file
+    if (!written || !file.commit()) {
+        setError(error, file.errorString());
+        return false;
+    }
+    return true;
+}
+
+bool NoteIO::writePlainText(const QString &rawText, QIODevice *device) {
+    QTextStream out(device);
+    QString chunk;
+    const QStringView raw(rawText);
+    for (qsizetype pos = 0; pos < raw.size(); pos += ChunkSize) {
+        toPlainText(raw.mid(pos, qMin<qsizetype>(ChunkSize, raw.size() - pos)), chunk);
+        out << chunk;
+    }
+    out.flush();
+    return out.status() == QTextStream::Ok;
+}
@@ -0,0 +1,33 @@
+#ifndef NOTEIO_H
+#define NOTEIO_H
+
+#include <QString>
+
+class QIODevice;
+class QTextDocument;
+
+// Synchronous note I/O shared by the editor, its worker threads and
+// notes-cli. Needs QtGui but no widgets, so it runs on the offscreen
+// platform. Every function is reentrant: distinct documents can be loaded
+// and saved on different threads at the same time.
+class NoteIO {
+public:
+    enum Format { PlainText, PNote, Html, Markdown, Pdf };
+
+    // Picks the format from the file suffix; unknown suffixes are plain text
+    static Format formatFor(const QString &fileName);
+    static QString suffixFor(Format format);
+    // "txt", "pnote", "html", "md" or "pdf"; false for anything else
+    static bool parseFormat(const QString &name, Format *format);
+
+    // PDF can only be written
+    static bool load(const QString &fileName, QTextDocument *document, QString *error = nullptr);
+    // Replaces fileName atomically, except for PDF which is written in place
+    static bool save(const QTextDocument *document, const QString &fileName, Format format, QString *error = nullptr);
+
+    // Writes raw document text (QTextDocument::toRawText()) as plain text,
+    // converting it in chunks so the snapshot is never copied whole
+    static bool writePlainText(const QString &rawText, QIODevice *device);
+};
+
+#endif // NOTEIO_H
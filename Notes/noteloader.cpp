@@ -0,0 +1,42 @@
+#include "noteloader.h"
+
+#include <QFile>
+#include <QTextStream>
+
+NoteLoader::NoteLoader(const QString &fileName, QObject *parent)
+    : QThread(parent), path(fileName), freeChunks(MaxChunksInFlight), cancelled(0) {}
+
+NoteLoader::~NoteLoader() {
+    cancel();
+    wait();
+}
+
+void NoteLoader::chunkConsumed() {
+    freeChunks.release();
+}
+
+void NoteLoader::cancel() {
+    cancelled.storeRelaxed(1);
+    freeChunks.release(); // Wake the reader if it is waiting for room
+}
+
+void NoteLoader::run() {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        emit loadFailed(file.errorString());
+        return;
+    }
+
+    const qint64 total = file.size();
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        freeChunks.acquire();
+        if (cancelled.loadRelaxed()) {
+            emit loadFinished(true);
+            return;
+        }
+        const QString chunk = in.read(ChunkSize);
+        emit chunkLoaded(chunk, file.pos(), total);
+    }
+    emit loadFinished(false);
+}
@@ -0,0 +1,45 @@
+#ifndef NOTELOADER_H
+#define NOTELOADER_H
+
+#include <QAtomicInt>
+#include <QSemaphore>
+#include <QString>
+#include <QThread>
+
+// Reads and decodes a note on a worker thread and hands it to the GUI in
+// chunks. At most a few chunks are in flight at once: the consumer calls
+// chunkConsumed() after inserting each one, so a large file never sits in
+// memory next to the document that is being filled from it.
+class NoteLoader : public QThread {
+    Q_OBJECT
+
+public:
+    // Characters per chunk; keeps every edit block on the GUI thread short
+    static const int ChunkSize = 64 * 1024;
+
+    explicit NoteLoader(const QString &fileName, QObject *parent = nullptr);
+    ~NoteLoader() override;
+
+    QString fileName() const { return path; }
+
+    // Both are safe to call from the GUI thread while the loader is running
+    void chunkConsumed();
+    void cancel();
+
+signals:
+    void chunkLoaded(const QString &text, qint64 bytesRead, qint64 bytesTotal);
+    void loadFailed(const QString &message);
+    void loadFinished(bool cancelled);
+
+protected:
+    void run() override;
+
+private:
+    static const int MaxChunksInFlight = 4;
+
+    QString path;
+    QSemaphore freeChunks;
+    QAtomicInt cancelled;
+};
+
+#endif // NOTELOADER_H
@@ -0,0 +1,49 @@
+#include "notesaver.h"
+
+#include "noteio.h"
+#include "pnoteformat.h"
+
+#include <QSaveFile>
+#include <QTextDocument>
+
+NoteSaver::NoteSaver(const QString &fileName, const QString &rawText, QObject *parent)
+    : QThread(parent), path(fileName), snapshot(rawText) {
+    clock.start();
+}
+
+NoteSaver::NoteSaver(const QString &fileName, QTextDocument *document, QObject *parent)
+    : QThread(parent), path(fileName), documentSnapshot(document) {
+    clock.start();
+}
+
+NoteSaver::~NoteSaver() {
+    wait();
+}
+
+void NoteSaver::run() {
+    QSaveFile file(path);
+    if (!file.open(documentSnapshot ? QIODevice::WriteOnly : QIODevice::WriteOnly | QIODevice::Text)) {
+        emit saveFailed(file.errorString());
+        return;
+    }
+
+    if (documentSnapshot) {
+        const bool written = PNoteFormat::write(documentSnapshot.data(), &file);
+        const qint64 bytesWritten = file.size();
+        if (!written || !file.commit()) {
+            emit saveFailed(file.errorString());
+            return;
+        }
+        emit saved(bytesWritten, clock.elapsed());
+        return;
+    }
+
+    const bool written = NoteIO::writePlainText(snapshot, &file);
+    const qint64 bytesWritten = file.size();
+    // commit() flushes to disk and renames over the old file
+    if (!written || !file.commit()) {
+        emit saveFailed(file.errorString());
+        return;
+    }
+    emit saved(bytesWritten, clock.elapsed());
+}
@@ -0,0 +1,49 @@
+#ifndef NOTESAVER_H
+#define NOTESAVER_H
+
+#include <QElapsedTimer>
+#include <QScopedPointer>
+#include <QString>
+#include <QThread>
+
+class QTextDocument;
+
+// Writes a snapshot of a note on a worker thread. For plain text the GUI
+// only copies the document's raw text (QTextDocument::toRawText()); for a
+// .pnote it hands over a clone of the document. Converting, encoding and
+// writing all happen here. The target file is replaced atomically through
+// QSaveFile, so a crash mid-save keeps the old note.
+class NoteSaver : public QThread {
+    Q_OBJECT
+
+public:
+    NoteSaver(const QString &fileName, const QString &rawText, QObject *parent = nullptr);
+    // Takes ownership of document, which must have no parent and must not be
+    // touched by anyone else; run() only reads it
+    NoteSaver(const QString &fileName, QTextDocument *document, QObject *parent = nullptr);
+    ~NoteSaver() override;
+
+    QString fileName() const { return path; }
+
+    // Whether the document had unsaved changes when the snapshot was taken;
+    // a failed save puts that state back
+    bool documentWasModified() const { return wasModified; }
+    void setDocumentWasModified(bool modified) { wasModified = modified; }
+
+signals:
+    // latencyMs runs from the snapshot to the file being replaced on disk
+    void saved(qint64 bytesWritten, qint64 latencyMs);
+    void saveFailed(const QString &message);
+
+protected:
+    void run() override;
+
+private:
+    QString path;
+    QString snapshot;
+    QScopedPointer<QTextDocument> documentSnapshot;
+    QElapsedTimer clock;
+    bool wasModified = false;
+};
+
+#endif // NOTESAVER_H
@@ -0,0 +1,130 @@
+#include "pagebackground.h"
+
+#include <QPainter>
+#include <QtGlobal>
+
+namespace {
+
+// Lines sit a quarter of the way from the page colour to the text colour:
+// light gray on a white page, dark gray on a black one.
+QColor lineColorFor(const QColor &base, const QColor &text) {
+    const qreal t = 0.25;
+    return QColor::fromRgbF(base.redF() + (text.redF() - base.redF()) * t,
+                            base.greenF() + (text.greenF() - base.greenF()) * t,
+                            base.blueF() + (text.blueF() - base.blueF()) * t);
+}
+
+// Modulo that stays positive for negative scroll offsets.
+int wrap(int value, int period) {
+    const int r = value % period;
+    return r < 0 ? r + period : r;
+}
+
+// Rounds down, also for negative values.
+int floorDiv(int value, int divisor) {
+    return (value - wrap(value, divisor)) / divisor;
+}
+
+// Fewest lines whose total span is a whole number of device pixels at this
+// ratio; 0 if more than a handful would be needed.
+int periodsFor(int spacing, qreal devicePixelRatio) {
+    const int maxPeriods = 16;
+    for (int n = 1; n <= maxPeriods; ++n) {
+        const qreal pixels = n * spacing * devicePixelRatio;
+        if (qAbs(pixels - qRound(pixels)) < 0.001) {
+            return n;
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+PageBackground::PageBackground()
+    : pageStyle(Plain), lineSpacing(20), cachedStyle(Plain), cachedSpacing(0), cachedRatio(0),
+      cachedPeriods(0) {}
+
+void PageBackground::setSpacing(int spacing) {
+    lineSpacing = qMax(2, spacing);
+}
+
+void PageBackground::paint(QPainter *painter, const QRect &exposed, const QPoint &documentOffset,
+                           const QColor &base, const QColor &text, qreal devicePixelRatio) {
+    if (pageStyle == Plain || exposed.isEmpty()) {
+        return;
+    }
+
+    const QColor lineColor = lineColorFor(base, text);
+    const QPixmap &pixmap = tile(lineColor, devicePixelRatio);
+    if (pixmap.isNull()) {
+        paintLines(painter, exposed, documentOffset, lineColor, devicePixelRatio);
+        return;
+    }
+
+    // Pick the tile offset so that the tile grid lines up with multiples of
+    // the spacing in document coordinates, whatever part of the view is exposed.
+    const int period = lineSpacing * cachedPeriods;
+    const QPoint origin(wrap(exposed.left() + documentOffset.x(), period),
+                        wrap(exposed.top() + documentOffset.y(), period));
+    painter->drawTiledPixmap(exposed, pixmap, origin);
+}
+
+void PageBackground::paintLines(QPainter *painter, const QRect &exposed, const QPoint &documentOffset,
+                                const QColor &lineColor, qreal devicePixelRatio) const {
+    // Each line from its own document position, snapped to a device pixel.
+    const qreal width = 1.0;
+    const auto snap = [devicePixelRatio](int logical) {
+        return qRound(logical * devicePixelRatio) / devicePixelRatio;
+    };
+    for (int k = floorDiv(exposed.top() + documentOffset.y(), lineSpacing);
+         k * lineSpacing - documentOffset.y() <= exposed.bottom(); ++k) {
+        const qreal y = snap(k * lineSpacing - documentOffset.y());
+        painter->fillRect(QRectF(exposed.left(), y, exposed.width(), width), lineColor);
+    }
+    if (pageStyle == Grid) {
+        for (int k = floorDiv(exposed.left() + documentOffset.x(), lineSpacing);
+             k * lineSpacing - documentOffset.x() <= exposed.right(); ++k) {
+            const qreal x = snap(k * lineSpacing - documentOffset.x());
+            painter->fillRect(QRectF(x, exposed.top(), width, exposed.height()), lineColor);
+        }
+    }
+}
+
+const QPixmap &PageBackground::tile(const QColor &lineColor, qreal devicePixelRatio) {
+    if (!cachedTile.isNull() && cachedStyle == pageStyle && cachedSpacing == lineSpacing
+        && cachedColor == lineColor && qFuzzyCompare(cachedRatio, devicePixelRatio)) {
+        return cachedTile;
+    }
+
+    cachedStyle = pageStyle;
+    cachedSpacing = lineSpacing;
+    cachedColor = lineColor;
+    cachedRatio = devicePixelRatio;
+    cachedPeriods = periodsFor(lineSpacing, devicePixelRatio);
+    if (cachedPeriods == 0) {
+        cachedTile = QPixmap();
+        return cachedTile;
+    }
+
+    // The side is exact, so the tile repeats at the logical spacing.
+    const int period = lineSpacing * cachedPeriods;
+    const int side = qRound(period * devicePixelRatio);
+    cachedTile = QPixmap(side, side);
+    cachedTile.setDevicePixelRatio(devicePixelRatio);
+    cachedTile.fill(Qt::transparent);
+
+    // Every line snapped to a device pixel on its own; fillRect keeps them
+    // crisp at any ratio.
+    QPainter painter(&cachedTile);
+    const qreal logicalSide = period;
+    const qreal width = 1.0;
+    for (int k = 0; k < cachedPeriods; ++k) {
+        const qreal at = qRound(k * lineSpacing * devicePixelRatio) / devicePixelRatio;
+        painter.fillRect(QRectF(0, at, logicalSide, width), lineColor); // Horizontal line
+        if (pageStyle == Grid) {
+            painter.fillRect(QRectF(at, 0, width, logicalSide), lineColor); // Vertical line
+        }
+    }
+    painter.end();
+    return cachedTile;
+}
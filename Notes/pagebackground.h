@@ -0,0 +1,52 @@
+#ifndef PAGEBACKGROUND_H
+#define PAGEBACKGROUND_H
+
+#include <QColor>
+#include <QPixmap>
+#include <QPoint>
+#include <QRect>
+
+class QPainter;
+
+// Ruled/grid page background for a scrolling text view.
+// Lines are anchored to document coordinates, so they move with the text,
+// and are blitted from a cached tile that is rebuilt only when the spacing,
+// the palette or the device pixel ratio changes. At a fractional ratio the
+// tile spans as many lines as it takes to be a whole number of device
+// pixels, so it repeats at exactly the spacing; ratios where no short span
+// does are drawn line by line.
+class PageBackground {
+public:
+    enum Style { Plain, Ruled, Grid };
+
+    PageBackground();
+
+    Style style() const { return pageStyle; }
+    void setStyle(Style style) { pageStyle = style; }
+
+    int spacing() const { return lineSpacing; }
+    void setSpacing(int spacing);
+
+    // Paints the exposed part of a viewport whose top-left corner shows the
+    // document point documentOffset (usually the scroll bar values).
+    void paint(QPainter *painter, const QRect &exposed, const QPoint &documentOffset,
+               const QColor &base, const QColor &text, qreal devicePixelRatio);
+
+private:
+    const QPixmap &tile(const QColor &lineColor, qreal devicePixelRatio);
+    void paintLines(QPainter *painter, const QRect &exposed, const QPoint &documentOffset,
+                    const QColor &lineColor, qreal devicePixelRatio) const;
+
+    Style pageStyle;
+    int lineSpacing;
+
+    // Cache key and cached tile
+    QPixmap cachedTile;
+    Style cachedStyle;
+    int cachedSpacing;
+    QColor cachedColor;
+    qreal cachedRatio;
+    int cachedPeriods; // lines per tile side; 0 when no tile fits the ratio
+};
+
+#endif // PAGEBACKGROUND_H
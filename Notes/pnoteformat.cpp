@@ -0,0 +1,530 @@
+#include "pnoteformat.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QIODevice>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QTextFrame>
+#include <QTextList>
+#include <QTextTable>
+#include <QVector>
+#include <QtEndian>
+
+namespace {
+
+const quint32 Magic = 0x544f4e50; // "PNOT"
+const quint32 Version = 1;
+const int HeaderSize = 16;
+const int DirectoryEntrySize = 24;
+
+enum SectionType : quint32 {
+    FormatSection = 1,
+    BlockSection = 2,
+    TextSection = 3,
+    StructureSection = 4,
+    SectionCount = 4,
+};
+
+// Record sizes in u32 fields
+const int BlockFields = 5;    // block format, char format, first fragment, fragment count, list + 1
+const int FragmentFields = 3; // char format, text offset, length
+const int TableFields = 7;    // format, rows, columns, first block, block count, first cell, cell count
+const int CellFields = 7;     // row, column, row span, column span, format, first block, block count
+
+void putU32(QByteArray &out, quint32 value) {
+    const quint32 le = qToLittleEndian(value);
+    out.append(reinterpret_cast<const char *>(&le), sizeof(le));
+}
+
+void putU64(QByteArray &out, quint64 value) {
+    const quint64 le = qToLittleEndian(value);
+    out.append(reinterpret_cast<const char *>(&le), sizeof(le));
+}
+
+void padTo(QByteArray &out, int alignment) {
+    const qsizetype size = out.size();
+    out.append((alignment - size % alignment) % alignment, '\0');
+}
+
+quint32 u32At(const uchar *p) {
+    return qFromLittleEndian<quint32>(p);
+}
+
+quint64 u64At(const uchar *p) {
+    return qFromLittleEndian<quint64>(p);
+}
+
+// Walks the frame tree once and flattens it into the record arrays.
+class Serializer {
+public:
+    explicit Serializer(const QTextDocument *document) : document(document) {}
+
+    QByteArray toByteArray() {
+        addFlow(document->rootFrame()->begin());
+
+        QByteArray sections[SectionCount];
+        writeFormats(sections[FormatSection - 1]);
+        writeBlocks(sections[BlockSection - 1]);
+        writeText(sections[TextSection - 1]);
+        writeStructure(sections[StructureSection - 1]);
+
+        QByteArray out;
+        putU32(out, Magic);
+        putU32(out, Version);
+        putU32(out, SectionCount);
+        putU32(out, 0);
+        quint64 offset = HeaderSize + SectionCount * DirectoryEntrySize;
+        for (int i = 0; i < SectionCount; ++i) {
+            putU32(out, quint32(i + 1));
+            putU32(out, 0);
+            putU64(out, offset);
+            putU64(out, quint64(sections[i].size()));
+            offset += (sections[i].size() + 7) & ~qsizetype(7);
+        }
+        for (const QByteArray &section : sections) {
+            out.append(section);
+            padTo(out, 8);
+        }
+        return out;
+    }
+
+private:
+    void addFlow(QTextFrame::iterator it) {
+        for (; !it.atEnd(); ++it) {
+            if (QTextFrame *frame = it.currentFrame()) {
+                if (QTextTable *table = qobject_cast<QTextTable *>(frame)) {
+                    addTable(table);
+                } else {
+                    addFlow(frame->begin()); // Other frames are flattened
+                }
+            } else {
+                addBlock(it.currentBlock());
+            }
+        }
+    }
+
+    void addBlock(const QTextBlock &block) {
+        blocks.append(quint32(block.blockFormatIndex()));
+        blocks.append(quint32(block.charFormatIndex()));
+        blocks.append(quint32(fragments.size() / FragmentFields));
+        const qsizetype first = fragments.size();
+        for (QTextBlock::iterator it = block.begin(); !it.atEnd(); ++it) {
+            const QTextFragment fragment = it.fragment();
+            fragments.append(quint32(fragment.charFormatIndex()));
+            fragments.append(quint32(text.size()));
+            fragments.append(quint32(fragment.length()));
+            text += fragment.text();
+        }
+        blocks.append(quint32((fragments.size() - first) / FragmentFields));
+
+        quint32 list = 0;
+        if (QTextList *textList = block.textList()) {
+            list = listIds.value(textList);
+            if (list == 0) {
+                listFormats.append(quint32(textList->formatIndex()));
+                list = quint32(listFormats.size());
+                listIds.insert(textList, list);
+            }
+        }
+        blocks.append(list);
+    }
+
+    void addTable(QTextTable *table) {
+        // Tables are stored in pre-order, so a reader meets an outer table
+        // before the tables nested in its cells
+        const qsizetype record = tables.size();
+        tables.resize(record + TableFields);
+        const quint32 firstBlock = quint32(blocks.size() / BlockFields);
+
+        QVector<quint32> ownCells;
+        for (int row = 0; row < table->rows(); ++row) {
+            for (int column = 0; column < table->columns(); ++column) {
+                const QTextTableCell cell = table->cellAt(row, column);
+                if (cell.row() != row || cell.column() != column) {
+                    continue; // Covered by a merged cell
+                }
+                const quint32 cellFirstBlock = quint32(blocks.size() / BlockFields);
+                addFlow(cell.begin());
+                ownCells << quint32(row) << quint32(column) << quint32(cell.rowSpan()) << quint32(cell.columnSpan())
+                         << quint32(cell.tableCellFormatIndex()) << cellFirstBlock
+                         << quint32(blocks.size() / BlockFields) - cellFirstBlock;
+            }
+        }
+
+        tables[record + 0] = quint32(table->formatIndex());
+        tables[record + 1] = quint32(table->rows());
+        tables[record + 2] = quint32(table->columns());
+        tables[record + 3] = firstBlock;
+        tables[record + 4] = quint32(blocks.size() / BlockFields) - firstBlock;
+        tables[record + 5] = quint32(cells.size() / CellFields);
+        tables[record + 6] = quint32(ownCells.size() / CellFields);
+        cells += ownCells;
+    }
+
+    void writeFormats(QByteArray &out) const {
+        const QVector<QTextFormat> formats = document->allFormats();
+        QByteArray entries;
+        putU32(out, quint32(formats.size()));
+        const qsizetype tableSize = 4 + formats.size() * 4;
+        for (QTextFormat format : formats) {
+            putU32(out, quint32(tableSize + entries.size()));
+            format.setObjectIndex(-1); // Only meaningful inside the writing document
+            QByteArray bytes;
+            QDataStream stream(&bytes, QIODevice::WriteOnly);
+            stream.setVersion(QDataStream::Qt_5_15);
+            stream << format;
+            putU32(entries, quint32(bytes.size()));
+            entries.append(bytes);
+            padTo(entries, 4);
+        }
+        out.append(entries);
+    }
+
+    void writeBlocks(QByteArray &out) const {
+        putU32(out, quint32(blocks.size() / BlockFields));
+        putU32(out, quint32(fragments.size() / FragmentFields));
+        for (quint32 v : blocks) {
+            putU32(out, v);
+        }
+        for (quint32 v : fragments) {
+            putU32(out, v);
+        }
+    }
+
+    void writeText(QByteArray &out) const {
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+        out.append(reinterpret_cast<const char *>(text.utf16()), text.size() * 2);
+#else
+        for (const QChar c : text) {
+            const quint16 le = qToLittleEndian(c.unicode());
+            out.append(reinterpret_cast<const char *>(&le), sizeof(le));
+        }
+#endif
+    }
+
+    void writeStructure(QByteArray &out) const {
+        putU32(out, quint32(listFormats.size()));
+        putU32(out, quint32(tables.size() / TableFields));
+        putU32(out, quint32(cells.size() / CellFields));
+        putU32(out, 0);
+        for (const QVector<quint32> *array : {&listFormats, &tables, &cells}) {
+            for (quint32 v : *array) {
+                putU32(out, v);
+            }
+        }
+    }
+
+    const QTextDocument *document;
+    QVector<quint32> blocks;
+    QVector<quint32> fragments;
+    QVector<quint32> listFormats;
+    QVector<quint32> tables;
+    QVector<quint32> cells;
+    QHash<QTextList *, quint32> listIds;
+    QString text;
+};
+
+// Reads the record arrays in place and rebuilds the document from them.
+class Deserializer {
+public:
+    Deserializer(const uchar *data, qint64 size) : data(data), size(size) {}
+
+    bool parse(QString *error) {
+        auto fail = [error](const char *message) {
+            if (error) {
+                *error = QString::fromLatin1(message);
+            }
+            return false;
+        };
+
+        if (size < HeaderSize || u32At(data) != Magic) {
+            return fail("Not a pnote file");
+        }
+        if (u32At(data + 4) != Version) {
+            return fail("Unsupported pnote version");
+        }
+        const quint32 sectionCount = u32At(data + 8);
+        if (HeaderSize + qint64(sectionCount) * DirectoryEntrySize > size) {
+            return fail("Truncated pnote file");
+        }
+
+        const uchar *sections[SectionCount] = {};
+        quint64 sectionSizes[SectionCount] = {};
+        for (quint32 i = 0; i < sectionCount; ++i) {
+            const uchar *entry = data + HeaderSize + i * DirectoryEntrySize;
+            const quint32 type = u32At(entry);
+            const quint64 offset = u64At(entry + 8);
+            const quint64 length = u64At(entry + 16);
+            if (offset > quint64(size) || length > quint64(size) - offset || offset % 8 != 0) {
+                return fail("Corrupt pnote section table");
+            }
+            if (type >= 1 && type <= SectionCount) {
+                sections[type - 1] = data + offset;
+                sectionSizes[type - 1] = length;
+            }
+        }
+        // Every section but the text starts with its counts
+        if (!sections[FormatSection - 1] || !sections[BlockSection - 1] || !sections[TextSection - 1]
+            || !sections[StructureSection - 1] || sectionSizes[FormatSection - 1] < 4
+            || sectionSizes[BlockSection - 1] < 8 || sectionSizes[StructureSection - 1] < 16) {
+            return fail("Missing pnote section");
+        }
+
+        // Formats
+        const uchar *formatSection = sections[FormatSection - 1];
+        const quint64 formatSize = sectionSizes[FormatSection - 1];
+        const quint32 formatCount = u32At(formatSection);
+        if (4 + quint64(formatCount) * 4 > formatSize) {
+            return fail("Corrupt pnote format table");
+        }
+        formats.resize(formatCount);
+        for (quint32 i = 0; i < formatCount; ++i) {
+            const quint64 at = u32At(formatSection + 4 + i * 4);
+            if (at + 4 > formatSize || u32At(formatSection + at) > formatSize - at - 4) {
+                return fail("Corrupt pnote format entry");
+            }
+            const QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char *>(formatSection + at + 4),
+                                                             int(u32At(formatSection + at)));
+            QDataStream stream(bytes);
+            stream.setVersion(QDataStream::Qt_5_15);
+            stream >> formats[i];
+        }
+
+        // Blocks and fragments
+        const uchar *blockSection = sections[BlockSection - 1];
+        blockCount = u32At(blockSection);
+        fragmentCount = u32At(blockSection + 4);
+        if (8 + (quint64(blockCount) * BlockFields + quint64(fragmentCount) * FragmentFields) * 4
+            > sectionSizes[BlockSection - 1]) {
+            return fail("Corrupt pnote block section");
+        }
+        blocks = blockSection + 8;
+        fragments = blocks + blockCount * BlockFields * 4;
+
+        text = sections[TextSection - 1];
+        textLength = sectionSizes[TextSection - 1] / 2;
+
+        // Structure
+        const uchar *structure = sections[StructureSection - 1];
+        listCount = u32At(structure);
+        tableCount = u32At(structure + 4);
+        cellCount = u32At(structure + 8);
+        if (16 + (quint64(listCount) + quint64(tableCount) * TableFields + quint64(cellCount) * CellFields) * 4
+            > sectionSizes[StructureSection - 1]) {
+            return fail("Corrupt pnote structure section");
+        }
+        listFormats = structure + 16;
+        tables = listFormats + listCount * 4;
+        cells = tables + tableCount * TableFields * 4;
+
+        return validate() || fail("Corrupt pnote records");
+    }
+
+    void build(QTextDocument *document) {
+        document->clear();
+        lists = QVector<QTextList *>(int(listCount), nullptr);
+        nextTable = 0;
+
+        QTextCursor cursor(document);
+        cursor.beginEditBlock();
+        fillFlow(cursor, 0, blockCount);
+        cursor.endEditBlock();
+    }
+
+private:
+    quint32 field(const uchar *records, quint32 index, int fields, int field) const {
+        return u32At(records + (quint64(index) * fields + field) * 4);
+    }
+
+    QTextFormat formatAt(quint32 index) const {
+        return formats.value(int(index));
+    }
+
+    // Checks every index the builder will follow, so build() never reads
+    // outside the mapping whatever the file contains.
+    bool validate() const {
+        for (quint32 i = 0; i < blockCount; ++i) {
+            const quint64 first = field(blocks, i, BlockFields, 2);
+            const quint64 count = field(blocks, i, BlockFields, 3);
+            if (first + count > fragmentCount || field(blocks, i, BlockFields, 4) > listCount) {
+                return false;
+            }
+        }
+        for (quint32 i = 0; i < fragmentCount; ++i) {
+            const quint64 offset = field(fragments, i, FragmentFields, 1);
+            const quint64 length = field(fragments, i, FragmentFields, 2);
+            if (offset + length > textLength) {
+                return false;
+            }
+        }
+        for (quint32 i = 0; i < tableCount; ++i) {
+            const quint64 rows = field(tables, i, TableFields, 1);
+            const quint64 columns = field(tables, i, TableFields, 2);
+            if (rows == 0 || columns == 0 || rows * columns > 1000000
+                || quint64(field(tables, i, TableFields, 3)) + field(tables, i, TableFields, 4) > blockCount
+                || quint64(field(tables, i, TableFields, 5)) + field(tables, i, TableFields, 6) > cellCount) {
+                return false;
+            }
+            for (quint32 c = 0; c < field(tables, i, TableFields, 6); ++c) {
+                const quint32 cell = field(tables, i, TableFields, 5) + c;
+                const quint64 row = field(cells, cell, CellFields, 0);
+                const quint64 column = field(cells, cell, CellFields, 1);
+                if (row + qMax<quint32>(1, field(cells, cell, CellFields, 2)) > rows
+                    || column + qMax<quint32>(1, field(cells, cell, CellFields, 3)) > columns
+                    || quint64(field(cells, cell, CellFields, 5)) + field(cells, cell, CellFields, 6) > blockCount) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    QString textAt(quint32 offset, quint32 length) const {
+        const uchar *p = text + quint64(offset) * 2;
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+        return QString::fromRawData(reinterpret_cast<const QChar *>(p), int(length));
+#else
+        QString result(int(length), Qt::Uninitialized);
+        for (quint32 i = 0; i < length; ++i) {
+            result[int(i)] = QChar(qFromLittleEndian<quint16>(p + 2 * i));
+        }
+        return result;
+#endif
+    }
+
+    // A flow is the content of the root frame or of a table cell. The cursor
+    // starts in an empty block that already exists; so does the block Qt
+    // puts after every table.
+    void fillFlow(QTextCursor &cursor, quint32 begin, quint32 end) {
+        bool reuseBlock = true;
+        quint32 i = begin;
+        while (i < end) {
+            if (nextTable < tableCount && field(tables, nextTable, TableFields, 3) == i) {
+                const quint32 table = nextTable++;
+                fillTable(cursor, table);
+                i += qMax<quint32>(1, field(tables, table, TableFields, 4));
+                reuseBlock = true;
+                continue;
+            }
+            fillBlock(cursor, i++, reuseBlock);
+            reuseBlock = false;
+        }
+    }
+
+    void fillBlock(QTextCursor &cursor, quint32 index, bool reuseBlock) {
+        const QTextBlockFormat blockFormat = formatAt(field(blocks, index, BlockFields, 0)).toBlockFormat();
+        const QTextCharFormat charFormat = formatAt(field(blocks, index, BlockFields, 1)).toCharFormat();
+        if (reuseBlock) {
+            cursor.setBlockFormat(blockFormat);
+            cursor.setBlockCharFormat(charFormat);
+        } else {
+            cursor.insertBlock(blockFormat, charFormat);
+        }
+
+        const quint32 first = field(blocks, index, BlockFields, 2);
+        const quint32 count = field(blocks, index, BlockFields, 3);
+        for (quint32 f = first; f < first + count; ++f) {
+            cursor.insertText(textAt(field(fragments, f, FragmentFields, 1), field(fragments, f, FragmentFields, 2)),
+                              formatAt(field(fragments, f, FragmentFields, 0)).toCharFormat());
+        }
+
+        const quint32 list = field(blocks, index, BlockFields, 4);
+        if (list > 0) {
+            QTextList *&textList = lists[int(list - 1)];
+            if (!textList) {
+                textList = cursor.createList(formatAt(u32At(listFormats + (list - 1) * 4)).toListFormat());
+            } else {
+                textList->add(cursor.block());
+            }
+        }
+    }
+
+    void fillTable(QTextCursor &cursor, quint32 index) {
+        QTextTable *table = cursor.insertTable(int(field(tables, index, TableFields, 1)),
+                                               int(field(tables, index, TableFields, 2)),
+                                               formatAt(field(tables, index, TableFields, 0)).toTableFormat());
+        const quint32 firstCell = field(tables, index, TableFields, 5);
+        const quint32 cellCount = field(tables, index, TableFields, 6);
+        for (quint32 c = firstCell; c < firstCell + cellCount; ++c) {
+            const int rowSpan = int(field(cells, c, CellFields, 2));
+            const int columnSpan = int(field(cells, c, CellFields, 3));
+            if (rowSpan > 1 || columnSpan > 1) {
+                table->mergeCells(int(field(cells, c, CellFields, 0)), int(field(cells, c, CellFields, 1)), rowSpan, columnSpan);
+            }
+        }
+        for (quint32 c = firstCell; c < firstCell + cellCount; ++c) {
+            QTextTableCell cell = table->cellAt(int(field(cells, c, CellFields, 0)), int(field(cells, c, CellFields, 1)));
+            cell.setFormat(formatAt(field(cells, c, CellFields, 4)).toCharFormat());
+            QTextCursor cellCursor = cell.firstCursorPosition();
+            const quint32 first = field(cells, c, CellFields, 5);
+            fillFlow(cellCursor, first, first + field(cells, c, CellFields, 6));
+        }
+        cursor.setPosition(table->lastPosition() + 1);
+    }
+
+    const uchar *data;
+    qint64 size;
+
+    QVector<QTextFormat> formats;
+    const uchar *blocks = nullptr;
+    const uchar *fragments = nullptr;
+    const uchar *text = nullptr;
+    const uchar *listFormats = nullptr;
+    const uchar *tables = nullptr;
+    const uchar *cells = nullptr;
+    quint32 blockCount = 0;
+    quint32 fragmentCount = 0;
+    quint64 textLength = 0;
+    quint32 listCount = 0;
+    quint32 tableCount = 0;
+    quint32 cellCount = 0;
+
+    QVector<QTextList *> lists;
+    quint32 nextTable = 0;
+};
+
+} // namespace
+
+QByteArray PNoteFormat::serialize(const QTextDocument *document) {
+    return Serializer(document).toByteArray();
+}
+
+bool PNoteFormat::write(const QTextDocument *document, QIODevice *device) {
+    const QByteArray bytes = serialize(document);
+    return device->write(bytes) == bytes.size();
+}
+
+bool PNoteFormat::read(const uchar *data, qint64 size, QTextDocument *document, QString *error) {
+    Deserializer reader(data, size);
+    if (!reader.parse(error)) {
+        return false;
+    }
+    reader.build(document);
+    return true;
+}
+
+bool PNoteFormat::load(const QString &fileName, QTextDocument *document, QString *error) {
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+    const uchar *data = file.map(0, file.size());
+    if (!data) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+    return read(data, file.size(), document, error);
+}
+
+bool PNoteFormat::isPNote(const QString &fileName) {
+    return QFileInfo(fileName).suffix().compare(QLatin1String(suffix()), Qt::CaseInsensitive) == 0;
+}
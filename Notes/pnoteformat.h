@@ -0,0 +1,41 @@
+#ifndef PNOTEFORMAT_H
+#define PNOTEFORMAT_H
+
+#include <QByteArray>
+#include <QString>
+
+class QIODevice;
+class QTextDocument;
+
+// Native note format (.pnote). Unlike the plain text files it keeps bold,
+// italic, colours, fonts, lists and tables, and it is laid out to be read
+// straight out of a memory mapping:
+//
+//   header     "PNOT", version, section count, flags
+//   directory  per section: type, reserved, u64 offset, u64 size
+//   formats    the document's deduplicated format table; each entry is a
+//              length-prefixed QDataStream-serialized QTextFormat
+//   blocks     block records (block format, char format, fragment range,
+//              list) followed by fragment records (char format, text range)
+//   text       UTF-16LE text of all fragments
+//   structure  list formats, tables (format, size, block and cell ranges)
+//              and cells (position, span, format, block range)
+//
+// All integers are little-endian u32 unless noted, sections start on an
+// 8-byte boundary and records are fixed size, so nothing is parsed twice.
+class PNoteFormat {
+public:
+    static const char *suffix() { return "pnote"; }
+
+    static QByteArray serialize(const QTextDocument *document);
+    static bool write(const QTextDocument *document, QIODevice *device);
+
+    // Replaces the content of document with the note in data
+    static bool read(const uchar *data, qint64 size, QTextDocument *document, QString *error = nullptr);
+    // Maps fileName and reads it in place
+    static bool load(const QString &fileName, QTextDocument *document, QString *error = nullptr);
+
+    static bool isPNote(const QString &fileName);
+};
+
+#endif // PNOTEFORMAT_H
@@ -0,0 +1,43 @@
+#include "recognizerfeed.h"
+
+#include "transcriptingestor.h"
+
+RecognizerFeed::RecognizerFeed(pen::Recognizer *recognizer, TranscriptIngestor *ingestor)
+    : recognizer(recognizer), ingestor(ingestor), offsetMs(0) {}
+
+void RecognizerFeed::feed(const qint16 *samples, int count) {
+    if (recognizer->acceptPcm(samples, size_t(count))) {
+        deliverFinal();
+        return;
+    }
+    // The engine may return the same guess for many chunks in a row
+    const std::string partial = recognizer->partial();
+    if (partial != lastPartial) {
+        lastPartial = partial;
+        ingestor->setPartial(QString::fromStdString(partial));
+    }
+}
+
+void RecognizerFeed::finish() {
+    if (recognizer->finish()) {
+        deliverFinal();
+    } else if (!lastPartial.empty()) {
+        lastPartial.clear();
+        ingestor->setPartial(QString());
+    }
+}
+
+void RecognizerFeed::deliverFinal() {
+    if (!recognizer->takeFinal(&result)) {
+        return;
+    }
+    QVector<TranscriptWord> words;
+    words.reserve(int(result.words.size()));
+    for (const pen::RecognizedWord &word : result.words) {
+        words.append({ QString::fromStdString(word.text), offsetMs + word.startMs, offsetMs + word.endMs,
+                       word.confidence });
+    }
+    // Also clears the hypothesis the final came from
+    ingestor->appendWords(words);
+    lastPartial.clear();
+}
@@ -0,0 +1,41 @@
+#ifndef RECOGNIZERFEED_H
+#define RECOGNIZERFEED_H
+
+#include <QtGlobal>
+
+#include <string>
+
+#include "pen/recognizer.h"
+
+class TranscriptIngestor;
+
+// Runs audio through any pen::Recognizer and hands the results to a
+// TranscriptIngestor: finals as timed words, the partial as the overlay
+// hypothesis. Knows nothing about the engine behind the interface.
+//
+// feed() and finish() belong to one thread, normally the audio thread;
+// the ingestor takes care of getting the text to the GUI thread.
+class RecognizerFeed {
+public:
+    RecognizerFeed(pen::Recognizer *recognizer, TranscriptIngestor *ingestor);
+
+    // Where the recognizer's time zero lies in the note's recording, for
+    // a recognizer started part-way through
+    void setTimeOffset(qint64 ms) { offsetMs = ms; }
+
+    // Mono, at recognizer->sampleRate()
+    void feed(const qint16 *samples, int count);
+    // End of the recording: the last utterance goes in as final
+    void finish();
+
+private:
+    void deliverFinal();
+
+    pen::Recognizer *recognizer;
+    TranscriptIngestor *ingestor;
+    qint64 offsetMs;
+    pen::RecognitionResult result; // Reused between finals
+    std::string lastPartial;
+};
+
+#endif // RECOGNIZERFEED_H
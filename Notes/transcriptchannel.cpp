@@ -0,0 +1,145 @@
+#include "transcriptchannel.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSocketNotifier>
+#include <QStandardPaths>
+
+TranscriptChannel::TranscriptChannel(TranscriptIngestor *ingestor, QObject *parent)
+    : QObject(parent),
+      ingestor(ingestor),
+      wakeNotifier(nullptr),
+      closeNotifier(nullptr),
+      wantedStream(-1),
+      followedStream(-1),
+      partialChanged(false),
+      records(0),
+      wakes(0) {
+    frameTimer.setSingleShot(true);
+    frameTimer.setInterval(TranscriptIngestor::FrameInterval);
+    connect(&frameTimer, &QTimer::timeout, this, &TranscriptChannel::readFrame);
+}
+
+TranscriptChannel::~TranscriptChannel() {
+    disconnectFromDaemon();
+}
+
+QString TranscriptChannel::defaultSocketPath() {
+    QString directory = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (directory.isEmpty()) {
+        directory = QDir::tempPath();
+    }
+    return directory + "/pen-transcript.sock";
+}
+
+bool TranscriptChannel::connectTo(const QString &path, QString *error) {
+    disconnectFromDaemon();
+    std::string message;
+    if (!reader.connect(QFile::encodeName(path).toStdString(), &message)) {
+        if (error) {
+            *error = QString::fromStdString(message);
+        }
+        return false;
+    }
+    followedStream = wantedStream;
+    wakeNotifier = new QSocketNotifier(reader.wakeFd(), QSocketNotifier::Read, this);
+    connect(wakeNotifier, &QSocketNotifier::activated, this, &TranscriptChannel::wake);
+    closeNotifier = new QSocketNotifier(reader.socketFd(), QSocketNotifier::Read, this);
+    connect(closeNotifier, &QSocketNotifier::activated, this, &TranscriptChannel::daemonClosed);
+    readFrame();
+    return true;
+}
+
+void TranscriptChannel::disconnectFromDaemon() {
+    if (!reader.isOpen()) {
+        return;
+    }
+    // The notifiers go before the descriptors they watch
+    delete wakeNotifier;
+    wakeNotifier = nullptr;
+    delete closeNotifier;
+    closeNotifier = nullptr;
+    frameTimer.stop();
+    reader.close();
+    finalWords.clear();
+    if (!partialWords.isEmpty()) {
+        partialWords.clear();
+        ingestor->setPartial(QString());
+    }
+}
+
+void TranscriptChannel::wake() {
+    reader.acknowledge();
+    wakeNotifier->setEnabled(false);
+    ++wakes;
+    drain();
+    frameTimer.start();
+}
+
+// Reads once a frame while records keep coming, then goes back to sleep
+void TranscriptChannel::readFrame() {
+    if (drain() > 0) {
+        frameTimer.start();
+    } else {
+        sleepUntilNextRecord();
+    }
+}
+
+void TranscriptChannel::sleepUntilNextRecord() {
+    if (reader.arm()) {
+        wakeNotifier->setEnabled(true);
+    } else {
+        frameTimer.start(); // Came in meanwhile
+    }
+}
+
+void TranscriptChannel::daemonClosed() {
+    drain();
+    disconnectFromDaemon();
+    emit disconnected();
+}
+
+int TranscriptChannel::drain() {
+    const size_t count = reader.drain([this](const pen::TranscriptRecord &record) { take(record); });
+    records += qint64(count);
+    // Only the newest hypothesis of the frame matters
+    if (partialChanged) {
+        partialChanged = false;
+        ingestor->setPartial(partialWords.join(QLatin1Char(' ')));
+    }
+    return int(count);
+}
+
+void TranscriptChannel::take(const pen::TranscriptRecord &record) {
+    if (followedStream < 0) {
+        followedStream = int(record.stream);
+    }
+    if (record.stream != uint32_t(followedStream)) {
+        return;
+    }
+    const int length = qMin(int(record.length), int(pen::TranscriptRecord::TextCapacity));
+    if (record.kind == pen::TranscriptRecord::Final) {
+        if (record.flags & pen::TranscriptRecord::First) {
+            finalWords.clear();
+        }
+        if (length > 0) {
+            finalWords.append({ QString::fromUtf8(record.text, length), record.startMs, record.endMs,
+                                record.confidence });
+        }
+        if (record.flags & pen::TranscriptRecord::Last) {
+            // Also clears the hypothesis the final came from
+            ingestor->appendWords(finalWords);
+            finalWords.clear();
+            partialWords.clear();
+            partialChanged = false;
+        }
+    } else if (record.kind == pen::TranscriptRecord::Partial) {
+        if (record.flags & pen::TranscriptRecord::First) {
+            partialWords.clear();
+        }
+        if (length > 0) {
+            partialWords.append(QString::fromUtf8(record.text, length));
+        }
+        partialChanged = true;
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef TRANSCRIPTCHANNEL_H
+#define TRANSCRIPTCHANNEL_H
+
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+
+#include "pen/transcriptring.h"
+#include "transcriptingestor.h"
+
+class QSocketNotifier;
+
+// Live transcript from pen-receiverd --publish through its shared-memory
+// ring (Linux only). Records are read in place; a word's text is copied
+// once, from the ring into the QString handed to the ingestor. The eventfd
+// wakes the GUI thread at most once per frame: after a wakeup the ring is
+// read on the frame timer until it stays empty for a frame.
+class TranscriptChannel : public QObject {
+    Q_OBJECT
+
+public:
+    explicit TranscriptChannel(TranscriptIngestor *ingestor, QObject *parent = nullptr);
+    ~TranscriptChannel() override;
+
+    // Where pen-receiverd is told to publish by default
+    static QString defaultSocketPath();
+
+    bool connectTo(const QString &path, QString *error = nullptr);
+    void disconnectFromDaemon();
+    bool isConnected() const { return reader.isOpen(); }
+
+    // Only this pen's words go into the note. With -1, the default, the
+    // note follows the first stream heard after connecting: words of
+    // several pens interleaved would make no sense, and their partials
+    // would overwrite each other.
+    void setStream(int stream) { wantedStream = stream; }
+
+    qint64 recordsRead() const { return records; }
+    qint64 wakeups() const { return wakes; }
+    quint64 droppedByDaemon() const { return reader.dropped(); }
+
+signals:
+    // The daemon went away
+    void disconnected();
+
+private slots:
+    void wake();
+    void readFrame();
+    void daemonClosed();
+
+private:
+    int drain();
+    void take(const pen::TranscriptRecord &record);
+    void sleepUntilNextRecord();
+
+    TranscriptIngestor *ingestor;
+    pen::TranscriptRingReader reader;
+    QSocketNotifier *wakeNotifier;
+    QSocketNotifier *closeNotifier;
+    QTimer frameTimer;
+    int wantedStream;
+    int followedStream; // wantedStream, or the first one heard
+
+    QVector<TranscriptWord> finalWords; // Of the run being read
+    QStringList partialWords;
+    bool partialChanged;
+    qint64 records;
+    qint64 wakes;
+};
+
+#endif // TRANSCRIPTCHANNEL_H
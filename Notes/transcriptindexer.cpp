@@ -0,0 +1,59 @@
+#include "transcriptindexer.h"
+
+#include <cstring>
+
+namespace {
+
+// Bytes scanned between progress reports and cancellation checks
+const qint64 SliceSize = 16 * 1024 * 1024;
+
+} // namespace
+
+TranscriptIndexer::TranscriptIndexer(const uchar *data, qint64 size, QObject *parent)
+    : QThread(parent), data(data), size(size), cancelled(0) {}
+
+TranscriptIndexer::~TranscriptIndexer() {
+    cancel();
+    wait();
+}
+
+void TranscriptIndexer::cancel() {
+    cancelled.storeRelaxed(1);
+}
+
+void TranscriptIndexer::run() {
+    QVector<qint64> found;
+    found.append(0); // Line 0
+    qint64 lines = 0;
+    qint64 at = 0;
+    while (at < size) {
+        if (cancelled.loadRelaxed()) {
+            return;
+        }
+
+        const qint64 sliceEnd = qMin(size, at + SliceSize);
+        while (at < sliceEnd) {
+            const void *newline = std::memchr(data + at, '\n', size_t(sliceEnd - at));
+            if (!newline) {
+                at = sliceEnd;
+                break;
+            }
+            at = static_cast<const uchar *>(newline) - data + 1;
+            if (++lines % CheckpointInterval == 0) {
+                found.append(at);
+            }
+        }
+
+        if (!found.isEmpty()) {
+            emit checkpointsFound(found);
+            found.clear();
+        }
+        emit progress(at, size, lines);
+    }
+
+    // A last line without a newline still counts
+    if (size > 0 && data[size - 1] != '\n') {
+        ++lines;
+    }
+    emit indexFinished(lines);
+}
@@ -0,0 +1,39 @@
+#ifndef TRANSCRIPTINDEXER_H
+#define TRANSCRIPTINDEXER_H
+
+#include <QAtomicInt>
+#include <QThread>
+#include <QVector>
+
+// Counts the lines of a mapped transcript on a worker thread. Only every
+// CheckpointInterval-th line start is kept, so the index of a file with
+// hundreds of millions of lines still fits in a few megabytes; the viewer
+// finds any line from the checkpoint before it plus a short scan.
+class TranscriptIndexer : public QThread {
+    Q_OBJECT
+
+public:
+    static const int CheckpointInterval = 1024;
+
+    // data must stay mapped until the indexer has finished
+    TranscriptIndexer(const uchar *data, qint64 size, QObject *parent = nullptr);
+    ~TranscriptIndexer() override;
+
+    void cancel();
+
+signals:
+    // Byte offsets of the start of lines n * CheckpointInterval, in order
+    void checkpointsFound(const QVector<qint64> &offsets);
+    void progress(qint64 bytesScanned, qint64 bytesTotal, qint64 lines);
+    void indexFinished(qint64 lines);
+
+protected:
+    void run() override;
+
+private:
+    const uchar *data;
+    qint64 size;
+    QAtomicInt cancelled;
+};
+
+#endif // TRANSCRIPTINDEXER_H
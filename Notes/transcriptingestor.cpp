@@ -0,0 +1,199 @@
+#include "transcriptingestor.h"
+
+#include "wordtimeindex.h"
+
+#include <QTextCursor>
+#include <QTextDocument>
+
+namespace {
+
+int countWords(const QString &text) {
+    int count = 0;
+    bool inWord = false;
+    for (const QChar c : text) {
+        const bool space = c.isSpace();
+        if (!space && !inWord) {
+            ++count;
+        }
+        inWord = !space;
+    }
+    return count;
+}
+
+} // namespace
+
+TranscriptIngestor::TranscriptIngestor(QTextDocument *document, QObject *parent)
+    : QObject(parent),
+      document(document),
+      wordIndex(nullptr),
+      paused(false),
+      pendingLength(0),
+      oldestPendingNs(0),
+      partialChanged(false),
+      flushRequested(false),
+      words(0),
+      flushes(0),
+      latencyNs(0),
+      maxLatencyNs(0),
+      flushNs(0) {
+    clock.start();
+    frameTimer.setSingleShot(true);
+    frameTimer.setInterval(FrameInterval);
+    connect(&frameTimer, &QTimer::timeout, this, &TranscriptIngestor::flush);
+}
+
+void TranscriptIngestor::append(const QString &text) {
+    if (text.trimmed().isEmpty()) {
+        return;
+    }
+
+    QMutexLocker locker(&mutex);
+    appendLocked(text.trimmed());
+}
+
+void TranscriptIngestor::appendWords(const QVector<TranscriptWord> &words) {
+    QStringList texts;
+    for (const TranscriptWord &word : words) {
+        texts.append(word.text.trimmed());
+    }
+    texts.removeAll(QString());
+    if (texts.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker locker(&mutex);
+    int offset = pendingLength + (pending.isEmpty() ? 0 : 1);
+    for (const TranscriptWord &word : words) {
+        const QString text = word.text.trimmed();
+        if (text.isEmpty()) {
+            continue;
+        }
+        pendingWords.append({ offset, int(text.size()), word.startMs, word.endMs, word.confidence });
+        offset += text.size() + 1;
+    }
+    appendLocked(texts.join(QLatin1Char(' ')));
+}
+
+// Called with the mutex held
+void TranscriptIngestor::appendLocked(const QString &text) {
+    if (pending.isEmpty()) {
+        oldestPendingNs = clock.nsecsElapsed();
+        pendingLength = text.size();
+    } else {
+        pendingLength += 1 + text.size();
+    }
+    pending.append(text);
+    // A final result replaces the hypothesis it came from
+    partial.clear();
+    partialChanged = true;
+    requestFlush();
+}
+
+void TranscriptIngestor::setPartial(const QString &text) {
+    QMutexLocker locker(&mutex);
+    if (text == partial) {
+        return;
+    }
+    partial = text;
+    partialChanged = true;
+    requestFlush();
+}
+
+// Called with the mutex held
+void TranscriptIngestor::requestFlush() {
+    if (!flushRequested) {
+        flushRequested = true;
+        // The timer belongs to the GUI thread
+        QMetaObject::invokeMethod(this, [this] { scheduleFlush(); }, Qt::QueuedConnection);
+    }
+}
+
+void TranscriptIngestor::setPaused(bool pause) {
+    paused = pause;
+    if (!paused) {
+        scheduleFlush();
+    }
+}
+
+double TranscriptIngestor::wordsPerSecond() const {
+    const qint64 since = clock.nsecsElapsed() - qint64(RateWindow) * 1000000;
+    int count = 0;
+    for (const auto &entry : recentFlushes) {
+        if (entry.first >= since) {
+            count += entry.second;
+        }
+    }
+    return count * 1000.0 / RateWindow;
+}
+
+void TranscriptIngestor::scheduleFlush() {
+    if (!paused && !frameTimer.isActive()) {
+        frameTimer.start();
+    }
+}
+
+void TranscriptIngestor::flush() {
+    if (paused) {
+        return;
+    }
+
+    QStringList pieces;
+    QVector<PendingWord> timedWords;
+    qint64 queuedAt;
+    QString hypothesis;
+    bool hypothesisChanged;
+    {
+        QMutexLocker locker(&mutex);
+        pieces.swap(pending);
+        timedWords.swap(pendingWords);
+        pendingLength = 0;
+        queuedAt = oldestPendingNs;
+        hypothesis = partial;
+        hypothesisChanged = partialChanged;
+        partialChanged = false;
+        flushRequested = false;
+    }
+    if (pieces.isEmpty()) {
+        if (hypothesisChanged) {
+            emit partialHypothesisChanged(hypothesis);
+        }
+        return;
+    }
+
+    QString text = pieces.join(QLatin1Char(' '));
+    const int added = countWords(text);
+
+    emit aboutToFlush();
+    const qint64 start = clock.nsecsElapsed();
+    QTextCursor cursor(document);
+    cursor.movePosition(QTextCursor::End);
+    // Start a new word unless the note already ends in white space
+    int textStart = cursor.position();
+    if (!cursor.atStart() && !document->characterAt(cursor.position() - 1).isSpace()) {
+        text.prepend(QLatin1Char(' '));
+        ++textStart;
+    }
+    cursor.beginEditBlock();
+    cursor.insertText(text);
+    cursor.endEditBlock();
+    if (wordIndex) {
+        for (const PendingWord &word : timedWords) {
+            wordIndex->addWord(textStart + word.offset, word.length, word.startMs, word.endMs, word.confidence);
+        }
+    }
+    const qint64 end = clock.nsecsElapsed();
+
+    flushNs = end - start;
+    latencyNs = end - queuedAt;
+    maxLatencyNs = qMax(maxLatencyNs, latencyNs);
+    words += added;
+    ++flushes;
+    recentFlushes.enqueue(qMakePair(end, added));
+    while (!recentFlushes.isEmpty() && recentFlushes.head().first < end - qint64(RateWindow) * 1000000) {
+        recentFlushes.dequeue();
+    }
+    emit flushed(added);
+    if (hypothesisChanged) {
+        emit partialHypothesisChanged(hypothesis);
+    }
+}
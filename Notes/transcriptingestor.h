@@ -0,0 +1,111 @@
+#ifndef TRANSCRIPTINGESTOR_H
+#define TRANSCRIPTINGESTOR_H
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QObject>
+#include <QPair>
+#include <QQueue>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+
+class QTextDocument;
+class WordTimeIndex;
+
+// A recognized word with its place in the recording
+struct TranscriptWord {
+    QString text;
+    qint64 startMs;
+    qint64 endMs;
+    float confidence;
+};
+
+// Live transcript input for a document. append() may be called from any
+// thread, e.g. once per recognized word; the text is queued and written to
+// the end of the document at most once per frame, in a single edit block,
+// so a fast recognizer costs one relayout and one undo step per frame
+// instead of one per word.
+class TranscriptIngestor : public QObject {
+    Q_OBJECT
+
+public:
+    static const int FrameInterval = 16; // ms
+    // Window for wordsPerSecond()
+    static const int RateWindow = 5000; // ms
+
+    explicit TranscriptIngestor(QTextDocument *document, QObject *parent = nullptr);
+
+    // Thread-safe. Pieces are joined with single spaces.
+    void append(const QString &text);
+    // Thread-safe. Like append() for the words joined with spaces; their
+    // times go to the word index once they are in the document.
+    void appendWords(const QVector<TranscriptWord> &words);
+    // Thread-safe. The recognizer's current guess for the words after the
+    // last final result; never written to the document, only handed on
+    // through partialHypothesisChanged() in the same frame as the finals
+    void setPartial(const QString &text);
+
+    // Queued text is held back while paused, e.g. while a note streams in
+    void setPaused(bool paused);
+
+    void setWordIndex(WordTimeIndex *index) { wordIndex = index; }
+
+    // Counters, GUI thread only
+    qint64 wordsIngested() const { return words; }
+    double wordsPerSecond() const;
+    // Oldest queued piece to its text being in the document
+    double lastLatencyMs() const { return latencyNs / 1e6; }
+    double maxLatencyMs() const { return maxLatencyNs / 1e6; }
+    // Time spent inside the edit block
+    double lastFlushMs() const { return flushNs / 1e6; }
+    qint64 flushCount() const { return flushes; }
+
+public slots:
+    void flush();
+
+signals:
+    // Around every flush, so that views can keep their cursor and scroll
+    // position where the user left them
+    void aboutToFlush();
+    void flushed(int wordsAdded);
+    void partialHypothesisChanged(const QString &text);
+
+private:
+    // Timed word inside the pending text
+    struct PendingWord {
+        int offset;
+        int length;
+        qint64 startMs;
+        qint64 endMs;
+        float confidence;
+    };
+
+    void appendLocked(const QString &text);
+    void requestFlush();
+    void scheduleFlush();
+
+    QTextDocument *document;
+    WordTimeIndex *wordIndex;
+    QTimer frameTimer;
+    QElapsedTimer clock; // Shared time base; started once, read from any thread
+    bool paused;
+
+    QMutex mutex; // Guards the seven below
+    QStringList pending;
+    int pendingLength; // Of pending joined with spaces
+    QVector<PendingWord> pendingWords;
+    qint64 oldestPendingNs;
+    QString partial;
+    bool partialChanged;
+    bool flushRequested;
+
+    qint64 words;
+    qint64 flushes;
+    qint64 latencyNs;
+    qint64 maxLatencyNs;
+    qint64 flushNs;
+    QQueue<QPair<qint64, int>> recentFlushes; // (time, words) within RateWindow
+};
+
+#endif // TRANSCRIPTINGESTOR_H
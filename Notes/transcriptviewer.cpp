@@ -0,0 +1,374 @@
+#include "transcriptviewer.h"
+
+#include "transcriptindexer.h"
+
+#include <QAction>
+#include <QFileInfo>
+#include <QInputDialog>
+#include <QKeyEvent>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QScopedValueRollback>
+#include <QScrollBar>
+#include <QWheelEvent>
+
+#include <climits>
+#include <cstring>
+
+namespace {
+
+const int Margin = 6;
+
+// Lines scrolled per wheel notch
+const int WheelLines = 3;
+
+} // namespace
+
+TranscriptViewer::TranscriptViewer(QWidget *parent)
+    : QAbstractScrollArea(parent),
+      data(nullptr),
+      size(0),
+      top(0),
+      bottom(0),
+      lines(-1),
+      scrollScale(1),
+      syncingScrollBar(false) {
+    setFocusPolicy(Qt::StrongFocus);
+    viewport()->setBackgroundRole(QPalette::Base);
+
+    QAction *lineAction = new QAction("Go to Line...", this);
+    lineAction->setShortcut(QKeySequence("Ctrl+G"));
+    lineAction->setShortcutContext(Qt::WidgetWithChildrenShortcut);
+    connect(lineAction, &QAction::triggered, this, &TranscriptViewer::askForLine);
+    addAction(lineAction);
+
+    QAction *offsetAction = new QAction("Go to Offset...", this);
+    offsetAction->setShortcut(QKeySequence("Ctrl+Shift+G"));
+    offsetAction->setShortcutContext(Qt::WidgetWithChildrenShortcut);
+    connect(offsetAction, &QAction::triggered, this, &TranscriptViewer::askForOffset);
+    addAction(offsetAction);
+
+    setContextMenuPolicy(Qt::ActionsContextMenu);
+}
+
+TranscriptViewer::~TranscriptViewer() {
+    delete indexer; // Stops the scan before the mapping goes away
+}
+
+bool TranscriptViewer::open(const QString &fileName, QString *error) {
+    delete indexer;
+    checkpoints.clear();
+    lines = -1;
+    data = nullptr;
+    size = 0;
+    file.close();
+
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+    size = file.size();
+    if (size > 0) {
+        data = file.map(0, size);
+        if (!data) {
+            if (error) {
+                *error = file.errorString();
+            }
+            file.close();
+            size = 0;
+            return false;
+        }
+    }
+
+    // The scroll bar works in scaled bytes so that any size fits in an int
+    scrollScale = qMax<qint64>(1, size / INT_MAX + 1);
+    {
+        QScopedValueRollback<bool> syncing(syncingScrollBar, true);
+        verticalScrollBar()->setRange(0, int(size / scrollScale));
+        verticalScrollBar()->setValue(0);
+    }
+    top = 0;
+    layoutVisibleLines();
+    updateTitle("indexing...");
+
+    indexer = new TranscriptIndexer(data, size, this);
+    connect(indexer, &TranscriptIndexer::checkpointsFound, this, &TranscriptViewer::addCheckpoints);
+    connect(indexer, &TranscriptIndexer::progress, this, &TranscriptViewer::indexProgress);
+    connect(indexer, &TranscriptIndexer::indexFinished, this, &TranscriptViewer::indexFinished);
+    indexer->start(QThread::LowPriority);
+    return true;
+}
+
+void TranscriptViewer::setPageStyle(PageBackground::Style style) {
+    background.setStyle(style);
+    viewport()->update();
+}
+
+void TranscriptViewer::goToOffset(qint64 offset) {
+    setTop(lineStartFor(qBound<qint64>(0, offset, size)));
+}
+
+void TranscriptViewer::goToLine(qint64 line) {
+    if (checkpoints.isEmpty() || line <= 0) {
+        setTop(0);
+        return;
+    }
+
+    // Nearest checkpoint at or before the line, then at most
+    // CheckpointInterval - 1 newlines forward
+    const qint64 checkpoint = qMin<qint64>(line / TranscriptIndexer::CheckpointInterval, checkpoints.size() - 1);
+    qint64 offset = checkpoints.at(int(checkpoint));
+    for (qint64 skip = line - checkpoint * TranscriptIndexer::CheckpointInterval; skip > 0 && offset < size; --skip) {
+        const void *newline = std::memchr(data + offset, '\n', size_t(size - offset));
+        if (!newline) {
+            break;
+        }
+        offset = static_cast<const uchar *>(newline) - data + 1;
+    }
+    setTop(qMin(offset, lineStartFor(size)));
+}
+
+void TranscriptViewer::paintEvent(QPaintEvent *event) {
+    QPainter painter(viewport());
+    painter.setClipRegion(event->region());
+
+    // Rows are whole lines, so the lines only move sideways
+    background.paint(&painter, event->rect(), QPoint(horizontalScrollBar()->value(), 0),
+                     palette().color(QPalette::Base), palette().color(QPalette::Text),
+                     viewport()->devicePixelRatioF());
+
+    const QFontMetrics metrics(font());
+    const int lineHeight = metrics.lineSpacing();
+    const int first = qMax(0, event->rect().top() / lineHeight);
+    const int last = qMin(int(visibleLines.size()) - 1, event->rect().bottom() / lineHeight);
+    painter.setPen(palette().color(QPalette::Text));
+    for (int row = first; row <= last; ++row) {
+        painter.drawText(Margin - horizontalScrollBar()->value(), row * lineHeight + metrics.ascent(),
+                         visibleLines.at(row));
+    }
+}
+
+void TranscriptViewer::resizeEvent(QResizeEvent *event) {
+    QAbstractScrollArea::resizeEvent(event);
+    layoutVisibleLines();
+}
+
+void TranscriptViewer::changeEvent(QEvent *event) {
+    QAbstractScrollArea::changeEvent(event);
+    if (event->type() == QEvent::FontChange) {
+        layoutVisibleLines();
+    } else if (event->type() == QEvent::PaletteChange) {
+        viewport()->update();
+    }
+}
+
+void TranscriptViewer::keyPressEvent(QKeyEvent *event) {
+    const int page = qMax(1, visibleRows() - 1);
+    switch (event->key()) {
+    case Qt::Key_Up:
+        scrollLines(-1);
+        break;
+    case Qt::Key_Down:
+        scrollLines(1);
+        break;
+    case Qt::Key_PageUp:
+        scrollLines(-page);
+        break;
+    case Qt::Key_PageDown:
+        scrollLines(page);
+        break;
+    case Qt::Key_Home:
+        setTop(0);
+        break;
+    case Qt::Key_End:
+        setTop(lineStartFor(size));
+        scrollLines(-page);
+        break;
+    default:
+        QAbstractScrollArea::keyPressEvent(event);
+    }
+}
+
+void TranscriptViewer::wheelEvent(QWheelEvent *event) {
+    const int notches = event->angleDelta().y() / 120;
+    if (notches == 0) {
+        QAbstractScrollArea::wheelEvent(event); // Sideways
+        return;
+    }
+    scrollLines(-notches * WheelLines);
+    event->accept();
+}
+
+void TranscriptViewer::scrollContentsBy(int dx, int dy) {
+    Q_UNUSED(dx);
+    if (dy != 0 && !syncingScrollBar) {
+        // Moved by the scroll bar: land on the start of the line under the
+        // new position, and make a small step down move at least one line
+        qint64 offset = lineStartFor(qint64(verticalScrollBar()->value()) * scrollScale);
+        if (dy < 0 && offset <= top) {
+            const qint64 next = nextLineStart(top);
+            offset = next < size ? next : top;
+        }
+        top = offset;
+        layoutVisibleLines();
+    }
+    viewport()->update();
+}
+
+void TranscriptViewer::addCheckpoints(const QVector<qint64> &offsets) {
+    if (sender() != indexer) {
+        return;
+    }
+    checkpoints += offsets;
+}
+
+void TranscriptViewer::indexProgress(qint64 bytesScanned, qint64 bytesTotal, qint64 linesFound) {
+    if (sender() != indexer || bytesTotal <= 0) {
+        return;
+    }
+    updateTitle(QString("indexing %1%, %2 lines so far")
+                    .arg(bytesScanned * 100 / bytesTotal)
+                    .arg(linesFound));
+}
+
+void TranscriptViewer::indexFinished(qint64 linesFound) {
+    if (sender() != indexer) {
+        return;
+    }
+    lines = linesFound;
+    updateTitle(QString("%1 lines").arg(linesFound));
+}
+
+void TranscriptViewer::askForLine() {
+    const qint64 indexed = lines >= 0 ? lines : qint64(checkpoints.size()) * TranscriptIndexer::CheckpointInterval;
+    if (indexed <= 0) {
+        return;
+    }
+    bool ok;
+    const int line = QInputDialog::getInt(this, "Go to Line", QString("Line (1 - %1):").arg(indexed), 1, 1,
+                                          int(qMin<qint64>(indexed, INT_MAX)), 1, &ok);
+    if (ok) {
+        goToLine(line - 1);
+    }
+}
+
+void TranscriptViewer::askForOffset() {
+    bool ok;
+    const QString text = QInputDialog::getText(this, "Go to Offset", QString("Byte offset (0 - %1):").arg(size),
+                                               QLineEdit::Normal, QString::number(top), &ok);
+    const qint64 offset = text.trimmed().toLongLong(&ok, 0);
+    if (ok) {
+        goToOffset(offset);
+    }
+}
+
+// Long lines are cut where the file crosses a multiple of MaxLineLength,
+// backed up to the start of a UTF-8 sequence so no character is split. The
+// cut points depend only on the file, so scrolling up and down agree.
+qint64 TranscriptViewer::pieceStart(qint64 piece) const {
+    qint64 at = piece * MaxLineLength;
+    if (at >= size) {
+        return size;
+    }
+    for (int back = 0; back < 3 && at > 0 && (data[at] & 0xc0) == 0x80; ++back) {
+        --at;
+    }
+    return at;
+}
+
+// Start of the line holding offset. Only the piece holding offset is looked
+// at, so a single huge line cannot make this scan the whole file.
+qint64 TranscriptViewer::lineStartFor(qint64 offset) const {
+    // The end of the file belongs to the last line
+    const qint64 piece = qMax<qint64>(0, qMin(offset, size - 1)) / MaxLineLength;
+    const qint64 next = pieceStart(piece + 1);
+    const qint64 limit = next <= offset && next < size ? next : pieceStart(piece);
+    for (qint64 at = offset; at > limit; --at) {
+        if (data[at - 1] == '\n') {
+            return at;
+        }
+    }
+    return limit;
+}
+
+qint64 TranscriptViewer::nextLineStart(qint64 offset) const {
+    const qint64 piece = offset / MaxLineLength;
+    qint64 limit = pieceStart(piece + 1);
+    if (limit <= offset) {
+        limit = pieceStart(piece + 2);
+    }
+    const void *newline = std::memchr(data + offset, '\n', size_t(limit - offset));
+    return newline ? static_cast<const uchar *>(newline) - data + 1 : limit;
+}
+
+void TranscriptViewer::scrollLines(int count) {
+    qint64 offset = top;
+    for (; count > 0 && offset < size; --count) {
+        const qint64 next = nextLineStart(offset);
+        if (next >= size) {
+            break; // Keep the last line on screen
+        }
+        offset = next;
+    }
+    for (; count < 0 && offset > 0; ++count) {
+        offset = lineStartFor(offset - 1);
+    }
+    setTop(offset);
+}
+
+void TranscriptViewer::setTop(qint64 offset) {
+    if (offset == top) {
+        return;
+    }
+    top = offset;
+    {
+        QScopedValueRollback<bool> syncing(syncingScrollBar, true);
+        verticalScrollBar()->setValue(int(top / scrollScale));
+    }
+    layoutVisibleLines();
+    viewport()->update();
+}
+
+// Decodes the lines that fit in the viewport and sizes the scroll bars;
+// this is the only place that touches file content outside of scrolling.
+void TranscriptViewer::layoutVisibleLines() {
+    visibleLines.clear();
+    const QFontMetrics metrics(font());
+    const int rows = visibleRows();
+    int widest = 0;
+    qint64 offset = top;
+    for (int row = 0; row < rows && offset < size; ++row) {
+        const qint64 next = nextLineStart(offset);
+        qint64 end = next;
+        while (end > offset && (data[end - 1] == '\n' || data[end - 1] == '\r')) {
+            --end;
+        }
+        const QString line = QString::fromUtf8(reinterpret_cast<const char *>(data + offset), int(end - offset));
+        widest = qMax(widest, metrics.horizontalAdvance(line));
+        visibleLines.append(line);
+        offset = next;
+    }
+    bottom = offset;
+
+    horizontalScrollBar()->setRange(0, qMax(0, widest + 2 * Margin - viewport()->width()));
+    horizontalScrollBar()->setPageStep(viewport()->width());
+    horizontalScrollBar()->setSingleStep(metrics.averageCharWidth() * 4);
+
+    QScopedValueRollback<bool> syncing(syncingScrollBar, true);
+    verticalScrollBar()->setPageStep(int(qMax<qint64>(1, (bottom - top) / scrollScale)));
+    verticalScrollBar()->setSingleStep(qMax(1, int((bottom - top) / scrollScale / qMax(1, rows))));
+
+    background.setSpacing(metrics.lineSpacing());
+}
+
+int TranscriptViewer::visibleRows() const {
+    const int lineHeight = QFontMetrics(font()).lineSpacing();
+    return viewport()->height() / lineHeight + 1;
+}
+
+void TranscriptViewer::updateTitle(const QString &state) {
+    setWindowTitle(QString("%1 (read-only) - %2").arg(QFileInfo(file.fileName()).fileName(), state));
+}
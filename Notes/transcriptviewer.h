@@ -0,0 +1,84 @@
+#ifndef TRANSCRIPTVIEWER_H
+#define TRANSCRIPTVIEWER_H
+
+#include <QAbstractScrollArea>
+#include <QFile>
+#include <QPointer>
+#include <QStringList>
+#include <QVector>
+
+#include "pagebackground.h"
+
+class TranscriptIndexer;
+
+// Read-only view of a transcript too large for a QTextDocument. The file is
+// memory-mapped and the view is anchored on the byte offset of its top line:
+// scrolling steps over newlines next to that offset and painting decodes
+// only the lines on screen, so neither depends on the size of the file.
+// Line numbers come from a sparse index that is built in the background.
+class TranscriptViewer : public QAbstractScrollArea {
+    Q_OBJECT
+
+public:
+    // Longer lines are shown in pieces of about this many bytes
+    static const int MaxLineLength = 64 * 1024;
+
+    explicit TranscriptViewer(QWidget *parent = nullptr);
+    ~TranscriptViewer() override;
+
+    bool open(const QString &fileName, QString *error = nullptr);
+    QString fileName() const { return file.fileName(); }
+
+    void setPageStyle(PageBackground::Style style);
+
+    qint64 topOffset() const { return top; }
+    // -1 until the background index is complete
+    qint64 lineCount() const { return lines; }
+
+public slots:
+    void goToOffset(qint64 offset);
+    // Lines past the part indexed so far go to the last indexed line
+    void goToLine(qint64 line);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void changeEvent(QEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+
+private slots:
+    void addCheckpoints(const QVector<qint64> &offsets);
+    void indexProgress(qint64 bytesScanned, qint64 bytesTotal, qint64 linesFound);
+    void indexFinished(qint64 linesFound);
+    void askForLine();
+    void askForOffset();
+
+private:
+    qint64 pieceStart(qint64 piece) const;
+    qint64 lineStartFor(qint64 offset) const;
+    qint64 nextLineStart(qint64 offset) const;
+    void scrollLines(int count);
+    void setTop(qint64 offset);
+    void layoutVisibleLines();
+    int visibleRows() const;
+    void updateTitle(const QString &state);
+
+    QFile file;
+    const uchar *data;
+    qint64 size;
+    qint64 top;
+    qint64 bottom; // First byte below the last visible line
+    qint64 lines;
+    qint64 scrollScale; // Bytes per vertical scroll bar step
+    bool syncingScrollBar;
+
+    QPointer<TranscriptIndexer> indexer;
+    QVector<qint64> checkpoints;
+
+    QStringList visibleLines;
+    PageBackground background;
+};
+
+#endif // TRANSCRIPTVIEWER_H
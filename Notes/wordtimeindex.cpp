@@ -0,0 +1,134 @@
+#include "wordtimeindex.h"
+
+#include <QTextDocument>
+
+#include <algorithm>
+
+WordTimeIndex::WordTimeIndex(QTextDocument *document, QObject *parent)
+    : QObject(parent), document(document) {
+    connect(document, &QTextDocument::contentsChange, this, &WordTimeIndex::documentChanged);
+}
+
+void WordTimeIndex::addWord(int position, int length, qint64 startMs, qint64 endMs, float confidence) {
+    if (length <= 0) {
+        return;
+    }
+    const int at = int(std::lower_bound(positions.cbegin(), positions.cend(), position) - positions.cbegin());
+    const qint64 duration = qBound<qint64>(0, endMs - startMs, 0xffff);
+    positions.insert(at, position);
+    lengths.insert(at, quint16(qMin(length, 0xffff)));
+    hashes.insert(at, hashAt(position, length));
+    starts.insert(at, quint32(qBound<qint64>(0, startMs, 0xffffffffLL)));
+    durations.insert(at, quint16(duration));
+    confidences.insert(at, quint8(qRound(qBound(0.0f, confidence, 1.0f) * 255)));
+}
+
+void WordTimeIndex::clear() {
+    positions.clear();
+    lengths.clear();
+    hashes.clear();
+    starts.clear();
+    durations.clear();
+    confidences.clear();
+}
+
+int WordTimeIndex::wordAt(int position) const {
+    const int at = int(std::upper_bound(positions.cbegin(), positions.cend(), position) - positions.cbegin()) - 1;
+    if (at >= 0 && position < positions.at(at) + lengths.at(at)) {
+        return at;
+    }
+    return -1;
+}
+
+qint64 WordTimeIndex::memoryBytes() const {
+    return qint64(positions.capacity()) * sizeof(qint32) + qint64(lengths.capacity()) * sizeof(quint16)
+           + qint64(hashes.capacity()) * sizeof(quint16) + qint64(starts.capacity()) * sizeof(quint32)
+           + qint64(durations.capacity()) * sizeof(quint16) + qint64(confidences.capacity()) * sizeof(quint8);
+}
+
+void WordTimeIndex::documentChanged(int position, int charsRemoved, int charsAdded) {
+    if (positions.isEmpty()) {
+        return;
+    }
+
+    const int removedEnd = position + charsRemoved;
+    const int delta = charsAdded - charsRemoved;
+
+    // Words are sorted and never overlap, so the first word that ends
+    // after the change is the one before the first start past it, or that one
+    int first = int(std::lower_bound(positions.cbegin(), positions.cend(), position) - positions.cbegin());
+    if (first > 0 && positions.at(first - 1) + lengths.at(first - 1) > position) {
+        --first;
+    }
+
+    // Words starting before the end of the removed range (before the
+    // insertion point for a pure insertion) may be touched; the rest shift
+    const int touchedEnd = charsRemoved == 0 ? position : removedEnd;
+    int dropped = 0;
+    int i = first;
+    for (; i < positions.size() && positions.at(i) < touchedEnd; ++i) {
+        const int start = positions.at(i);
+        const int end = start + lengths.at(i);
+        if (charsRemoved == 0) {
+            if (start < position && position < end) {
+                // Typing inside the word keeps it
+                lengths[i] = quint16(qMin(lengths.at(i) + charsAdded, 0xffff));
+                hashes[i] = hashAt(start, lengths.at(i));
+            }
+            continue;
+        }
+        if (end <= position) {
+            continue;
+        }
+        // Overlapped by the change: keep the word only if its text is still
+        // there, i.e. the change was a format change
+        if (charsRemoved == charsAdded && hashAt(start, lengths.at(i)) == hashes.at(i)) {
+            continue;
+        }
+        positions[i] = -1;
+        ++dropped;
+    }
+
+    // Everything past the removed range moves by the size difference
+    if (delta != 0) {
+        qint32 *p = positions.data();
+        for (int k = i, count = positions.size(); k < count; ++k) {
+            p[k] += delta;
+        }
+    }
+
+    if (dropped > 0) {
+        removeWords(first, i - first);
+    }
+}
+
+// Compacts out the words marked with position -1 among count words from first
+void WordTimeIndex::removeWords(int first, int count) {
+    int out = first;
+    for (int in = first, size = positions.size(); in < size; ++in) {
+        if (in < first + count && positions.at(in) < 0) {
+            continue;
+        }
+        positions[out] = positions.at(in);
+        lengths[out] = lengths.at(in);
+        hashes[out] = hashes.at(in);
+        starts[out] = starts.at(in);
+        durations[out] = durations.at(in);
+        confidences[out] = confidences.at(in);
+        ++out;
+    }
+    positions.resize(out);
+    lengths.resize(out);
+    hashes.resize(out);
+    starts.resize(out);
+    durations.resize(out);
+    confidences.resize(out);
+}
+
+quint16 WordTimeIndex::hashAt(int position, int length) const {
+    quint32 hash = 2166136261u; // FNV-1a, folded to 16 bits
+    for (int k = 0; k < length; ++k) {
+        hash = (hash ^ document->characterAt(position + k).unicode()) * 16777619u;
+    }
+    return quint16(hash ^ (hash >> 16));
+}
@@ -0,0 +1,58 @@
+#ifndef WORDTIMEINDEX_H
+#define WORDTIMEINDEX_H
+
+#include <QObject>
+#include <QVector>
+
+class QTextDocument;
+
+// Audio time of every transcribed word in a note, kept in step with the
+// document as the user edits. Stored as parallel arrays (structure of
+// arrays): 15 bytes per word, and shifting the positions after an edit is
+// one pass over a flat int array.
+//
+// A word survives edits around it and typing inside it. It is dropped once
+// its text is replaced or deleted; format-only changes (same text, new
+// format) keep it, which is what the 16-bit text hash is for.
+class WordTimeIndex : public QObject {
+    Q_OBJECT
+
+public:
+    explicit WordTimeIndex(QTextDocument *document, QObject *parent = nullptr);
+
+    // position/length in document characters, times in ms from the start
+    // of the recording, confidence 0..1. Words normally arrive in document
+    // order, which makes this an append.
+    void addWord(int position, int length, qint64 startMs, qint64 endMs, float confidence);
+    void clear();
+
+    int size() const { return positions.size(); }
+    // Word covering position, or -1
+    int wordAt(int position) const;
+
+    int position(int word) const { return positions.at(word); }
+    int length(int word) const { return lengths.at(word); }
+    qint64 startMs(int word) const { return starts.at(word); }
+    qint64 endMs(int word) const { return starts.at(word) + durations.at(word); }
+    float confidence(int word) const { return confidences.at(word) / 255.0f; }
+
+    qint64 memoryBytes() const;
+
+private slots:
+    void documentChanged(int position, int charsRemoved, int charsAdded);
+
+private:
+    quint16 hashAt(int position, int length) const;
+    void removeWords(int first, int count);
+
+    QTextDocument *document;
+
+    QVector<qint32> positions;
+    QVector<quint16> lengths;
+    QVector<quint16> hashes;
+    QVector<quint32> starts;    // ms
+    QVector<quint16> durations; // ms, clamped to ~65 s
+    QVector<quint8> confidences;
+};
+
+#endif // WORDTIMEINDEX_H
@@ -0,0 +1,223 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/*
+ * Host bench of the capture ring and the A2DP data callback, fed by the
+ * simulated microphone.
+ *
+ *   audio_bench              run every scenario
+ *   audio_bench paced 5      one scenario, for 5 seconds
+ *
+ * paced     microphone and A2DP both in real time; the stream must arrive
+ *           whole and in order
+ * stall     the A2DP side stops for 200 ms; the microphone must overrun
+ *           and the stream pick up again
+ * flat-out  both sides as fast as they go, the callback only taking full
+ *           buffers, to time it
+ *
+ * Exits with 1 if a scenario finds the stream damaged.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <time.h>
+#include <sched.h>
+#include "bt_app_audio.h"
+#include "sim_audio_source.h"
+
+/* what the A2DP stack asks for per call, 10 ms at 44.1 kHz */
+#define CALLBACK_FRAMES    (441)
+#define STALL_MS           (200)
+
+typedef struct {
+    uint64_t next;          /* sample index expected next */
+    uint64_t audio;         /* frames of audio seen */
+    uint64_t silence;       /* frames of silence seen */
+    uint64_t skips;         /* places where samples were missing */
+    uint64_t errors;        /* frames with differing channels */
+} stream_check_t;
+
+typedef struct {
+    uint64_t *ns;
+    size_t count;
+    size_t cap;
+} timings_t;
+
+static uint64_t now_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000u + (uint64_t)t.tv_nsec;
+}
+
+static void sleep_until(uint64_t ns)
+{
+    struct timespec t = { .tv_sec = (time_t)(ns / 1000000000u), .tv_nsec = (long)(ns % 1000000000u) };
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, NULL);
+}
+
+static void check_frames(stream_check_t *check, const int16_t *pcm, size_t frames)
+{
+    for (size_t i = 0; i < frames; i++) {
+        int16_t l = pcm[2 * i], r = pcm[2 * i + 1];
+        if (l != r) {
+            check->errors++;
+            continue;
+        }
+        if (l == 0) {
+            check->silence++;
+            continue;
+        }
+        int16_t want = sim_audio_sample(check->next);
+        if (l != want) {
+            /* samples are missing; move on to the one that came */
+            check->skips++;
+            check->next += (uint64_t)((l - want + 32767) % 32767);
+        }
+        check->next++;
+        check->audio++;
+    }
+}
+
+static void timings_add(timings_t *t, uint64_t ns)
+{
+    if (t->count == t->cap) {
+        t->cap = t->cap ? t->cap * 2 : 4096;
+        t->ns = realloc(t->ns, t->cap * sizeof(uint64_t));
+    }
+    t->ns[t->count++] = ns;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static uint64_t timings_pct(timings_t *t, double p)
+{
+    if (t->count == 0) {
+        return 0;
+    }
+    qsort(t->ns, t->count, sizeof(uint64_t), cmp_u64);
+    return t->ns[(size_t)(p * (double)(t->count - 1))];
+}
+
+static void stats_diff(bt_app_audio_stats_t *d, const bt_app_audio_stats_t *before)
+{
+    bt_app_audio_stats_t now;
+    bt_app_audio_get_stats(&now);
+    d->bytes_captured = now.bytes_captured - before->bytes_captured;
+    d->bytes_sent = now.bytes_sent - before->bytes_sent;
+    d->overruns = now.overruns - before->overruns;
+    d->overrun_bytes = now.overrun_bytes - before->overrun_bytes;
+    d->underruns = now.underruns - before->underruns;
+    d->underrun_bytes = now.underrun_bytes - before->underrun_bytes;
+    d->read_errors = now.read_errors - before->read_errors;
+    d->max_fill = now.max_fill;
+}
+
+static bool run(const char *name, double seconds)
+{
+    bool flat_out = strcmp(name, "flat-out") == 0;
+    bool stall = strcmp(name, "stall") == 0;
+    if (!flat_out && !stall && strcmp(name, "paced") != 0) {
+        fprintf(stderr, "unknown scenario: %s\n", name);
+        return false;
+    }
+
+    static int16_t pcm[CALLBACK_FRAMES * 2];
+    const int32_t len = (int32_t)sizeof(pcm);
+    const uint64_t period_ns = (uint64_t)CALLBACK_FRAMES * 1000000000u / BT_APP_AUDIO_SAMPLE_RATE;
+    stream_check_t check = { 0 };
+    timings_t timings = { 0 };
+    bt_app_audio_stats_t before, d;
+
+    bt_app_audio_get_stats(&before);
+    sim_audio_source_config(flat_out ? SIM_AUDIO_FLAT_OUT : SIM_AUDIO_PACED, BT_APP_AUDIO_SAMPLE_RATE);
+    if (!bt_app_audio_start()) {
+        fprintf(stderr, "%s: source failed to start\n", name);
+        return false;
+    }
+
+    uint64_t start = now_ns(), end = start + (uint64_t)(seconds * 1e9), due = start;
+    uint64_t stall_at = start + (uint64_t)(seconds * 1e9) / 2;
+    bool stalled = false;
+    for (uint64_t t = start; t < end; t = now_ns()) {
+        if (flat_out) {
+            if (bt_app_audio_queued() < (size_t)len) {
+                sched_yield();
+                continue;
+            }
+        } else {
+            due += period_ns;
+            if (stall && !stalled && due >= stall_at) {
+                /* the A2DP side falls behind, then catches up in one go */
+                sleep_until(due + STALL_MS * 1000000u);
+                stalled = true;
+            } else {
+                sleep_until(due);
+            }
+        }
+        uint64_t t0 = now_ns();
+        bt_app_audio_read((uint8_t *)pcm, len);
+        timings_add(&timings, now_ns() - t0);
+        check_frames(&check, pcm, CALLBACK_FRAMES);
+    }
+    uint64_t elapsed = now_ns() - start;
+    bt_app_audio_stop();
+    stats_diff(&d, &before);
+
+    uint64_t calls = timings.count;
+    uint64_t p50 = timings_pct(&timings, 0.50), p99 = timings_pct(&timings, 0.99);
+    uint64_t max = timings.count ? timings.ns[timings.count - 1] : 0;
+    printf("%-9s %6.2f s  %8" PRIu64 " calls  read p50 %5" PRIu64 " ns  p99 %6" PRIu64 " ns  max %7" PRIu64 " ns",
+           name, (double)elapsed / 1e9, calls, p50, p99, max);
+    if (flat_out) {
+        printf("  %7.1f MB/s", (double)d.bytes_sent / ((double)elapsed / 1e9) / 1e6);
+    }
+    printf("\n          audio %" PRIu64 " silence %" PRIu64 " frames; overruns %" PRIu32 " (%" PRIu32 " B) "
+           "underruns %" PRIu32 " (%" PRIu32 " B) max fill %" PRIu32 " B; skips %" PRIu64 "\n",
+           check.audio, check.silence, d.overruns, d.overrun_bytes, d.underruns, d.underrun_bytes,
+           d.max_fill, check.skips);
+    free(timings.ns);
+
+    bool ok = check.errors == 0 && check.audio > 0;
+    if (check.errors) {
+        printf("          FAIL: %" PRIu64 " frames with differing channels\n", check.errors);
+    }
+    if (check.skips > 0 && d.overruns == 0) {
+        printf("          FAIL: samples missing without an overrun\n");
+        ok = false;
+    }
+    if (stall && d.overruns == 0) {
+        printf("          FAIL: the stall did not overrun the ring\n");
+        ok = false;
+    }
+    if (check.audio + d.overrun_bytes / BT_APP_AUDIO_FRAME_BYTES > sim_audio_source_produced()) {
+        printf("          FAIL: more audio out than the microphone produced\n");
+        ok = false;
+    }
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    static const char *all[] = { "paced", "stall", "flat-out" };
+    double seconds = argc > 2 ? atof(argv[2]) : 2.0;
+    bool ok = true;
+
+    if (argc > 1) {
+        ok = run(argv[1], seconds);
+    } else {
+        for (size_t i = 0; i < sizeof(all) / sizeof(all[0]); i++) {
+            ok &= run(all[i], seconds);
+        }
+    }
+    return ok ? 0 : 1;
+}
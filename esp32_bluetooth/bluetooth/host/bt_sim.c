@@ -0,0 +1,620 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/*
+ * Scripted event driver: runs app_main() from bluetooth.c on the FreeRTOS
+ * shim, plays the Bluetooth stack from a script through the fake stack and
+ * checks what the application does in return.
+ *
+ *   bt_sim scenarios/connect_stream.txt        run a script
+ *   bt_sim -v scenarios/connect_stream.txt     and print the log
+ *
+ * One command per line, '#' starts a comment. Every expect first lets the
+ * application task handle everything queued (see settle).
+ *
+ *   lane <control|bulk> <depth> <wait_ms> <block|drop_oldest|coalesce>
+ *                                     configure a lane, before app_main
+ *   app_main                          boot the firmware and let the stack come up
+ *   heartbeat [n]                     n heart beats, each handled before the next
+ *   advance <ms>                      move the timers on, without waiting
+ *   wait <ms>                         real time, e.g. for the microphone to fill
+ *   pull <n> [bytes]                  n calls of the A2DP data callback
+ *   stall <ms> [control|bulk]         work that keeps the task busy for ms
+ *   burst <n> <command...>            a command n times, timed until handled
+ *   settle                            wait until the task has handled all work
+ *   stats                             print the lanes and times per kind of work
+ *
+ *   gap disc_res <bda> <cod> [name]   an inquiry result, name in its EIR
+ *   gap disc_state <started|stopped>
+ *   gap pin_req [16]
+ *   a2d conn <disconnected|connecting|connected|disconnecting> [bda]
+ *   a2d audio <suspend|started>
+ *   a2d ack <check_src_rdy|start|suspend> <success|failure|busy>
+ *   a2d delay <value>
+ *   avrc conn <up|down>
+ *   avrc features <mask>
+ *   avrc caps <bits>
+ *   avrc notify volume <value>
+ *   avrc setvol_rsp <value>
+ *   avrc meta <attr_id> <text>
+ *
+ *   expect call <text...>             the application made a call starting
+ *                                     with text since the last one expected
+ *   expect no-call <text...>          and none such
+ *   expect log <text...>              a log line since the last one expected
+ *   expect lane <control|bulk> <field> <op> <value>
+ *   expect audio <field> <op> <value>
+ *   expect pool <misses|heap_in_use> <op> <value>
+ *
+ * Exits with 1 if an expectation fails or a command is malformed.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/timers.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "bt_app_core.h"
+#include "bt_app_audio.h"
+#include "bt_app_pool.h"
+#include "fake_bt_stack.h"
+
+#define MAX_ARGS            (16)
+#define LINE_BYTES          (256)
+#define HEART_BEAT_MS       (10000)
+#define SETTLE_TIMEOUT_MS   (5000)
+#define DEFAULT_PULL_BYTES  (512)
+
+typedef struct {
+    const char *path;
+    int line;
+    int expectations;
+    int failures;
+    size_t call_at;    /* calls before this one are matched already */
+    size_t log_at;     /* so are these log lines */
+} sim_t;
+
+/* the firmware's entry point, in bluetooth.c */
+void app_main(void);
+
+/*********************************
+ * STATIC VARIABLE DEFINITIONS
+ ********************************/
+static sim_t s_sim;
+static const esp_bd_addr_t s_default_bda = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66};
+
+/*********************************
+ * STATIC FUNCTION DEFINITIONS
+ ********************************/
+
+static void sim_fail(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+static void sim_fail(const char *fmt, ...)
+{
+    va_list args;
+    fprintf(stderr, "%s:%d: ", s_sim.path, s_sim.line);
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fputc('\n', stderr);
+    s_sim.failures++;
+}
+
+static void sim_join(char *text, size_t len, int argc, char **argv)
+{
+    size_t n = 0;
+    text[0] = '\0';
+    for (int i = 0; i < argc && n < len; i++) {
+        n += snprintf(text + n, len - n, i ? " %s" : "%s", argv[i]);
+    }
+}
+
+static bool sim_number(const char *text, long *value)
+{
+    char *end;
+    *value = strtol(text, &end, 0);
+    return *text != '\0' && *end == '\0';
+}
+
+static bool sim_bda(const char *text, esp_bd_addr_t bda)
+{
+    unsigned b[ESP_BD_ADDR_LEN];
+    if (sscanf(text, "%x:%x:%x:%x:%x:%x", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) != ESP_BD_ADDR_LEN) {
+        return false;
+    }
+    for (int i = 0; i < ESP_BD_ADDR_LEN; i++) {
+        bda[i] = (uint8_t)b[i];
+    }
+    return true;
+}
+
+/* index of text in names, -1 if it is none of them */
+static int sim_choice(const char *text, const char *const *names, int count)
+{
+    for (int i = 0; i < count; i++) {
+        if (names[i] && strcmp(text, names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool sim_compare(uint64_t have, const char *op, long want)
+{
+    uint64_t w = want < 0 ? 0 : (uint64_t)want;
+    if (strcmp(op, "==") == 0) {
+        return have == w;
+    } else if (strcmp(op, "!=") == 0) {
+        return have != w;
+    } else if (strcmp(op, "<") == 0) {
+        return have < w;
+    } else if (strcmp(op, "<=") == 0) {
+        return have <= w;
+    } else if (strcmp(op, ">") == 0) {
+        return have > w;
+    } else if (strcmp(op, ">=") == 0) {
+        return have >= w;
+    }
+    sim_fail("unknown comparison '%s'", op);
+    return true;
+}
+
+/* true once every piece of work queued has been handled or evicted */
+static bool sim_settle(void)
+{
+    static bt_app_event_stats_t stats[BT_APP_EVENT_STATS_SLOTS];
+    int64_t deadline = esp_timer_get_time() + (int64_t)SETTLE_TIMEOUT_MS * 1000;
+
+    do {
+        uint64_t queued = 0, done = 0;
+        bool waiting = false;
+        for (int i = 0; i < BT_APP_LANES; i++) {
+            bt_app_lane_stats_t lane;
+            bt_app_lane_get_stats(i, &lane);
+            queued += lane.enqueued;
+            done += lane.dropped;
+            waiting |= lane.waiting > 0;
+        }
+        /* the task counts work once its handler has returned */
+        int n = bt_app_event_stats_get(stats, BT_APP_EVENT_STATS_SLOTS);
+        for (int i = 0; i < n; i++) {
+            done += stats[i].wait.count;
+        }
+        if (!waiting && queued == done) {
+            return true;
+        }
+        usleep(100);
+    } while (esp_timer_get_time() < deadline);
+
+    sim_fail("work still queued after %d ms", SETTLE_TIMEOUT_MS);
+    return false;
+}
+
+static void sim_stall_hdlr(uint16_t event, void *param)
+{
+    (void)param;
+    /* the event id is the time to stay busy */
+    usleep((useconds_t)event * 1000);
+}
+
+static void sim_gap(int argc, char **argv)
+{
+    esp_bt_gap_cb_param_t param;
+    memset(&param, 0, sizeof(param));
+    long value;
+
+    if (argc >= 3 && strcmp(argv[0], "disc_res") == 0) {
+        uint32_t cod;
+        int8_t rssi = -50;
+        uint8_t eir[ESP_BT_GAP_EIR_DATA_LEN] = {0};
+        esp_bt_gap_dev_prop_t props[3];
+        int num_prop = 0;
+
+        if (!sim_bda(argv[1], param.disc_res.bda) || !sim_number(argv[2], &value)) {
+            sim_fail("bad inquiry result");
+            return;
+        }
+        cod = (uint32_t)value;
+        props[num_prop++] = (esp_bt_gap_dev_prop_t) { ESP_BT_GAP_DEV_PROP_COD, sizeof(cod), &cod };
+        props[num_prop++] = (esp_bt_gap_dev_prop_t) { ESP_BT_GAP_DEV_PROP_RSSI, sizeof(rssi), &rssi };
+        if (argc >= 4) {
+            size_t len = strlen(argv[3]);
+            if (len > ESP_BT_GAP_EIR_DATA_LEN - 3) {
+                len = ESP_BT_GAP_EIR_DATA_LEN - 3;
+            }
+            eir[0] = (uint8_t)(len + 1);
+            eir[1] = ESP_BT_EIR_TYPE_CMPL_LOCAL_NAME;
+            memcpy(&eir[2], argv[3], len);
+            props[num_prop++] = (esp_bt_gap_dev_prop_t) { ESP_BT_GAP_DEV_PROP_EIR, (int)len + 2, eir };
+        }
+        param.disc_res.num_prop = num_prop;
+        param.disc_res.prop = props;
+        if (!fake_bt_gap_event(ESP_BT_GAP_DISC_RES_EVT, &param)) {
+            sim_fail("no GAP callback registered");
+        }
+    } else if (argc == 2 && strcmp(argv[0], "disc_state") == 0) {
+        static const char *const states[] = { "stopped", "started" };
+        int state = sim_choice(argv[1], states, 2);
+        if (state < 0) {
+            sim_fail("bad discovery state '%s'", argv[1]);
+            return;
+        }
+        param.disc_st_chg.state = (esp_bt_gap_discovery_state_t)state;
+        if (!fake_bt_gap_event(ESP_BT_GAP_DISC_STATE_CHANGED_EVT, &param)) {
+            sim_fail("no GAP callback registered");
+        }
+    } else if (argc >= 1 && strcmp(argv[0], "pin_req") == 0) {
+        memcpy(param.pin_req.bda, s_default_bda, ESP_BD_ADDR_LEN);
+        param.pin_req.min_16_digit = argc >= 2 && strcmp(argv[1], "16") == 0;
+        if (!fake_bt_gap_event(ESP_BT_GAP_PIN_REQ_EVT, &param)) {
+            sim_fail("no GAP callback registered");
+        }
+    } else {
+        sim_fail("bad gap command");
+    }
+}
+
+static void sim_a2d(int argc, char **argv)
+{
+    static const char *const conn_states[] = { "disconnected", "connecting", "connected", "disconnecting" };
+    static const char *const audio_states[] = { "suspend", "started" };
+    static const char *const ctrls[] = { NULL, "check_src_rdy", "start", "suspend" };
+    static const char *const acks[] = { "success", "failure", "busy" };
+    esp_a2d_cb_param_t param;
+    esp_a2d_cb_event_t event;
+    memset(&param, 0, sizeof(param));
+    long value;
+    int a, b;
+
+    if (argc >= 2 && strcmp(argv[0], "conn") == 0 && (a = sim_choice(argv[1], conn_states, 4)) >= 0) {
+        event = ESP_A2D_CONNECTION_STATE_EVT;
+        param.conn_stat.state = (esp_a2d_connection_state_t)a;
+        memcpy(param.conn_stat.remote_bda, s_default_bda, ESP_BD_ADDR_LEN);
+        if (argc >= 3 && !sim_bda(argv[2], param.conn_stat.remote_bda)) {
+            sim_fail("bad address '%s'", argv[2]);
+            return;
+        }
+    } else if (argc == 2 && strcmp(argv[0], "audio") == 0 && (a = sim_choice(argv[1], audio_states, 2)) >= 0) {
+        event = ESP_A2D_AUDIO_STATE_EVT;
+        param.audio_stat.state = (esp_a2d_audio_state_t)a;
+        memcpy(param.audio_stat.remote_bda, s_default_bda, ESP_BD_ADDR_LEN);
+    } else if (argc == 3 && strcmp(argv[0], "ack") == 0 && (a = sim_choice(argv[1], ctrls, 4)) >= 0 &&
+               (b = sim_choice(argv[2], acks, 3)) >= 0) {
+        event = ESP_A2D_MEDIA_CTRL_ACK_EVT;
+        param.media_ctrl_stat.cmd = (esp_a2d_media_ctrl_t)a;
+        param.media_ctrl_stat.status = (esp_a2d_media_ctrl_ack_t)b;
+    } else if (argc == 2 && strcmp(argv[0], "delay") == 0 && sim_number(argv[1], &value)) {
+        event = ESP_A2D_REPORT_SNK_DELAY_VALUE_EVT;
+        param.a2d_report_delay_value_stat.delay_value = (uint16_t)value;
+    } else {
+        sim_fail("bad a2d command");
+        return;
+    }
+    if (!fake_bt_a2d_event(event, &param)) {
+        sim_fail("no A2DP callback registered");
+    }
+}
+
+static void sim_avrc(int argc, char **argv)
+{
+    esp_avrc_ct_cb_param_t param;
+    esp_avrc_ct_cb_event_t event;
+    memset(&param, 0, sizeof(param));
+    long value = 0;
+
+    if (argc == 2 && strcmp(argv[0], "conn") == 0) {
+        event = ESP_AVRC_CT_CONNECTION_STATE_EVT;
+        param.conn_stat.connected = strcmp(argv[1], "up") == 0;
+        memcpy(param.conn_stat.remote_bda, s_default_bda, ESP_BD_ADDR_LEN);
+    } else if (argc == 2 && strcmp(argv[0], "features") == 0 && sim_number(argv[1], &value)) {
+        event = ESP_AVRC_CT_REMOTE_FEATURES_EVT;
+        param.rmt_feats.feat_mask = (uint32_t)value;
+        memcpy(param.rmt_feats.remote_bda, s_default_bda, ESP_BD_ADDR_LEN);
+    } else if (argc == 2 && strcmp(argv[0], "caps") == 0 && sim_number(argv[1], &value)) {
+        event = ESP_AVRC_CT_GET_RN_CAPABILITIES_RSP_EVT;
+        param.get_rn_caps_rsp.evt_set.bits = (uint16_t)value;
+        param.get_rn_caps_rsp.cap_count = (uint8_t)__builtin_popcount((unsigned)(uint16_t)value);
+    } else if (argc == 3 && strcmp(argv[0], "notify") == 0 && strcmp(argv[1], "volume") == 0 &&
+               sim_number(argv[2], &value)) {
+        event = ESP_AVRC_CT_CHANGE_NOTIFY_EVT;
+        param.change_ntf.event_id = ESP_AVRC_RN_VOLUME_CHANGE;
+        param.change_ntf.event_parameter.volume = (uint8_t)value;
+    } else if (argc == 2 && strcmp(argv[0], "setvol_rsp") == 0 && sim_number(argv[1], &value)) {
+        event = ESP_AVRC_CT_SET_ABSOLUTE_VOLUME_RSP_EVT;
+        param.set_volume_rsp.volume = (uint8_t)value;
+    } else if (argc == 3 && strcmp(argv[0], "meta") == 0 && sim_number(argv[1], &value)) {
+        /* the stack hands over the text, the handler frees it */
+        event = ESP_AVRC_CT_METADATA_RSP_EVT;
+        param.meta_rsp.attr_id = (uint8_t)value;
+        param.meta_rsp.attr_text = (uint8_t *)strdup(argv[2]);
+        param.meta_rsp.attr_length = (int)strlen(argv[2]);
+    } else {
+        sim_fail("bad avrc command");
+        return;
+    }
+    if (!fake_bt_avrc_event(event, &param)) {
+        sim_fail("no AVRC callback registered");
+    }
+}
+
+static bool sim_lane_field(const bt_app_lane_stats_t *s, const char *name, uint64_t *value)
+{
+    if (strcmp(name, "depth") == 0) {
+        *value = s->depth;
+    } else if (strcmp(name, "waiting") == 0) {
+        *value = s->waiting;
+    } else if (strcmp(name, "high_water") == 0) {
+        *value = s->high_water;
+    } else if (strcmp(name, "enqueued") == 0) {
+        *value = s->enqueued;
+    } else if (strcmp(name, "failed") == 0) {
+        *value = s->failed;
+    } else if (strcmp(name, "dropped") == 0) {
+        *value = s->dropped;
+    } else if (strcmp(name, "coalesced") == 0) {
+        *value = s->coalesced;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool sim_audio_field(const bt_app_audio_stats_t *s, const char *name, uint64_t *value)
+{
+    if (strcmp(name, "bytes_captured") == 0) {
+        *value = s->bytes_captured;
+    } else if (strcmp(name, "bytes_sent") == 0) {
+        *value = s->bytes_sent;
+    } else if (strcmp(name, "overruns") == 0) {
+        *value = s->overruns;
+    } else if (strcmp(name, "underruns") == 0) {
+        *value = s->underruns;
+    } else if (strcmp(name, "read_errors") == 0) {
+        *value = s->read_errors;
+    } else if (strcmp(name, "max_fill") == 0) {
+        *value = s->max_fill;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static void sim_expect(int argc, char **argv)
+{
+    static const char *const lanes[] = { "control", "bulk" };
+    char text[LINE_BYTES];
+    uint64_t have = 0;
+    long want;
+    int lane;
+
+    s_sim.expectations++;
+    sim_settle();
+
+    if (argc >= 2 && strcmp(argv[0], "call") == 0) {
+        sim_join(text, sizeof(text), argc - 1, argv + 1);
+        size_t from = s_sim.call_at;
+        if (!fake_bt_find_call(text, &s_sim.call_at)) {
+            sim_fail("no call '%s'; calls since the last one expected:", text);
+            for (const char *call; (call = fake_bt_call(from)) != NULL; from++) {
+                fprintf(stderr, "    %s\n", call);
+            }
+        }
+    } else if (argc >= 2 && strcmp(argv[0], "no-call") == 0) {
+        sim_join(text, sizeof(text), argc - 1, argv + 1);
+        size_t from = s_sim.call_at;
+        if (fake_bt_find_call(text, &from)) {
+            sim_fail("unexpected call '%s'", fake_bt_call(from - 1));
+        }
+    } else if (argc >= 2 && strcmp(argv[0], "log") == 0) {
+        sim_join(text, sizeof(text), argc - 1, argv + 1);
+        if (!shim_log_find(text, &s_sim.log_at)) {
+            sim_fail("no log line with '%s'", text);
+        }
+    } else if (argc == 5 && strcmp(argv[0], "lane") == 0 && (lane = sim_choice(argv[1], lanes, 2)) >= 0 &&
+               sim_number(argv[4], &want)) {
+        bt_app_lane_stats_t stats;
+        bt_app_lane_get_stats((bt_app_lane_t)lane, &stats);
+        if (!sim_lane_field(&stats, argv[2], &have)) {
+            sim_fail("unknown lane field '%s'", argv[2]);
+        } else if (!sim_compare(have, argv[3], want)) {
+            sim_fail("%s lane %s is %" PRIu64 ", expected %s %ld", argv[1], argv[2], have, argv[3], want);
+        }
+    } else if (argc == 4 && strcmp(argv[0], "audio") == 0 && sim_number(argv[3], &want)) {
+        bt_app_audio_stats_t stats;
+        bt_app_audio_get_stats(&stats);
+        if (!sim_audio_field(&stats, argv[1], &have)) {
+            sim_fail("unknown audio field '%s'", argv[1]);
+        } else if (!sim_compare(have, argv[2], want)) {
+            sim_fail("audio %s is %" PRIu64 ", expected %s %ld", argv[1], have, argv[2], want);
+        }
+    } else if (argc == 4 && strcmp(argv[0], "pool") == 0 && sim_number(argv[3], &want)) {
+        bt_app_pool_stats_t stats;
+        bt_app_pool_get_stats(&stats);
+        if (strcmp(argv[1], "misses") == 0) {
+            have = stats.misses;
+        } else if (strcmp(argv[1], "heap_in_use") == 0) {
+            have = stats.heap_in_use;
+        } else {
+            sim_fail("unknown pool field '%s'", argv[1]);
+            return;
+        }
+        if (!sim_compare(have, argv[2], want)) {
+            sim_fail("pool %s is %" PRIu64 ", expected %s %ld", argv[1], have, argv[2], want);
+        }
+    } else {
+        sim_fail("bad expect command");
+    }
+}
+
+static void sim_exec(int argc, char **argv);
+
+static void sim_burst(int argc, char **argv)
+{
+    long n;
+    char text[LINE_BYTES];
+    if (argc < 2 || !sim_number(argv[0], &n) || n <= 0) {
+        sim_fail("bad burst command");
+        return;
+    }
+    sim_join(text, sizeof(text), argc - 1, argv + 1);
+
+    int64_t start = esp_timer_get_time();
+    for (long i = 0; i < n; i++) {
+        sim_exec(argc - 1, argv + 1);
+    }
+    int64_t sent = esp_timer_get_time();
+    sim_settle();
+    int64_t done = esp_timer_get_time();
+
+    double ms = (double)(done - start) / 1000.0;
+    printf("%s:%d: %ld x '%s': sent in %.1f ms, handled in %.1f ms, %.0f/s\n", s_sim.path, s_sim.line, n, text,
+           (double)(sent - start) / 1000.0, ms, ms > 0 ? (double)n * 1000.0 / ms : 0.0);
+}
+
+static void sim_exec(int argc, char **argv)
+{
+    static const char *const lanes[] = { "control", "bulk" };
+    static const char *const policies[] = { "block", "drop_oldest", "coalesce" };
+    long value, count;
+    int lane, policy;
+
+    if (argc == 0) {
+        return;
+    }
+    const char *cmd = argv[0];
+    argc--;
+    argv++;
+
+    if (strcmp(cmd, "lane") == 0 && argc == 4 && (lane = sim_choice(argv[0], lanes, 2)) >= 0 &&
+            sim_number(argv[1], &value) && sim_number(argv[2], &count) &&
+            (policy = sim_choice(argv[3], policies, 3)) >= 0) {
+        bt_app_lane_config_t config = {
+            .depth = (uint16_t)value,
+            .wait_ms = (uint16_t)count,
+            .policy = (bt_app_lane_policy_t)policy,
+        };
+        bt_app_lane_configure((bt_app_lane_t)lane, &config);
+    } else if (strcmp(cmd, "app_main") == 0 && argc == 0) {
+        app_main();
+        sim_settle();
+    } else if (strcmp(cmd, "heartbeat") == 0 && argc <= 1) {
+        count = 1;
+        if (argc == 1 && !sim_number(argv[0], &count)) {
+            sim_fail("bad heart beat count");
+            return;
+        }
+        for (long i = 0; i < count; i++) {
+            if (shim_timers_advance(HEART_BEAT_MS) == 0) {
+                sim_fail("no heart beat timer running");
+                return;
+            }
+            sim_settle();
+        }
+    } else if (strcmp(cmd, "advance") == 0 && argc == 1 && sim_number(argv[0], &value)) {
+        shim_timers_advance((uint32_t)value);
+    } else if (strcmp(cmd, "wait") == 0 && argc == 1 && sim_number(argv[0], &value)) {
+        usleep((useconds_t)value * 1000);
+    } else if (strcmp(cmd, "pull") == 0 && (argc == 1 || argc == 2) && sim_number(argv[0], &count)) {
+        value = DEFAULT_PULL_BYTES;
+        if (argc == 2 && !sim_number(argv[1], &value)) {
+            sim_fail("bad pull size");
+            return;
+        }
+        uint8_t *buf = malloc((size_t)value);
+        for (long i = 0; buf && i < count; i++) {
+            int32_t got = fake_bt_a2d_pull(buf, (int32_t)value);
+            if (got != (int32_t)value) {
+                sim_fail("data callback gave %" PRId32 " of %ld bytes", got, value);
+                break;
+            }
+        }
+        free(buf);
+    } else if (strcmp(cmd, "stall") == 0 && (argc == 1 || argc == 2) && sim_number(argv[0], &value) &&
+               value > 0 && value <= UINT16_MAX) {
+        lane = argc == 2 ? sim_choice(argv[1], lanes, 2) : BT_APP_LANE_CONTROL;
+        if (lane < 0) {
+            sim_fail("bad lane '%s'", argv[1]);
+            return;
+        }
+        bt_app_work_dispatch_to((bt_app_lane_t)lane, sim_stall_hdlr, (uint16_t)value, NULL, 0, NULL);
+    } else if (strcmp(cmd, "burst") == 0) {
+        sim_burst(argc, argv);
+    } else if (strcmp(cmd, "settle") == 0 && argc == 0) {
+        sim_settle();
+    } else if (strcmp(cmd, "stats") == 0 && argc == 0) {
+        sim_settle();
+        bt_app_event_stats_dump(stdout);
+    } else if (strcmp(cmd, "gap") == 0) {
+        sim_gap(argc, argv);
+    } else if (strcmp(cmd, "a2d") == 0) {
+        sim_a2d(argc, argv);
+    } else if (strcmp(cmd, "avrc") == 0) {
+        sim_avrc(argc, argv);
+    } else if (strcmp(cmd, "expect") == 0) {
+        sim_expect(argc, argv);
+    } else {
+        sim_fail("unknown or malformed command '%s'", cmd);
+    }
+}
+
+static int sim_run(FILE *script)
+{
+    char line[LINE_BYTES];
+    char *argv[MAX_ARGS];
+    int commands = 0;
+    int64_t start = esp_timer_get_time();
+
+    while (fgets(line, sizeof(line), script)) {
+        s_sim.line++;
+        char *hash = strchr(line, '#');
+        if (hash) {
+            *hash = '\0';
+        }
+        int argc = 0;
+        for (char *tok = strtok(line, " \t\r\n"); tok && argc < MAX_ARGS; tok = strtok(NULL, " \t\r\n")) {
+            argv[argc++] = tok;
+        }
+        if (argc > 0) {
+            sim_exec(argc, argv);
+            commands++;
+        }
+    }
+    sim_settle();
+
+    printf("%s: %d commands, %d expectations, %d failed, %.1f ms\n", s_sim.path, commands, s_sim.expectations,
+           s_sim.failures, (double)(esp_timer_get_time() - start) / 1000.0);
+    return s_sim.failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    int arg = 1;
+    shim_log_set_print_level(ESP_LOG_NONE);
+    if (arg < argc && strcmp(argv[arg], "-v") == 0) {
+        shim_log_set_print_level(ESP_LOG_INFO);
+        arg++;
+    }
+    if (arg + 1 != argc) {
+        fprintf(stderr, "usage: %s [-v] script\n", argv[0]);
+        return 2;
+    }
+
+    s_sim.path = argv[arg];
+    FILE *script = fopen(s_sim.path, "r");
+    if (script == NULL) {
+        perror(s_sim.path);
+        return 2;
+    }
+    bt_app_name_handler(sim_stall_hdlr, "stall");
+    int ret = sim_run(script);
+    fclose(script);
+    return ret;
+}
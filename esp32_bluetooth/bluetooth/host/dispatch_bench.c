@@ -0,0 +1,200 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/*
+ * Host bench of the dispatcher: bt_app_core's lanes, pool copies and
+ * BtAppTask on the FreeRTOS shim, with the lanes configured as on the pen.
+ *
+ *   dispatch_bench            100000 events per callback thread
+ *   dispatch_bench 20000      fewer
+ *
+ * Two callback threads send A2DP-sized events on the control lane and one
+ * sends AVRC-sized events on the bulk lane, as fast as they can; the
+ * handler checks every copy. Prints events per second and the wait and run
+ * times of each lane.
+ *
+ * Exits with 1 if the control lane loses work, the bulk lane loses work
+ * other than by its drop policy, a copy arrives damaged or pool blocks are
+ * not returned.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "bt_app_core.h"
+#include "bt_app_pool.h"
+
+#define DEFAULT_EVENTS      (100000)    /* per thread */
+#define CONTROL_THREADS     (2)
+#define BULK_THREADS        (1)
+#define CONTROL_BYTES       (16)        /* about an esp_a2d_cb_param_t */
+#define BULK_BYTES          (40)        /* about an esp_avrc_ct_cb_param_t */
+#define DRAIN_TIMEOUT_US    (10 * 1000 * 1000)
+
+typedef struct {
+    bt_app_lane_t lane;
+    uint8_t mark;
+} producer_t;
+
+static long s_events = DEFAULT_EVENTS;
+static atomic_uint_fast64_t s_handled[BT_APP_LANES];
+static atomic_uint_fast64_t s_damaged;
+static atomic_bool s_drained;
+
+static void bench_hdlr(uint16_t event, void *param)
+{
+    /* every byte carries the sender's mark */
+    const uint8_t *p = param;
+    size_t len = event == BT_APP_LANE_CONTROL ? CONTROL_BYTES : BULK_BYTES;
+    for (size_t i = 1; i < len; i++) {
+        if (p[i] != p[0]) {
+            atomic_fetch_add(&s_damaged, 1);
+            break;
+        }
+    }
+    atomic_fetch_add(&s_handled[event], 1);
+}
+
+/* queued behind everything else: once it runs, the task has freed every copy before it */
+static void drain_hdlr(uint16_t event, void *param)
+{
+    (void)event;
+    (void)param;
+    atomic_store(&s_drained, true);
+}
+
+static void *producer(void *arg)
+{
+    const producer_t *self = arg;
+    uint8_t param[BULK_BYTES];
+    int len = self->lane == BT_APP_LANE_CONTROL ? CONTROL_BYTES : BULK_BYTES;
+    memset(param, self->mark, sizeof(param));
+    for (long n = 0; n < s_events; n++) {
+        bt_app_work_dispatch_to(self->lane, bench_hdlr, (uint16_t)self->lane, param, len, NULL);
+    }
+    return NULL;
+}
+
+/* the percentile as the upper bound of its histogram bucket */
+static uint32_t hist_pct(const bt_app_hist_t *hist, uint32_t pct)
+{
+    uint64_t want = ((uint64_t)hist->count * pct + 99) / 100, seen = 0;
+    for (int k = 0; k < BT_APP_HIST_BUCKETS && hist->count > 0; k++) {
+        seen += hist->buckets[k];
+        if (seen >= want) {
+            return k == 0 ? 0 : (k == BT_APP_HIST_BUCKETS - 1 ? hist->max_us : 1u << k);
+        }
+    }
+    return 0;
+}
+
+static bool pool_idle(void)
+{
+    bt_app_pool_stats_t st;
+    bt_app_pool_get_stats(&st);
+    for (int i = 0; i < BT_APP_POOL_CLASSES; i++) {
+        if (st.classes[i].in_use != 0) {
+            printf("          FAIL: %" PRIu32 " blocks of %" PRIu32 " B still in use\n",
+                   st.classes[i].in_use, st.classes[i].block_bytes);
+            return false;
+        }
+    }
+    if (st.heap_in_use != 0) {
+        printf("          FAIL: %" PRIu32 " heap copies still in use\n", st.heap_in_use);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    static const char *lane_names[BT_APP_LANES] = { "control", "bulk" };
+    static bt_app_event_stats_t stats[BT_APP_EVENT_STATS_SLOTS];
+    producer_t producers[CONTROL_THREADS + BULK_THREADS];
+    pthread_t threads[CONTROL_THREADS + BULK_THREADS];
+    uint64_t sent[BT_APP_LANES] = {0};
+    bt_app_lane_stats_t lane[BT_APP_LANES];
+    bool ok = true;
+
+    if (argc > 1 && (s_events = strtol(argv[1], NULL, 0)) <= 0) {
+        fprintf(stderr, "usage: %s [events per thread]\n", argv[0]);
+        return 2;
+    }
+    /* full lanes log every loss */
+    shim_log_set_print_level(ESP_LOG_NONE);
+    bt_app_task_start_up();
+    bt_app_name_handler(bench_hdlr, "bench");
+
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < CONTROL_THREADS + BULK_THREADS; i++) {
+        producers[i].lane = i < CONTROL_THREADS ? BT_APP_LANE_CONTROL : BT_APP_LANE_BULK;
+        producers[i].mark = (uint8_t)(i + 1);
+        sent[producers[i].lane] += (uint64_t)s_events;
+        pthread_create(&threads[i], NULL, producer, &producers[i]);
+    }
+    for (int i = 0; i < CONTROL_THREADS + BULK_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    /* drained once everything sent was handled or evicted */
+    for (;;) {
+        uint64_t accounted = 0;
+        for (int i = 0; i < BT_APP_LANES; i++) {
+            bt_app_lane_get_stats(i, &lane[i]);
+            accounted += atomic_load(&s_handled[i]) + lane[i].dropped + lane[i].failed;
+        }
+        if (accounted == sent[0] + sent[1] || esp_timer_get_time() - start > DRAIN_TIMEOUT_US) {
+            break;
+        }
+        usleep(100);
+    }
+    int64_t elapsed = esp_timer_get_time() - start;
+    bt_app_work_dispatch(drain_hdlr, 0, NULL, 0, NULL);
+    while (!atomic_load(&s_drained) && esp_timer_get_time() - start < 2 * DRAIN_TIMEOUT_US) {
+        usleep(100);
+    }
+    uint64_t handled = atomic_load(&s_handled[0]) + atomic_load(&s_handled[1]);
+    printf("dispatch  %" PRIu64 " of %" PRIu64 " events handled in %.2f s, %.0f/s\n", handled, sent[0] + sent[1],
+           (double)elapsed / 1e6, (double)handled * 1e6 / (double)elapsed);
+
+    int n = bt_app_event_stats_get(stats, BT_APP_EVENT_STATS_SLOTS);
+    for (int i = 0; i < BT_APP_LANES; i++) {
+        const bt_app_event_stats_t *e = NULL;
+        for (int j = 0; j < n; j++) {
+            if (stats[j].cb == bench_hdlr && stats[j].event == i) {
+                e = &stats[j];
+            }
+        }
+        printf("%-8s  %8" PRIu64 " handled, %" PRIu32 " dropped, %" PRIu32 " failed, high water %u/%u; "
+               "wait us p50 <%" PRIu32 " p99 <%" PRIu32 " max %" PRIu32 "; run us p99 <%" PRIu32 "\n",
+               lane_names[i], (uint64_t)atomic_load(&s_handled[i]), lane[i].dropped, lane[i].failed,
+               lane[i].high_water, lane[i].depth, e ? hist_pct(&e->wait, 50) : 0, e ? hist_pct(&e->wait, 99) : 0,
+               e ? e->wait.max_us : 0, e ? hist_pct(&e->run, 99) : 0);
+    }
+
+    if (lane[BT_APP_LANE_CONTROL].failed || lane[BT_APP_LANE_CONTROL].dropped ||
+            atomic_load(&s_handled[BT_APP_LANE_CONTROL]) != sent[BT_APP_LANE_CONTROL]) {
+        printf("          FAIL: the control lane lost work\n");
+        ok = false;
+    }
+    if (lane[BT_APP_LANE_BULK].failed ||
+            atomic_load(&s_handled[BT_APP_LANE_BULK]) + lane[BT_APP_LANE_BULK].dropped != sent[BT_APP_LANE_BULK]) {
+        printf("          FAIL: the bulk lane lost work other than by dropping the oldest\n");
+        ok = false;
+    }
+    if (atomic_load(&s_damaged)) {
+        printf("          FAIL: %" PRIu64 " copies damaged\n", (uint64_t)atomic_load(&s_damaged));
+        ok = false;
+    }
+    ok &= pool_idle();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,326 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "fake_bt_stack.h"
+#include "bt_app_console.h"
+
+/*********************************
+ * STATIC VARIABLE DEFINITIONS
+ ********************************/
+static pthread_mutex_t s_call_lock = PTHREAD_MUTEX_INITIALIZER;
+static char **s_calls = NULL;
+static size_t s_call_count = 0;
+static size_t s_call_cap = 0;
+
+static esp_bt_gap_cb_t s_gap_cb = NULL;
+static esp_a2d_cb_t s_a2d_cb = NULL;
+static esp_a2d_source_data_cb_t s_a2d_data_cb = NULL;
+static esp_avrc_ct_cb_t s_avrc_cb = NULL;
+
+static const char *s_media_ctrl_names[] = { "none", "check_src_rdy", "start", "suspend" };
+
+/*********************************
+ * STATIC FUNCTION DEFINITIONS
+ ********************************/
+
+static void fake_bt_record(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+static void fake_bt_record(const char *fmt, ...)
+{
+    char line[128];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+
+    pthread_mutex_lock(&s_call_lock);
+    if (s_call_count == s_call_cap) {
+        size_t cap = s_call_cap ? 2 * s_call_cap : 64;
+        char **calls = realloc(s_calls, cap * sizeof(*calls));
+        if (calls == NULL) {
+            pthread_mutex_unlock(&s_call_lock);
+            return;
+        }
+        s_calls = calls;
+        s_call_cap = cap;
+    }
+    char *copy = strdup(line);
+    if (copy) {
+        s_calls[s_call_count++] = copy;
+    }
+    pthread_mutex_unlock(&s_call_lock);
+}
+
+static void fake_bt_record_bda(const char *name, const uint8_t *bda)
+{
+    fake_bt_record("%s %02x:%02x:%02x:%02x:%02x:%02x", name, bda[0], bda[1], bda[2], bda[3], bda[4], bda[5]);
+}
+
+/*********************************
+ * EXTERN FUNCTION DEFINITIONS
+ ********************************/
+
+size_t fake_bt_call_count(void)
+{
+    pthread_mutex_lock(&s_call_lock);
+    size_t count = s_call_count;
+    pthread_mutex_unlock(&s_call_lock);
+    return count;
+}
+
+bool fake_bt_find_call(const char *text, size_t *from)
+{
+    bool found = false;
+    size_t len = strlen(text);
+    pthread_mutex_lock(&s_call_lock);
+    for (size_t i = *from; i < s_call_count; i++) {
+        if (strncmp(s_calls[i], text, len) == 0) {
+            *from = i + 1;
+            found = true;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&s_call_lock);
+    return found;
+}
+
+const char *fake_bt_call(size_t index)
+{
+    pthread_mutex_lock(&s_call_lock);
+    const char *call = index < s_call_count ? s_calls[index] : NULL;
+    pthread_mutex_unlock(&s_call_lock);
+    return call;
+}
+
+bool fake_bt_gap_event(esp_bt_gap_cb_event_t event, esp_bt_gap_cb_param_t *param)
+{
+    if (s_gap_cb == NULL) {
+        return false;
+    }
+    s_gap_cb(event, param);
+    return true;
+}
+
+bool fake_bt_a2d_event(esp_a2d_cb_event_t event, esp_a2d_cb_param_t *param)
+{
+    if (s_a2d_cb == NULL) {
+        return false;
+    }
+    s_a2d_cb(event, param);
+    return true;
+}
+
+bool fake_bt_avrc_event(esp_avrc_ct_cb_event_t event, esp_avrc_ct_cb_param_t *param)
+{
+    if (s_avrc_cb == NULL) {
+        return false;
+    }
+    s_avrc_cb(event, param);
+    return true;
+}
+
+int32_t fake_bt_a2d_pull(uint8_t *buf, int32_t len)
+{
+    return s_a2d_data_cb ? s_a2d_data_cb(buf, len) : -1;
+}
+
+/* GAP */
+
+esp_err_t esp_bt_gap_register_callback(esp_bt_gap_cb_t callback)
+{
+    fake_bt_record("esp_bt_gap_register_callback");
+    s_gap_cb = callback;
+    return ESP_OK;
+}
+
+esp_err_t esp_bt_gap_set_device_name(const char *name)
+{
+    fake_bt_record("esp_bt_gap_set_device_name %s", name);
+    return ESP_OK;
+}
+
+esp_err_t esp_bt_gap_get_device_name(void)
+{
+    fake_bt_record("esp_bt_gap_get_device_name");
+    return ESP_OK;
+}
+
+esp_err_t esp_bt_gap_set_scan_mode(esp_bt_connection_mode_t c_mode, esp_bt_discovery_mode_t d_mode)
+{
+    fake_bt_record("esp_bt_gap_set_scan_mode %d %d", c_mode, d_mode);
+    return ESP_OK;
+}
+
+esp_err_t esp_bt_gap_start_discovery(esp_bt_inq_mode_t mode, uint8_t inq_len, uint8_t num_rsps)
+{
+    fake_bt_record("esp_bt_gap_start_discovery %d %u %u", mode, inq_len, num_rsps);
+    return ESP_OK;
+}
+
+esp_err_t esp_bt_gap_cancel_discovery(void)
+{
+    fake_bt_record("esp_bt_gap_cancel_discovery");
+    return ESP_OK;
+}
+
+uint8_t *esp_bt_gap_resolve_eir_data(uint8_t *eir, uint8_t type, uint8_t *length)
+{
+    /* EIR is a list of length, type, data; a zero length ends it */
+    for (size_t at = 0; eir && at < ESP_BT_GAP_EIR_DATA_LEN && eir[at] != 0; at += eir[at] + 1u) {
+        if (eir[at + 1] == type) {
+            if (length) {
+                *length = eir[at] - 1;
+            }
+            return &eir[at + 2];
+        }
+    }
+    if (length) {
+        *length = 0;
+    }
+    return NULL;
+}
+
+esp_err_t esp_bt_gap_set_pin(esp_bt_pin_type_t pin_type, uint8_t pin_code_len, esp_bt_pin_code_t pin_code)
+{
+    (void)pin_code;
+    fake_bt_record("esp_bt_gap_set_pin %d %u", pin_type, pin_code_len);
+    return ESP_OK;
+}
+
+esp_err_t esp_bt_gap_pin_reply(esp_bd_addr_t bd_addr, bool accept, uint8_t pin_code_len, esp_bt_pin_code_t pin_code)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "esp_bt_gap_pin_reply %d %.*s", accept, pin_code_len, (const char *)pin_code);
+    fake_bt_record_bda(name, bd_addr);
+    return ESP_OK;
+}
+
+esp_err_t esp_bt_gap_set_security_param(esp_bt_sp_param_t param_type, void *value, uint8_t len)
+{
+    (void)value;
+    fake_bt_record("esp_bt_gap_set_security_param %d %u", param_type, len);
+    return ESP_OK;
+}
+
+esp_err_t esp_bt_gap_ssp_confirm_reply(esp_bd_addr_t bd_addr, bool accept)
+{
+    fake_bt_record_bda(accept ? "esp_bt_gap_ssp_confirm_reply 1" : "esp_bt_gap_ssp_confirm_reply 0", bd_addr);
+    return ESP_OK;
+}
+
+/* A2DP source */
+
+esp_err_t esp_a2d_register_callback(esp_a2d_cb_t callback)
+{
+    fake_bt_record("esp_a2d_register_callback");
+    s_a2d_cb = callback;
+    return ESP_OK;
+}
+
+esp_err_t esp_a2d_source_register_data_callback(esp_a2d_source_data_cb_t callback)
+{
+    fake_bt_record("esp_a2d_source_register_data_callback");
+    s_a2d_data_cb = callback;
+    return ESP_OK;
+}
+
+esp_err_t esp_a2d_source_init(void)
+{
+    fake_bt_record("esp_a2d_source_init");
+    return ESP_OK;
+}
+
+esp_err_t esp_a2d_source_connect(esp_bd_addr_t remote_bda)
+{
+    fake_bt_record_bda("esp_a2d_source_connect", remote_bda);
+    return ESP_OK;
+}
+
+esp_err_t esp_a2d_source_disconnect(esp_bd_addr_t remote_bda)
+{
+    fake_bt_record_bda("esp_a2d_source_disconnect", remote_bda);
+    return ESP_OK;
+}
+
+esp_err_t esp_a2d_media_ctrl(esp_a2d_media_ctrl_t ctrl)
+{
+    if ((unsigned)ctrl >= sizeof(s_media_ctrl_names) / sizeof(s_media_ctrl_names[0])) {
+        fake_bt_record("esp_a2d_media_ctrl %d", ctrl);
+        return ESP_ERR_INVALID_ARG;
+    }
+    fake_bt_record("esp_a2d_media_ctrl %s", s_media_ctrl_names[ctrl]);
+    return ESP_OK;
+}
+
+/* AVRC controller */
+
+esp_err_t esp_avrc_ct_init(void)
+{
+    fake_bt_record("esp_avrc_ct_init");
+    return ESP_OK;
+}
+
+esp_err_t esp_avrc_ct_register_callback(esp_avrc_ct_cb_t callback)
+{
+    fake_bt_record("esp_avrc_ct_register_callback");
+    s_avrc_cb = callback;
+    return ESP_OK;
+}
+
+esp_err_t esp_avrc_tg_set_rn_evt_cap(const esp_avrc_rn_evt_cap_mask_t *evt_set)
+{
+    fake_bt_record("esp_avrc_tg_set_rn_evt_cap 0x%04x", evt_set->bits);
+    return ESP_OK;
+}
+
+bool esp_avrc_rn_evt_bit_mask_operation(esp_avrc_bit_mask_op_t op, esp_avrc_rn_evt_cap_mask_t *events,
+                                        esp_avrc_rn_event_ids_t event_id)
+{
+    if (events == NULL || event_id >= 16) {
+        return false;
+    }
+    uint16_t bit = (uint16_t)(1u << event_id);
+    switch (op) {
+    case ESP_AVRC_BIT_MASK_OP_SET:
+        events->bits |= bit;
+        return true;
+    case ESP_AVRC_BIT_MASK_OP_CLEAR:
+        events->bits &= (uint16_t)~bit;
+        return true;
+    case ESP_AVRC_BIT_MASK_OP_TEST:
+    default:
+        return (events->bits & bit) != 0;
+    }
+}
+
+esp_err_t esp_avrc_ct_send_get_rn_capabilities_cmd(uint8_t tl)
+{
+    fake_bt_record("esp_avrc_ct_send_get_rn_capabilities_cmd %u", tl);
+    return ESP_OK;
+}
+
+esp_err_t esp_avrc_ct_send_register_notification_cmd(uint8_t tl, uint8_t event_id, uint32_t event_parameter)
+{
+    fake_bt_record("esp_avrc_ct_send_register_notification_cmd %u 0x%02x %u", tl, event_id, (unsigned)event_parameter);
+    return ESP_OK;
+}
+
+esp_err_t esp_avrc_ct_send_set_absolute_volume_cmd(uint8_t tl, uint8_t volume)
+{
+    fake_bt_record("esp_avrc_ct_send_set_absolute_volume_cmd %u %u", tl, volume);
+    return ESP_OK;
+}
+
+/* the script driver stands in for the console's UART */
+void bt_app_console_start(void)
+{
+    fake_bt_record("bt_app_console_start");
+}
@@ -0,0 +1,59 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#ifndef __FAKE_BT_STACK_H__
+#define __FAKE_BT_STACK_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_gap_bt_api.h"
+#include "esp_a2dp_api.h"
+#include "esp_avrc_api.h"
+
+/*
+ * Stand-in for Bluedroid's GAP, A2DP source and AVRC controller in the host
+ * build. Every call the application makes into them is recorded as a line
+ * of text, the function name followed by its interesting arguments, e.g.
+ * "esp_a2d_media_ctrl start" or "esp_a2d_source_connect 11:22:33:44:55:66".
+ * Events go the other way through fake_bt_*_event(), which call the
+ * registered callbacks in the calling thread, as the Bluetooth task would.
+ */
+
+/* calls recorded so far */
+size_t fake_bt_call_count(void);
+
+/**
+ * @brief    the first recorded call at or after *from that starts with text;
+ *           *from moves past it
+ *
+ * @return  true if there is one
+ */
+bool fake_bt_find_call(const char *text, size_t *from);
+
+/**
+ * @brief    a recorded call
+ *
+ * @return  its text, NULL past the last one
+ */
+const char *fake_bt_call(size_t index);
+
+/**
+ * @brief    deliver an event to the callback the application registered
+ *
+ * @return  false if it has registered none yet
+ */
+bool fake_bt_gap_event(esp_bt_gap_cb_event_t event, esp_bt_gap_cb_param_t *param);
+bool fake_bt_a2d_event(esp_a2d_cb_event_t event, esp_a2d_cb_param_t *param);
+bool fake_bt_avrc_event(esp_avrc_ct_cb_event_t event, esp_avrc_ct_cb_param_t *param);
+
+/**
+ * @brief    ask the registered A2DP data callback for len bytes, as the
+ *           source does once per media packet
+ *
+ * @return  what the callback returned, -1 if none is registered
+ */
+int32_t fake_bt_a2d_pull(uint8_t *buf, int32_t len);
+
+#endif /* __FAKE_BT_STACK_H__ */
@@ -0,0 +1,228 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/*
+ * Host bench of the dispatch parameter pool.
+ *
+ *   pool_bench
+ *
+ * single    one task allocating and freeing, against malloc and free
+ * exhaust   every block taken; further copies must go to the heap and all
+ *           of it come back
+ * dispatch  three callback threads copying events into a 10-deep queue for
+ *           one task that checks and frees them, like bt_app_work_dispatch
+ *
+ * Exits with 1 if a scenario finds a block handed out twice, a copy
+ * damaged or a block not returned.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <time.h>
+#include "bt_app_pool.h"
+
+#define SINGLE_OPS          (5000000)
+#define DISPATCH_THREADS    (3)
+#define DISPATCH_EVENTS     (200000)    /* per thread */
+#define QUEUE_DEPTH         (10)
+
+typedef struct {
+    void *items[QUEUE_DEPTH];
+    size_t lens[QUEUE_DEPTH];
+    size_t head, count;
+    int producers;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+} queue_t;
+
+static queue_t s_queue = { .lock = PTHREAD_MUTEX_INITIALIZER, .changed = PTHREAD_COND_INITIALIZER };
+
+static uint64_t now_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000u + (uint64_t)t.tv_nsec;
+}
+
+static bool pool_idle(const char *name)
+{
+    bt_app_pool_stats_t st;
+    bt_app_pool_get_stats(&st);
+    for (int i = 0; i < BT_APP_POOL_CLASSES; i++) {
+        if (st.classes[i].in_use != 0) {
+            printf("          FAIL: %s left %" PRIu32 " blocks of %" PRIu32 " B in use\n",
+                   name, st.classes[i].in_use, st.classes[i].block_bytes);
+            return false;
+        }
+    }
+    if (st.heap_in_use != 0) {
+        printf("          FAIL: %s left %" PRIu32 " heap copies\n", name, st.heap_in_use);
+        return false;
+    }
+    return true;
+}
+
+static bool run_single(void)
+{
+    volatile uintptr_t sink = 0;
+    uint64_t t0 = now_ns();
+    for (int i = 0; i < SINGLE_OPS; i++) {
+        void *p = bt_app_pool_alloc(16);
+        sink += (uintptr_t)p;
+        bt_app_pool_free(p);
+    }
+    uint64_t t1 = now_ns();
+    for (int i = 0; i < SINGLE_OPS; i++) {
+        void *p = malloc(16);
+        sink += (uintptr_t)p;
+        free(p);
+    }
+    uint64_t t2 = now_ns();
+    (void)sink;
+    printf("single    pool %5.1f ns  malloc %5.1f ns  per alloc and free\n",
+           (double)(t1 - t0) / SINGLE_OPS, (double)(t2 - t1) / SINGLE_OPS);
+    return pool_idle("single");
+}
+
+static bool run_exhaust(void)
+{
+    enum { EXTRA = 4, TOTAL = BT_APP_POOL_SMALL_BLOCKS + BT_APP_POOL_LARGE_BLOCKS + EXTRA };
+    void *held[TOTAL];
+    bt_app_pool_stats_t before, after;
+    bool ok = true;
+
+    bt_app_pool_get_stats(&before);
+    for (int i = 0; i < TOTAL; i++) {
+        held[i] = bt_app_pool_alloc(BT_APP_POOL_SMALL_BYTES);
+        memset(held[i], i, BT_APP_POOL_SMALL_BYTES);
+    }
+    for (int i = 0; i < TOTAL && ok; i++) {
+        for (int j = 0; j < BT_APP_POOL_SMALL_BYTES; j++) {
+            if (((uint8_t *)held[i])[j] != (uint8_t)i) {
+                printf("          FAIL: block %d overlaps another\n", i);
+                ok = false;
+                break;
+            }
+        }
+    }
+    bt_app_pool_get_stats(&after);
+    uint32_t misses = after.misses - before.misses;
+    printf("exhaust   %d copies: %" PRIu32 " small, %" PRIu32 " large, %" PRIu32 " heap\n", TOTAL,
+           after.classes[0].in_use, after.classes[1].in_use, misses);
+    if (misses != EXTRA || after.classes[0].in_use != BT_APP_POOL_SMALL_BLOCKS ||
+            after.classes[1].in_use != BT_APP_POOL_LARGE_BLOCKS) {
+        printf("          FAIL: expected the small class, then the large one, then %d heap copies\n", EXTRA);
+        ok = false;
+    }
+    for (int i = TOTAL - 1; i >= 0; i--) {
+        bt_app_pool_free(held[i]);
+    }
+    return pool_idle("exhaust") && ok;
+}
+
+static void *producer(void *arg)
+{
+    uint32_t id = (uint32_t)(uintptr_t)arg, seed = id * 2654435761u + 1;
+    for (uint32_t n = 0; n < DISPATCH_EVENTS; n++) {
+        seed = seed * 1103515245u + 12345u;
+        /* mostly A2DP- and AVRC-sized events, now and then one that fits no class */
+        size_t len = (seed >> 16) % 64 == 0 ? 96 : 4 + (seed >> 8) % (BT_APP_POOL_LARGE_BYTES - 4);
+        uint8_t *p = bt_app_pool_alloc(len);
+        memset(p, (int)(id * 64 + len), len);
+
+        pthread_mutex_lock(&s_queue.lock);
+        while (s_queue.count == QUEUE_DEPTH) {
+            pthread_cond_wait(&s_queue.changed, &s_queue.lock);
+        }
+        size_t at = (s_queue.head + s_queue.count++) % QUEUE_DEPTH;
+        s_queue.items[at] = p;
+        s_queue.lens[at] = len;
+        pthread_cond_broadcast(&s_queue.changed);
+        pthread_mutex_unlock(&s_queue.lock);
+    }
+    pthread_mutex_lock(&s_queue.lock);
+    s_queue.producers--;
+    pthread_cond_broadcast(&s_queue.changed);
+    pthread_mutex_unlock(&s_queue.lock);
+    return NULL;
+}
+
+static bool run_dispatch(void)
+{
+    pthread_t threads[DISPATCH_THREADS];
+    bt_app_pool_stats_t before, after;
+    uint64_t events = 0, damaged = 0;
+
+    bt_app_pool_get_stats(&before);
+    s_queue.producers = DISPATCH_THREADS;
+    uint64_t t0 = now_ns();
+    for (uintptr_t i = 0; i < DISPATCH_THREADS; i++) {
+        pthread_create(&threads[i], NULL, producer, (void *)i);
+    }
+    for (;;) {
+        pthread_mutex_lock(&s_queue.lock);
+        while (s_queue.count == 0 && s_queue.producers > 0) {
+            pthread_cond_wait(&s_queue.changed, &s_queue.lock);
+        }
+        if (s_queue.count == 0) {
+            pthread_mutex_unlock(&s_queue.lock);
+            break;
+        }
+        uint8_t *p = s_queue.items[s_queue.head];
+        size_t len = s_queue.lens[s_queue.head];
+        s_queue.head = (s_queue.head + 1) % QUEUE_DEPTH;
+        s_queue.count--;
+        pthread_cond_broadcast(&s_queue.changed);
+        pthread_mutex_unlock(&s_queue.lock);
+
+        /* every byte carries the same mark; another thread's copy would differ */
+        for (size_t i = 1; i < len; i++) {
+            if (p[i] != p[0]) {
+                damaged++;
+                break;
+            }
+        }
+        bt_app_pool_free(p);
+        events++;
+    }
+    uint64_t elapsed = now_ns() - t0;
+    for (int i = 0; i < DISPATCH_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    bt_app_pool_get_stats(&after);
+
+    uint32_t hits = 0;
+    for (int i = 0; i < BT_APP_POOL_CLASSES; i++) {
+        hits += after.classes[i].hits - before.classes[i].hits;
+    }
+    uint32_t misses = after.misses - before.misses;
+    printf("dispatch  %" PRIu64 " events in %.2f s, %.0f ns each; %" PRIu32 " pool, %" PRIu32 " heap; "
+           "high water %" PRIu32 "/%" PRIu32 " small %" PRIu32 "/%" PRIu32 " large\n",
+           events, (double)elapsed / 1e9, (double)elapsed / (double)events, hits, misses,
+           after.classes[0].high_water, after.classes[0].blocks, after.classes[1].high_water, after.classes[1].blocks);
+
+    bool ok = pool_idle("dispatch");
+    if (damaged) {
+        printf("          FAIL: %" PRIu64 " copies damaged\n", damaged);
+        ok = false;
+    }
+    if (events != (uint64_t)DISPATCH_THREADS * DISPATCH_EVENTS || hits + misses != events) {
+        printf("          FAIL: events lost or counted wrong\n");
+        ok = false;
+    }
+    return ok;
+}
+
+int main(void)
+{
+    bool ok = run_single();
+    ok &= run_exhaust();
+    ok &= run_dispatch();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#ifndef __HOST_ESP_A2DP_API_H__
+#define __HOST_ESP_A2DP_API_H__
+
+#include "esp_bt_defs.h"
+
+typedef enum {
+    ESP_A2D_CONNECTION_STATE_EVT = 0,
+    ESP_A2D_AUDIO_STATE_EVT,
+    ESP_A2D_AUDIO_CFG_EVT,
+    ESP_A2D_MEDIA_CTRL_ACK_EVT,
+    ESP_A2D_PROF_STATE_EVT,
+    ESP_A2D_SNK_PSC_CFG_EVT,
+    ESP_A2D_SNK_SET_DELAY_VALUE_EVT,
+    ESP_A2D_SNK_GET_DELAY_VALUE_EVT,
+    ESP_A2D_REPORT_SNK_DELAY_VALUE_EVT,
+} esp_a2d_cb_event_t;
+
+typedef enum {
+    ESP_A2D_CONNECTION_STATE_DISCONNECTED = 0,
+    ESP_A2D_CONNECTION_STATE_CONNECTING,
+    ESP_A2D_CONNECTION_STATE_CONNECTED,
+    ESP_A2D_CONNECTION_STATE_DISCONNECTING,
+} esp_a2d_connection_state_t;
+
+typedef enum {
+    ESP_A2D_DISC_RSN_NORMAL = 0,
+    ESP_A2D_DISC_RSN_ABNORMAL,
+} esp_a2d_disc_rsn_t;
+
+typedef enum {
+    ESP_A2D_AUDIO_STATE_SUSPEND = 0,
+    ESP_A2D_AUDIO_STATE_STARTED,
+} esp_a2d_audio_state_t;
+
+typedef enum {
+    ESP_A2D_MEDIA_CTRL_NONE = 0,
+    ESP_A2D_MEDIA_CTRL_CHECK_SRC_RDY,
+    ESP_A2D_MEDIA_CTRL_START,
+    ESP_A2D_MEDIA_CTRL_SUSPEND,
+} esp_a2d_media_ctrl_t;
+
+typedef enum {
+    ESP_A2D_MEDIA_CTRL_ACK_SUCCESS = 0,
+    ESP_A2D_MEDIA_CTRL_ACK_FAILURE,
+    ESP_A2D_MEDIA_CTRL_ACK_BUSY,
+} esp_a2d_media_ctrl_ack_t;
+
+typedef struct {
+    uint8_t type;
+    union {
+        uint8_t sbc[4];
+        uint8_t m12[4];
+        uint8_t m24[6];
+        uint8_t atrac[7];
+    } cie;
+} esp_a2d_mcc_t;
+
+typedef union {
+    struct a2d_conn_stat_param {
+        esp_a2d_connection_state_t state;
+        esp_bd_addr_t remote_bda;
+        esp_a2d_disc_rsn_t disc_rsn;
+    } conn_stat;
+    struct a2d_audio_stat_param {
+        esp_a2d_audio_state_t state;
+        esp_bd_addr_t remote_bda;
+    } audio_stat;
+    struct a2d_audio_cfg_param {
+        esp_bd_addr_t remote_bda;
+        esp_a2d_mcc_t mcc;
+    } audio_cfg;
+    struct media_ctrl_stat_param {
+        esp_a2d_media_ctrl_t cmd;
+        esp_a2d_media_ctrl_ack_t status;
+    } media_ctrl_stat;
+    struct a2d_report_delay_stat_param {
+        uint16_t delay_value;
+    } a2d_report_delay_value_stat;
+} esp_a2d_cb_param_t;
+
+typedef void (* esp_a2d_cb_t)(esp_a2d_cb_event_t event, esp_a2d_cb_param_t *param);
+typedef int32_t (* esp_a2d_source_data_cb_t)(uint8_t *buf, int32_t len);
+
+esp_err_t esp_a2d_register_callback(esp_a2d_cb_t callback);
+esp_err_t esp_a2d_source_register_data_callback(esp_a2d_source_data_cb_t callback);
+esp_err_t esp_a2d_source_init(void);
+esp_err_t esp_a2d_source_connect(esp_bd_addr_t remote_bda);
+esp_err_t esp_a2d_source_disconnect(esp_bd_addr_t remote_bda);
+esp_err_t esp_a2d_media_ctrl(esp_a2d_media_ctrl_t ctrl);
+
+#endif /* __HOST_ESP_A2DP_API_H__ */
@@ -0,0 +1,27 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#ifndef __HOST_ESP_BT_H__
+#define __HOST_ESP_BT_H__
+
+#include "esp_bt_defs.h"
+
+typedef enum {
+    ESP_BT_MODE_IDLE = 0x00,
+    ESP_BT_MODE_BLE = 0x01,
+    ESP_BT_MODE_CLASSIC_BT = 0x02,
+    ESP_BT_MODE_BTDM = 0x03,
+} esp_bt_mode_t;
+
+typedef struct {
+    uint8_t mode;
+} esp_bt_controller_config_t;
+
+#define BT_CONTROLLER_INIT_CONFIG_DEFAULT()     { .mode = ESP_BT_MODE_CLASSIC_BT }
+
+esp_err_t esp_bt_controller_mem_release(esp_bt_mode_t mode);
+esp_err_t esp_bt_controller_init(esp_bt_controller_config_t *cfg);
+esp_err_t esp_bt_controller_enable(esp_bt_mode_t mode);
+
+#endif /* __HOST_ESP_BT_H__ */
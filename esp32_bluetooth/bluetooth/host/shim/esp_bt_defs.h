@@ -0,0 +1,23 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#ifndef __HOST_ESP_BT_DEFS_H__
+#define __HOST_ESP_BT_DEFS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#define ESP_BD_ADDR_LEN     6
+typedef uint8_t esp_bd_addr_t[ESP_BD_ADDR_LEN];
+
+typedef enum {
+    ESP_BT_STATUS_SUCCESS = 0,
+    ESP_BT_STATUS_FAIL,
+    ESP_BT_STATUS_NOT_READY,
+    ESP_BT_STATUS_NOMEM,
+    ESP_BT_STATUS_BUSY,
+} esp_bt_status_t;
+
+#endif /* __HOST_ESP_BT_DEFS_H__ */
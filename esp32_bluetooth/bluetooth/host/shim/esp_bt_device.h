@@ -0,0 +1,12 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#ifndef __HOST_ESP_BT_DEVICE_H__
+#define __HOST_ESP_BT_DEVICE_H__
+
+#include "esp_bt_defs.h"
+
+const uint8_t *esp_bt_dev_get_address(void);
+
+#endif /* __HOST_ESP_BT_DEVICE_H__ */
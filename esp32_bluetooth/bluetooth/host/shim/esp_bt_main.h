@@ -0,0 +1,19 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#ifndef __HOST_ESP_BT_MAIN_H__
+#define __HOST_ESP_BT_MAIN_H__
+
+#include "esp_bt_defs.h"
+
+typedef struct {
+    bool ssp_en;
+} esp_bluedroid_config_t;
+
+#define BT_BLUEDROID_INIT_CONFIG_DEFAULT()      { .ssp_en = true }
+
+esp_err_t esp_bluedroid_init_with_cfg(esp_bluedroid_config_t *cfg);
+esp_err_t esp_bluedroid_enable(void);
+
+#endif /* __HOST_ESP_BT_MAIN_H__ */
@@ -0,0 +1,48 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#ifndef __HOST_ESP_LOG_H__
+#define __HOST_ESP_LOG_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+void shim_log(esp_log_level_t level, const char *tag, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+void shim_log_hex(const char *tag, const void *buf, size_t len);
+
+/**
+ * @brief    lines at this level or more important are printed; all lines
+ *           down to info are kept for shim_log_find() whatever the level
+ */
+void shim_log_set_print_level(esp_log_level_t level);
+
+/**
+ * @brief    the first kept line at or after *from that contains text; *from
+ *           moves past it
+ *
+ * @return  true if there is one
+ */
+bool shim_log_find(const char *text, size_t *from);
+
+/* lines kept so far */
+size_t shim_log_count(void);
+
+#define ESP_LOGE(tag, fmt, ...)     shim_log(ESP_LOG_ERROR, tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...)     shim_log(ESP_LOG_WARN, tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...)     shim_log(ESP_LOG_INFO, tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...)     shim_log(ESP_LOG_DEBUG, tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGV(tag, fmt, ...)     shim_log(ESP_LOG_VERBOSE, tag, fmt, ##__VA_ARGS__)
+#define ESP_LOG_BUFFER_HEX(tag, buf, len)   shim_log_hex(tag, buf, len)
+
+#endif /* __HOST_ESP_LOG_H__ */
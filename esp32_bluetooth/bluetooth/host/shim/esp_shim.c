@@ -0,0 +1,188 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs_flash.h"
+#include "esp_bt.h"
+#include "esp_bt_main.h"
+#include "esp_bt_device.h"
+
+#define LOG_LINE_BYTES      (256)
+
+/*********************************
+ * STATIC VARIABLE DEFINITIONS
+ ********************************/
+static pthread_mutex_t s_log_lock = PTHREAD_MUTEX_INITIALIZER;
+static char **s_log_lines = NULL;    /* info and more important, in order */
+static size_t s_log_count = 0;
+static size_t s_log_cap = 0;
+static esp_log_level_t s_print_level = ESP_LOG_WARN;
+static const uint8_t s_own_bda[ESP_BD_ADDR_LEN] = {0x24, 0x0a, 0xc4, 0x00, 0x00, 0x01};
+
+/*********************************
+ * STATIC FUNCTION DEFINITIONS
+ ********************************/
+
+static void shim_log_keep(const char *line)
+{
+    if (s_log_count == s_log_cap) {
+        size_t cap = s_log_cap ? 2 * s_log_cap : 256;
+        char **lines = realloc(s_log_lines, cap * sizeof(*lines));
+        if (lines == NULL) {
+            return;
+        }
+        s_log_lines = lines;
+        s_log_cap = cap;
+    }
+    char *copy = strdup(line);
+    if (copy) {
+        s_log_lines[s_log_count++] = copy;
+    }
+}
+
+/*********************************
+ * EXTERN FUNCTION DEFINITIONS
+ ********************************/
+
+void shim_log(esp_log_level_t level, const char *tag, const char *fmt, ...)
+{
+    static const char letters[] = "NEWIDV";
+    char line[LOG_LINE_BYTES];
+    int n = snprintf(line, sizeof(line), "%c (%s) ", letters[level], tag);
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(line + n, sizeof(line) - n, fmt, args);
+    va_end(args);
+
+    pthread_mutex_lock(&s_log_lock);
+    if (level <= ESP_LOG_INFO) {
+        shim_log_keep(line);
+    }
+    if (level <= s_print_level) {
+        fprintf(stderr, "%s\n", line);
+    }
+    pthread_mutex_unlock(&s_log_lock);
+}
+
+void shim_log_hex(const char *tag, const void *buf, size_t len)
+{
+    char text[3 * 16 + 1];
+    const uint8_t *bytes = buf;
+    for (size_t at = 0; at < len; at += 16) {
+        size_t n = 0;
+        for (size_t i = at; i < len && i < at + 16; i++) {
+            n += snprintf(text + n, sizeof(text) - n, "%02x ", bytes[i]);
+        }
+        shim_log(ESP_LOG_INFO, tag, "%s", text);
+    }
+}
+
+void shim_log_set_print_level(esp_log_level_t level)
+{
+    pthread_mutex_lock(&s_log_lock);
+    s_print_level = level;
+    pthread_mutex_unlock(&s_log_lock);
+}
+
+bool shim_log_find(const char *text, size_t *from)
+{
+    bool found = false;
+    pthread_mutex_lock(&s_log_lock);
+    for (size_t i = *from; i < s_log_count; i++) {
+        if (strstr(s_log_lines[i], text)) {
+            *from = i + 1;
+            found = true;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&s_log_lock);
+    return found;
+}
+
+size_t shim_log_count(void)
+{
+    pthread_mutex_lock(&s_log_lock);
+    size_t count = s_log_count;
+    pthread_mutex_unlock(&s_log_lock);
+    return count;
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK:
+        return "ESP_OK";
+    case ESP_FAIL:
+        return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+        return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+        return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_TIMEOUT:
+        return "ESP_ERR_TIMEOUT";
+    default:
+        return "UNKNOWN ERROR";
+    }
+}
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (int64_t)t.tv_sec * 1000000 + t.tv_nsec / 1000;
+}
+
+/* flash, controller and host stack have nothing to bring up on the host */
+esp_err_t nvs_flash_init(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_bt_controller_mem_release(esp_bt_mode_t mode)
+{
+    (void)mode;
+    return ESP_OK;
+}
+
+esp_err_t esp_bt_controller_init(esp_bt_controller_config_t *cfg)
+{
+    return cfg ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t esp_bt_controller_enable(esp_bt_mode_t mode)
+{
+    return mode == ESP_BT_MODE_CLASSIC_BT ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t esp_bluedroid_init_with_cfg(esp_bluedroid_config_t *cfg)
+{
+    return cfg ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t esp_bluedroid_enable(void)
+{
+    return ESP_OK;
+}
+
+const uint8_t *esp_bt_dev_get_address(void)
+{
+    return s_own_bda;
+}
@@ -0,0 +1,10 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#ifndef __HOST_ESP_SYSTEM_H__
+#define __HOST_ESP_SYSTEM_H__
+
+#include "esp_err.h"
+
+#endif /* __HOST_ESP_SYSTEM_H__ */
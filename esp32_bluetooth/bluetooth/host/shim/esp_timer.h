@@ -0,0 +1,13 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#ifndef __HOST_ESP_TIMER_H__
+#define __HOST_ESP_TIMER_H__
+
+#include <stdint.h>
+
+/* microseconds of the monotonic clock */
+int64_t esp_timer_get_time(void);
+
+#endif /* __HOST_ESP_TIMER_H__ */
@@ -0,0 +1,33 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#ifndef __HOST_FREERTOS_H__
+#define __HOST_FREERTOS_H__
+
+/*
+ * The part of FreeRTOS the firmware uses, on POSIX threads, for the host
+ * build. Tasks are threads, semaphores are a counter under a mutex,
+ * blocking times are real time. Software timers run on virtual time that
+ * only moves when the host program advances it (shim_timers_advance()),
+ * so a ten second heart beat costs nothing in a test.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOSConfig.h"
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdFALSE                     ((BaseType_t)0)
+#define pdTRUE                      ((BaseType_t)1)
+#define pdFAIL                      pdFALSE
+#define pdPASS                      pdTRUE
+#define portMAX_DELAY               ((TickType_t)0xffffffffu)
+#define portTICK_PERIOD_MS          ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)           ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+
+#endif /* __HOST_FREERTOS_H__ */
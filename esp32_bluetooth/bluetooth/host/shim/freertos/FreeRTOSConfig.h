@@ -0,0 +1,13 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#ifndef __HOST_FREERTOS_CONFIG_H__
+#define __HOST_FREERTOS_CONFIG_H__
+
+/* as in the pen's sdkconfig */
+#define CONFIG_FREERTOS_HZ          100
+#define configTICK_RATE_HZ          CONFIG_FREERTOS_HZ
+#define configMAX_PRIORITIES        25
+
+#endif /* __HOST_FREERTOS_CONFIG_H__ */
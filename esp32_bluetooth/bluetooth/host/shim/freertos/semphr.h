@@ -0,0 +1,20 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#ifndef __HOST_FREERTOS_SEMPHR_H__
+#define __HOST_FREERTOS_SEMPHR_H__
+
+#include "freertos/FreeRTOS.h"
+
+/* a mutex is a binary semaphore here: no recursion, no priority inheritance */
+typedef struct shim_sem *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+void vSemaphoreDelete(SemaphoreHandle_t sem);
+
+#endif /* __HOST_FREERTOS_SEMPHR_H__ */
@@ -0,0 +1,31 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#ifndef __HOST_FREERTOS_TASK_H__
+#define __HOST_FREERTOS_TASK_H__
+
+#include "freertos/FreeRTOS.h"
+
+/* host stacks get this much on top of what the task asks for: glibc's
+ * printf alone needs more than a 2 KiB ESP32 task has */
+#define SHIM_TASK_STACK_EXTRA       (64 * 1024)
+
+typedef struct shim_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_bytes, void *arg,
+                       UBaseType_t prio, TaskHandle_t *handle);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_bytes, void *arg,
+                                   UBaseType_t prio, TaskHandle_t *handle, BaseType_t core);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount(void);
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks);
+
+/* bytes of the task's stack never touched, counted on the host stack (see SHIM_TASK_STACK_EXTRA) */
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+#endif /* __HOST_FREERTOS_TASK_H__ */
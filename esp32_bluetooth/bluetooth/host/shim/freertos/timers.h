@@ -0,0 +1,28 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#ifndef __HOST_FREERTOS_TIMERS_H__
+#define __HOST_FREERTOS_TIMERS_H__
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct shim_timer *TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t timer);
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t auto_reload, void *id,
+                           TimerCallbackFunction_t cb);
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t ticks);
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticks);
+BaseType_t xTimerDelete(TimerHandle_t timer, TickType_t ticks);
+void *pvTimerGetTimerID(TimerHandle_t timer);
+
+/**
+ * @brief    move virtual time on by ms and run the callbacks of the timers
+ *           that fall due, in the calling thread, in order of their expiry
+ *
+ * @return  callbacks run
+ */
+int shim_timers_advance(uint32_t ms);
+
+#endif /* __HOST_FREERTOS_TIMERS_H__ */
@@ -0,0 +1,398 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/timers.h"
+
+#define STACK_PAINT     (0xa5)
+
+struct shim_task {
+    pthread_t       thread;
+    TaskFunction_t  fn;
+    void            *arg;
+    uint8_t         *stack;
+    size_t          stack_bytes;
+    pthread_mutex_t lock;
+    pthread_cond_t  notified;
+    uint32_t        notify_count;
+};
+
+struct shim_sem {
+    pthread_mutex_t lock;
+    pthread_cond_t  changed;
+    UBaseType_t     count;
+    UBaseType_t     max;
+};
+
+struct shim_timer {
+    TimerCallbackFunction_t cb;
+    void                    *id;
+    uint64_t                period_ms;
+    uint64_t                due_ms;
+    bool                    auto_reload;
+    bool                    active;
+    struct shim_timer       *next;
+};
+
+/*********************************
+ * STATIC VARIABLE DEFINITIONS
+ ********************************/
+static __thread struct shim_task *s_self = NULL;
+static struct shim_task s_main_task;    /* stands for any thread the shim did not start */
+static pthread_once_t s_main_task_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t s_timer_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct shim_timer *s_timers = NULL;
+static uint64_t s_virtual_ms = 0;
+
+/*********************************
+ * STATIC FUNCTION DEFINITIONS
+ ********************************/
+
+/* the deadline of a wait of so many ticks; false for a wait without one */
+static bool shim_deadline(TickType_t ticks, struct timespec *at)
+{
+    if (ticks == portMAX_DELAY) {
+        return false;
+    }
+    uint64_t ns = (uint64_t)ticks * portTICK_PERIOD_MS * 1000000u;
+    clock_gettime(CLOCK_MONOTONIC, at);
+    ns += (uint64_t)at->tv_nsec;
+    at->tv_sec += (time_t)(ns / 1000000000u);
+    at->tv_nsec = (long)(ns % 1000000000u);
+    return true;
+}
+
+static void shim_cond_init(pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static void shim_main_task_init(void)
+{
+    pthread_mutex_init(&s_main_task.lock, NULL);
+    shim_cond_init(&s_main_task.notified);
+}
+
+static struct shim_task *shim_current(void)
+{
+    if (s_self) {
+        return s_self;
+    }
+    pthread_once(&s_main_task_once, shim_main_task_init);
+    return &s_main_task;
+}
+
+static void *shim_task_main(void *arg)
+{
+    struct shim_task *task = arg;
+    s_self = task;
+    task->fn(task->arg);
+    return NULL;
+}
+
+/*********************************
+ * EXTERN FUNCTION DEFINITIONS
+ ********************************/
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_bytes, void *arg,
+                                   UBaseType_t prio, TaskHandle_t *handle, BaseType_t core)
+{
+    (void)name;
+    (void)prio;
+    (void)core;
+
+    struct shim_task *task = calloc(1, sizeof(*task));
+    if (task == NULL) {
+        return pdFAIL;
+    }
+    task->fn = fn;
+    task->arg = arg;
+    task->stack_bytes = stack_bytes + SHIM_TASK_STACK_EXTRA;
+    if (posix_memalign((void **)&task->stack, 4096, task->stack_bytes) != 0) {
+        free(task);
+        return pdFAIL;
+    }
+    /* painted, so the untouched part can be measured */
+    memset(task->stack, STACK_PAINT, task->stack_bytes);
+    pthread_mutex_init(&task->lock, NULL);
+    shim_cond_init(&task->notified);
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, task->stack, task->stack_bytes);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int err = pthread_create(&task->thread, &attr, shim_task_main, task);
+    pthread_attr_destroy(&attr);
+    if (err != 0) {
+        free(task->stack);
+        free(task);
+        return pdFAIL;
+    }
+    if (handle) {
+        *handle = task;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_bytes, void *arg,
+                       UBaseType_t prio, TaskHandle_t *handle)
+{
+    return xTaskCreatePinnedToCore(fn, name, stack_bytes, arg, prio, handle, 0);
+}
+
+/* a task ending itself returns from its thread; deleting another task
+ * cancels its thread, which ends at its next blocking wait. The stack is
+ * not freed: a cancelled thread may still be on it. */
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task == NULL || task == s_self) {
+        pthread_exit(NULL);
+    }
+    pthread_cancel(task->thread);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    struct timespec at;
+    if (shim_deadline(ticks, &at)) {
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &at, NULL) == EINTR) {
+        }
+    }
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (TickType_t)(((uint64_t)t.tv_sec * 1000u + (uint64_t)t.tv_nsec / 1000000u) / portTICK_PERIOD_MS);
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    if (task == NULL) {
+        return pdFAIL;
+    }
+    pthread_mutex_lock(&task->lock);
+    task->notify_count++;
+    pthread_cond_signal(&task->notified);
+    pthread_mutex_unlock(&task->lock);
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks)
+{
+    struct shim_task *task = shim_current();
+    struct timespec at;
+    bool timed = shim_deadline(ticks, &at);
+
+    pthread_mutex_lock(&task->lock);
+    while (task->notify_count == 0 && ticks != 0) {
+        if (timed) {
+            if (pthread_cond_timedwait(&task->notified, &task->lock, &at) == ETIMEDOUT) {
+                break;
+            }
+        } else {
+            pthread_cond_wait(&task->notified, &task->lock);
+        }
+    }
+    uint32_t count = task->notify_count;
+    if (count > 0) {
+        task->notify_count = clear ? 0 : count - 1;
+    }
+    pthread_mutex_unlock(&task->lock);
+    return count;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    if (task == NULL || task->stack == NULL) {
+        return 0;
+    }
+    /* the stack grows down, from the end of the block */
+    size_t untouched = 0;
+    while (untouched < task->stack_bytes && task->stack[untouched] == STACK_PAINT) {
+        untouched++;
+    }
+    return (UBaseType_t)untouched;
+}
+
+static SemaphoreHandle_t shim_sem_create(UBaseType_t max, UBaseType_t initial)
+{
+    struct shim_sem *sem = calloc(1, sizeof(*sem));
+    if (sem == NULL) {
+        return NULL;
+    }
+    pthread_mutex_init(&sem->lock, NULL);
+    shim_cond_init(&sem->changed);
+    sem->max = max;
+    sem->count = initial;
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return shim_sem_create(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return shim_sem_create(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial)
+{
+    return shim_sem_create(max, initial);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    struct timespec at;
+    bool timed = shim_deadline(ticks, &at);
+    BaseType_t taken = pdFALSE;
+
+    pthread_mutex_lock(&sem->lock);
+    while (sem->count == 0 && ticks != 0) {
+        if (timed) {
+            if (pthread_cond_timedwait(&sem->changed, &sem->lock, &at) == ETIMEDOUT) {
+                break;
+            }
+        } else {
+            pthread_cond_wait(&sem->changed, &sem->lock);
+        }
+    }
+    if (sem->count > 0) {
+        sem->count--;
+        taken = pdTRUE;
+    }
+    pthread_mutex_unlock(&sem->lock);
+    return taken;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    BaseType_t given = pdFALSE;
+    pthread_mutex_lock(&sem->lock);
+    if (sem->count < sem->max) {
+        sem->count++;
+        given = pdTRUE;
+        pthread_cond_signal(&sem->changed);
+    }
+    pthread_mutex_unlock(&sem->lock);
+    return given;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    if (sem) {
+        pthread_cond_destroy(&sem->changed);
+        pthread_mutex_destroy(&sem->lock);
+        free(sem);
+    }
+}
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t auto_reload, void *id,
+                           TimerCallbackFunction_t cb)
+{
+    (void)name;
+    struct shim_timer *timer = calloc(1, sizeof(*timer));
+    if (timer == NULL || period == 0) {
+        free(timer);
+        return NULL;
+    }
+    timer->cb = cb;
+    timer->id = id;
+    timer->period_ms = (uint64_t)period * portTICK_PERIOD_MS;
+    timer->auto_reload = auto_reload != 0;
+
+    pthread_mutex_lock(&s_timer_lock);
+    timer->next = s_timers;
+    s_timers = timer;
+    pthread_mutex_unlock(&s_timer_lock);
+    return timer;
+}
+
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t ticks)
+{
+    (void)ticks;
+    pthread_mutex_lock(&s_timer_lock);
+    timer->due_ms = s_virtual_ms + timer->period_ms;
+    timer->active = true;
+    pthread_mutex_unlock(&s_timer_lock);
+    return pdPASS;
+}
+
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticks)
+{
+    (void)ticks;
+    pthread_mutex_lock(&s_timer_lock);
+    timer->active = false;
+    pthread_mutex_unlock(&s_timer_lock);
+    return pdPASS;
+}
+
+BaseType_t xTimerDelete(TimerHandle_t timer, TickType_t ticks)
+{
+    (void)ticks;
+    pthread_mutex_lock(&s_timer_lock);
+    for (struct shim_timer **at = &s_timers; *at; at = &(*at)->next) {
+        if (*at == timer) {
+            *at = timer->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&s_timer_lock);
+    free(timer);
+    return pdPASS;
+}
+
+void *pvTimerGetTimerID(TimerHandle_t timer)
+{
+    return timer->id;
+}
+
+int shim_timers_advance(uint32_t ms)
+{
+    int fired = 0;
+    pthread_mutex_lock(&s_timer_lock);
+    uint64_t until = s_virtual_ms + ms;
+    for (;;) {
+        /* the next timer due by then */
+        struct shim_timer *next = NULL;
+        for (struct shim_timer *t = s_timers; t; t = t->next) {
+            if (t->active && t->due_ms <= until && (next == NULL || t->due_ms < next->due_ms)) {
+                next = t;
+            }
+        }
+        if (next == NULL) {
+            break;
+        }
+        s_virtual_ms = next->due_ms;
+        if (next->auto_reload) {
+            next->due_ms += next->period_ms;
+        } else {
+            next->active = false;
+        }
+        /* callbacks may start and stop timers */
+        pthread_mutex_unlock(&s_timer_lock);
+        next->cb(next);
+        fired++;
+        pthread_mutex_lock(&s_timer_lock);
+    }
+    s_virtual_ms = until;
+    pthread_mutex_unlock(&s_timer_lock);
+    return fired;
+}
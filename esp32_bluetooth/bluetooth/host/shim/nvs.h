@@ -0,0 +1,14 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#ifndef __HOST_NVS_H__
+#define __HOST_NVS_H__
+
+#include "esp_err.h"
+
+#define ESP_ERR_NVS_BASE                0x1100
+#define ESP_ERR_NVS_NO_FREE_PAGES       (ESP_ERR_NVS_BASE + 0x0d)
+#define ESP_ERR_NVS_NEW_VERSION_FOUND   (ESP_ERR_NVS_BASE + 0x10)
+
+#endif /* __HOST_NVS_H__ */
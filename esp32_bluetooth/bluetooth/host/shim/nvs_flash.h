@@ -0,0 +1,13 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#ifndef __HOST_NVS_FLASH_H__
+#define __HOST_NVS_FLASH_H__
+
+#include "nvs.h"
+
+esp_err_t nvs_flash_init(void);
+esp_err_t nvs_flash_erase(void);
+
+#endif /* __HOST_NVS_FLASH_H__ */
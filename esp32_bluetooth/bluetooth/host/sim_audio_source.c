@@ -0,0 +1,114 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "bt_app_audio.h"
+#include "sim_audio_source.h"
+
+/*********************************
+ * STATIC VARIABLE DEFINITIONS
+ ********************************/
+static sim_audio_mode_t s_mode = SIM_AUDIO_PACED;
+static uint32_t s_sample_rate = BT_APP_AUDIO_SAMPLE_RATE;
+static pthread_t s_thread;
+static atomic_bool s_running;
+static atomic_uint_fast64_t s_produced;
+
+/*********************************
+ * STATIC FUNCTION DEFINITIONS
+ ********************************/
+
+static void sim_audio_advance(struct timespec *t, uint64_t ns)
+{
+    ns += (uint64_t)t->tv_nsec;
+    t->tv_sec += (time_t)(ns / 1000000000u);
+    t->tv_nsec = (long)(ns % 1000000000u);
+}
+
+static void *sim_audio_thread(void *arg)
+{
+    const uint64_t block_ns = (uint64_t)BT_APP_AUDIO_DMA_FRAMES * 1000000000u / s_sample_rate;
+    struct timespec due;
+    uint64_t n = 0;
+
+    (void)arg;
+    clock_gettime(CLOCK_MONOTONIC, &due);
+    while (atomic_load(&s_running)) {
+        if (s_mode == SIM_AUDIO_PACED) {
+            /* the DMA buffer fills in real time */
+            sim_audio_advance(&due, block_ns);
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL);
+        }
+
+        size_t left = BT_APP_AUDIO_DMA_FRAMES;
+        while (left > 0) {
+            size_t span = 0;
+            int16_t *out = (int16_t *)bt_app_audio_write_begin(&span);
+            if (span == 0) {
+                if (s_mode == SIM_AUDIO_PACED) {
+                    bt_app_audio_write_dropped(left * BT_APP_AUDIO_FRAME_BYTES);
+                    n += left;
+                    break;
+                }
+                if (!atomic_load(&s_running)) {
+                    break;
+                }
+                sched_yield();
+                continue;
+            }
+            size_t frames = span / BT_APP_AUDIO_FRAME_BYTES;
+            frames = frames < left ? frames : left;
+            for (size_t i = 0; i < frames; i++) {
+                int16_t s = sim_audio_sample(n++);
+                out[2 * i] = s;
+                out[2 * i + 1] = s;
+            }
+            bt_app_audio_write_commit(frames * BT_APP_AUDIO_FRAME_BYTES);
+            left -= frames;
+        }
+        atomic_store(&s_produced, n);
+    }
+    return NULL;
+}
+
+/*********************************
+ * EXTERN FUNCTION DEFINITIONS
+ ********************************/
+
+void sim_audio_source_config(sim_audio_mode_t mode, uint32_t sample_rate)
+{
+    s_mode = mode;
+    s_sample_rate = sample_rate ? sample_rate : BT_APP_AUDIO_SAMPLE_RATE;
+}
+
+uint64_t sim_audio_source_produced(void)
+{
+    return atomic_load(&s_produced);
+}
+
+bool bt_app_audio_source_start(void)
+{
+    if (atomic_load(&s_running)) {
+        return true;
+    }
+    atomic_store(&s_produced, 0);
+    atomic_store(&s_running, true);
+    if (pthread_create(&s_thread, NULL, sim_audio_thread, NULL) != 0) {
+        atomic_store(&s_running, false);
+        return false;
+    }
+    return true;
+}
+
+void bt_app_audio_source_stop(void)
+{
+    if (atomic_exchange(&s_running, false)) {
+        pthread_join(s_thread, NULL);
+    }
+}
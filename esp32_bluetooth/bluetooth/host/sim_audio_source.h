@@ -0,0 +1,39 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#ifndef __SIM_AUDIO_SOURCE_H__
+#define __SIM_AUDIO_SOURCE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Simulated microphone for the host build: a thread that writes blocks of
+ * BT_APP_AUDIO_DMA_FRAMES samples into the capture ring the way the
+ * capture task does. Sample n of a run is sim_audio_sample(n), which is
+ * never 0, so a reader can tell audio from the silence of an underrun and
+ * check that nothing was lost or reordered.
+ */
+
+typedef enum {
+    SIM_AUDIO_PACED = 0,    /* one block per block time, like DMA; a full ring drops the block */
+    SIM_AUDIO_FLAT_OUT,     /* as fast as the ring takes it; a full ring waits */
+} sim_audio_mode_t;
+
+/**
+ * @brief    how the next bt_app_audio_start() produces audio
+ */
+void sim_audio_source_config(sim_audio_mode_t mode, uint32_t sample_rate);
+
+/**
+ * @brief    samples produced since the last start, including dropped ones
+ */
+uint64_t sim_audio_source_produced(void);
+
+static inline int16_t sim_audio_sample(uint64_t n)
+{
+    return (int16_t)(n % 32767 + 1);
+}
+
+#endif /* __SIM_AUDIO_SOURCE_H__ */
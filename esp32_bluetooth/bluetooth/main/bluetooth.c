@@ -19,6 +19,9 @@
 
 #include "esp_bt.h"
 #include "bt_app_core.h"
+#include "bt_app_audio.h"
+#include "bt_app_pool.h"
+#include "bt_app_console.h"
 #include "esp_bt_main.h"
 #include "esp_bt_device.h"
 #include "esp_gap_bt_api.h"
@@ -36,6 +39,10 @@
 #define APP_RC_CT_TL_GET_CAPS            (0)
 #define APP_RC_CT_TL_RN_VOLUME_CHANGE    (1)
 
+/* event parameters are copied into blocks of the dispatch pool */
+_Static_assert(sizeof(esp_a2d_cb_param_t) <= BT_APP_POOL_SMALL_BYTES, "A2DP events must fit a small pool block");
+_Static_assert(sizeof(esp_avrc_ct_cb_param_t) <= BT_APP_POOL_LARGE_BYTES, "AVRC events must fit a large pool block");
+
 enum {
     BT_APP_STACK_UP_EVT   = 0x0000,    /* event for stack up */
     BT_APP_HEART_BEAT_EVT = 0xff00,    /* event for heart beat */
@@ -354,27 +361,21 @@ static void bt_av_hdl_stack_evt(uint16_t event, void *p_param)
 
 static void bt_app_a2d_cb(esp_a2d_cb_event_t event, esp_a2d_cb_param_t *param)
 {
-    bt_app_work_dispatch(bt_app_av_sm_hdlr, event, param, sizeof(esp_a2d_cb_param_t), NULL);
+    /* delay reports are informational, everything else drives the state machine */
+    bt_app_lane_t lane = event == ESP_A2D_REPORT_SNK_DELAY_VALUE_EVT ? BT_APP_LANE_BULK : BT_APP_LANE_CONTROL;
+    bt_app_work_dispatch_to(lane, bt_app_av_sm_hdlr, event, param, sizeof(esp_a2d_cb_param_t), NULL);
 }
 
-/* generate some random noise to simulate source audio */
+/* hand the A2DP stack what the microphone captured, silence if it is behind */
 static int32_t bt_app_a2d_data_cb(uint8_t *data, int32_t len)
 {
-    if (data == NULL || len < 0) {
-        return 0;
-    }
-
-    int16_t *p_buf = (int16_t *)data;
-    for (int i = 0; i < (len >> 1); i++) {
-        p_buf[i] = rand() % (1 << 16);
-    }
-
-    return len;
+    return bt_app_audio_read(data, len);
 }
 
 static void bt_app_a2d_heart_beat(TimerHandle_t arg)
 {
-    bt_app_work_dispatch(bt_app_av_sm_hdlr, BT_APP_HEART_BEAT_EVT, NULL, 0, NULL);
+    /* a heart beat still waiting makes this one redundant */
+    bt_app_work_dispatch_to(BT_APP_LANE_BULK, bt_app_av_sm_hdlr, BT_APP_HEART_BEAT_EVT, NULL, 0, NULL);
 }
 
 static void bt_app_av_sm_hdlr(uint16_t event, void *param)
@@ -491,6 +492,10 @@ static void bt_app_av_media_proc(uint16_t event, void *param)
             if (a2d->media_ctrl_stat.cmd == ESP_A2D_MEDIA_CTRL_CHECK_SRC_RDY &&
                     a2d->media_ctrl_stat.status == ESP_A2D_MEDIA_CTRL_ACK_SUCCESS) {
                 ESP_LOGI(BT_AV_TAG, "a2dp media ready, starting ...");
+                /* capture from now on, so audio is queued by the time the stream starts */
+                if (!bt_app_audio_start()) {
+                    ESP_LOGE(BT_AV_TAG, "microphone capture failed to start");
+                }
                 esp_a2d_media_ctrl(ESP_A2D_MEDIA_CTRL_START);
                 s_media_state = APP_AV_MEDIA_STATE_STARTING;
             }
@@ -508,6 +513,7 @@ static void bt_app_av_media_proc(uint16_t event, void *param)
             } else {
                 /* not started successfully, transfer to idle state */
                 ESP_LOGI(BT_AV_TAG, "a2dp media start failed.");
+                bt_app_audio_stop();
                 s_media_state = APP_AV_MEDIA_STATE_IDLE;
             }
         }
@@ -531,6 +537,7 @@ static void bt_app_av_media_proc(uint16_t event, void *param)
             if (a2d->media_ctrl_stat.cmd == ESP_A2D_MEDIA_CTRL_SUSPEND &&
                     a2d->media_ctrl_stat.status == ESP_A2D_MEDIA_CTRL_ACK_SUCCESS) {
                 ESP_LOGI(BT_AV_TAG, "a2dp media suspend successfully, disconnecting...");
+                bt_app_audio_stop();
                 s_media_state = APP_AV_MEDIA_STATE_IDLE;
                 esp_a2d_source_disconnect(s_peer_bda);
                 s_a2d_state = APP_AV_STATE_DISCONNECTING;
@@ -557,6 +564,7 @@ static void bt_app_av_state_connected_hdlr(uint16_t event, void *param)
         a2d = (esp_a2d_cb_param_t *)(param);
         if (a2d->conn_stat.state == ESP_A2D_CONNECTION_STATE_DISCONNECTED) {
             ESP_LOGI(BT_AV_TAG, "a2dp disconnected");
+            bt_app_audio_stop();
             s_a2d_state = APP_AV_STATE_UNCONNECTED;
         }
         break;
@@ -624,15 +632,20 @@ static void bt_app_rc_ct_cb(esp_avrc_ct_cb_event_t event, esp_avrc_ct_cb_param_t
 {
     switch (event) {
     case ESP_AVRC_CT_CONNECTION_STATE_EVT:
-    case ESP_AVRC_CT_PASSTHROUGH_RSP_EVT:
-    case ESP_AVRC_CT_METADATA_RSP_EVT:
-    case ESP_AVRC_CT_CHANGE_NOTIFY_EVT:
     case ESP_AVRC_CT_REMOTE_FEATURES_EVT:
     case ESP_AVRC_CT_GET_RN_CAPABILITIES_RSP_EVT:
+    /* the volume notification is registered again from its handler; if it were lost, it never would be */
+    case ESP_AVRC_CT_CHANGE_NOTIFY_EVT:
     case ESP_AVRC_CT_SET_ABSOLUTE_VOLUME_RSP_EVT: {
         bt_app_work_dispatch(bt_av_hdl_avrc_ct_evt, event, param, sizeof(esp_avrc_ct_cb_param_t), NULL);
         break;
     }
+    case ESP_AVRC_CT_PASSTHROUGH_RSP_EVT:
+    case ESP_AVRC_CT_METADATA_RSP_EVT: {
+        bt_app_work_dispatch_to(BT_APP_LANE_BULK, bt_av_hdl_avrc_ct_evt, event, param,
+                                sizeof(esp_avrc_ct_cb_param_t), NULL);
+        break;
+    }
     default: {
         ESP_LOGE(BT_RC_CT_TAG, "Invalid AVRC event: %d", event);
         break;
@@ -792,6 +805,10 @@ void app_main(void)
 
     ESP_LOGI(BT_AV_TAG, "Own address:[%s]", bda2str((uint8_t *)esp_bt_dev_get_address(), bda_str, sizeof(bda_str)));
     bt_app_task_start_up();
+    bt_app_name_handler(bt_av_hdl_stack_evt, "stack");
+    bt_app_name_handler(bt_app_av_sm_hdlr, "av_sm");
+    bt_app_name_handler(bt_av_hdl_avrc_ct_evt, "avrc_ct");
+    bt_app_console_start();
     /* Bluetooth device name, connection mode and profile set up */
     bt_app_work_dispatch(bt_av_hdl_stack_evt, BT_APP_STACK_UP_EVT, NULL, 0, NULL);
 }
\ No newline at end of file
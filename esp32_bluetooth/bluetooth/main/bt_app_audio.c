@@ -0,0 +1,141 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "bt_app_audio.h"
+
+/*
+ * Single-producer single-consumer byte ring between the capture task and
+ * the A2DP data callback. head and tail count bytes and only grow (modulo
+ * 2^32); the producer owns head, the consumer tail. The capture source
+ * reads straight into the ring, so the only copy on the way out is the
+ * callback's memcpy into the A2DP buffer (two when it wraps).
+ */
+
+#define RING_MASK    (BT_APP_AUDIO_RING_BYTES - 1)
+
+_Static_assert((BT_APP_AUDIO_RING_BYTES & RING_MASK) == 0, "ring size must be a power of two");
+_Static_assert(BT_APP_AUDIO_RING_BYTES % BT_APP_AUDIO_FRAME_BYTES == 0, "ring must hold whole frames");
+
+/*********************************
+ * STATIC VARIABLE DEFINITIONS
+ ********************************/
+static uint8_t s_ring[BT_APP_AUDIO_RING_BYTES] __attribute__((aligned(4)));
+static atomic_uint_fast32_t s_head;    /* bytes written */
+static atomic_uint_fast32_t s_tail;    /* bytes read */
+static bool s_primed = false;          /* consumer only: prefill reached */
+static bt_app_audio_stats_t s_stats;
+
+/*********************************
+ * EXTERN FUNCTION DEFINITIONS
+ ********************************/
+
+void bt_app_audio_ring_reset(void)
+{
+    atomic_store(&s_head, 0);
+    atomic_store(&s_tail, 0);
+    s_primed = false;
+}
+
+uint8_t *bt_app_audio_write_begin(size_t *len)
+{
+    uint32_t head = (uint32_t)atomic_load_explicit(&s_head, memory_order_relaxed);
+    uint32_t tail = (uint32_t)atomic_load_explicit(&s_tail, memory_order_acquire);
+    uint32_t free_bytes = BT_APP_AUDIO_RING_BYTES - (head - tail);
+    uint32_t to_end = BT_APP_AUDIO_RING_BYTES - (head & RING_MASK);
+
+    *len = (free_bytes < to_end ? free_bytes : to_end) & ~(uint32_t)(BT_APP_AUDIO_FRAME_BYTES - 1);
+    return &s_ring[head & RING_MASK];
+}
+
+void bt_app_audio_write_commit(size_t len)
+{
+    uint32_t head = (uint32_t)atomic_load_explicit(&s_head, memory_order_relaxed) + (uint32_t)len;
+    atomic_store_explicit(&s_head, head, memory_order_release);
+
+    uint32_t fill = head - (uint32_t)atomic_load_explicit(&s_tail, memory_order_relaxed);
+    if (fill > s_stats.max_fill) {
+        s_stats.max_fill = fill;
+    }
+    s_stats.bytes_captured += len;
+}
+
+void bt_app_audio_write_dropped(size_t len)
+{
+    s_stats.overruns++;
+    s_stats.overrun_bytes += len;
+}
+
+void bt_app_audio_read_failed(void)
+{
+    s_stats.read_errors++;
+}
+
+int32_t bt_app_audio_read(uint8_t *data, int32_t len)
+{
+    if (data == NULL || len <= 0) {
+        return 0;
+    }
+
+    uint32_t tail = (uint32_t)atomic_load_explicit(&s_tail, memory_order_relaxed);
+    uint32_t head = (uint32_t)atomic_load_explicit(&s_head, memory_order_acquire);
+    uint32_t avail = head - tail;
+
+    if (!s_primed) {
+        if (avail < BT_APP_AUDIO_PREFILL_BYTES) {
+            memset(data, 0, len);
+            return len;
+        }
+        s_primed = true;
+    }
+
+    uint32_t n = avail < (uint32_t)len ? avail : (uint32_t)len;
+    n &= ~(uint32_t)(BT_APP_AUDIO_FRAME_BYTES - 1);
+    uint32_t at = tail & RING_MASK;
+    uint32_t first = BT_APP_AUDIO_RING_BYTES - at;
+    if (n <= first) {
+        memcpy(data, &s_ring[at], n);
+    } else {
+        memcpy(data, &s_ring[at], first);
+        memcpy(data + first, s_ring, n - first);
+    }
+    atomic_store_explicit(&s_tail, tail + n, memory_order_release);
+    s_stats.bytes_sent += n;
+
+    if (n < (uint32_t)len) {
+        /* ran dry: pad with silence and build the prefill up again */
+        memset(data + n, 0, len - n);
+        s_stats.underruns++;
+        s_stats.underrun_bytes += len - n;
+        s_primed = false;
+    }
+    return len;
+}
+
+size_t bt_app_audio_queued(void)
+{
+    return (uint32_t)atomic_load_explicit(&s_head, memory_order_acquire) -
+           (uint32_t)atomic_load_explicit(&s_tail, memory_order_relaxed);
+}
+
+void bt_app_audio_get_stats(bt_app_audio_stats_t *stats)
+{
+    if (stats) {
+        memcpy(stats, &s_stats, sizeof(*stats));
+    }
+}
+
+bool bt_app_audio_start(void)
+{
+    bt_app_audio_ring_reset();
+    return bt_app_audio_source_start();
+}
+
+void bt_app_audio_stop(void)
+{
+    bt_app_audio_source_stop();
+}
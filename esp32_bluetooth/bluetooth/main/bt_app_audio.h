@@ -0,0 +1,118 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#ifndef __BT_APP_AUDIO_H__
+#define __BT_APP_AUDIO_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* log tag */
+#define BT_APP_AUDIO_TAG            "BT_APP_AUDIO"
+
+/* PCM as the A2DP source sends it: 44.1 kHz, 16-bit, stereo. The pen has
+ * one microphone, which goes out on both channels. */
+#define BT_APP_AUDIO_SAMPLE_RATE    (44100)
+#define BT_APP_AUDIO_FRAME_BYTES    (4)
+
+/* capture ring, a power of two; 16 KiB is about 93 ms */
+#ifndef BT_APP_AUDIO_RING_BYTES
+#define BT_APP_AUDIO_RING_BYTES     (16384)
+#endif
+
+/* samples per DMA buffer; the driver fills one while the other is read */
+#ifndef BT_APP_AUDIO_DMA_FRAMES
+#define BT_APP_AUDIO_DMA_FRAMES     (256)
+#endif
+
+/* queued before the data callback starts taking audio, after start-up and
+ * after every underrun, so the stream does not stutter at its start */
+#ifndef BT_APP_AUDIO_PREFILL_BYTES
+#define BT_APP_AUDIO_PREFILL_BYTES  (BT_APP_AUDIO_RING_BYTES / 4)
+#endif
+
+/* each field has a single writer: the capture task or the data callback */
+typedef struct {
+    uint32_t bytes_captured;    /*!< put in the ring */
+    uint32_t bytes_sent;        /*!< taken by the data callback */
+    uint32_t overruns;          /*!< capture blocks dropped because the ring was full */
+    uint32_t overrun_bytes;
+    uint32_t underruns;         /*!< callbacks that found less audio than they asked for */
+    uint32_t underrun_bytes;    /*!< silence sent in its place */
+    uint32_t read_errors;       /*!< failed or timed-out reads from the capture driver */
+    uint32_t max_fill;          /*!< most bytes queued at once */
+} bt_app_audio_stats_t;
+
+/**
+ * @brief    empty the ring; only while capture is stopped
+ */
+void bt_app_audio_ring_reset(void);
+
+/**
+ * @brief    producer: contiguous free space in the ring, to be filled in place
+ *
+ * @param [out] len  bytes free from the returned pointer on, a multiple of
+ *                   BT_APP_AUDIO_FRAME_BYTES
+ *
+ * @return  where to write
+ */
+uint8_t *bt_app_audio_write_begin(size_t *len);
+
+/**
+ * @brief    producer: publish len bytes written from bt_app_audio_write_begin()
+ */
+void bt_app_audio_write_commit(size_t len);
+
+/**
+ * @brief    producer: account for a block of len bytes that found no room
+ */
+void bt_app_audio_write_dropped(size_t len);
+
+/**
+ * @brief    producer: account for a failed read from the capture driver
+ */
+void bt_app_audio_read_failed(void);
+
+/**
+ * @brief    consumer: fill an A2DP buffer from the ring, with silence for
+ *           what is missing
+ *
+ * @param [out] data  buffer of the A2DP data callback
+ * @param [in]  len   its length, a multiple of BT_APP_AUDIO_FRAME_BYTES
+ *
+ * @return  len
+ */
+int32_t bt_app_audio_read(uint8_t *data, int32_t len);
+
+/**
+ * @brief    consumer: bytes waiting in the ring
+ */
+size_t bt_app_audio_queued(void);
+
+/**
+ * @brief    copy of the counters since boot
+ */
+void bt_app_audio_get_stats(bt_app_audio_stats_t *stats);
+
+/**
+ * @brief    empty the ring and start capturing
+ *
+ * @return  true if the capture source started
+ */
+bool bt_app_audio_start(void);
+
+/**
+ * @brief    stop capturing; returns once the source has stopped writing
+ */
+void bt_app_audio_stop(void);
+
+/**
+ * @brief    capture source behind bt_app_audio_start()/bt_app_audio_stop():
+ *           the microphone on the pen, a simulated one in the host build
+ */
+bool bt_app_audio_source_start(void);
+void bt_app_audio_source_stop(void);
+
+#endif /* __BT_APP_AUDIO_H__ */
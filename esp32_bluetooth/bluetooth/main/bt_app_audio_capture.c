@@ -0,0 +1,295 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_err.h"
+#include "bt_app_audio.h"
+
+/*
+ * Capture source for the pen's microphone. Two front ends, chosen at build
+ * time with BT_APP_AUDIO_SOURCE:
+ *
+ * - BT_APP_AUDIO_SOURCE_ADC: the analog microphone and its LM358 stage on
+ *   an ADC1 pin, sampled in continuous mode (on the ESP32 the ADC streams
+ *   through I2S0's DMA);
+ * - BT_APP_AUDIO_SOURCE_PDM: a digital PDM microphone on I2S0 in PDM RX
+ *   mode.
+ *
+ * Either way the driver has two DMA buffers of BT_APP_AUDIO_DMA_FRAMES
+ * samples, one filled while the other is read. The capture task reads mono
+ * samples straight into the back half of the free span of the ring,
+ * widens them in place to stereo and commits them.
+ */
+
+#define BT_APP_AUDIO_SOURCE_ADC     (0)
+#define BT_APP_AUDIO_SOURCE_PDM     (1)
+
+#ifndef BT_APP_AUDIO_SOURCE
+#define BT_APP_AUDIO_SOURCE         BT_APP_AUDIO_SOURCE_ADC
+#endif
+
+/* ADC1 channel of the microphone amplifier's output (channel 6 is GPIO34) */
+#ifndef BT_APP_AUDIO_ADC_CHANNEL
+#define BT_APP_AUDIO_ADC_CHANNEL    (6)
+#endif
+
+/* PDM microphone pins */
+#ifndef BT_APP_AUDIO_PDM_CLK_GPIO
+#define BT_APP_AUDIO_PDM_CLK_GPIO   (26)
+#endif
+#ifndef BT_APP_AUDIO_PDM_DIN_GPIO
+#define BT_APP_AUDIO_PDM_DIN_GPIO   (33)
+#endif
+
+#if BT_APP_AUDIO_SOURCE == BT_APP_AUDIO_SOURCE_ADC
+#include "esp_adc/adc_continuous.h"
+#else
+#include "driver/i2s_pdm.h"
+#endif
+
+/* above BtAppTask, below the Bluetooth stack */
+#define CAPTURE_TASK_PRIO           (12)
+#define CAPTURE_TASK_STACK          (2560)
+/* the longest a read may block, which bounds bt_app_audio_stop() */
+#define CAPTURE_READ_TIMEOUT_MS     (50)
+/* stereo bytes of one DMA buffer */
+#define CAPTURE_BLOCK_BYTES         (BT_APP_AUDIO_DMA_FRAMES * BT_APP_AUDIO_FRAME_BYTES)
+
+/*********************************
+ * STATIC VARIABLE DEFINITIONS
+ ********************************/
+static TaskHandle_t s_capture_task = NULL;
+static SemaphoreHandle_t s_capture_done = NULL;    /* given by the task as it exits */
+static atomic_bool s_capture_running;
+/* mono samples of a block that found the ring full; read and dropped so the DMA keeps going */
+static int16_t s_scratch[BT_APP_AUDIO_DMA_FRAMES];
+
+#if BT_APP_AUDIO_SOURCE == BT_APP_AUDIO_SOURCE_ADC
+static adc_continuous_handle_t s_adc = NULL;
+static int32_t s_dc = 0;                           /* DC level of the ADC input, 6 fractional bits */
+#else
+static i2s_chan_handle_t s_rx_chan = NULL;
+#endif
+
+/*********************************
+ * STATIC FUNCTION DEFINITIONS
+ ********************************/
+
+#if BT_APP_AUDIO_SOURCE == BT_APP_AUDIO_SOURCE_ADC
+
+static bool bt_app_audio_driver_start(void)
+{
+    adc_continuous_handle_cfg_t handle_cfg = {
+        .max_store_buf_size = 2 * BT_APP_AUDIO_DMA_FRAMES * SOC_ADC_DIGI_DATA_BYTES_PER_CONV,
+        .conv_frame_size = BT_APP_AUDIO_DMA_FRAMES * SOC_ADC_DIGI_DATA_BYTES_PER_CONV,
+    };
+    adc_digi_pattern_config_t pattern = {
+        .atten = ADC_ATTEN_DB_12,
+        .channel = BT_APP_AUDIO_ADC_CHANNEL,
+        .unit = ADC_UNIT_1,
+        .bit_width = SOC_ADC_DIGI_MAX_BITWIDTH,
+    };
+    adc_continuous_config_t cfg = {
+        .pattern_num = 1,
+        .adc_pattern = &pattern,
+        .sample_freq_hz = BT_APP_AUDIO_SAMPLE_RATE,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE1,
+    };
+    esp_err_t err;
+
+    if ((err = adc_continuous_new_handle(&handle_cfg, &s_adc)) != ESP_OK) {
+        ESP_LOGE(BT_APP_AUDIO_TAG, "%s adc handle failed: %s", __func__, esp_err_to_name(err));
+        return false;
+    }
+    if ((err = adc_continuous_config(s_adc, &cfg)) != ESP_OK ||
+            (err = adc_continuous_start(s_adc)) != ESP_OK) {
+        ESP_LOGE(BT_APP_AUDIO_TAG, "%s adc start failed: %s", __func__, esp_err_to_name(err));
+        adc_continuous_deinit(s_adc);
+        s_adc = NULL;
+        return false;
+    }
+    s_dc = (2048 << 4) << 6;
+    return true;
+}
+
+static void bt_app_audio_driver_stop(void)
+{
+    if (s_adc) {
+        adc_continuous_stop(s_adc);
+        adc_continuous_deinit(s_adc);
+        s_adc = NULL;
+    }
+}
+
+/* returns the bytes read, 2 per sample */
+static size_t bt_app_audio_driver_read(void *dst, size_t len)
+{
+    uint32_t got = 0;
+    esp_err_t err = adc_continuous_read(s_adc, dst, len, &got, CAPTURE_READ_TIMEOUT_MS);
+    if (err != ESP_OK) {
+        bt_app_audio_read_failed();
+        return 0;
+    }
+
+    /* 12-bit readings around the amplifier's bias point to signed 16-bit */
+    int16_t *samples = (int16_t *)dst;
+    const adc_digi_output_data_t *raw = (const adc_digi_output_data_t *)dst;
+    for (uint32_t i = 0; i < got / SOC_ADC_DIGI_DATA_BYTES_PER_CONV; i++) {
+        int32_t x = (int32_t)raw[i].type1.data << 4;
+        int32_t y = x - (s_dc >> 6);
+        s_dc += ((x << 6) - s_dc) >> 10;
+        samples[i] = (int16_t)(y > INT16_MAX ? INT16_MAX : (y < INT16_MIN ? INT16_MIN : y));
+    }
+    return got;
+}
+
+#else /* BT_APP_AUDIO_SOURCE_PDM */
+
+static bool bt_app_audio_driver_start(void)
+{
+    i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_0, I2S_ROLE_MASTER);
+    chan_cfg.dma_desc_num = 2;
+    chan_cfg.dma_frame_num = BT_APP_AUDIO_DMA_FRAMES;
+    i2s_pdm_rx_config_t pdm_cfg = {
+        .clk_cfg = I2S_PDM_RX_CLK_DEFAULT_CONFIG(BT_APP_AUDIO_SAMPLE_RATE),
+        .slot_cfg = I2S_PDM_RX_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO),
+        .gpio_cfg = {
+            .clk = BT_APP_AUDIO_PDM_CLK_GPIO,
+            .din = BT_APP_AUDIO_PDM_DIN_GPIO,
+            .invert_flags = {
+                .clk_inv = false,
+            },
+        },
+    };
+    esp_err_t err;
+
+    if ((err = i2s_new_channel(&chan_cfg, NULL, &s_rx_chan)) != ESP_OK) {
+        ESP_LOGE(BT_APP_AUDIO_TAG, "%s i2s channel failed: %s", __func__, esp_err_to_name(err));
+        return false;
+    }
+    if ((err = i2s_channel_init_pdm_rx_mode(s_rx_chan, &pdm_cfg)) != ESP_OK ||
+            (err = i2s_channel_enable(s_rx_chan)) != ESP_OK) {
+        ESP_LOGE(BT_APP_AUDIO_TAG, "%s pdm rx start failed: %s", __func__, esp_err_to_name(err));
+        i2s_del_channel(s_rx_chan);
+        s_rx_chan = NULL;
+        return false;
+    }
+    return true;
+}
+
+static void bt_app_audio_driver_stop(void)
+{
+    if (s_rx_chan) {
+        i2s_channel_disable(s_rx_chan);
+        i2s_del_channel(s_rx_chan);
+        s_rx_chan = NULL;
+    }
+}
+
+/* returns the bytes read, 2 per sample */
+static size_t bt_app_audio_driver_read(void *dst, size_t len)
+{
+    size_t got = 0;
+    esp_err_t err = i2s_channel_read(s_rx_chan, dst, len, &got, CAPTURE_READ_TIMEOUT_MS);
+    if (err != ESP_OK) {
+        bt_app_audio_read_failed();
+    }
+    /* a timed-out read still hands over what it got */
+    return got & ~(size_t)1;
+}
+
+#endif /* BT_APP_AUDIO_SOURCE */
+
+static void bt_app_audio_capture_task(void *arg)
+{
+    while (atomic_load(&s_capture_running)) {
+        size_t span = 0;
+        uint8_t *dst = bt_app_audio_write_begin(&span);
+
+        if (span == 0) {
+            /* ring full: take the block off the driver anyway and count it */
+            size_t got = bt_app_audio_driver_read(s_scratch, sizeof(s_scratch));
+            if (got > 0) {
+                bt_app_audio_write_dropped(got * 2);
+            }
+            continue;
+        }
+
+        /* mono into the back half of the span, then widened forwards in place,
+         * which never overwrites a sample not yet widened */
+        size_t stereo = span < CAPTURE_BLOCK_BYTES ? span : CAPTURE_BLOCK_BYTES;
+        int16_t *mono = (int16_t *)(dst + stereo / 2);
+        size_t got = bt_app_audio_driver_read(mono, stereo / 2);
+        int16_t *out = (int16_t *)dst;
+        for (size_t i = 0; i < got / 2; i++) {
+            int16_t s = mono[i];
+            out[2 * i] = s;
+            out[2 * i + 1] = s;
+        }
+        if (got > 0) {
+            bt_app_audio_write_commit(got * 2);
+        }
+    }
+
+    xSemaphoreGive(s_capture_done);
+    vTaskDelete(NULL);
+}
+
+/*********************************
+ * EXTERN FUNCTION DEFINITIONS
+ ********************************/
+
+bool bt_app_audio_source_start(void)
+{
+    if (atomic_load(&s_capture_running)) {
+        return true;
+    }
+    if (s_capture_done == NULL && (s_capture_done = xSemaphoreCreateBinary()) == NULL) {
+        return false;
+    }
+    if (!bt_app_audio_driver_start()) {
+        return false;
+    }
+
+    atomic_store(&s_capture_running, true);
+#if CONFIG_FREERTOS_UNICORE
+    BaseType_t core = 0;
+#else
+    BaseType_t core = 1;    /* the controller and host run on core 0 */
+#endif
+    if (xTaskCreatePinnedToCore(bt_app_audio_capture_task, "BtAppAudio", CAPTURE_TASK_STACK, NULL,
+                                CAPTURE_TASK_PRIO, &s_capture_task, core) != pdPASS) {
+        ESP_LOGE(BT_APP_AUDIO_TAG, "%s capture task create failed", __func__);
+        atomic_store(&s_capture_running, false);
+        bt_app_audio_driver_stop();
+        return false;
+    }
+    ESP_LOGI(BT_APP_AUDIO_TAG, "capture started, %d Hz", BT_APP_AUDIO_SAMPLE_RATE);
+    return true;
+}
+
+void bt_app_audio_source_stop(void)
+{
+    if (!atomic_exchange(&s_capture_running, false)) {
+        return;
+    }
+    xSemaphoreTake(s_capture_done, portMAX_DELAY);
+    s_capture_task = NULL;
+    bt_app_audio_driver_stop();
+
+    bt_app_audio_stats_t stats;
+    bt_app_audio_get_stats(&stats);
+    ESP_LOGI(BT_APP_AUDIO_TAG, "capture stopped: %"PRIu32" overruns (%"PRIu32" B), %"PRIu32" underruns (%"PRIu32" B), "
+             "%"PRIu32" read errors, max fill %"PRIu32" B", stats.overruns, stats.overrun_bytes,
+             stats.underruns, stats.underrun_bytes, stats.read_errors, stats.max_fill);
+}
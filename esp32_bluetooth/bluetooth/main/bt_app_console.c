@@ -0,0 +1,93 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "esp_console.h"
+#include "esp_log.h"
+#include "bt_app_core.h"
+#include "bt_app_pool.h"
+#include "bt_app_audio.h"
+#include "bt_app_console.h"
+
+/*********************************
+ * STATIC FUNCTION DEFINITIONS
+ ********************************/
+
+static void bt_app_console_dump_pool(FILE *out)
+{
+    bt_app_pool_stats_t pool;
+    bt_app_pool_get_stats(&pool);
+
+    fprintf(out, "pool     block blocks  used  high      hits\n");
+    for (int i = 0; i < BT_APP_POOL_CLASSES; i++) {
+        const bt_app_pool_class_stats_t *c = &pool.classes[i];
+        fprintf(out, "%-8s %5lu %6lu %5lu %5lu %9lu\n", i == 0 ? "small" : "large", (unsigned long)c->block_bytes,
+                (unsigned long)c->blocks, (unsigned long)c->in_use, (unsigned long)c->high_water,
+                (unsigned long)c->hits);
+    }
+    fprintf(out, "heap copies: %lu, %lu in use\n", (unsigned long)pool.misses, (unsigned long)pool.heap_in_use);
+}
+
+static void bt_app_console_dump_audio(FILE *out)
+{
+    bt_app_audio_stats_t audio;
+    bt_app_audio_get_stats(&audio);
+
+    fprintf(out, "audio: %lu B captured, %lu B sent, max fill %lu of %d B\n", (unsigned long)audio.bytes_captured,
+            (unsigned long)audio.bytes_sent, (unsigned long)audio.max_fill, BT_APP_AUDIO_RING_BYTES);
+    fprintf(out, "       %lu overruns (%lu B), %lu underruns (%lu B), %lu read errors\n",
+            (unsigned long)audio.overruns, (unsigned long)audio.overrun_bytes, (unsigned long)audio.underruns,
+            (unsigned long)audio.underrun_bytes, (unsigned long)audio.read_errors);
+}
+
+static int bt_app_console_btstat(int argc, char **argv)
+{
+    if (argc > 1 && strcmp(argv[1], "reset") == 0) {
+        bt_app_event_stats_reset();
+        printf("times cleared\n");
+        return 0;
+    }
+    if (argc > 1) {
+        printf("usage: btstat [reset]\n");
+        return 1;
+    }
+
+    bt_app_event_stats_dump(stdout);
+    bt_app_console_dump_pool(stdout);
+    bt_app_console_dump_audio(stdout);
+    return 0;
+}
+
+/*********************************
+ * EXTERN FUNCTION DEFINITIONS
+ ********************************/
+
+void bt_app_console_start(void)
+{
+    esp_console_repl_t *repl = NULL;
+    esp_console_repl_config_t repl_config = ESP_CONSOLE_REPL_CONFIG_DEFAULT();
+    esp_console_dev_uart_config_t uart_config = ESP_CONSOLE_DEV_UART_CONFIG_DEFAULT();
+    repl_config.prompt = "pen>";
+
+    esp_err_t err = esp_console_new_repl_uart(&uart_config, &repl_config, &repl);
+    if (err != ESP_OK) {
+        ESP_LOGE(BT_APP_CONSOLE_TAG, "%s console failed: %s", __func__, esp_err_to_name(err));
+        return;
+    }
+
+    const esp_console_cmd_t btstat = {
+        .command = "btstat",
+        .help = "Dispatcher lanes, queue wait and handler times per event, BtAppTask stack, "
+                "dispatch pool and audio counters. 'btstat reset' clears the times.",
+        .hint = "[reset]",
+        .func = &bt_app_console_btstat,
+    };
+    esp_console_register_help_command();
+    esp_console_cmd_register(&btstat);
+
+    if ((err = esp_console_start_repl(repl)) != ESP_OK) {
+        ESP_LOGE(BT_APP_CONSOLE_TAG, "%s console start failed: %s", __func__, esp_err_to_name(err));
+    }
+}
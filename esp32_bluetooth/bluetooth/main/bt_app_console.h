@@ -0,0 +1,20 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#ifndef __BT_APP_CONSOLE_H__
+#define __BT_APP_CONSOLE_H__
+
+/* log tag */
+#define BT_APP_CONSOLE_TAG          "BT_APP_CONSOLE"
+
+/**
+ * @brief    start a console on the UART with the pen's diagnostic commands:
+ *
+ *           btstat [reset]   dispatcher lanes, times per kind of work, stack
+ *                            of BtAppTask, dispatch pool and audio counters;
+ *                            reset clears the times
+ */
+void bt_app_console_start(void);
+
+#endif /* __BT_APP_CONSOLE_H__ */
@@ -5,14 +5,34 @@
  */
 
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 #include "freertos/FreeRTOSConfig.h"
 #include "freertos/FreeRTOS.h"
-#include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "freertos/task.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "bt_app_core.h"
+#include "bt_app_pool.h"
+
+/* BtAppTask */
+#define BT_APP_TASK_STACK           (2048)
+#define BT_APP_TASK_PRIO            (10)
+/* handlers that can be named */
+#define BT_APP_HANDLER_NAMES        (8)
+
+/* a lane: a ring of messages, guarded by s_bt_app_lane_lock */
+typedef struct {
+    bt_app_lane_config_t config;   /* in use; the ring and slots are sized for it */
+    bt_app_lane_config_t pending;  /* from bt_app_lane_configure(), taken at start-up */
+    bt_app_msg_t         *ring;
+    uint16_t             head;
+    uint16_t             count;
+    SemaphoreHandle_t    slots;    /* free places, taken by senders of a lane that blocks */
+    bt_app_lane_stats_t  stats;
+} bt_app_lane_ctx_t;
 
 /*********************************
  * STATIC FUNCTION DECLARATIONS
@@ -21,34 +41,128 @@
 /* application task handler */
 static void bt_app_task_handler(void *arg);
 /* message sender for Work queue */
-static bool bt_app_send_msg(bt_app_msg_t *msg);
+static bool bt_app_send_msg(bt_app_lane_t lane, bt_app_msg_t *msg);
+/* next message to handle, control lane first */
+static bool bt_app_take_msg(bt_app_msg_t *msg);
 /* handler for dispatched message */
 static void bt_app_work_dispatched(bt_app_msg_t *msg);
+/* add the times of handled work */
+static void bt_app_event_stats_record(const bt_app_msg_t *msg, int64_t wait_us, int64_t run_us);
 
 /*********************************
  * STATIC VARIABLE DEFINITIONS
  ********************************/
-static QueueHandle_t s_bt_app_task_queue = NULL;
+static const char *s_lane_names[BT_APP_LANES] = { "control", "bulk" };
+static bt_app_lane_ctx_t s_lanes[BT_APP_LANES] = {
+    [BT_APP_LANE_CONTROL] = {
+        .config = { BT_APP_CONTROL_LANE_DEPTH, BT_APP_CONTROL_LANE_WAIT_MS, BT_APP_LANE_BLOCK },
+        .pending = { BT_APP_CONTROL_LANE_DEPTH, BT_APP_CONTROL_LANE_WAIT_MS, BT_APP_LANE_BLOCK },
+    },
+    [BT_APP_LANE_BULK] = {
+        .config = { BT_APP_BULK_LANE_DEPTH, 0, BT_APP_LANE_COALESCE },
+        .pending = { BT_APP_BULK_LANE_DEPTH, 0, BT_APP_LANE_COALESCE },
+    },
+};
+static SemaphoreHandle_t s_bt_app_lane_lock = NULL;
 static TaskHandle_t s_bt_app_task_handle = NULL;
 
+/* written by BtAppTask only; readers may see an entry half-updated */
+static bt_app_event_stats_t s_event_stats[BT_APP_EVENT_STATS_SLOTS];    /* the last slot: all other work */
+static int s_event_stats_used = 0;
+static volatile bool s_event_stats_reset = false;
+static struct {
+    bt_app_cb_t cb;
+    const char  *name;
+} s_handler_names[BT_APP_HANDLER_NAMES];
+
 /*********************************
  * STATIC FUNCTION DEFINITIONS
  ********************************/
 
-static bool bt_app_send_msg(bt_app_msg_t *msg)
+static TickType_t bt_app_wait_ticks(uint16_t ms)
 {
-    if (msg == NULL) {
+    /* one tick more than the wait: the first tick may be over at once (10 ms at 100 Hz) */
+    return ms == 0 ? 0 : pdMS_TO_TICKS(ms) + 1;
+}
+
+static bool bt_app_send_msg(bt_app_lane_t lane_id, bt_app_msg_t *msg)
+{
+    if (msg == NULL || lane_id >= BT_APP_LANES || s_lanes[lane_id].ring == NULL) {
         return false;
     }
 
-    if (pdTRUE != xQueueSend(s_bt_app_task_queue, msg, 10 / portTICK_PERIOD_MS)) {
-        ESP_LOGE(BT_APP_CORE_TAG, "%s xQueue send failed", __func__);
+    bt_app_lane_ctx_t *lane = &s_lanes[lane_id];
+    if (lane->config.policy == BT_APP_LANE_BLOCK &&
+            xSemaphoreTake(lane->slots, bt_app_wait_ticks(lane->config.wait_ms)) != pdTRUE) {
+        xSemaphoreTake(s_bt_app_lane_lock, portMAX_DELAY);
+        lane->stats.failed++;
+        xSemaphoreGive(s_bt_app_lane_lock);
+        ESP_LOGE(BT_APP_CORE_TAG, "%s %s lane full, event 0x%x lost", __func__, s_lane_names[lane_id], msg->event);
         return false;
     }
 
+    bool queued = true;
+    void *evicted = NULL;
+    xSemaphoreTake(s_bt_app_lane_lock, portMAX_DELAY);
+    if (lane->config.policy == BT_APP_LANE_COALESCE && msg->param == NULL) {
+        for (uint16_t i = 0; i < lane->count; i++) {
+            bt_app_msg_t *waiting = &lane->ring[(lane->head + i) % lane->config.depth];
+            if (waiting->param == NULL && waiting->sig == msg->sig && waiting->event == msg->event &&
+                    waiting->cb == msg->cb) {
+                lane->stats.coalesced++;
+                queued = false;
+                break;
+            }
+        }
+    }
+    if (queued) {
+        if (lane->count == lane->config.depth) {
+            /* only lanes that do not block get here full */
+            evicted = lane->ring[lane->head].param;
+            lane->head = (lane->head + 1) % lane->config.depth;
+            lane->count--;
+            lane->stats.dropped++;
+        }
+        msg->enqueue_us = esp_timer_get_time();
+        lane->ring[(lane->head + lane->count) % lane->config.depth] = *msg;
+        lane->count++;
+        lane->stats.enqueued++;
+        if (lane->count > lane->stats.high_water) {
+            lane->stats.high_water = lane->count;
+        }
+    }
+    xSemaphoreGive(s_bt_app_lane_lock);
+
+    bt_app_pool_free(evicted);
+    if (queued) {
+        xTaskNotifyGive(s_bt_app_task_handle);
+    }
     return true;
 }
 
+static bool bt_app_take_msg(bt_app_msg_t *msg)
+{
+    bt_app_lane_ctx_t *from = NULL;
+
+    xSemaphoreTake(s_bt_app_lane_lock, portMAX_DELAY);
+    for (int i = 0; i < BT_APP_LANES; i++) {
+        bt_app_lane_ctx_t *lane = &s_lanes[i];
+        if (lane->count > 0) {
+            *msg = lane->ring[lane->head];
+            lane->head = (lane->head + 1) % lane->config.depth;
+            lane->count--;
+            from = lane;
+            break;
+        }
+    }
+    xSemaphoreGive(s_bt_app_lane_lock);
+
+    if (from && from->slots) {
+        xSemaphoreGive(from->slots);
+    }
+    return from != NULL;
+}
+
 static void bt_app_work_dispatched(bt_app_msg_t *msg)
 {
     if (msg->cb) {
@@ -56,15 +170,96 @@ static void bt_app_work_dispatched(bt_app_msg_t *msg)
     }
 }
 
+static int bt_app_hist_bucket(uint32_t us)
+{
+    int k = us == 0 ? 0 : 32 - __builtin_clz(us);
+    return k < BT_APP_HIST_BUCKETS ? k : BT_APP_HIST_BUCKETS - 1;
+}
+
+static void bt_app_hist_add(bt_app_hist_t *hist, int64_t us)
+{
+    uint32_t v = us < 0 ? 0 : (us > UINT32_MAX ? UINT32_MAX : (uint32_t)us);
+    hist->count++;
+    hist->total_us += v;
+    if (v > hist->max_us) {
+        hist->max_us = v;
+    }
+    hist->buckets[bt_app_hist_bucket(v)]++;
+}
+
+/* the percentile as the bound of its bucket, e.g. "<64"; the last bucket gives the maximum */
+static void bt_app_hist_pct(const bt_app_hist_t *hist, uint32_t pct, char *text, size_t len)
+{
+    uint64_t want = ((uint64_t)hist->count * pct + 99) / 100, seen = 0;
+    for (int k = 0; k < BT_APP_HIST_BUCKETS && hist->count > 0; k++) {
+        seen += hist->buckets[k];
+        if (seen >= want) {
+            if (k == 0) {
+                snprintf(text, len, "0");
+            } else if (k == BT_APP_HIST_BUCKETS - 1) {
+                snprintf(text, len, "%u", (unsigned)hist->max_us);
+            } else {
+                snprintf(text, len, "<%u", 1u << k);
+            }
+            return;
+        }
+    }
+    snprintf(text, len, "-");
+}
+
+static void bt_app_event_stats_record(const bt_app_msg_t *msg, int64_t wait_us, int64_t run_us)
+{
+    if (s_event_stats_reset) {
+        memset(s_event_stats, 0, sizeof(s_event_stats));
+        s_event_stats_used = 0;
+        s_event_stats_reset = false;
+    }
+
+    bt_app_event_stats_t *slot = NULL;
+    for (int i = 0; i < s_event_stats_used; i++) {
+        if (s_event_stats[i].cb == msg->cb && s_event_stats[i].event == msg->event) {
+            slot = &s_event_stats[i];
+            break;
+        }
+    }
+    if (slot == NULL) {
+        if (s_event_stats_used < BT_APP_EVENT_STATS_SLOTS - 1) {
+            slot = &s_event_stats[s_event_stats_used++];
+            slot->cb = msg->cb;
+            slot->event = msg->event;
+        } else {
+            slot = &s_event_stats[BT_APP_EVENT_STATS_SLOTS - 1];
+        }
+    }
+    bt_app_hist_add(&slot->wait, wait_us);
+    bt_app_hist_add(&slot->run, run_us);
+}
+
+static const char *bt_app_handler_name(bt_app_cb_t cb, char *text, size_t len)
+{
+    if (cb == NULL) {
+        return "(other)";
+    }
+    for (int i = 0; i < BT_APP_HANDLER_NAMES; i++) {
+        if (s_handler_names[i].cb == cb) {
+            return s_handler_names[i].name;
+        }
+    }
+    snprintf(text, len, "%p", (void *)cb);
+    return text;
+}
+
 static void bt_app_task_handler(void *arg)
 {
     bt_app_msg_t msg;
 
     for (;;) {
-        /* receive message from work queue and handle it */
-        if (pdTRUE == xQueueReceive(s_bt_app_task_queue, &msg, (TickType_t)portMAX_DELAY)) {
+        /* woken once per message sent, then take what is waiting, control lane first */
+        ulTaskNotifyTake(pdTRUE, (TickType_t)portMAX_DELAY);
+        while (bt_app_take_msg(&msg)) {
             ESP_LOGD(BT_APP_CORE_TAG, "%s, signal: 0x%x, event: 0x%x", __func__, msg.sig, msg.event);
 
+            int64_t start_us = esp_timer_get_time();
             switch (msg.sig) {
             case BT_APP_SIG_WORK_DISPATCH:
                 bt_app_work_dispatched(&msg);
@@ -73,10 +268,9 @@ static void bt_app_task_handler(void *arg)
                 ESP_LOGW(BT_APP_CORE_TAG, "%s, unhandled signal: %d", __func__, msg.sig);
                 break;
             }
+            bt_app_event_stats_record(&msg, start_us - msg.enqueue_us, esp_timer_get_time() - start_us);
 
-            if (msg.param) {
-                free(msg.param);
-            }
+            bt_app_pool_free(msg.param);
         }
     }
 }
@@ -87,7 +281,13 @@ static void bt_app_task_handler(void *arg)
 
 bool bt_app_work_dispatch(bt_app_cb_t p_cback, uint16_t event, void *p_params, int param_len, bt_app_copy_cb_t p_copy_cback)
 {
-    ESP_LOGD(BT_APP_CORE_TAG, "%s event: 0x%x, param len: %d", __func__, event, param_len);
+    return bt_app_work_dispatch_to(BT_APP_LANE_CONTROL, p_cback, event, p_params, param_len, p_copy_cback);
+}
+
+bool bt_app_work_dispatch_to(bt_app_lane_t lane, bt_app_cb_t p_cback, uint16_t event, void *p_params, int param_len,
+                             bt_app_copy_cb_t p_copy_cback)
+{
+    ESP_LOGD(BT_APP_CORE_TAG, "%s lane: %d, event: 0x%x, param len: %d", __func__, lane, event, param_len);
 
     bt_app_msg_t msg;
     memset(&msg, 0, sizeof(bt_app_msg_t));
@@ -97,25 +297,143 @@ bool bt_app_work_dispatch(bt_app_cb_t p_cback, uint16_t event, void *p_params, i
     msg.cb = p_cback;
 
     if (param_len == 0) {
-        return bt_app_send_msg(&msg);
+        return bt_app_send_msg(lane, &msg);
     } else if (p_params && param_len > 0) {
-        if ((msg.param = malloc(param_len)) != NULL) {
+        if ((msg.param = bt_app_pool_alloc(param_len)) != NULL) {
             memcpy(msg.param, p_params, param_len);
             /* check if caller has provided a copy callback to do the deep copy */
             if (p_copy_cback) {
                 p_copy_cback(msg.param, p_params, param_len);
             }
-            return bt_app_send_msg(&msg);
+            if (bt_app_send_msg(lane, &msg)) {
+                return true;
+            }
+            bt_app_pool_free(msg.param);
+            return false;
+        }
+        if (lane < BT_APP_LANES && s_bt_app_lane_lock) {
+            xSemaphoreTake(s_bt_app_lane_lock, portMAX_DELAY);
+            s_lanes[lane].stats.failed++;
+            xSemaphoreGive(s_bt_app_lane_lock);
         }
     }
 
     return false;
 }
 
+void bt_app_lane_configure(bt_app_lane_t lane, const bt_app_lane_config_t *config)
+{
+    if (lane >= BT_APP_LANES || config == NULL || config->depth == 0) {
+        return;
+    }
+    /* the running task keeps the ring it has; senders index it by config.depth */
+    s_lanes[lane].pending = *config;
+}
+
+void bt_app_lane_get_stats(bt_app_lane_t lane, bt_app_lane_stats_t *stats)
+{
+    if (lane >= BT_APP_LANES || stats == NULL) {
+        return;
+    }
+    if (s_bt_app_lane_lock == NULL) {
+        memset(stats, 0, sizeof(*stats));
+        stats->depth = s_lanes[lane].pending.depth;
+        return;
+    }
+    xSemaphoreTake(s_bt_app_lane_lock, portMAX_DELAY);
+    *stats = s_lanes[lane].stats;
+    stats->depth = s_lanes[lane].config.depth;
+    stats->waiting = s_lanes[lane].count;
+    xSemaphoreGive(s_bt_app_lane_lock);
+}
+
+void bt_app_name_handler(bt_app_cb_t cb, const char *name)
+{
+    for (int i = 0; i < BT_APP_HANDLER_NAMES; i++) {
+        if (s_handler_names[i].cb == NULL || s_handler_names[i].cb == cb) {
+            s_handler_names[i].cb = cb;
+            s_handler_names[i].name = name;
+            return;
+        }
+    }
+}
+
+int bt_app_event_stats_get(bt_app_event_stats_t *stats, int max)
+{
+    int n = 0;
+    if (stats == NULL || s_event_stats_reset) {
+        return 0;
+    }
+    for (int i = 0; i < s_event_stats_used && n < max; i++) {
+        stats[n++] = s_event_stats[i];
+    }
+    if (n < max && s_event_stats[BT_APP_EVENT_STATS_SLOTS - 1].wait.count > 0) {
+        stats[n++] = s_event_stats[BT_APP_EVENT_STATS_SLOTS - 1];
+    }
+    return n;
+}
+
+void bt_app_event_stats_reset(void)
+{
+    s_event_stats_reset = true;
+}
+
+uint32_t bt_app_task_stack_free(void)
+{
+    /* in bytes on ESP-IDF */
+    return s_bt_app_task_handle ? (uint32_t)uxTaskGetStackHighWaterMark(s_bt_app_task_handle) : 0;
+}
+
+void bt_app_event_stats_dump(FILE *out)
+{
+    static bt_app_event_stats_t stats[BT_APP_EVENT_STATS_SLOTS];
+    char name[16], w50[12], w99[12], r50[12], r99[12];
+
+    fprintf(out, "lane     depth  now  high   queued  failed  dropped  merged\n");
+    for (int i = 0; i < BT_APP_LANES; i++) {
+        bt_app_lane_stats_t lane;
+        bt_app_lane_get_stats(i, &lane);
+        fprintf(out, "%-8s %5u %4u %5u %8lu %7lu %8lu %7lu\n", s_lane_names[i], lane.depth, lane.waiting,
+                lane.high_water, (unsigned long)lane.enqueued, (unsigned long)lane.failed,
+                (unsigned long)lane.dropped, (unsigned long)lane.coalesced);
+    }
+
+    int n = bt_app_event_stats_get(stats, BT_APP_EVENT_STATS_SLOTS);
+    fprintf(out, "handler     event        n | wait us  p50    p99     max | run us  p50    p99     max\n");
+    for (int i = 0; i < n; i++) {
+        const bt_app_event_stats_t *e = &stats[i];
+        bt_app_hist_pct(&e->wait, 50, w50, sizeof(w50));
+        bt_app_hist_pct(&e->wait, 99, w99, sizeof(w99));
+        bt_app_hist_pct(&e->run, 50, r50, sizeof(r50));
+        bt_app_hist_pct(&e->run, 99, r99, sizeof(r99));
+        fprintf(out, "%-11s 0x%04x %7lu |       %6s %6s %7lu |      %6s %6s %7lu\n",
+                bt_app_handler_name(e->cb, name, sizeof(name)), e->event, (unsigned long)e->wait.count,
+                w50, w99, (unsigned long)e->wait.max_us, r50, r99, (unsigned long)e->run.max_us);
+    }
+    fprintf(out, "BtAppTask stack: %lu of %d bytes never used\n", (unsigned long)bt_app_task_stack_free(),
+            BT_APP_TASK_STACK);
+}
+
 void bt_app_task_start_up(void)
 {
-    s_bt_app_task_queue = xQueueCreate(10, sizeof(bt_app_msg_t));
-    xTaskCreate(bt_app_task_handler, "BtAppTask", 2048, NULL, 10, &s_bt_app_task_handle);
+    /* a second start-up begins afresh instead of leaking the first one's lanes */
+    if (s_bt_app_lane_lock) {
+        ESP_LOGW(BT_APP_CORE_TAG, "%s while running, restarting", __func__);
+        bt_app_task_shut_down();
+    }
+    s_bt_app_lane_lock = xSemaphoreCreateMutex();
+    for (int i = 0; i < BT_APP_LANES; i++) {
+        bt_app_lane_ctx_t *lane = &s_lanes[i];
+        lane->config = lane->pending;
+        lane->ring = calloc(lane->config.depth, sizeof(bt_app_msg_t));
+        lane->head = 0;
+        lane->count = 0;
+        memset(&lane->stats, 0, sizeof(lane->stats));
+        if (lane->config.policy == BT_APP_LANE_BLOCK) {
+            lane->slots = xSemaphoreCreateCounting(lane->config.depth, lane->config.depth);
+        }
+    }
+    xTaskCreate(bt_app_task_handler, "BtAppTask", BT_APP_TASK_STACK, NULL, BT_APP_TASK_PRIO, &s_bt_app_task_handle);
 }
 
 void bt_app_task_shut_down(void)
@@ -124,8 +442,23 @@ void bt_app_task_shut_down(void)
         vTaskDelete(s_bt_app_task_handle);
         s_bt_app_task_handle = NULL;
     }
-    if (s_bt_app_task_queue) {
-        vQueueDelete(s_bt_app_task_queue);
-        s_bt_app_task_queue = NULL;
+    for (int i = 0; i < BT_APP_LANES; i++) {
+        bt_app_lane_ctx_t *lane = &s_lanes[i];
+        if (lane->ring) {
+            for (uint16_t n = 0; n < lane->count; n++) {
+                bt_app_pool_free(lane->ring[(lane->head + n) % lane->config.depth].param);
+            }
+            free(lane->ring);
+            lane->ring = NULL;
+            lane->count = 0;
+        }
+        if (lane->slots) {
+            vSemaphoreDelete(lane->slots);
+            lane->slots = NULL;
+        }
+    }
+    if (s_bt_app_lane_lock) {
+        vSemaphoreDelete(s_bt_app_lane_lock);
+        s_bt_app_lane_lock = NULL;
     }
-}
\ No newline at end of file
+}
@@ -17,6 +17,54 @@
 /* signal for dispatcher */
 #define BT_APP_SIG_WORK_DISPATCH    (0x01)
 
+/* default lane configuration, see bt_app_lane_configure() */
+#ifndef BT_APP_CONTROL_LANE_DEPTH
+#define BT_APP_CONTROL_LANE_DEPTH   (16)
+#endif
+#ifndef BT_APP_CONTROL_LANE_WAIT_MS
+#define BT_APP_CONTROL_LANE_WAIT_MS (100)
+#endif
+#ifndef BT_APP_BULK_LANE_DEPTH
+#define BT_APP_BULK_LANE_DEPTH      (8)
+#endif
+
+/**
+ * Work reaches the application task through two lanes. The control lane
+ * carries what the state machines must not miss (connection and media
+ * state, stack up, AVRC volume notifications) and is always served first;
+ * the bulk lane carries the rest (heart beats, delay reports, AVRC
+ * passthrough and metadata responses).
+ */
+typedef enum {
+    BT_APP_LANE_CONTROL = 0,
+    BT_APP_LANE_BULK,
+    BT_APP_LANES,
+} bt_app_lane_t;
+
+/* what a full lane does with new work */
+typedef enum {
+    BT_APP_LANE_BLOCK = 0,      /*!< the sender waits up to wait_ms for room, then the work is lost */
+    BT_APP_LANE_DROP_OLDEST,    /*!< the oldest waiting work makes room */
+    BT_APP_LANE_COALESCE,       /*!< work without parameters merges into the same work still waiting;
+                                     otherwise as BT_APP_LANE_DROP_OLDEST */
+} bt_app_lane_policy_t;
+
+typedef struct {
+    uint16_t             depth;      /*!< messages the lane holds */
+    uint16_t             wait_ms;    /*!< longest wait of a sender, for BT_APP_LANE_BLOCK */
+    bt_app_lane_policy_t policy;
+} bt_app_lane_config_t;
+
+typedef struct {
+    uint16_t             depth;
+    uint16_t             waiting;       /*!< messages in the lane now */
+    uint16_t             high_water;    /*!< most messages in the lane at once */
+    uint32_t             enqueued;
+    uint32_t             failed;        /*!< work lost: no room in time, or no memory for its parameters */
+    uint32_t             dropped;       /*!< waiting work evicted by BT_APP_LANE_DROP_OLDEST */
+    uint32_t             coalesced;     /*!< work merged by BT_APP_LANE_COALESCE */
+} bt_app_lane_stats_t;
+
 /**
  * @brief    handler for the dispatched work
  *
@@ -27,12 +75,36 @@ typedef void (* bt_app_cb_t) (uint16_t event, void *param);
 
 /* message to be sent */
 typedef struct {
-    uint16_t             sig;      /*!< signal to bt_app_task */
-    uint16_t             event;    /*!< message event id */
-    bt_app_cb_t          cb;       /*!< context switch callback */
-    void                 *param;   /*!< parameter area needs to be last */
+    uint16_t             sig;           /*!< signal to bt_app_task */
+    uint16_t             event;         /*!< message event id */
+    bt_app_cb_t          cb;            /*!< context switch callback */
+    int64_t              enqueue_us;    /*!< when it was queued, esp_timer time */
+    void                 *param;        /*!< parameter area needs to be last */
 } bt_app_msg_t;
 
+/* kinds of work the task keeps times for; the rest is counted together */
+#ifndef BT_APP_EVENT_STATS_SLOTS
+#define BT_APP_EVENT_STATS_SLOTS    (32)
+#endif
+
+/* bucket 0 holds 0 us, bucket k from 2^(k-1) up to 2^k us, the last one the rest */
+#define BT_APP_HIST_BUCKETS         (20)
+
+typedef struct {
+    uint32_t             count;
+    uint32_t             max_us;
+    uint64_t             total_us;
+    uint32_t             buckets[BT_APP_HIST_BUCKETS];
+} bt_app_hist_t;
+
+/* times of one kind of work: a handler and an event id */
+typedef struct {
+    bt_app_cb_t          cb;            /*!< NULL for the slot of all other work */
+    uint16_t             event;
+    bt_app_hist_t        wait;          /*!< queued until the task took it */
+    bt_app_hist_t        run;           /*!< in the handler */
+} bt_app_event_stats_t;
+
 /**
  * @brief    parameter deep-copy function to be customized
  *
@@ -56,7 +128,68 @@ typedef void (* bt_app_copy_cb_t) (void *p_dest, void *p_src, int len);
 bool bt_app_work_dispatch(bt_app_cb_t p_cback, uint16_t event, void *p_params, int param_len, bt_app_copy_cb_t p_copy_cback);
 
 /**
- * @brief    start up the application task
+ * @brief    work dispatcher for the application task, on a given lane;
+ *           bt_app_work_dispatch() uses the control lane
+ *
+ * @param [in] lane          lane to queue the work on
+ *
+ * @return  true if the work was queued or merged, false if it was lost
+ */
+bool bt_app_work_dispatch_to(bt_app_lane_t lane, bt_app_cb_t p_cback, uint16_t event, void *p_params, int param_len,
+                             bt_app_copy_cb_t p_copy_cback);
+
+/**
+ * @brief    configure a lane; takes effect at the next bt_app_task_start_up(), while a running
+ *           task keeps the lanes it started with
+ *
+ * @param [in] lane    lane to configure
+ * @param [in] config  its depth, wait and policy
+ */
+void bt_app_lane_configure(bt_app_lane_t lane, const bt_app_lane_config_t *config);
+
+/**
+ * @brief    counters of a lane since the application task started
+ *
+ * @param [in]  lane   lane to read
+ * @param [out] stats  its counters
+ */
+void bt_app_lane_get_stats(bt_app_lane_t lane, bt_app_lane_stats_t *stats);
+
+/**
+ * @brief    name a handler for bt_app_event_stats_dump()
+ *
+ * @param [in] cb    handler
+ * @param [in] name  its name, kept by reference
+ */
+void bt_app_name_handler(bt_app_cb_t cb, const char *name);
+
+/**
+ * @brief    times of the work handled so far, one entry per handler and event id
+ *
+ * @param [out] stats  room for max entries
+ * @param [in]  max    entries to copy at most
+ *
+ * @return  entries copied
+ */
+int bt_app_event_stats_get(bt_app_event_stats_t *stats, int max);
+
+/**
+ * @brief    clear the times; the task clears them before it handles the next work
+ */
+void bt_app_event_stats_reset(void);
+
+/**
+ * @brief    print the lanes, the times per kind of work and the task's stack use
+ */
+void bt_app_event_stats_dump(FILE *out);
+
+/**
+ * @brief    least stack the application task has had free, in bytes; 0 if it is not running
+ */
+uint32_t bt_app_task_stack_free(void);
+
+/**
+ * @brief    start up the application task, shutting down one already running
  */
 void bt_app_task_start_up(void);
 
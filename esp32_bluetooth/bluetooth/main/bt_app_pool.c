@@ -0,0 +1,151 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "bt_app_pool.h"
+
+/*
+ * Each class keeps its free blocks as set bits of one word. Taking a block
+ * clears a bit with compare-and-swap and giving it back sets it again, so
+ * any number of tasks can allocate and free at once without a lock, and
+ * without the ABA trouble of a lock-free free list.
+ */
+
+#define BLOCK_ALIGN(n)    (((n) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+#define SMALL_STRIDE      BLOCK_ALIGN(BT_APP_POOL_SMALL_BYTES)
+#define LARGE_STRIDE      BLOCK_ALIGN(BT_APP_POOL_LARGE_BYTES)
+
+_Static_assert(BT_APP_POOL_SMALL_BLOCKS >= 1 && BT_APP_POOL_SMALL_BLOCKS <= 32, "1 to 32 small blocks");
+_Static_assert(BT_APP_POOL_LARGE_BLOCKS >= 1 && BT_APP_POOL_LARGE_BLOCKS <= 32, "1 to 32 large blocks");
+_Static_assert(BT_APP_POOL_SMALL_BYTES <= BT_APP_POOL_LARGE_BYTES, "classes go from small to large");
+
+typedef struct {
+    uint8_t *base;
+    uint32_t stride;
+    uint32_t block_bytes;
+    uint32_t blocks;
+    atomic_uint_fast32_t free_mask;    /* set bit: block free */
+    atomic_uint_fast32_t hits;
+    atomic_uint_fast32_t high_water;
+} pool_class_t;
+
+/*********************************
+ * STATIC VARIABLE DEFINITIONS
+ ********************************/
+static uint8_t s_small[BT_APP_POOL_SMALL_BLOCKS * SMALL_STRIDE] __attribute__((aligned(8)));
+static uint8_t s_large[BT_APP_POOL_LARGE_BLOCKS * LARGE_STRIDE] __attribute__((aligned(8)));
+
+#define ALL_FREE(blocks)  ((blocks) == 32 ? 0xffffffffu : (1u << (blocks)) - 1)
+
+static pool_class_t s_classes[BT_APP_POOL_CLASSES] = {
+    {
+        .base = s_small, .stride = SMALL_STRIDE, .block_bytes = BT_APP_POOL_SMALL_BYTES,
+        .blocks = BT_APP_POOL_SMALL_BLOCKS,
+        .free_mask = ALL_FREE(BT_APP_POOL_SMALL_BLOCKS),
+    },
+    {
+        .base = s_large, .stride = LARGE_STRIDE, .block_bytes = BT_APP_POOL_LARGE_BYTES,
+        .blocks = BT_APP_POOL_LARGE_BLOCKS,
+        .free_mask = ALL_FREE(BT_APP_POOL_LARGE_BLOCKS),
+    },
+};
+static atomic_uint_fast32_t s_misses;
+static atomic_uint_fast32_t s_heap_in_use;
+
+/*********************************
+ * STATIC FUNCTION DEFINITIONS
+ ********************************/
+
+static void *pool_class_take(pool_class_t *c)
+{
+    uint_fast32_t mask = atomic_load_explicit(&c->free_mask, memory_order_relaxed);
+    while (mask != 0) {
+        uint_fast32_t bit = mask & -mask;
+        if (atomic_compare_exchange_weak_explicit(&c->free_mask, &mask, mask & ~bit,
+                                                  memory_order_acquire, memory_order_relaxed)) {
+            /* the blocks in use are the clear bits */
+            uint32_t in_use = c->blocks - (uint32_t)__builtin_popcount((unsigned int)(mask & ~bit));
+            uint_fast32_t high = atomic_load_explicit(&c->high_water, memory_order_relaxed);
+            while (in_use > high &&
+                    !atomic_compare_exchange_weak_explicit(&c->high_water, &high, in_use,
+                                                           memory_order_relaxed, memory_order_relaxed)) {
+            }
+            atomic_fetch_add_explicit(&c->hits, 1, memory_order_relaxed);
+            return c->base + (uint32_t)__builtin_ctz((unsigned int)bit) * c->stride;
+        }
+    }
+    return NULL;
+}
+
+static pool_class_t *pool_class_of(const void *p)
+{
+    for (int i = 0; i < BT_APP_POOL_CLASSES; i++) {
+        pool_class_t *c = &s_classes[i];
+        const uint8_t *b = (const uint8_t *)p;
+        if (b >= c->base && b < c->base + c->blocks * c->stride) {
+            return c;
+        }
+    }
+    return NULL;
+}
+
+/*********************************
+ * EXTERN FUNCTION DEFINITIONS
+ ********************************/
+
+void *bt_app_pool_alloc(size_t len)
+{
+    for (int i = 0; i < BT_APP_POOL_CLASSES; i++) {
+        if (len <= s_classes[i].block_bytes) {
+            void *p = pool_class_take(&s_classes[i]);
+            if (p) {
+                return p;
+            }
+        }
+    }
+
+    atomic_fetch_add_explicit(&s_misses, 1, memory_order_relaxed);
+    void *p = malloc(len);
+    if (p) {
+        atomic_fetch_add_explicit(&s_heap_in_use, 1, memory_order_relaxed);
+    }
+    return p;
+}
+
+void bt_app_pool_free(void *p)
+{
+    if (p == NULL) {
+        return;
+    }
+
+    pool_class_t *c = pool_class_of(p);
+    if (c == NULL) {
+        atomic_fetch_sub_explicit(&s_heap_in_use, 1, memory_order_relaxed);
+        free(p);
+        return;
+    }
+    uint32_t index = (uint32_t)((uint8_t *)p - c->base) / c->stride;
+    atomic_fetch_or_explicit(&c->free_mask, (uint_fast32_t)1 << index, memory_order_release);
+}
+
+void bt_app_pool_get_stats(bt_app_pool_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    for (int i = 0; i < BT_APP_POOL_CLASSES; i++) {
+        pool_class_t *c = &s_classes[i];
+        stats->classes[i].block_bytes = c->block_bytes;
+        stats->classes[i].blocks = c->blocks;
+        stats->classes[i].hits = (uint32_t)atomic_load(&c->hits);
+        stats->classes[i].in_use = c->blocks - (uint32_t)__builtin_popcount((unsigned int)atomic_load(&c->free_mask));
+        stats->classes[i].high_water = (uint32_t)atomic_load(&c->high_water);
+    }
+    stats->misses = (uint32_t)atomic_load(&s_misses);
+    stats->heap_in_use = (uint32_t)atomic_load(&s_heap_in_use);
+}
@@ -0,0 +1,68 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#ifndef __BT_APP_POOL_H__
+#define __BT_APP_POOL_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Fixed blocks for the parameter copies of bt_app_work_dispatch(), so the
+ * Bluetooth callbacks do not go to the heap for every event. A copy takes
+ * a block of the smallest class it fits in, or of the next larger class
+ * when that one is used up, or else comes from the heap (a miss).
+ *
+ * The small class takes esp_a2d_cb_param_t and the large one
+ * esp_avrc_ct_cb_param_t; bluetooth.c checks that they fit. A class has at
+ * most 32 blocks.
+ */
+
+#ifndef BT_APP_POOL_SMALL_BYTES
+#define BT_APP_POOL_SMALL_BYTES     (32)
+#endif
+#ifndef BT_APP_POOL_SMALL_BLOCKS
+#define BT_APP_POOL_SMALL_BLOCKS    (16)
+#endif
+#ifndef BT_APP_POOL_LARGE_BYTES
+#define BT_APP_POOL_LARGE_BYTES     (64)
+#endif
+#ifndef BT_APP_POOL_LARGE_BLOCKS
+#define BT_APP_POOL_LARGE_BLOCKS    (8)
+#endif
+
+#define BT_APP_POOL_CLASSES         (2)
+
+typedef struct {
+    uint32_t block_bytes;
+    uint32_t blocks;
+    uint32_t hits;          /*!< copies given a block of this class */
+    uint32_t in_use;
+    uint32_t high_water;    /*!< most blocks in use at once */
+} bt_app_pool_class_stats_t;
+
+typedef struct {
+    bt_app_pool_class_stats_t classes[BT_APP_POOL_CLASSES];
+    uint32_t misses;        /*!< copies that went to the heap */
+    uint32_t heap_in_use;
+} bt_app_pool_stats_t;
+
+/**
+ * @brief    a block of at least len bytes; from any task
+ *
+ * @return  the block, or NULL if the pool is used up and the heap is too
+ */
+void *bt_app_pool_alloc(size_t len);
+
+/**
+ * @brief    give back a block from bt_app_pool_alloc(); NULL is ignored
+ */
+void bt_app_pool_free(void *p);
+
+/**
+ * @brief    copy of the counters since boot
+ */
+void bt_app_pool_get_stats(bt_app_pool_stats_t *stats);
+
+#endif /* __BT_APP_POOL_H__ */
@@ -0,0 +1,19 @@
+#ifndef PEN_CLOCK_H
+#define PEN_CLOCK_H
+
+#include <chrono>
+#include <cstdint>
+
+namespace pen {
+
+// Monotonic time in nanoseconds; the time base of every timestamp in the
+// receiver
+inline int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+} // namespace pen
+
+#endif // PEN_CLOCK_H
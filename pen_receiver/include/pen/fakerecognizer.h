@@ -0,0 +1,90 @@
+#ifndef PEN_FAKERECOGNIZER_H
+#define PEN_FAKERECOGNIZER_H
+
+#include "pen/mappedfile.h"
+#include "pen/recognizer.h"
+
+#include <memory>
+
+namespace pen {
+
+class FakeModel;
+
+// Deterministic stand-in for a speech engine. It ignores what the audio
+// says and "recognizes" a script, one word per wordMs of input, closing an
+// utterance every wordsPerUtterance words. The same input length always
+// gives the same words and timings, so runs can be compared.
+//
+// computeFactor burns CPU in proportion to the audio: 0.3 spends 3 ms per
+// 10 ms chunk, roughly what a small VOSK model costs on a Raspberry Pi 4.
+// loadMs and sessionMs stand in for loading the model and for setting up
+// a session on it; a modelPath file is mapped as the model's weights and
+// streamed through while decoding.
+class FakeRecognizer : public Recognizer {
+public:
+    struct Options {
+        int sampleRate = 16000;
+        int wordMs = 300;
+        int wordsPerUtterance = 8;
+        double computeFactor = 0;
+        int loadMs = 0;
+        int sessionMs = 0;
+        std::string modelPath;
+        std::vector<std::string> script; // Empty: a built-in lecture
+    };
+
+    explicit FakeRecognizer(std::shared_ptr<const FakeModel> model);
+
+    int sampleRate() const override { return options.sampleRate; }
+    bool acceptPcm(const int16_t *samples, size_t count) override;
+    std::string partial() override;
+    bool takeFinal(RecognitionResult *result) override;
+    bool finish() override;
+    void reset() override;
+    std::string name() const override { return "fake"; }
+
+    // Parses "fake[:key=value,...]" with keys rate, word-ms, utterance,
+    // cost, load, session, model and script (a text file, split at white
+    // space)
+    static bool parseSpec(const std::string &spec, Options *options, std::string *error);
+
+private:
+    void burn(size_t count);
+    void readWeights(size_t count);
+    void closeUtterance();
+
+    std::shared_ptr<const FakeModel> model;
+    const Options &options; // The model's
+    uint64_t samplesSeen = 0;
+    uint64_t wordsEmitted = 0; // Over the whole stream; indexes the script
+    std::vector<RecognizedWord> current;
+    RecognitionResult completed;
+    bool hasCompleted = false;
+    uint32_t checksum = 0; // Keeps the burn loop from being optimized away
+    size_t weightsAt = 0;
+};
+
+// The fake engine's shared part: options, script and mapped weights
+class FakeModel : public RecognizerModel, public std::enable_shared_from_this<FakeModel> {
+public:
+    // Spends options.loadMs
+    static std::shared_ptr<FakeModel> load(FakeRecognizer::Options options, std::string *error);
+
+    // Spends options.sessionMs
+    std::unique_ptr<Recognizer> createSession(std::string *error) override;
+    int sampleRate() const override { return modelOptions.sampleRate; }
+    std::string name() const override { return "fake"; }
+
+    const FakeRecognizer::Options &options() const { return modelOptions; }
+    const MappedFile *weights() const { return mappedWeights.get(); }
+
+private:
+    explicit FakeModel(FakeRecognizer::Options options);
+
+    FakeRecognizer::Options modelOptions;
+    std::unique_ptr<MappedFile> mappedWeights;
+};
+
+} // namespace pen
+
+#endif // PEN_FAKERECOGNIZER_H
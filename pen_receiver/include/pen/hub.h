@@ -0,0 +1,96 @@
+#ifndef PEN_HUB_H
+#define PEN_HUB_H
+
+#include "pen/receiver.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pen {
+
+// Classroom mode: many pen streams decoded on a fixed pool of workers
+// instead of a thread per pen.
+//
+// Each stream is a Receiver without a decode thread. A queued frame makes
+// the stream runnable; a runnable stream sits in exactly one worker's
+// deque and is drained by one worker at a time, so its frames reach the
+// recognizer in order and its state is never shared. A stream goes back to
+// the worker that last ran it, keeping the recognizer's state in that
+// core's cache; an idle worker steals from the others.
+class Hub {
+public:
+    struct Options {
+        int workers = int(std::thread::hardware_concurrency());
+        // Frames drained per turn before a stream yields to the next
+        size_t batchFrames = 4;
+    };
+
+    struct WorkerStats {
+        std::atomic<uint64_t> turns{0};
+        std::atomic<uint64_t> steals{0};
+        std::atomic<int64_t> busyNs{0};
+    };
+
+    explicit Hub(Options options);
+    ~Hub();
+
+    Hub(const Hub &) = delete;
+    Hub &operator=(const Hub &) = delete;
+
+    // The transport and sink must outlive the hub. Start the returned
+    // receiver as usual; start() may block (sockets), so several can be
+    // started from separate threads.
+    Receiver &addStream(Transport &transport, FrameSink &sink, Receiver::Options options);
+
+    int streamCount() const { return int(streams.size()); }
+    Receiver &receiver(int stream) { return *streams[size_t(stream)]->receiver; }
+    int workerCount() const { return int(workers.size()); }
+    const WorkerStats &workerStats(int worker) const { return workers[size_t(worker)]->stats; }
+
+    // Stops the workers once every queued frame is consumed
+    void shutdown();
+
+private:
+    struct Stream {
+        std::unique_ptr<Receiver> receiver;
+        std::atomic<bool> scheduled{false};
+        std::atomic<int> home{-1}; // Worker that last ran it
+    };
+
+    struct alignas(64) Worker {
+        std::mutex mutex;
+        std::deque<int> runnable; // Owner takes the front, thieves the back
+        std::atomic<bool> asleep{false};
+        std::thread thread;
+        WorkerStats stats;
+    };
+
+    void schedule(int stream);
+    void push(int worker, int stream);
+    bool take(int worker, int *stream);
+    bool steal(int worker, int *stream);
+    bool canSteal(int worker);
+    // The stream an awake owner is about to take is not up for stealing
+    static size_t backlogOf(const Worker &victim) { return victim.asleep.load(std::memory_order_relaxed) ? 0 : 1; }
+    void run(int worker, int stream);
+    void work(int worker);
+
+    Options options;
+    std::vector<std::unique_ptr<Stream>> streams;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    std::atomic<int> queuedStreams{0};
+    std::atomic<bool> stopping{false};
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+    int sleepers = 0; // Guarded by sleepMutex
+};
+
+} // namespace pen
+
+#endif // PEN_HUB_H
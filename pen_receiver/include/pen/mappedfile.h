@@ -0,0 +1,39 @@
+#ifndef PEN_MAPPEDFILE_H
+#define PEN_MAPPEDFILE_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace pen {
+
+// A file mapped read-only. Every mapping of a file shares the same page
+// cache pages, so a model mapped once per process costs its size in
+// memory once, however many sessions (or daemons) read it.
+class MappedFile {
+public:
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    static std::unique_ptr<MappedFile> open(const std::string &path, std::string *error);
+
+    const unsigned char *data() const { return bytes; }
+    size_t size() const { return length; }
+    const std::string &path() const { return filePath; }
+
+    // Asks the kernel to read the whole file in now rather than on first
+    // touch, e.g. while the daemon starts
+    void prefetch() const;
+
+private:
+    MappedFile(std::string path, const unsigned char *bytes, size_t length);
+
+    std::string filePath;
+    const unsigned char *bytes;
+    size_t length;
+};
+
+} // namespace pen
+
+#endif // PEN_MAPPEDFILE_H
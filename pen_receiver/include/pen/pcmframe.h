@@ -0,0 +1,34 @@
+#ifndef PEN_PCMFRAME_H
+#define PEN_PCMFRAME_H
+
+#include <cstdint>
+
+namespace pen {
+
+// Sample format of a pen stream. The pen's A2DP source sends interleaved
+// signed 16-bit little-endian PCM, 44.1 kHz stereo unless configured
+// otherwise.
+struct StreamFormat {
+    uint32_t sampleRate = 44100;
+    uint16_t channels = 2;
+
+    uint32_t bytesPerFrame(int frameMs) const { return sampleRate * frameMs / 1000 * channels * 2; }
+};
+
+// One fixed-size block of PCM as it came off the transport. Plain data, so
+// ring slots can be filled in place and never allocate.
+struct PcmFrame {
+    // 20 ms of 48 kHz stereo
+    static constexpr int MaxSamples = 48000 / 50 * 2;
+
+    uint64_t sequence;
+    int64_t arrivalNs; // steady clock
+    uint32_t sampleRate;
+    uint16_t channels;
+    uint16_t frames; // Samples per channel
+    int16_t samples[MaxSamples];
+};
+
+} // namespace pen
+
+#endif // PEN_PCMFRAME_H
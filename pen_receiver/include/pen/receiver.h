@@ -0,0 +1,109 @@
+#ifndef PEN_RECEIVER_H
+#define PEN_RECEIVER_H
+
+#include "pen/pcmframe.h"
+#include "pen/spscring.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace pen {
+
+class Transport;
+
+// Where decoded frames go: the recognizer, a meter, a recorder. Called on
+// the decode thread only.
+class FrameSink {
+public:
+    virtual ~FrameSink() = default;
+
+    // Before the first frame, once the transport knows the format; the
+    // place to allocate. Returning false fails Receiver::start().
+    virtual bool streamStarted(StreamFormat format, std::string *error) {
+        (void)format;
+        (void)error;
+        return true;
+    }
+    virtual void consume(const PcmFrame &frame) = 0;
+    virtual void endOfStream() {}
+};
+
+// Updated by the receiver threads; read from anywhere
+struct ReceiverStats {
+    std::atomic<uint64_t> framesReceived{0};
+    std::atomic<uint64_t> framesDecoded{0};
+    std::atomic<uint64_t> bytesReceived{0};
+    // Frames dropped because the decode side had fallen a whole ring behind
+    std::atomic<uint64_t> overruns{0};
+    // Frames that arrived more than a frame period after they were due, i.e.
+    // the link stalled and the decoder ran dry
+    std::atomic<uint64_t> underruns{0};
+    // Most frames waiting in the ring at once
+    std::atomic<uint64_t> maxQueued{0};
+};
+
+// Pulls fixed-size frames off a transport on one thread and hands them to
+// a sink on another, through an SpscRing whose slots are read into
+// directly. After start() nothing on the per-frame path allocates.
+//
+// By default the receiver runs its own decode thread. With frameQueued set
+// it runs none: the callback fires on the receive thread after every
+// queued frame and once at the end of the stream, and whoever it wakes
+// calls drain() (one thread at a time), as the Hub does.
+class Receiver {
+public:
+    struct Options {
+        int frameMs = 10;
+        size_t ringFrames = 64;
+        std::function<void()> frameQueued;
+    };
+
+    Receiver(Transport &transport, FrameSink &sink, Options options);
+    ~Receiver();
+
+    Receiver(const Receiver &) = delete;
+    Receiver &operator=(const Receiver &) = delete;
+
+    // Opens the transport and starts both threads
+    bool start(std::string *error);
+    // Interrupts the transport; the decode thread drains what is queued
+    void stop();
+    // Returns once the stream has ended and, with a decode thread, every
+    // queued frame is consumed
+    void wait();
+
+    // Consumes up to maxFrames queued frames on the calling thread, and
+    // ends the stream in the sink once the transport is done and the ring
+    // is empty. Returns the number of frames consumed.
+    size_t drain(size_t maxFrames);
+    // Whether drain() has anything to do
+    bool pending() const;
+
+    bool running() const { return !finished.load(std::memory_order_acquire); }
+    const ReceiverStats &stats() const { return counters; }
+    size_t queued() const { return ring.size(); }
+
+private:
+    void receive();
+    void decode();
+    void finish();
+
+    Transport &transport;
+    FrameSink &sink;
+    Options options;
+    SpscRing<PcmFrame> ring;
+    PcmFrame scratch; // Overrun frames are read here and dropped
+    ReceiverStats counters;
+
+    std::atomic<bool> producerDone{false};
+    std::atomic<bool> finished{true};
+    std::thread producer;
+    std::thread consumer;
+};
+
+} // namespace pen
+
+#endif // PEN_RECEIVER_H
@@ -0,0 +1,74 @@
+#ifndef PEN_RECOGNIZER_H
+#define PEN_RECOGNIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pen {
+
+struct RecognizedWord {
+    std::string text;
+    int64_t startMs; // From the first sample given since reset()
+    int64_t endMs;
+    float confidence; // 0..1
+};
+
+// A finished utterance
+struct RecognitionResult {
+    std::vector<RecognizedWord> words;
+
+    std::string text() const;
+};
+
+// Streaming speech recognizer. Everything above this interface (receiver,
+// benchmarks, the Notes app) is engine-agnostic; one instance serves one
+// stream and is used from one thread at a time.
+class Recognizer {
+public:
+    virtual ~Recognizer() = default;
+
+    // Input rate in Hz; input is mono signed 16-bit
+    virtual int sampleRate() const = 0;
+
+    // Feeds a chunk of audio. Returns true when it completed an utterance,
+    // which takeFinal() then returns.
+    virtual bool acceptPcm(const int16_t *samples, size_t count) = 0;
+    // Best guess for the utterance in progress; may change with every chunk
+    virtual std::string partial() = 0;
+    // Moves out the completed utterance. Returns false if there is none.
+    virtual bool takeFinal(RecognitionResult *result) = 0;
+    // End of stream: completes the utterance in progress, if any
+    virtual bool finish() = 0;
+    // Forgets all state, including the time base
+    virtual void reset() = 0;
+
+    virtual std::string name() const = 0;
+};
+
+// What an engine loads once and then only reads: acoustic model, decoding
+// graph, vocabulary. Each stream gets a session of its own; sessions may
+// be created from any thread and run concurrently.
+class RecognizerModel {
+public:
+    virtual ~RecognizerModel() = default;
+
+    virtual std::unique_ptr<Recognizer> createSession(std::string *error) = 0;
+    virtual int sampleRate() const = 0;
+    virtual std::string name() const = 0;
+};
+
+// Loads the model for an engine spec: "fake[:options]" (see
+// FakeRecognizer) or, when built with VOSK, "vosk:MODEL_DIR". sampleRate is
+// the input rate. A model is loaded once per spec and rate and then kept
+// for the life of the process, so later calls return at once.
+std::shared_ptr<RecognizerModel> loadModel(const std::string &spec, int sampleRate, std::string *error);
+
+// A session of the model for spec; see loadModel()
+std::unique_ptr<Recognizer> createRecognizer(const std::string &spec, int sampleRate, std::string *error);
+
+} // namespace pen
+
+#endif // PEN_RECOGNIZER_H
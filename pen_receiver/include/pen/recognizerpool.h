@@ -0,0 +1,71 @@
+#ifndef PEN_RECOGNIZERPOOL_H
+#define PEN_RECOGNIZERPOOL_H
+
+#include "pen/recognizer.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pen {
+
+// Recognizer sessions created ahead of time, so that a pen that connects
+// mid-lecture starts decoding at once instead of waiting for a session to
+// be set up. A background thread keeps warm sessions ready; each has
+// already decoded a little silence, so first-use allocations and page
+// faults on the model are behind it. Sessions come back through release()
+// when their stream ends and are reused.
+class RecognizerPool {
+public:
+    struct Options {
+        int warm = 2; // Kept ready
+        int maxIdle = 16; // Released sessions kept beyond that
+    };
+
+    struct Stats {
+        std::atomic<uint64_t> hits{0}; // acquire() found a ready session
+        std::atomic<uint64_t> misses{0}; // ... and had to create one
+        std::atomic<uint64_t> created{0};
+        std::atomic<int64_t> createNs{0}; // Total, including warm-up
+    };
+
+    RecognizerPool(std::shared_ptr<RecognizerModel> model, Options options);
+    ~RecognizerPool();
+
+    // Thread-safe. A ready session, or a new one if none is ready.
+    std::unique_ptr<Recognizer> acquire(std::string *error);
+    // Thread-safe. Resets the session and keeps it for the next stream.
+    void release(std::unique_ptr<Recognizer> session);
+
+    // Blocks until the first options.warm sessions are ready, e.g. before
+    // the daemon starts taking connections
+    void waitUntilWarm();
+
+    size_t ready() const;
+    const RecognizerModel &model() const { return *recognizerModel; }
+    const Stats &stats() const { return counters; }
+
+private:
+    std::unique_ptr<Recognizer> createWarm(std::string *error);
+    void fill();
+
+    std::shared_ptr<RecognizerModel> recognizerModel;
+    Options options;
+    Stats counters;
+
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<std::unique_ptr<Recognizer>> sessions; // Ready
+    bool stopping = false;
+    bool failed = false; // Creating a session failed; do not keep trying
+    std::thread filler;
+};
+
+} // namespace pen
+
+#endif // PEN_RECOGNIZERPOOL_H
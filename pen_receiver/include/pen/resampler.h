@@ -0,0 +1,78 @@
+#ifndef PEN_RESAMPLER_H
+#define PEN_RESAMPLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace pen {
+
+// Polyphase FIR bank for one rational rate change up/down (e.g. 160/441
+// for 44.1 kHz to 16 kHz): a Kaiser-windowed sinc split into `up` phases
+// of tapsPerPhase coefficients each, stored reversed and zero-padded so
+// that every output sample is one contiguous dot product.
+struct FilterBank {
+    int inputRate;
+    int outputRate;
+    int up;
+    int down;
+    int tapsPerPhase; // Multiple of 8
+    std::vector<float> coefficients; // up * tapsPerPhase
+    // After an output at phase p: next phase, and input samples to move on
+    std::vector<int> nextPhase;
+    std::vector<int> advance;
+
+    const float *phase(int p) const { return coefficients.data() + size_t(p) * size_t(tapsPerPhase); }
+
+    // Designed once per rate pair and shared by every resampler using it
+    static std::shared_ptr<const FilterBank> forRates(int inputRate, int outputRate);
+};
+
+// Downmixes interleaved 16-bit PCM to mono and resamples it, e.g. A2DP's
+// 44.1 or 48 kHz stereo to the 16 kHz mono speech models are trained on.
+// Block based and stateful across blocks; all memory is allocated in the
+// constructor.
+//
+// Passband is flat to 85% of the lower Nyquist rate (6.8 kHz at 16 kHz)
+// with 60 dB stopband; the top of the band is allowed to alias, which
+// speech recognition does not notice, for a filter half as long.
+class Resampler {
+public:
+    Resampler(int inputRate, int outputRate, int channels, size_t maxInputFrames);
+
+    // Output frames that frames of input can produce at most
+    size_t outputCapacity(size_t frames) const;
+
+    // Writes at most outputCapacity(frames) samples and returns how many.
+    // frames may exceed maxInputFrames; it is then done in pieces.
+    size_t process(const int16_t *input, size_t frames, int16_t *output);
+    void reset();
+
+    int inputRate() const { return bank->inputRate; }
+    int outputRate() const { return bank->outputRate; }
+    int channels() const { return channelCount; }
+    int tapsPerPhase() const { return bank->tapsPerPhase; }
+    // Whether process() is a plain copy (same rate, mono)
+    bool passthrough() const { return bank->up == bank->down && channelCount == 1; }
+
+    static const char *kernelName();
+
+private:
+    size_t processBlock(const int16_t *input, size_t frames, int16_t *output);
+
+    std::shared_ptr<const FilterBank> bank;
+    int channelCount;
+    size_t maxInputFrames;
+    // tapsPerPhase - 1 samples of history, then the current block, as float
+    std::vector<float> window;
+    // Filter output of one block, before rounding
+    std::vector<float> filtered;
+    int phase = 0;
+    // Index in window of the newest input sample of the next output
+    int64_t position;
+};
+
+} // namespace pen
+
+#endif // PEN_RESAMPLER_H
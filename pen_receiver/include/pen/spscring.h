@@ -0,0 +1,96 @@
+#ifndef PEN_SPSCRING_H
+#define PEN_SPSCRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace pen {
+
+// Bounded lock-free ring for exactly one producer thread and one consumer
+// thread. Slots are allocated once; both sides work on them in place:
+//
+//   T *slot = ring.beginWrite();   // nullptr when full
+//   ...fill *slot...
+//   ring.commitWrite();
+//
+//   const T *slot = ring.beginRead(); // nullptr when empty
+//   ...use *slot...
+//   ring.endRead();
+//
+// The indices are free-running 64-bit counters on separate cache lines;
+// each side caches the other's index and only reloads it (acquire) when
+// the ring looks full or empty.
+template <typename T>
+class SpscRing {
+public:
+    // capacity is rounded up to a power of two
+    explicit SpscRing(size_t capacity)
+        : mask(roundUp(capacity) - 1), slots(new T[mask + 1]) {}
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    size_t capacity() const { return mask + 1; }
+
+    // Producer side
+    T *beginWrite() {
+        const uint64_t head = writer.index.load(std::memory_order_relaxed);
+        if (head - writer.cachedOther > mask) {
+            writer.cachedOther = reader.index.load(std::memory_order_acquire);
+            if (head - writer.cachedOther > mask) {
+                return nullptr;
+            }
+        }
+        return &slots[head & mask];
+    }
+
+    void commitWrite() {
+        writer.index.store(writer.index.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Consumer side
+    const T *beginRead() {
+        const uint64_t tail = reader.index.load(std::memory_order_relaxed);
+        if (tail == reader.cachedOther) {
+            reader.cachedOther = writer.index.load(std::memory_order_acquire);
+            if (tail == reader.cachedOther) {
+                return nullptr;
+            }
+        }
+        return &slots[tail & mask];
+    }
+
+    void endRead() {
+        reader.index.store(reader.index.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Approximate; exact only when called from one of the two sides
+    size_t size() const {
+        return size_t(writer.index.load(std::memory_order_acquire) - reader.index.load(std::memory_order_acquire));
+    }
+
+private:
+    static size_t roundUp(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    struct alignas(64) Side {
+        std::atomic<uint64_t> index{0};
+        uint64_t cachedOther = 0; // Owner's copy of the other side's index
+    };
+
+    const size_t mask;
+    std::unique_ptr<T[]> slots;
+    Side writer;
+    Side reader;
+};
+
+} // namespace pen
+
+#endif // PEN_SPSCRING_H
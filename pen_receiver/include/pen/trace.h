@@ -0,0 +1,215 @@
+#ifndef PEN_TRACE_H
+#define PEN_TRACE_H
+
+#include "pen/mappedfile.h"
+#include "pen/pcmframe.h"
+#include "pen/receiver.h"
+#include "pen/transport.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace pen {
+
+// Trace files hold what came in from the pens, as it came in, so that a
+// session from the classroom can be put through the pipeline again.
+//
+// A TraceFileHeader, then records in the order they were written: a
+// TraceRecord and its payload, padded to 8 bytes. Times are microseconds
+// from when the trace was opened; streams are interleaved, and each
+// stream's records are in time order. Native (little-endian) byte order.
+struct TraceFileHeader {
+    static const uint32_t Version = 1;
+
+    char magic[8]; // "PENTRACE"
+    uint32_t version;
+    uint32_t frameMs; // Receiver frame length when recorded
+    int64_t startedUnixMs; // Wall clock, for people reading it
+    uint64_t reserved;
+};
+static_assert(sizeof(TraceFileHeader) == 32, "trace header layout");
+
+struct TraceEvent {
+    enum Code : uint32_t {
+        Connected = 1, // a: sample rate, b: channels
+        Disconnected = 2,
+        Dropped = 3 // a: frames the receiver dropped before the next one (overrun)
+    };
+
+    uint32_t code;
+    uint32_t a;
+    uint32_t b;
+};
+
+struct TraceRecord {
+    enum Type : uint8_t {
+        Frame = 1, // Payload: the frame's PCM
+        Event = 2 // Payload: a TraceEvent
+    };
+    enum Flags : uint8_t {
+        // A stereo frame whose channels were identical, stored once. Pens
+        // have one microphone and usually send it on both channels.
+        Folded = 1
+    };
+
+    uint64_t timeUs; // Of a frame: when the receiver read it off the transport
+    uint32_t length; // Payload bytes, before padding
+    uint16_t stream;
+    uint8_t type;
+    uint8_t flags;
+
+    const unsigned char *payload() const { return reinterpret_cast<const unsigned char *>(this + 1); }
+    TraceEvent event() const {
+        TraceEvent event = {};
+        std::memcpy(&event, payload(), std::min<size_t>(length, sizeof(event)));
+        return event;
+    }
+};
+static_assert(sizeof(TraceRecord) == 16, "trace record layout");
+
+// Writes a trace. Frames and events may come from any thread, e.g. from
+// every hub worker; records go through a large stdio buffer under a short
+// lock. After a crash the trace is good up to the last buffer written.
+class TraceWriter {
+public:
+    struct Stats {
+        std::atomic<uint64_t> frames{0};
+        std::atomic<uint64_t> events{0};
+        std::atomic<uint64_t> bytes{0};
+    };
+
+    TraceWriter(const std::string &path, int frameMs);
+    ~TraceWriter();
+
+    TraceWriter(const TraceWriter &) = delete;
+    TraceWriter &operator=(const TraceWriter &) = delete;
+
+    // Creates the file; trace time starts here
+    bool open(std::string *error);
+    // Flushes and closes. Returns false if anything could not be written.
+    bool close(std::string *error);
+
+    void frame(uint16_t stream, const PcmFrame &frame);
+    void event(uint16_t stream, int64_t timeNs, const TraceEvent &event);
+
+    const std::string &path() const { return filePath; }
+    const Stats &stats() const { return counters; }
+
+private:
+    // Called with the mutex held
+    void write(const TraceRecord &record, const void *payload);
+
+    std::string filePath;
+    int frameMs;
+    int64_t originNs = 0;
+    std::mutex mutex;
+    std::FILE *file = nullptr;
+    bool failed = false; // A write failed; nothing more is written
+    std::vector<int16_t> folded; // One channel of a folded frame
+    Stats counters;
+};
+
+// Records a stream on its way to another sink: connect and disconnect,
+// every frame with its arrival time, and frames the receiver dropped.
+// Frames are written after the next sink has had them, so recording adds
+// nothing to the stream's latency.
+class TraceRecorder : public FrameSink {
+public:
+    TraceRecorder(TraceWriter &writer, uint16_t stream, FrameSink &next);
+
+    bool streamStarted(StreamFormat format, std::string *error) override;
+    void consume(const PcmFrame &frame) override;
+    void endOfStream() override;
+
+private:
+    TraceWriter &writer;
+    uint16_t stream;
+    FrameSink &next;
+    uint64_t nextSequence = 0;
+};
+
+// A trace mapped for reading, with each stream's records indexed. A trace
+// cut short by a crash reads up to its last whole record.
+class TraceReader {
+public:
+    bool open(const std::string &path, std::string *error);
+
+    const TraceFileHeader &header() const { return *reinterpret_cast<const TraceFileHeader *>(file->data()); }
+    const std::string &path() const { return file->path(); }
+    bool truncated() const { return cutShort; }
+
+    std::vector<uint16_t> streams() const;
+    // The stream's records in time order
+    const std::vector<const TraceRecord *> &records(uint16_t stream) const;
+    // Every record, in file order
+    const std::vector<const TraceRecord *> &all() const { return everything; }
+
+    // Audio frames of a stream and their length
+    uint64_t frameCount(uint16_t stream) const;
+    double audioSeconds(uint16_t stream) const;
+
+private:
+    std::unique_ptr<MappedFile> file;
+    std::vector<const TraceRecord *> everything;
+    std::map<uint16_t, std::vector<const TraceRecord *>> byStream;
+    bool cutShort = false;
+};
+
+// Plays one stream of a trace back. With realTime set the pen connects,
+// sends each frame and hangs up at the recorded times, counted from
+// originNs, so jitter and stalls of the link come back as they were;
+// otherwise everything is handed out as fast as it is read. Either way
+// the receiver gets the same frames in the same order.
+class TraceReplayTransport : public Transport {
+public:
+    TraceReplayTransport(const TraceReader &trace, uint16_t stream, bool realTime, int64_t originNs);
+
+    bool open(std::string *error) override;
+    ssize_t read(void *buffer, size_t size) override;
+    void close() override {}
+    void interrupt() override;
+
+    std::string describe() const override;
+    StreamFormat format() const override { return streamFormat; }
+    bool live() const override { return realTime; }
+
+    // Valid once the stream has ended
+    uint64_t droppedWhenRecorded() const { return dropped; }
+    // Time spent handing out frames, without waiting for them to be due
+    int64_t busyNs() const { return busy; }
+
+private:
+    // Returns false when interrupted
+    bool waitUntil(uint64_t timeUs);
+    // Expands the next frame into pending; false at the end of the stream
+    bool nextFrame();
+
+    const TraceReader &trace;
+    const std::vector<const TraceRecord *> &records;
+    uint16_t stream;
+    bool realTime;
+    int64_t originNs;
+    StreamFormat streamFormat;
+    size_t next = 0; // Index in records
+    std::vector<int16_t> pending; // Samples of the current frame
+    size_t pendingAt = 0; // Bytes of it handed out
+    uint64_t dropped = 0;
+    int64_t busy = 0;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool interrupted = false;
+};
+
+} // namespace pen
+
+#endif // PEN_TRACE_H
@@ -0,0 +1,72 @@
+#ifndef PEN_TRANSCRIPTPUBLISHER_H
+#define PEN_TRANSCRIPTPUBLISHER_H
+
+#include "pen/recognizer.h"
+#include "pen/transcriptring.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace pen {
+
+// The daemon's end of the transcript ring. Listens on a UNIX socket and
+// gives the viewer that connects a ring of its own; a newer viewer takes
+// over from an older one. Without a viewer, records go nowhere.
+//
+// publish*() may be called from any thread, e.g. from every hub worker;
+// a run of records is written straight into shared memory under a short
+// lock and costs a system call only when the viewer is asleep on the
+// eventfd, which it does at most once per frame.
+class TranscriptPublisher {
+public:
+    struct Stats {
+        std::atomic<uint64_t> records{0};
+        std::atomic<uint64_t> dropped{0}; // Ring full
+        std::atomic<uint64_t> wakeups{0};
+        std::atomic<uint64_t> viewers{0}; // Connected so far
+    };
+
+    explicit TranscriptPublisher(const std::string &path, uint32_t capacity = 4096);
+    ~TranscriptPublisher();
+
+    bool listen(std::string *error);
+    void close();
+
+    void publishFinal(uint32_t stream, const RecognitionResult &result);
+    // One record per word; an empty hypothesis clears the viewer's.
+    // audioMs is how far into the stream the hypothesis goes.
+    void publishPartial(uint32_t stream, const std::string &text, int64_t audioMs = 0);
+
+    const std::string &path() const { return socketPath; }
+    bool hasViewer() const { return viewerConnected.load(std::memory_order_relaxed); }
+    const Stats &stats() const { return counters; }
+
+private:
+    void serve();
+    bool attach(int connection);
+    void detach();
+    // Called with the mutex held: room for count records, or null
+    TranscriptRecord *reserve(size_t count, uint64_t *head);
+    void commit(uint64_t head);
+
+    std::string socketPath;
+    uint32_t capacity;
+    int listener = -1;
+    int wakePipe[2] = {-1, -1};
+    std::thread server;
+
+    std::mutex mutex; // Guards the ring and the viewer's descriptors
+    int viewer = -1;
+    int eventFd = -1;
+    TranscriptRingHeader *ring = nullptr;
+    std::atomic<bool> viewerConnected{false};
+
+    Stats counters;
+};
+
+} // namespace pen
+
+#endif // PEN_TRANSCRIPTPUBLISHER_H
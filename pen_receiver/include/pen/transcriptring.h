@@ -0,0 +1,236 @@
+#ifndef PEN_TRANSCRIPTRING_H
+#define PEN_TRANSCRIPTRING_H
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Transcript from pen-receiverd to a viewer through shared memory (Linux).
+// The daemon listens on a UNIX socket; a viewer that connects is sent a
+// memfd holding a ring of fixed-size records and an eventfd for wakeups.
+// This header is all a viewer needs; it does not link against pen_core.
+
+namespace pen {
+
+// One word of a final result or of a partial hypothesis. Both come as
+// runs of records, first to last, published all at once.
+struct TranscriptRecord {
+    enum Kind : uint8_t {
+        Final = 0, // Also ends the stream's hypothesis
+        Partial = 1 // Replaces the stream's hypothesis; a run of one empty record clears it
+    };
+    enum Flags : uint8_t {
+        First = 1,
+        Last = 2
+    };
+    static const size_t TextCapacity = 37; // Bytes; longer words are cut at a character boundary
+
+    int64_t startMs;
+    int64_t endMs; // Of a partial: how far into the stream the hypothesis goes
+    float confidence;
+    uint32_t stream;
+    uint8_t kind;
+    uint8_t flags;
+    uint8_t length; // Of text
+    char text[TextCapacity]; // UTF-8, not terminated
+
+    std::string word() const { return std::string(text, std::min<size_t>(length, TextCapacity)); }
+};
+static_assert(sizeof(TranscriptRecord) == 64, "records are one cache line");
+
+// At the start of the shared memory, followed by capacity records at
+// RecordsOffset. head and tail count records and only grow; the producer
+// writes head, the consumer tail and waiting.
+struct TranscriptRingHeader {
+    static const uint32_t Magic = 0x54524e50; // "PNRT"
+    static const uint32_t Version = 1;
+    static const size_t RecordsOffset = 256;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity; // Power of two
+    uint32_t recordSize;
+    alignas(64) std::atomic<uint64_t> head;
+    std::atomic<uint64_t> dropped; // Records that found the ring full
+    alignas(64) std::atomic<uint64_t> tail;
+    // Set by the consumer before it sleeps; the producer clears it and
+    // signals the eventfd, so there is one wakeup per sleep however many
+    // records come in, and none while the consumer is busy anyway
+    std::atomic<uint32_t> waiting;
+
+    TranscriptRecord *records() {
+        return reinterpret_cast<TranscriptRecord *>(reinterpret_cast<char *>(this) + RecordsOffset);
+    }
+    static size_t bytesFor(uint32_t capacity) { return RecordsOffset + size_t(capacity) * sizeof(TranscriptRecord); }
+};
+static_assert(sizeof(TranscriptRingHeader) <= TranscriptRingHeader::RecordsOffset, "header overlaps records");
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "the ring's atomics must work across processes");
+
+// The viewer's end: connects to the daemon, maps the ring it is sent and
+// reads records in place. One thread.
+class TranscriptRingReader {
+public:
+    TranscriptRingReader() = default;
+    TranscriptRingReader(const TranscriptRingReader &) = delete;
+    TranscriptRingReader &operator=(const TranscriptRingReader &) = delete;
+    ~TranscriptRingReader() { close(); }
+
+    bool connect(const std::string &path, std::string *error) {
+        close();
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path)) {
+            return fail(error, "socket path too long: " + path);
+        }
+        std::strcpy(address.sun_path, path.c_str());
+        connectionFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (connectionFd < 0 || ::connect(connectionFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+            return fail(error, path + ": " + std::strerror(errno));
+        }
+
+        // The daemon's hello: magic and version, with the memfd and the
+        // eventfd attached
+        uint32_t hello[2] = {};
+        iovec data = {hello, sizeof(hello)};
+        alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))] = {};
+        msghdr message = {};
+        message.msg_iov = &data;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        ssize_t n;
+        do {
+            n = ::recvmsg(connectionFd, &message, MSG_CMSG_CLOEXEC);
+        } while (n < 0 && errno == EINTR);
+        const cmsghdr *header = CMSG_FIRSTHDR(&message);
+        if (header && header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS
+            && header->cmsg_len == CMSG_LEN(2 * sizeof(int))) {
+            int fds[2];
+            std::memcpy(fds, CMSG_DATA(header), sizeof(fds));
+            memoryFd = fds[0];
+            eventFd = fds[1];
+        }
+        if (n != ssize_t(sizeof(hello)) || hello[0] != TranscriptRingHeader::Magic || memoryFd < 0) {
+            return fail(error, path + ": not a transcript channel");
+        }
+        if (hello[1] != TranscriptRingHeader::Version) {
+            return fail(error, path + ": transcript channel version " + std::to_string(hello[1]));
+        }
+        return map(error);
+    }
+
+    void close() {
+        if (ring) {
+            ::munmap(ring, mappedBytes);
+            ring = nullptr;
+        }
+        for (int *fd : {&connectionFd, &memoryFd, &eventFd}) {
+            if (*fd >= 0) {
+                ::close(*fd);
+                *fd = -1;
+            }
+        }
+    }
+
+    bool isOpen() const { return ring != nullptr; }
+    // Readable when records are there and arm() was called
+    int wakeFd() const { return eventFd; }
+    // Readable (at end of file) once the daemon is gone
+    int socketFd() const { return connectionFd; }
+
+    // Calls visit(const TranscriptRecord &) for every record published so
+    // far, in order. The record is in shared memory and only valid during
+    // the call. Returns the number of records.
+    template <typename Visit>
+    size_t drain(Visit visit) {
+        if (!ring) {
+            return 0;
+        }
+        const uint64_t head = ring->head.load(std::memory_order_acquire);
+        const uint64_t capacity = ring->capacity;
+        const uint64_t mask = capacity - 1;
+        uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+        // Never more than a ring's worth, whatever the other side wrote
+        if (tail > head || head - tail > capacity) {
+            tail = head > capacity ? head - capacity : 0;
+        }
+        TranscriptRecord *records = ring->records();
+        for (uint64_t i = tail; i != head; ++i) {
+            visit(static_cast<const TranscriptRecord &>(records[i & mask]));
+        }
+        ring->tail.store(head, std::memory_order_release);
+        return size_t(head - tail);
+    }
+
+    // Clears the eventfd after a wakeup
+    void acknowledge() {
+        uint64_t count;
+        [[maybe_unused]] const ssize_t n = ::read(eventFd, &count, sizeof(count));
+    }
+
+    // Asks for a wakeup at the next record. Returns false if records came
+    // in since the last drain(); drain again instead of waiting then.
+    bool arm() {
+        if (!ring) {
+            return false;
+        }
+        ring->waiting.store(1, std::memory_order_relaxed);
+        // Pairs with the fence in the producer: either it sees waiting or
+        // this sees its head
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return ring->head.load(std::memory_order_relaxed) == ring->tail.load(std::memory_order_relaxed);
+    }
+
+    uint64_t dropped() const { return ring ? ring->dropped.load(std::memory_order_relaxed) : 0; }
+
+private:
+    bool fail(std::string *error, const std::string &message) {
+        if (error) {
+            *error = message;
+        }
+        close();
+        return false;
+    }
+
+    // Everything in the header is checked before it is trusted; the daemon
+    // seals the memfd, so the size cannot change after the fstat()
+    bool map(std::string *error) {
+        struct stat status;
+        if (::fstat(memoryFd, &status) != 0 || size_t(status.st_size) < TranscriptRingHeader::RecordsOffset) {
+            return fail(error, "transcript ring too small");
+        }
+        mappedBytes = size_t(status.st_size);
+        void *memory = ::mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED, memoryFd, 0);
+        if (memory == MAP_FAILED) {
+            return fail(error, std::string("mmap: ") + std::strerror(errno));
+        }
+        ring = static_cast<TranscriptRingHeader *>(memory);
+        const uint32_t capacity = ring->capacity;
+        if (ring->magic != TranscriptRingHeader::Magic || ring->recordSize != sizeof(TranscriptRecord)
+            || capacity == 0 || (capacity & (capacity - 1)) != 0
+            || TranscriptRingHeader::bytesFor(capacity) > mappedBytes) {
+            return fail(error, "transcript ring has an unknown layout");
+        }
+        return true;
+    }
+
+    int connectionFd = -1;
+    int memoryFd = -1;
+    int eventFd = -1;
+    TranscriptRingHeader *ring = nullptr;
+    size_t mappedBytes = 0;
+};
+
+} // namespace pen
+
+#endif // PEN_TRANSCRIPTRING_H
@@ -0,0 +1,108 @@
+#ifndef PEN_TRANSPORT_H
+#define PEN_TRANSPORT_H
+
+#include "pen/pcmframe.h"
+
+#include <cstddef>
+#include <string>
+#include <sys/types.h>
+
+namespace pen {
+
+// Where a pen's PCM comes from. On the hub that is the Bluetooth A2DP sink
+// (e.g. bluealsa piping into stdin); for tests and benchmarks a UNIX
+// socket or a recorded file stands in for the radio link.
+class Transport {
+public:
+    virtual ~Transport() = default;
+
+    // Blocks until a peer is there (sockets) or the source is open
+    virtual bool open(std::string *error) = 0;
+    // Reads up to size bytes, blocking until size bytes are there or the
+    // stream ends. Returns the bytes read, 0 at the end, -1 on error or
+    // after interrupt().
+    virtual ssize_t read(void *buffer, size_t size) = 0;
+    virtual void close() = 0;
+    // Wakes a blocked open() or read(); safe from any thread
+    virtual void interrupt() = 0;
+
+    virtual std::string describe() const = 0;
+    virtual StreamFormat format() const = 0;
+    // Whether data keeps coming whether or not it is read, like a radio
+    // link. A receiver drops frames it has no room for from a live source
+    // and waits for room otherwise.
+    virtual bool live() const { return true; }
+};
+
+// Base for transports that read a file descriptor. Reads wait in poll()
+// together with a wake-up pipe, so interrupt() never has to close a
+// descriptor another thread is blocked on.
+class FdTransport : public Transport {
+public:
+    explicit FdTransport(StreamFormat format);
+    ~FdTransport() override;
+
+    ssize_t read(void *buffer, size_t size) override;
+    void close() override;
+    void interrupt() override;
+    StreamFormat format() const override { return streamFormat; }
+
+protected:
+    // Waits until fd is readable or interrupt() is called
+    bool waitReadable(int fd);
+
+    int fd = -1;
+    int wakePipe[2] = {-1, -1};
+    StreamFormat streamFormat;
+};
+
+// Accepts a single connection on a UNIX stream socket and reads raw PCM
+// from it: socat, the test driver or a Bluetooth bridge can connect.
+class UnixSocketTransport : public FdTransport {
+public:
+    UnixSocketTransport(const std::string &path, StreamFormat format);
+    ~UnixSocketTransport() override;
+
+    bool open(std::string *error) override;
+    std::string describe() const override { return "unix:" + path; }
+
+private:
+    std::string path;
+    int listener = -1;
+};
+
+// Raw PCM on standard input
+class StdinTransport : public FdTransport {
+public:
+    explicit StdinTransport(StreamFormat format) : FdTransport(format) {}
+
+    bool open(std::string *error) override;
+    void close() override { fd = -1; } // Not ours to close
+    std::string describe() const override { return "stdin"; }
+};
+
+// Replays a recording: raw PCM, or a PCM WAV file whose header overrides
+// the format. With realTime set the data is handed out no faster than
+// the pen would have sent it; otherwise as fast as it is read.
+class FileReplayTransport : public FdTransport {
+public:
+    FileReplayTransport(const std::string &path, StreamFormat format, bool realTime);
+
+    bool open(std::string *error) override;
+    ssize_t read(void *buffer, size_t size) override;
+    std::string describe() const override { return "file:" + path; }
+    bool live() const override { return realTime; }
+
+private:
+    bool readWavHeader(std::string *error);
+
+    std::string path;
+    bool realTime;
+    int64_t startNs = 0;
+    uint64_t bytesRead = 0;
+    uint64_t dataBytes = 0; // 0: up to end of file
+};
+
+} // namespace pen
+
+#endif // PEN_TRANSPORT_H
@@ -0,0 +1,112 @@
+#ifndef PEN_VAD_H
+#define PEN_VAD_H
+
+#include "pen/recognizer.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace pen {
+
+// Energy plus zero-crossing voice activity detection on blocks of mono
+// PCM (one receiver frame, 10-30 ms, per call).
+//
+// A block is speech when it is louder than the tracked noise floor by a
+// margin and than an absolute minimum, and crosses zero less often than
+// broadband noise (fans, rustling) does. Speech is held for a hangover
+// after the last speech block so that word endings and short pauses pass.
+class VoiceActivityDetector {
+public:
+    struct Options {
+        int sampleRate = 16000;
+        double marginDb = 9;
+        double minimumDb = -55; // dBFS
+        double maxCrossingRate = 0.35; // Per sample; white noise is about 0.5
+        int hangoverMs = 300;
+        double floorRiseDbPerSecond = 3;
+    };
+
+    explicit VoiceActivityDetector(Options options);
+
+    // True for speech and hangover blocks
+    bool process(const int16_t *samples, size_t count);
+
+    bool inSpeech() const { return hangoverLeft > 0; }
+    double noiseFloorDb() const { return floorDb; }
+
+    // Which SIMD kernels compute the block features on this machine
+    static const char *kernelName();
+
+private:
+    Options options;
+    double floorDb;
+    int64_t hangoverLeft = 0; // Samples
+};
+
+// Puts a VoiceActivityDetector in front of another recognizer: blocks that
+// are not speech are dropped (or, with keepOneIn, all but one in N), so
+// the recognizer only spends time on speech. The end of a hangover ends
+// the recognizer's utterance, as its own endpointing would.
+//
+// Word times are mapped back from the shortened audio the recognizer saw
+// to the time in the stream.
+class GatedRecognizer : public Recognizer {
+public:
+    struct Options {
+        VoiceActivityDetector::Options vad;
+        int keepOneIn = 0; // 0: drop every gated block
+    };
+
+    // Readable from any thread
+    struct Stats {
+        std::atomic<uint64_t> blocksPassed{0};
+        std::atomic<uint64_t> blocksGated{0};
+        std::atomic<uint64_t> blocksDecimated{0}; // Gated, but passed by keepOneIn
+        std::atomic<uint64_t> samplesPassed{0};
+        std::atomic<uint64_t> samplesGated{0};
+    };
+
+    GatedRecognizer(std::unique_ptr<Recognizer> recognizer, Options gateOptions);
+
+    int sampleRate() const override { return inner->sampleRate(); }
+    bool acceptPcm(const int16_t *samples, size_t count) override;
+    std::string partial() override { return inner->partial(); }
+    bool takeFinal(RecognitionResult *result) override;
+    bool finish() override { return inner->finish(); }
+    void reset() override;
+    std::string name() const override { return "vad+" + inner->name(); }
+
+    // Hands back the wrapped recognizer, e.g. to a RecognizerPool; the gate
+    // is unusable afterwards
+    std::unique_ptr<Recognizer> releaseInner() { return std::move(inner); }
+
+    const Stats &stats() const { return counters; }
+    // Share of the stream's samples that did not reach the recognizer
+    double gatedFraction() const;
+
+private:
+    // Where a run of passed audio starts, in recognizer and stream samples
+    struct Segment {
+        uint64_t fed;
+        uint64_t stream;
+    };
+
+    int64_t toStreamMs(int64_t fedMs) const;
+
+    std::unique_ptr<Recognizer> inner;
+    Options options;
+    VoiceActivityDetector detector;
+    Stats counters;
+
+    uint64_t fedSamples = 0;
+    uint64_t streamSamples = 0;
+    uint64_t gatedRun = 0;
+    bool passing = false;  // Last block went to the recognizer
+    bool speaking = false; // Last block was speech or hangover
+    std::vector<Segment> segments;
+};
+
+} // namespace pen
+
+#endif // PEN_VAD_H
@@ -0,0 +1,67 @@
+#ifndef PEN_VOSKENGINE_H
+#define PEN_VOSKENGINE_H
+
+#include "pen/recognizer.h"
+
+#include <memory>
+
+struct VoskModel;
+struct VoskRecognizer;
+
+namespace pen {
+
+class VoskSharedModel;
+
+// Recognizer backed by the VOSK (Kaldi) API. Only built when the VOSK
+// library is found; see PEN_HAVE_VOSK.
+class VoskEngine : public Recognizer {
+public:
+    ~VoskEngine() override;
+
+    int sampleRate() const override { return rate; }
+    bool acceptPcm(const int16_t *samples, size_t count) override;
+    std::string partial() override;
+    bool takeFinal(RecognitionResult *result) override;
+    bool finish() override;
+    void reset() override;
+    std::string name() const override { return "vosk"; }
+
+private:
+    friend class VoskSharedModel;
+    VoskEngine(std::shared_ptr<const VoskSharedModel> model, VoskRecognizer *recognizer, int sampleRate);
+
+    bool completeWith(const char *json);
+
+    std::shared_ptr<const VoskSharedModel> model; // Outlives the recognizer
+    VoskRecognizer *recognizer;
+    int rate;
+    RecognitionResult completed;
+    bool hasCompleted = false;
+};
+
+// A loaded model directory. VOSK models are thread-safe and reference
+// counted; Kaldi reads them into its own memory rather than mapping them,
+// so sharing means loading once per process and giving every session the
+// same one.
+class VoskSharedModel : public RecognizerModel, public std::enable_shared_from_this<VoskSharedModel> {
+public:
+    ~VoskSharedModel() override;
+
+    // sampleRate is that of the input, which VOSK resamples to the model's
+    // rate itself
+    static std::shared_ptr<VoskSharedModel> load(const std::string &modelPath, int sampleRate, std::string *error);
+
+    std::unique_ptr<Recognizer> createSession(std::string *error) override;
+    int sampleRate() const override { return rate; }
+    std::string name() const override { return "vosk"; }
+
+private:
+    VoskSharedModel(VoskModel *model, int sampleRate);
+
+    VoskModel *model;
+    int rate;
+};
+
+} // namespace pen
+
+#endif // PEN_VOSKENGINE_H
@@ -0,0 +1,214 @@
+#include "pen/fakerecognizer.h"
+
+#include "pen/clock.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+namespace pen {
+
+namespace {
+
+const char *const Lecture[] = {
+    "today", "we", "look", "at", "how", "plants", "turn", "light", "into", "chemical", "energy",
+    "photosynthesis", "happens", "in", "the", "chloroplasts", "and", "needs", "water", "carbon",
+    "dioxide", "and", "sunlight", "the", "glucose", "it", "makes", "is", "stored", "as", "starch",
+};
+
+// Confidence that varies from word to word but is the same on every run
+float confidenceFor(uint64_t word) {
+    return 0.6f + float((word * 2654435761u >> 8) % 40) / 100.0f;
+}
+
+// Spins for ms, as loading would
+void spin(int ms) {
+    const int64_t until = nowNs() + int64_t(ms) * 1000000;
+    volatile uint32_t state = 1;
+    while (nowNs() < until) {
+        for (int i = 0; i < 256; ++i) {
+            state = state * 1664525u + 1013904223u;
+        }
+    }
+}
+
+} // namespace
+
+FakeModel::FakeModel(FakeRecognizer::Options options) : modelOptions(std::move(options)) {
+    if (modelOptions.script.empty()) {
+        modelOptions.script.assign(std::begin(Lecture), std::end(Lecture));
+    }
+}
+
+std::shared_ptr<FakeModel> FakeModel::load(FakeRecognizer::Options options, std::string *error) {
+    std::shared_ptr<FakeModel> model(new FakeModel(std::move(options)));
+    if (!model->modelOptions.modelPath.empty()) {
+        model->mappedWeights = MappedFile::open(model->modelOptions.modelPath, error);
+        if (!model->mappedWeights) {
+            return nullptr;
+        }
+        model->mappedWeights->prefetch();
+    }
+    spin(model->modelOptions.loadMs);
+    return model;
+}
+
+std::unique_ptr<Recognizer> FakeModel::createSession(std::string *) {
+    spin(modelOptions.sessionMs);
+    return std::unique_ptr<Recognizer>(new FakeRecognizer(shared_from_this()));
+}
+
+FakeRecognizer::FakeRecognizer(std::shared_ptr<const FakeModel> model)
+    : model(std::move(model)), options(this->model->options()) {
+    current.reserve(size_t(options.wordsPerUtterance));
+}
+
+bool FakeRecognizer::acceptPcm(const int16_t *samples, size_t count) {
+    burn(count);
+    readWeights(count);
+    for (size_t i = 0; i < count; ++i) {
+        checksum = checksum * 31 + uint16_t(samples[i]);
+    }
+
+    const uint64_t samplesPerWord = uint64_t(options.sampleRate) * options.wordMs / 1000;
+    samplesSeen += count;
+    bool closed = false;
+    // A word is "heard" once all of its audio is in
+    while ((wordsEmitted + 1) * samplesPerWord <= samplesSeen) {
+        const int64_t start = int64_t(wordsEmitted * options.wordMs);
+        current.push_back({options.script[wordsEmitted % options.script.size()], start, start + options.wordMs * 4 / 5,
+                           confidenceFor(wordsEmitted)});
+        ++wordsEmitted;
+        if (int(current.size()) >= options.wordsPerUtterance) {
+            closeUtterance();
+            closed = true;
+        }
+    }
+    return closed;
+}
+
+std::string FakeRecognizer::partial() {
+    std::string text;
+    for (const RecognizedWord &word : current) {
+        if (!text.empty()) {
+            text += ' ';
+        }
+        text += word.text;
+    }
+    return text;
+}
+
+bool FakeRecognizer::takeFinal(RecognitionResult *result) {
+    if (!hasCompleted) {
+        return false;
+    }
+    result->words.swap(completed.words);
+    completed.words.clear();
+    hasCompleted = false;
+    return true;
+}
+
+bool FakeRecognizer::finish() {
+    if (current.empty()) {
+        return false;
+    }
+    closeUtterance();
+    return true;
+}
+
+void FakeRecognizer::reset() {
+    samplesSeen = 0;
+    wordsEmitted = 0;
+    current.clear();
+    completed.words.clear();
+    hasCompleted = false;
+}
+
+void FakeRecognizer::closeUtterance() {
+    // An unread result is merged into, not lost
+    completed.words.insert(completed.words.end(), current.begin(), current.end());
+    current.clear();
+    hasCompleted = true;
+}
+
+// One cache line of the weights per sample, round and round the file
+void FakeRecognizer::readWeights(size_t count) {
+    const MappedFile *weights = model->weights();
+    if (!weights || weights->size() == 0) {
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        checksum += weights->data()[weightsAt];
+        weightsAt += 64;
+        if (weightsAt >= weights->size()) {
+            weightsAt = 0;
+        }
+    }
+}
+
+// Spins for computeFactor times the duration of count samples
+void FakeRecognizer::burn(size_t count) {
+    if (options.computeFactor <= 0) {
+        return;
+    }
+    const int64_t budgetNs = int64_t(double(count) * 1e9 / options.sampleRate * options.computeFactor);
+    const int64_t until = nowNs() + budgetNs;
+    while (nowNs() < until) {
+        for (int i = 0; i < 256; ++i) {
+            checksum = checksum * 1664525u + 1013904223u;
+        }
+    }
+}
+
+bool FakeRecognizer::parseSpec(const std::string &spec, Options *options, std::string *error) {
+    if (spec.compare(0, 4, "fake") != 0 || (spec.size() > 4 && spec[4] != ':')) {
+        *error = "not a fake engine: " + spec;
+        return false;
+    }
+    std::istringstream fields(spec.size() > 5 ? spec.substr(5) : std::string());
+    std::string field;
+    while (std::getline(fields, field, ',')) {
+        const size_t equals = field.find('=');
+        const std::string key = field.substr(0, equals);
+        const std::string value = equals == std::string::npos ? std::string() : field.substr(equals + 1);
+        if (key == "rate") {
+            options->sampleRate = std::atoi(value.c_str());
+        } else if (key == "word-ms") {
+            options->wordMs = std::atoi(value.c_str());
+        } else if (key == "utterance") {
+            options->wordsPerUtterance = std::atoi(value.c_str());
+        } else if (key == "cost") {
+            options->computeFactor = std::atof(value.c_str());
+        } else if (key == "load") {
+            options->loadMs = std::atoi(value.c_str());
+        } else if (key == "session") {
+            options->sessionMs = std::atoi(value.c_str());
+        } else if (key == "model") {
+            options->modelPath = value;
+        } else if (key == "script") {
+            std::ifstream file(value);
+            if (!file) {
+                *error = "cannot read script " + value;
+                return false;
+            }
+            options->script.assign(std::istream_iterator<std::string>(file), std::istream_iterator<std::string>());
+        } else {
+            *error = "unknown fake engine option: " + key;
+            return false;
+        }
+    }
+    if (options->sampleRate <= 0 || options->wordMs <= 0 || options->wordsPerUtterance <= 0
+        || options->computeFactor < 0 || options->loadMs < 0 || options->sessionMs < 0) {
+        *error = "bad fake engine options: " + spec;
+        return false;
+    }
+    // acceptPcm() needs at least one sample per word
+    if (uint64_t(options->sampleRate) * uint64_t(options->wordMs) < 1000) {
+        *error = "fake engine words shorter than one sample: " + spec;
+        return false;
+    }
+    return true;
+}
+
+} // namespace pen
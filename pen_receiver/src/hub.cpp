@@ -0,0 +1,188 @@
+#include "pen/hub.h"
+
+#include "pen/clock.h"
+
+#include <chrono>
+
+namespace pen {
+
+namespace {
+
+// Empty polls of all deques before a worker sleeps
+const int SpinRounds = 32;
+
+} // namespace
+
+Hub::Hub(Options options) : options(options) {
+    const int count = options.workers > 0 ? options.workers : 1;
+    // All workers exist before any runs, so stealing never sees a partial list
+    for (int i = 0; i < count; ++i) {
+        workers.emplace_back(new Worker);
+    }
+    for (int i = 0; i < count; ++i) {
+        workers[size_t(i)]->thread = std::thread(&Hub::work, this, i);
+    }
+}
+
+Hub::~Hub() {
+    for (const std::unique_ptr<Stream> &stream : streams) {
+        stream->receiver->stop();
+        stream->receiver->wait();
+    }
+    shutdown();
+}
+
+Receiver &Hub::addStream(Transport &transport, FrameSink &sink, Receiver::Options receiverOptions) {
+    const int id = int(streams.size());
+    receiverOptions.frameQueued = [this, id] { schedule(id); };
+    std::unique_ptr<Stream> stream(new Stream);
+    stream->receiver.reset(new Receiver(transport, sink, receiverOptions));
+    // Spread new streams over the workers until they have run somewhere
+    stream->home.store(id % int(workers.size()));
+    streams.push_back(std::move(stream));
+    return *streams.back()->receiver;
+}
+
+void Hub::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping.store(true);
+    }
+    wakeUp.notify_all();
+    for (const std::unique_ptr<Worker> &worker : workers) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+// Called on a stream's receive thread
+void Hub::schedule(int id) {
+    Stream &stream = *streams[size_t(id)];
+    // Pairs with the fence in run(): either this sees the stream idle, or
+    // the worker finishing it sees the frame just queued
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (stream.scheduled.exchange(true)) {
+        return;
+    }
+    push(stream.home.load(std::memory_order_relaxed), id);
+}
+
+void Hub::push(int worker, int stream) {
+    {
+        std::lock_guard<std::mutex> lock(workers[size_t(worker)]->mutex);
+        workers[size_t(worker)]->runnable.push_back(stream);
+    }
+    queuedStreams.fetch_add(1);
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    if (sleepers > 0) {
+        wakeUp.notify_one();
+    }
+}
+
+bool Hub::take(int worker, int *stream) {
+    Worker &self = *workers[size_t(worker)];
+    std::lock_guard<std::mutex> lock(self.mutex);
+    if (self.runnable.empty()) {
+        return false;
+    }
+    *stream = self.runnable.front();
+    self.runnable.pop_front();
+    return true;
+}
+
+// Takes the most recently queued stream of the first other worker with
+// backlog, starting with the next one so that thieves spread out
+bool Hub::steal(int worker, int *stream) {
+    const int count = int(workers.size());
+    for (int i = 1; i < count; ++i) {
+        Worker &victim = *workers[size_t((worker + i) % count)];
+        std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+        if (!lock.owns_lock() || victim.runnable.size() <= backlogOf(victim)) {
+            continue;
+        }
+        *stream = victim.runnable.back();
+        victim.runnable.pop_back();
+        return true;
+    }
+    return false;
+}
+
+// Whether steal() would find anything, waiting for the locks instead
+bool Hub::canSteal(int worker) {
+    const int count = int(workers.size());
+    for (int i = 1; i < count; ++i) {
+        Worker &victim = *workers[size_t((worker + i) % count)];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.runnable.size() > backlogOf(victim)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Hub::run(int worker, int id) {
+    Stream &stream = *streams[size_t(id)];
+    WorkerStats &stats = workers[size_t(worker)]->stats;
+    stream.home.store(worker, std::memory_order_relaxed);
+
+    const int64_t start = nowNs();
+    stream.receiver->drain(options.batchFrames);
+    stats.busyNs.fetch_add(nowNs() - start, std::memory_order_relaxed);
+    stats.turns.fetch_add(1, std::memory_order_relaxed);
+
+    stream.scheduled.store(false);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    // Frames left over from the batch, or queued while this turn ran; to
+    // the back of this worker's deque so other streams get their turn
+    if (stream.receiver->pending() && !stream.scheduled.exchange(true)) {
+        push(worker, id);
+    }
+}
+
+void Hub::work(int worker) {
+    int idleRounds = 0;
+    for (;;) {
+        int stream;
+        const bool own = take(worker, &stream);
+        if (own || steal(worker, &stream)) {
+            queuedStreams.fetch_sub(1);
+            if (!own) {
+                workers[size_t(worker)]->stats.steals.fetch_add(1, std::memory_order_relaxed);
+            }
+            run(worker, stream);
+            idleRounds = 0;
+            continue;
+        }
+        if (++idleRounds < SpinRounds) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        if (stopping.load() && queuedStreams.load() == 0) {
+            return;
+        }
+        ++sleepers;
+        Worker &self = *workers[size_t(worker)];
+        self.asleep.store(true, std::memory_order_relaxed);
+        // Own work may have arrived since take(). Streams queued behind a
+        // busy owner are its own to run, so only stealable work wakes us;
+        // waking for any queued stream would spin while one waits there.
+        // The timeout covers a steal that lost its try_lock race.
+        wakeUp.wait_for(lock, std::chrono::milliseconds(2), [&] {
+            {
+                std::lock_guard<std::mutex> own(self.mutex);
+                if (!self.runnable.empty()) {
+                    return true;
+                }
+            }
+            return (stopping.load() && queuedStreams.load() == 0) || canSteal(worker);
+        });
+        self.asleep.store(false, std::memory_order_relaxed);
+        --sleepers;
+        idleRounds = 0;
+    }
+}
+
+} // namespace pen
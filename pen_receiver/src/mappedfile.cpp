@@ -0,0 +1,50 @@
+#include "pen/mappedfile.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pen {
+
+MappedFile::MappedFile(std::string path, const unsigned char *bytes, size_t length)
+    : filePath(std::move(path)), bytes(bytes), length(length) {}
+
+MappedFile::~MappedFile() {
+    if (length > 0) {
+        ::munmap(const_cast<unsigned char *>(bytes), length);
+    }
+}
+
+std::unique_ptr<MappedFile> MappedFile::open(const std::string &path, std::string *error) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat status;
+    if (fd < 0 || ::fstat(fd, &status) != 0) {
+        *error = path + ": " + std::strerror(errno);
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return nullptr;
+    }
+    const size_t length = size_t(status.st_size);
+    void *memory = nullptr;
+    if (length > 0) {
+        memory = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd); // The mapping keeps the file
+    if (memory == MAP_FAILED) {
+        *error = path + ": mmap: " + std::strerror(errno);
+        return nullptr;
+    }
+    return std::unique_ptr<MappedFile>(new MappedFile(path, static_cast<const unsigned char *>(memory), length));
+}
+
+void MappedFile::prefetch() const {
+    if (length > 0) {
+        ::madvise(const_cast<unsigned char *>(bytes), length, MADV_WILLNEED);
+    }
+}
+
+} // namespace pen
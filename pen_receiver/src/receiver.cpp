@@ -0,0 +1,185 @@
+#include "pen/receiver.h"
+
+#include "pen/clock.h"
+#include "pen/transport.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace pen {
+
+namespace {
+
+// Decode thread back-off while the ring is empty: spin briefly, then
+// sleep in steps well under a frame period
+const int SpinPolls = 64;
+const auto IdleSleep = std::chrono::microseconds(500);
+
+} // namespace
+
+Receiver::Receiver(Transport &transport, FrameSink &sink, Options options)
+    : transport(transport), sink(sink), options(options), ring(options.ringFrames) {}
+
+Receiver::~Receiver() {
+    stop();
+    wait();
+}
+
+bool Receiver::start(std::string *error) {
+    if (!transport.open(error)) {
+        return false;
+    }
+    // Only now: a WAV header may have set the format
+    const StreamFormat format = transport.format();
+    const uint32_t frameBytes = format.bytesPerFrame(options.frameMs);
+    if (frameBytes == 0 || frameBytes > sizeof(PcmFrame::samples)) {
+        if (error) {
+            *error = "frame of " + std::to_string(options.frameMs) + " ms does not fit a ring slot";
+        }
+        transport.close();
+        return false;
+    }
+    if (!sink.streamStarted(format, error)) {
+        transport.close();
+        return false;
+    }
+    producerDone.store(false);
+    finished.store(false, std::memory_order_release);
+    producer = std::thread(&Receiver::receive, this);
+    if (!options.frameQueued) {
+        consumer = std::thread(&Receiver::decode, this);
+    }
+    return true;
+}
+
+void Receiver::stop() {
+    transport.interrupt();
+}
+
+void Receiver::wait() {
+    if (producer.joinable()) {
+        producer.join();
+    }
+    if (consumer.joinable()) {
+        consumer.join();
+    }
+}
+
+void Receiver::receive() {
+    const StreamFormat format = transport.format();
+    const uint32_t frameBytes = format.bytesPerFrame(options.frameMs);
+    const int64_t periodNs = int64_t(options.frameMs) * 1000000;
+    const bool live = transport.live();
+    int64_t dueNs = 0;
+
+    for (uint64_t sequence = 0;; ++sequence) {
+        PcmFrame *slot = ring.beginWrite();
+        // A recording can wait for the decoder; nothing is lost meanwhile
+        while (!slot && !live) {
+            std::this_thread::sleep_for(IdleSleep);
+            slot = ring.beginWrite();
+        }
+        const bool overrun = slot == nullptr;
+        if (overrun) {
+            slot = &scratch;
+        }
+
+        const ssize_t n = transport.read(slot->samples, frameBytes);
+        if (n <= 0) {
+            break;
+        }
+        const int64_t now = nowNs();
+        slot->sequence = sequence;
+        slot->arrivalNs = now;
+        slot->sampleRate = format.sampleRate;
+        slot->channels = format.channels;
+        slot->frames = uint16_t(size_t(n) / (2 * format.channels));
+
+        counters.framesReceived.fetch_add(1, std::memory_order_relaxed);
+        counters.bytesReceived.fetch_add(uint64_t(n), std::memory_order_relaxed);
+        // Frames from a live source are due one period apart from the first
+        // one; a late frame means the decoder went without input, and the
+        // schedule restarts
+        if (live && dueNs != 0 && now > dueNs + periodNs) {
+            counters.underruns.fetch_add(1, std::memory_order_relaxed);
+            dueNs = now;
+        } else if (dueNs == 0) {
+            dueNs = now;
+        }
+        dueNs += periodNs;
+
+        if (overrun) {
+            counters.overruns.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            ring.commitWrite();
+            const uint64_t depth = ring.size();
+            if (depth > counters.maxQueued.load(std::memory_order_relaxed)) {
+                counters.maxQueued.store(depth, std::memory_order_relaxed);
+            }
+            if (options.frameQueued) {
+                options.frameQueued();
+            }
+        }
+        if (size_t(n) < frameBytes) {
+            break; // Short read: the stream ended mid-frame
+        }
+    }
+    transport.close();
+    producerDone.store(true, std::memory_order_release);
+    if (options.frameQueued) {
+        options.frameQueued();
+    }
+}
+
+void Receiver::decode() {
+    int idle = 0;
+    for (;;) {
+        const PcmFrame *frame = ring.beginRead();
+        if (frame) {
+            sink.consume(*frame);
+            ring.endRead();
+            counters.framesDecoded.fetch_add(1, std::memory_order_relaxed);
+            idle = 0;
+            continue;
+        }
+        // Checked after an empty read, so frames committed before the flag
+        // are still drained
+        if (producerDone.load(std::memory_order_acquire) && !ring.beginRead()) {
+            break;
+        }
+        if (++idle < SpinPolls) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(IdleSleep);
+        }
+    }
+    finish();
+}
+
+size_t Receiver::drain(size_t maxFrames) {
+    size_t consumed = 0;
+    for (; consumed < maxFrames; ++consumed) {
+        const PcmFrame *frame = ring.beginRead();
+        if (!frame) {
+            break;
+        }
+        sink.consume(*frame);
+        ring.endRead();
+        counters.framesDecoded.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (consumed < maxFrames && running() && producerDone.load(std::memory_order_acquire) && !ring.beginRead()) {
+        finish();
+    }
+    return consumed;
+}
+
+bool Receiver::pending() const {
+    return ring.size() > 0 || (running() && producerDone.load(std::memory_order_acquire));
+}
+
+void Receiver::finish() {
+    sink.endOfStream();
+    finished.store(true, std::memory_order_release);
+}
+
+} // namespace pen
@@ -0,0 +1,67 @@
+#include "pen/recognizer.h"
+
+#include "pen/fakerecognizer.h"
+#ifdef PEN_HAVE_VOSK
+#include "pen/voskengine.h"
+#endif
+
+#include <map>
+#include <mutex>
+
+namespace pen {
+
+std::string RecognitionResult::text() const {
+    std::string joined;
+    for (const RecognizedWord &word : words) {
+        if (!joined.empty()) {
+            joined += ' ';
+        }
+        joined += word.text;
+    }
+    return joined;
+}
+
+namespace {
+
+std::shared_ptr<RecognizerModel> load(const std::string &spec, int sampleRate, std::string *error) {
+    if (spec.compare(0, 4, "fake") == 0) {
+        FakeRecognizer::Options options;
+        options.sampleRate = sampleRate;
+        if (!FakeRecognizer::parseSpec(spec, &options, error)) {
+            return nullptr;
+        }
+        return FakeModel::load(std::move(options), error);
+    }
+    if (spec.compare(0, 5, "vosk:") == 0) {
+#ifdef PEN_HAVE_VOSK
+        return VoskSharedModel::load(spec.substr(5), sampleRate, error);
+#else
+        *error = "built without VOSK";
+        return nullptr;
+#endif
+    }
+    *error = "unknown engine: " + spec;
+    return nullptr;
+}
+
+} // namespace
+
+std::shared_ptr<RecognizerModel> loadModel(const std::string &spec, int sampleRate, std::string *error) {
+    static std::mutex mutex;
+    static std::map<std::pair<std::string, int>, std::shared_ptr<RecognizerModel>> models;
+    // Held while loading, so that streams connecting together wait for one
+    // load instead of each doing their own
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<RecognizerModel> &model = models[std::make_pair(spec, sampleRate)];
+    if (!model) {
+        model = load(spec, sampleRate, error);
+    }
+    return model;
+}
+
+std::unique_ptr<Recognizer> createRecognizer(const std::string &spec, int sampleRate, std::string *error) {
+    const std::shared_ptr<RecognizerModel> model = loadModel(spec, sampleRate, error);
+    return model ? model->createSession(error) : nullptr;
+}
+
+} // namespace pen
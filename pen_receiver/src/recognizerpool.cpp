@@ -0,0 +1,115 @@
+#include "pen/recognizerpool.h"
+
+#include "pen/clock.h"
+
+#include <algorithm>
+
+namespace pen {
+
+namespace {
+
+// Fed to a new session before it is handed out
+const int WarmUpMs = 200;
+
+} // namespace
+
+RecognizerPool::RecognizerPool(std::shared_ptr<RecognizerModel> model, Options options)
+    : recognizerModel(std::move(model)), options(options) {
+    sessions.reserve(size_t(std::max(0, options.warm) + std::max(0, options.maxIdle)));
+    if (options.warm > 0) {
+        filler = std::thread(&RecognizerPool::fill, this);
+    }
+}
+
+RecognizerPool::~RecognizerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    if (filler.joinable()) {
+        filler.join();
+    }
+}
+
+std::unique_ptr<Recognizer> RecognizerPool::createWarm(std::string *error) {
+    const int64_t start = nowNs();
+    std::unique_ptr<Recognizer> session = recognizerModel->createSession(error);
+    if (session) {
+        const std::vector<int16_t> silence(size_t(session->sampleRate()) * WarmUpMs / 1000, 0);
+        session->acceptPcm(silence.data(), silence.size());
+        session->partial();
+        session->reset();
+        counters.created.fetch_add(1, std::memory_order_relaxed);
+        counters.createNs.fetch_add(nowNs() - start, std::memory_order_relaxed);
+    }
+    return session;
+}
+
+std::unique_ptr<Recognizer> RecognizerPool::acquire(std::string *error) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!sessions.empty()) {
+            std::unique_ptr<Recognizer> session = std::move(sessions.back());
+            sessions.pop_back();
+            counters.hits.fetch_add(1, std::memory_order_relaxed);
+            changed.notify_all(); // Below warm now; the filler tops up
+            return session;
+        }
+    }
+    counters.misses.fetch_add(1, std::memory_order_relaxed);
+    // Created cold; the stream is waiting for it
+    const int64_t start = nowNs();
+    std::unique_ptr<Recognizer> session = recognizerModel->createSession(error);
+    if (session) {
+        counters.created.fetch_add(1, std::memory_order_relaxed);
+        counters.createNs.fetch_add(nowNs() - start, std::memory_order_relaxed);
+    }
+    return session;
+}
+
+void RecognizerPool::release(std::unique_ptr<Recognizer> session) {
+    if (!session) {
+        return;
+    }
+    session->reset();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (int(sessions.size()) < std::max(0, options.warm) + std::max(0, options.maxIdle)) {
+        sessions.push_back(std::move(session));
+        changed.notify_all();
+    }
+}
+
+void RecognizerPool::waitUntilWarm() {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this] { return failed || stopping || int(sessions.size()) >= options.warm; });
+}
+
+size_t RecognizerPool::ready() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return sessions.size();
+}
+
+// Creates outside the lock, so acquire() and release() never wait for it
+void RecognizerPool::fill() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        changed.wait(lock, [this] { return stopping || int(sessions.size()) < options.warm; });
+        if (stopping) {
+            return;
+        }
+        lock.unlock();
+        std::string error;
+        std::unique_ptr<Recognizer> session = createWarm(&error);
+        lock.lock();
+        if (!session) {
+            failed = true;
+            changed.notify_all();
+            return;
+        }
+        sessions.push_back(std::move(session));
+        changed.notify_all();
+    }
+}
+
+} // namespace pen
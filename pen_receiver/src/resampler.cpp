@@ -0,0 +1,177 @@
+#include "pen/resampler.h"
+
+#include "simd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <numeric>
+
+namespace pen {
+
+namespace {
+
+const double PassbandFraction = 0.85; // Of the lower Nyquist rate
+const double StopbandDb = 60;
+
+// Zeroth-order modified Bessel function, for the Kaiser window
+double besselI0(double x) {
+    double sum = 1;
+    double term = 1;
+    for (int k = 1; k < 50; ++k) {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+std::shared_ptr<const FilterBank> design(int inputRate, int outputRate) {
+    std::shared_ptr<FilterBank> bank(new FilterBank);
+    const int divisor = std::gcd(inputRate, outputRate);
+    bank->inputRate = inputRate;
+    bank->outputRate = outputRate;
+    bank->up = outputRate / divisor;
+    bank->down = inputRate / divisor;
+
+    // Passband edge, and a stopband edge mirrored around the lower Nyquist
+    // rate, so that aliases only land above the passband
+    const double nyquist = std::min(inputRate, outputRate) / 2.0;
+    const double pass = nyquist * PassbandFraction;
+    const double stop = 2 * nyquist - pass;
+    // Kaiser's estimate of the length, in input samples per output phase
+    const double transition = 2 * M_PI * (stop - pass) / inputRate;
+    const int taps = int(std::ceil((StopbandDb - 8) / (2.285 * transition)));
+    bank->tapsPerPhase = std::max(8, (taps + 7) / 8 * 8);
+    const double beta = 0.1102 * (StopbandDb - 8.7);
+
+    // Prototype at up * inputRate; cutoff halfway through the transition
+    const int length = bank->up * bank->tapsPerPhase;
+    const double cutoff = (pass + stop) / 2 / (double(bank->up) * inputRate);
+    const double centre = (length - 1) / 2.0;
+    const double windowScale = besselI0(beta);
+    std::vector<double> prototype(size_t(length), 0.0);
+    for (int m = 0; m < length; ++m) {
+        const double t = m - centre;
+        const double sinc = t == 0 ? 2 * cutoff : std::sin(2 * M_PI * cutoff * t) / (M_PI * t);
+        const double ratio = t / centre;
+        prototype[size_t(m)] = sinc * besselI0(beta * std::sqrt(std::max(0.0, 1 - ratio * ratio))) / windowScale;
+    }
+
+    // Phase p holds taps p, p + up, p + 2 up, ..., newest input last; the
+    // factor up restores the gain lost to zero-stuffing
+    bank->coefficients.assign(size_t(length), 0.0f);
+    for (int p = 0; p < bank->up; ++p) {
+        float *phase = bank->coefficients.data() + size_t(p) * size_t(bank->tapsPerPhase);
+        for (int k = 0; k < bank->tapsPerPhase; ++k) {
+            phase[bank->tapsPerPhase - 1 - k] = float(prototype[size_t(k * bank->up + p)] * bank->up);
+        }
+    }
+
+    bank->nextPhase.resize(size_t(bank->up));
+    bank->advance.resize(size_t(bank->up));
+    for (int p = 0; p < bank->up; ++p) {
+        bank->nextPhase[size_t(p)] = (p + bank->down) % bank->up;
+        bank->advance[size_t(p)] = (p + bank->down) / bank->up;
+    }
+    return bank;
+}
+
+} // namespace
+
+std::shared_ptr<const FilterBank> FilterBank::forRates(int inputRate, int outputRate) {
+    static std::mutex mutex;
+    static std::map<std::pair<int, int>, std::shared_ptr<const FilterBank>> banks;
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<const FilterBank> &bank = banks[std::make_pair(inputRate, outputRate)];
+    if (!bank) {
+        bank = design(inputRate, outputRate);
+    }
+    return bank;
+}
+
+Resampler::Resampler(int inputRate, int outputRate, int channels, size_t maxInputFrames)
+    : bank(FilterBank::forRates(inputRate, outputRate)),
+      channelCount(channels),
+      maxInputFrames(std::max<size_t>(1, maxInputFrames)),
+      window(size_t(bank->tapsPerPhase - 1) + this->maxInputFrames, 0.0f),
+      filtered(outputCapacity(this->maxInputFrames)) {
+    reset();
+}
+
+void Resampler::reset() {
+    std::fill(window.begin(), window.end(), 0.0f);
+    phase = 0;
+    position = bank->tapsPerPhase - 1;
+}
+
+size_t Resampler::outputCapacity(size_t frames) const {
+    return size_t((uint64_t(frames) * uint64_t(bank->up) + uint64_t(bank->down) - 1) / uint64_t(bank->down)) + 1;
+}
+
+const char *Resampler::kernelName() {
+    return simdKernels().name;
+}
+
+size_t Resampler::process(const int16_t *input, size_t frames, int16_t *output) {
+    if (passthrough()) {
+        std::copy(input, input + frames, output);
+        return frames;
+    }
+    size_t written = 0;
+    while (frames > 0) {
+        const size_t block = std::min(frames, maxInputFrames);
+        written += processBlock(input, block, output + written);
+        input += block * size_t(channelCount);
+        frames -= block;
+    }
+    return written;
+}
+
+size_t Resampler::processBlock(const int16_t *input, size_t frames, int16_t *output) {
+    const SimdKernels &kernels = simdKernels();
+    const int history = bank->tapsPerPhase - 1;
+    float *block = window.data() + history;
+
+    if (channelCount == 2) {
+        kernels.downmixStereo(input, frames, block);
+    } else if (channelCount == 1) {
+        for (size_t i = 0; i < frames; ++i) {
+            block[i] = input[i];
+        }
+    } else {
+        for (size_t i = 0; i < frames; ++i) {
+            int32_t sum = 0;
+            for (int c = 0; c < channelCount; ++c) {
+                sum += input[i * size_t(channelCount) + size_t(c)];
+            }
+            block[i] = float(sum) / float(channelCount);
+        }
+    }
+
+    // Every output whose newest input sample is in this block
+    PolyphaseRun run;
+    run.coefficients = bank->coefficients.data();
+    run.taps = bank->tapsPerPhase;
+    run.nextPhase = bank->nextPhase.data();
+    run.advance = bank->advance.data();
+    run.window = window.data();
+    run.position = position;
+    run.phase = phase;
+    run.end = history + int64_t(frames);
+    run.output = filtered.data();
+    const size_t written = kernels.polyphase(run);
+    kernels.toInt16(filtered.data(), written, output);
+    position = run.position;
+    phase = run.phase;
+
+    // Keep the newest history samples in front of the next block
+    std::copy(window.data() + frames, window.data() + frames + history, window.data());
+    position -= int64_t(frames);
+    return written;
+}
+
+} // namespace pen
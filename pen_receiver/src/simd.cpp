@@ -0,0 +1,84 @@
+#include "simd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace pen {
+
+// Sign changes are counted as "negative" flipping, with zero on the
+// non-negative side, so every kernel agrees on silence runs of zeros
+FrameFeatures frameFeaturesScalar(const int16_t *samples, size_t count) {
+    FrameFeatures features = {0, 0};
+    for (size_t i = 0; i < count; ++i) {
+        features.energy += uint64_t(int32_t(samples[i]) * samples[i]);
+        if (i > 0 && (samples[i] < 0) != (samples[i - 1] < 0)) {
+            ++features.crossings;
+        }
+    }
+    return features;
+}
+
+size_t polyphaseScalar(PolyphaseRun &run) {
+    size_t written = 0;
+    while (run.position < run.end) {
+        const float *coefficients = run.coefficients + size_t(run.phase) * size_t(run.taps);
+        const float *samples = run.window + run.position - (run.taps - 1);
+        float sum = 0;
+        for (int i = 0; i < run.taps; ++i) {
+            sum += coefficients[i] * samples[i];
+        }
+        *run.output++ = sum;
+        ++written;
+        run.position += run.advance[run.phase];
+        run.phase = run.nextPhase[run.phase];
+    }
+    return written;
+}
+
+void downmixStereoScalar(const int16_t *input, size_t frames, float *output) {
+    for (size_t i = 0; i < frames; ++i) {
+        output[i] = (float(input[2 * i]) + float(input[2 * i + 1])) * 0.5f;
+    }
+}
+
+void toInt16Scalar(const float *input, size_t count, int16_t *output) {
+    for (size_t i = 0; i < count; ++i) {
+        const float clamped = std::max(-32768.0f, std::min(32767.0f, input[i]));
+        output[i] = int16_t(std::lrint(clamped));
+    }
+}
+
+namespace {
+
+SimdKernels pickKernels() {
+    const SimdKernels scalar = {"scalar", frameFeaturesScalar, polyphaseScalar, downmixStereoScalar, toInt16Scalar};
+    const SimdKernels available[] = {
+#if defined(PEN_SIMD_X86)
+        {"avx2", __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") ? frameFeaturesAvx2 : nullptr,
+         polyphaseAvx2, downmixStereoAvx2, toInt16Avx2},
+        {"sse2", frameFeaturesSse2, polyphaseSse2, downmixStereoSse2, toInt16Sse2},
+#endif
+#if defined(PEN_SIMD_NEON)
+        {"neon", frameFeaturesNeon, polyphaseNeon, downmixStereoNeon, toInt16Neon},
+#endif
+        scalar,
+    };
+    const char *forced = std::getenv("PEN_SIMD");
+    for (const SimdKernels &kernels : available) {
+        if (kernels.frameFeatures && (!forced || std::strcmp(forced, kernels.name) == 0)) {
+            return kernels;
+        }
+    }
+    return scalar;
+}
+
+} // namespace
+
+const SimdKernels &simdKernels() {
+    static const SimdKernels kernels = pickKernels();
+    return kernels;
+}
+
+} // namespace pen
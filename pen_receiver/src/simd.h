@@ -0,0 +1,74 @@
+#ifndef PEN_SIMD_H
+#define PEN_SIMD_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace pen {
+
+// What the voice-activity gate needs from a block of samples
+struct FrameFeatures {
+    uint64_t energy;    // Sum of squares
+    uint32_t crossings; // Sign changes between neighbouring samples
+};
+
+// One block of polyphase filtering: outputs are produced while position
+// (index in window of the newest input sample an output needs) is before
+// end, each the dot product of the phase's coefficients with the taps
+// samples ending there. position and phase are left at the next output,
+// and output past the last one written.
+struct PolyphaseRun {
+    const float *coefficients; // phases * taps, taps a multiple of 8
+    int taps;
+    const int *nextPhase;
+    const int *advance;
+    const float *window;
+    int64_t position;
+    int phase;
+    int64_t end;
+    float *output;
+};
+
+// The DSP inner loops, once per instruction set. Every set computes what
+// the scalar one does; float results may differ in the last bits.
+struct SimdKernels {
+    const char *name;
+    FrameFeatures (*frameFeatures)(const int16_t *samples, size_t count);
+    // Returns the number of outputs written
+    size_t (*polyphase)(PolyphaseRun &run);
+    // Interleaved stereo to the mean of both channels, at 16-bit scale
+    void (*downmixStereo)(const int16_t *input, size_t frames, float *output);
+    // Rounded to nearest and saturated
+    void (*toInt16)(const float *input, size_t count, int16_t *output);
+};
+
+FrameFeatures frameFeaturesScalar(const int16_t *samples, size_t count);
+size_t polyphaseScalar(PolyphaseRun &run);
+void downmixStereoScalar(const int16_t *input, size_t frames, float *output);
+void toInt16Scalar(const float *input, size_t count, int16_t *output);
+
+#if defined(PEN_SIMD_X86)
+FrameFeatures frameFeaturesSse2(const int16_t *samples, size_t count);
+size_t polyphaseSse2(PolyphaseRun &run);
+void downmixStereoSse2(const int16_t *input, size_t frames, float *output);
+void toInt16Sse2(const float *input, size_t count, int16_t *output);
+// Built with AVX2 and FMA; only called when the CPU has both
+FrameFeatures frameFeaturesAvx2(const int16_t *samples, size_t count);
+size_t polyphaseAvx2(PolyphaseRun &run);
+void downmixStereoAvx2(const int16_t *input, size_t frames, float *output);
+void toInt16Avx2(const float *input, size_t count, int16_t *output);
+#endif
+#if defined(PEN_SIMD_NEON)
+FrameFeatures frameFeaturesNeon(const int16_t *samples, size_t count);
+size_t polyphaseNeon(PolyphaseRun &run);
+void downmixStereoNeon(const int16_t *input, size_t frames, float *output);
+void toInt16Neon(const float *input, size_t count, int16_t *output);
+#endif
+
+// Best set for this CPU, chosen once. PEN_SIMD=scalar|sse2|avx2|neon in
+// the environment overrides it, for comparing them.
+const SimdKernels &simdKernels();
+
+} // namespace pen
+
+#endif // PEN_SIMD_H
@@ -0,0 +1,138 @@
+#include "simd.h"
+
+#include <immintrin.h>
+
+namespace pen {
+
+namespace {
+
+uint32_t sumLanes(__m256i counts) {
+    alignas(32) uint16_t lanes[16];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), counts);
+    uint32_t sum = 0;
+    for (uint16_t lane : lanes) {
+        sum += lane;
+    }
+    return sum;
+}
+
+} // namespace
+
+// The SSE2 kernel at sixteen samples per step
+FrameFeatures frameFeaturesAvx2(const int16_t *samples, size_t count) {
+    if (count < 17) {
+        return frameFeaturesScalar(samples, count);
+    }
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i energy = zero;
+    __m256i crossings = zero;
+    FrameFeatures features = {uint64_t(int32_t(samples[0]) * samples[0]), 0};
+
+    size_t i = 1;
+    int steps = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m256i current = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(samples + i));
+        const __m256i previous = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(samples + i - 1));
+
+        // Unpacking works within 128-bit halves; the order does not matter
+        // for a sum
+        const __m256i squares = _mm256_madd_epi16(current, current);
+        energy = _mm256_add_epi64(energy, _mm256_unpacklo_epi32(squares, zero));
+        energy = _mm256_add_epi64(energy, _mm256_unpackhi_epi32(squares, zero));
+
+        crossings = _mm256_sub_epi16(crossings, _mm256_srai_epi16(_mm256_xor_si256(current, previous), 15));
+        if (++steps == 0xffff) {
+            features.crossings += sumLanes(crossings);
+            crossings = zero;
+            steps = 0;
+        }
+    }
+
+    alignas(32) uint64_t sums[4];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(sums), energy);
+    features.energy += sums[0] + sums[1] + sums[2] + sums[3];
+    features.crossings += sumLanes(crossings);
+
+    for (; i < count; ++i) {
+        features.energy += uint64_t(int32_t(samples[i]) * samples[i]);
+        if ((samples[i] < 0) != (samples[i - 1] < 0)) {
+            ++features.crossings;
+        }
+    }
+    return features;
+}
+
+// Four outputs at a time, as in the SSE2 kernel, with fused multiply-add
+size_t polyphaseAvx2(PolyphaseRun &run) {
+    const int taps = run.taps;
+    size_t written = 0;
+    for (;;) {
+        int64_t positions[4];
+        int phases[4];
+        int ready = 0;
+        int64_t position = run.position;
+        int phase = run.phase;
+        for (; ready < 4 && position < run.end; ++ready) {
+            positions[ready] = position;
+            phases[ready] = phase;
+            position += run.advance[phase];
+            phase = run.nextPhase[phase];
+        }
+        if (ready < 4) {
+            run.output += written;
+            return written + polyphaseScalar(run);
+        }
+
+        const float *c0 = run.coefficients + size_t(phases[0]) * size_t(taps);
+        const float *c1 = run.coefficients + size_t(phases[1]) * size_t(taps);
+        const float *c2 = run.coefficients + size_t(phases[2]) * size_t(taps);
+        const float *c3 = run.coefficients + size_t(phases[3]) * size_t(taps);
+        const float *x0 = run.window + positions[0] - (taps - 1);
+        const float *x1 = run.window + positions[1] - (taps - 1);
+        const float *x2 = run.window + positions[2] - (taps - 1);
+        const float *x3 = run.window + positions[3] - (taps - 1);
+        __m256 s0 = _mm256_setzero_ps();
+        __m256 s1 = _mm256_setzero_ps();
+        __m256 s2 = _mm256_setzero_ps();
+        __m256 s3 = _mm256_setzero_ps();
+        for (int i = 0; i < taps; i += 8) {
+            s0 = _mm256_fmadd_ps(_mm256_loadu_ps(c0 + i), _mm256_loadu_ps(x0 + i), s0);
+            s1 = _mm256_fmadd_ps(_mm256_loadu_ps(c1 + i), _mm256_loadu_ps(x1 + i), s1);
+            s2 = _mm256_fmadd_ps(_mm256_loadu_ps(c2 + i), _mm256_loadu_ps(x2 + i), s2);
+            s3 = _mm256_fmadd_ps(_mm256_loadu_ps(c3 + i), _mm256_loadu_ps(x3 + i), s3);
+        }
+        // Pairwise adds leave each output's sum split over the two halves
+        const __m256 pairs = _mm256_hadd_ps(_mm256_hadd_ps(s0, s1), _mm256_hadd_ps(s2, s3));
+        _mm_storeu_ps(run.output + written,
+                      _mm_add_ps(_mm256_castps256_ps128(pairs), _mm256_extractf128_ps(pairs, 1)));
+        written += 4;
+        run.position = position;
+        run.phase = phase;
+    }
+}
+
+void toInt16Avx2(const float *input, size_t count, int16_t *output) {
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m256i low = _mm256_cvtps_epi32(_mm256_loadu_ps(input + i));
+        const __m256i high = _mm256_cvtps_epi32(_mm256_loadu_ps(input + i + 8));
+        // packs works per 128-bit half; put the quarters back in order
+        const __m256i packed = _mm256_packs_epi32(low, high);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(output + i), _mm256_permute4x64_epi64(packed, 0xd8));
+    }
+    toInt16Scalar(input + i, count - i, output + i);
+}
+
+void downmixStereoAvx2(const int16_t *input, size_t frames, float *output) {
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        const __m256i pairs = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input + 2 * i));
+        const __m256i sums = _mm256_madd_epi16(pairs, ones);
+        _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_cvtepi32_ps(sums), half));
+    }
+    downmixStereoScalar(input + 2 * i, frames - i, output + i);
+}
+
+} // namespace pen
@@ -0,0 +1,128 @@
+#include "simd.h"
+
+#include <arm_neon.h>
+
+namespace pen {
+
+// Eight samples per step. Squares are widened to 32 bits (at most 2^30
+// each) and pairwise accumulated into 64-bit lanes. Only lane-wise
+// intrinsics are used, so this also builds for 32-bit ARM with NEON.
+FrameFeatures frameFeaturesNeon(const int16_t *samples, size_t count) {
+    if (count < 9) {
+        return frameFeaturesScalar(samples, count);
+    }
+    uint64x2_t energy = vdupq_n_u64(0);
+    uint16x8_t crossings = vdupq_n_u16(0);
+    FrameFeatures features = {uint64_t(int32_t(samples[0]) * samples[0]), 0};
+
+    size_t i = 1;
+    int steps = 0;
+    for (; i + 8 <= count; i += 8) {
+        const int16x8_t current = vld1q_s16(samples + i);
+        const int16x8_t previous = vld1q_s16(samples + i - 1);
+
+        const int32x4_t low = vmull_s16(vget_low_s16(current), vget_low_s16(current));
+        const int32x4_t high = vmull_s16(vget_high_s16(current), vget_high_s16(current));
+        energy = vpadalq_u32(energy, vreinterpretq_u32_s32(low));
+        energy = vpadalq_u32(energy, vreinterpretq_u32_s32(high));
+
+        // One where the signs differ
+        const uint16x8_t differ = vshrq_n_u16(vreinterpretq_u16_s16(veorq_s16(current, previous)), 15);
+        crossings = vaddq_u16(crossings, differ);
+        if (++steps == 0xffff) {
+            const uint64x2_t wide = vpaddlq_u32(vpaddlq_u16(crossings));
+            features.crossings += uint32_t(vgetq_lane_u64(wide, 0) + vgetq_lane_u64(wide, 1));
+            crossings = vdupq_n_u16(0);
+            steps = 0;
+        }
+    }
+
+    features.energy += vgetq_lane_u64(energy, 0) + vgetq_lane_u64(energy, 1);
+    const uint64x2_t wide = vpaddlq_u32(vpaddlq_u16(crossings));
+    features.crossings += uint32_t(vgetq_lane_u64(wide, 0) + vgetq_lane_u64(wide, 1));
+
+    for (; i < count; ++i) {
+        features.energy += uint64_t(int32_t(samples[i]) * samples[i]);
+        if ((samples[i] < 0) != (samples[i - 1] < 0)) {
+            ++features.crossings;
+        }
+    }
+    return features;
+}
+
+// Four outputs at a time, as in the SSE2 kernel
+size_t polyphaseNeon(PolyphaseRun &run) {
+    const int taps = run.taps;
+    size_t written = 0;
+    for (;;) {
+        int64_t positions[4];
+        int phases[4];
+        int ready = 0;
+        int64_t position = run.position;
+        int phase = run.phase;
+        for (; ready < 4 && position < run.end; ++ready) {
+            positions[ready] = position;
+            phases[ready] = phase;
+            position += run.advance[phase];
+            phase = run.nextPhase[phase];
+        }
+        if (ready < 4) {
+            run.output += written;
+            return written + polyphaseScalar(run);
+        }
+
+        float32x4_t sums[4];
+        const float *coefficients[4];
+        const float *samples[4];
+        for (int k = 0; k < 4; ++k) {
+            sums[k] = vdupq_n_f32(0);
+            coefficients[k] = run.coefficients + size_t(phases[k]) * size_t(taps);
+            samples[k] = run.window + positions[k] - (taps - 1);
+        }
+        for (int i = 0; i < taps; i += 4) {
+            for (int k = 0; k < 4; ++k) {
+                sums[k] = vmlaq_f32(sums[k], vld1q_f32(coefficients[k] + i), vld1q_f32(samples[k] + i));
+            }
+        }
+        // Lane sums of all four at once: {s0, s1, s2, s3}
+        const float32x2_t p01 = vpadd_f32(vadd_f32(vget_low_f32(sums[0]), vget_high_f32(sums[0])),
+                                          vadd_f32(vget_low_f32(sums[1]), vget_high_f32(sums[1])));
+        const float32x2_t p23 = vpadd_f32(vadd_f32(vget_low_f32(sums[2]), vget_high_f32(sums[2])),
+                                          vadd_f32(vget_low_f32(sums[3]), vget_high_f32(sums[3])));
+        vst1q_f32(run.output + written, vcombine_f32(p01, p23));
+        written += 4;
+        run.position = position;
+        run.phase = phase;
+    }
+}
+
+void toInt16Neon(const float *input, size_t count, int16_t *output) {
+    // vcvtq truncates; add a half away from zero first. It saturates to
+    // 32 bits and vqmovn on to 16.
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const float32x4_t low = vld1q_f32(input + i);
+        const float32x4_t high = vld1q_f32(input + i + 4);
+        const float32x4_t lowHalf = vbslq_f32(vcltq_f32(low, zero), vnegq_f32(half), half);
+        const float32x4_t highHalf = vbslq_f32(vcltq_f32(high, zero), vnegq_f32(half), half);
+        const int32x4_t lowInt = vcvtq_s32_f32(vaddq_f32(low, lowHalf));
+        const int32x4_t highInt = vcvtq_s32_f32(vaddq_f32(high, highHalf));
+        vst1q_s16(output + i, vcombine_s16(vqmovn_s32(lowInt), vqmovn_s32(highInt)));
+    }
+    toInt16Scalar(input + i, count - i, output + i);
+}
+
+// vld2 splits left and right into separate registers
+void downmixStereoNeon(const int16_t *input, size_t frames, float *output) {
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const int16x4x2_t channels = vld2_s16(input + 2 * i);
+        const int32x4_t sums = vaddl_s16(channels.val[0], channels.val[1]);
+        vst1q_f32(output + i, vmulq_n_f32(vcvtq_f32_s32(sums), 0.5f));
+    }
+    downmixStereoScalar(input + 2 * i, frames - i, output + i);
+}
+
+} // namespace pen
@@ -0,0 +1,137 @@
+#include "simd.h"
+
+#include <emmintrin.h>
+#include <xmmintrin.h>
+
+namespace pen {
+
+namespace {
+
+uint32_t sumLanes(__m128i counts) {
+    alignas(16) uint16_t lanes[8];
+    _mm_store_si128(reinterpret_cast<__m128i *>(lanes), counts);
+    uint32_t sum = 0;
+    for (uint16_t lane : lanes) {
+        sum += lane;
+    }
+    return sum;
+}
+
+} // namespace
+
+// Eight samples per step. madd squares and adds pairs into 32-bit lanes;
+// two squares of -32768 make exactly 2^31, so the lanes are read as
+// unsigned and widened to 64 bits before they can add up.
+FrameFeatures frameFeaturesSse2(const int16_t *samples, size_t count) {
+    if (count < 9) {
+        return frameFeaturesScalar(samples, count);
+    }
+    const __m128i zero = _mm_setzero_si128();
+    __m128i energy = zero;
+    __m128i crossings = zero; // 16-bit counts, emptied before they can wrap
+    FrameFeatures features = {uint64_t(int32_t(samples[0]) * samples[0]), 0};
+
+    size_t i = 1;
+    int steps = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i));
+        const __m128i previous = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i - 1));
+
+        const __m128i squares = _mm_madd_epi16(current, current);
+        energy = _mm_add_epi64(energy, _mm_unpacklo_epi32(squares, zero));
+        energy = _mm_add_epi64(energy, _mm_unpackhi_epi32(squares, zero));
+
+        // Minus all ones where the signs differ
+        crossings = _mm_sub_epi16(crossings, _mm_srai_epi16(_mm_xor_si128(current, previous), 15));
+        if (++steps == 0xffff) {
+            features.crossings += sumLanes(crossings);
+            crossings = zero;
+            steps = 0;
+        }
+    }
+
+    alignas(16) uint64_t sums[2];
+    _mm_store_si128(reinterpret_cast<__m128i *>(sums), energy);
+    features.energy += sums[0] + sums[1];
+    features.crossings += sumLanes(crossings);
+
+    for (; i < count; ++i) {
+        features.energy += uint64_t(int32_t(samples[i]) * samples[i]);
+        if ((samples[i] < 0) != (samples[i - 1] < 0)) {
+            ++features.crossings;
+        }
+    }
+    return features;
+}
+
+// Four outputs at a time: four independent accumulator chains keep the
+// multiply-add latency hidden, and one transpose sums all four
+size_t polyphaseSse2(PolyphaseRun &run) {
+    const int taps = run.taps;
+    size_t written = 0;
+    for (;;) {
+        int64_t positions[4];
+        int phases[4];
+        int ready = 0;
+        int64_t position = run.position;
+        int phase = run.phase;
+        for (; ready < 4 && position < run.end; ++ready) {
+            positions[ready] = position;
+            phases[ready] = phase;
+            position += run.advance[phase];
+            phase = run.nextPhase[phase];
+        }
+        if (ready < 4) {
+            run.output += written;
+            return written + polyphaseScalar(run);
+        }
+
+        __m128 sums[4];
+        for (int k = 0; k < 4; ++k) {
+            sums[k] = _mm_setzero_ps();
+        }
+        const float *coefficients[4];
+        const float *samples[4];
+        for (int k = 0; k < 4; ++k) {
+            coefficients[k] = run.coefficients + size_t(phases[k]) * size_t(taps);
+            samples[k] = run.window + positions[k] - (taps - 1);
+        }
+        for (int i = 0; i < taps; i += 4) {
+            for (int k = 0; k < 4; ++k) {
+                sums[k] = _mm_add_ps(sums[k], _mm_mul_ps(_mm_loadu_ps(coefficients[k] + i), _mm_loadu_ps(samples[k] + i)));
+            }
+        }
+        _MM_TRANSPOSE4_PS(sums[0], sums[1], sums[2], sums[3]);
+        _mm_storeu_ps(run.output + written,
+                      _mm_add_ps(_mm_add_ps(sums[0], sums[1]), _mm_add_ps(sums[2], sums[3])));
+        written += 4;
+        run.position = position;
+        run.phase = phase;
+    }
+}
+
+void toInt16Sse2(const float *input, size_t count, int16_t *output) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        // cvtps rounds to nearest; packs saturates
+        const __m128i low = _mm_cvtps_epi32(_mm_loadu_ps(input + i));
+        const __m128i high = _mm_cvtps_epi32(_mm_loadu_ps(input + i + 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output + i), _mm_packs_epi32(low, high));
+    }
+    toInt16Scalar(input + i, count - i, output + i);
+}
+
+// madd against ones adds each left/right pair in one step
+void downmixStereoSse2(const int16_t *input, size_t frames, float *output) {
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128 half = _mm_set1_ps(0.5f);
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const __m128i pairs = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + 2 * i));
+        const __m128i sums = _mm_madd_epi16(pairs, ones);
+        _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(sums), half));
+    }
+    downmixStereoScalar(input + 2 * i, frames - i, output + i);
+}
+
+} // namespace pen
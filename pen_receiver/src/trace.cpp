@@ -0,0 +1,335 @@
+#include "pen/trace.h"
+
+#include "pen/clock.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+namespace pen {
+
+namespace {
+
+const char Magic[8] = {'P', 'E', 'N', 'T', 'R', 'A', 'C', 'E'};
+const size_t BufferBytes = 1 << 20;
+
+void setError(std::string *error, const std::string &message) {
+    if (error) {
+        *error = message;
+    }
+}
+
+size_t padded(size_t length) {
+    return (length + 7) & ~size_t(7);
+}
+
+} // namespace
+
+TraceWriter::TraceWriter(const std::string &path, int frameMs)
+    : filePath(path), frameMs(frameMs), folded(PcmFrame::MaxSamples / 2) {}
+
+TraceWriter::~TraceWriter() {
+    close(nullptr);
+}
+
+bool TraceWriter::open(std::string *error) {
+    file = std::fopen(filePath.c_str(), "wbe");
+    if (!file) {
+        setError(error, filePath + ": " + std::strerror(errno));
+        return false;
+    }
+    std::setvbuf(file, nullptr, _IOFBF, BufferBytes);
+    TraceFileHeader header = {};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = TraceFileHeader::Version;
+    header.frameMs = uint32_t(frameMs);
+    header.startedUnixMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                               std::chrono::system_clock::now().time_since_epoch())
+                               .count();
+    originNs = nowNs();
+    failed = std::fwrite(&header, sizeof(header), 1, file) != 1;
+    counters.bytes.store(sizeof(header));
+    return true;
+}
+
+bool TraceWriter::close(std::string *error) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!file) {
+        return true;
+    }
+    failed |= std::fclose(file) != 0;
+    file = nullptr;
+    if (failed) {
+        setError(error, filePath + ": write failed; the trace is incomplete");
+        return false;
+    }
+    return true;
+}
+
+void TraceWriter::write(const TraceRecord &record, const void *payload) {
+    static const char Padding[8] = {};
+    if (!file || failed) {
+        return;
+    }
+    const size_t padding = padded(record.length) - record.length;
+    failed = std::fwrite(&record, sizeof(record), 1, file) != 1
+             || (record.length > 0 && std::fwrite(payload, record.length, 1, file) != 1)
+             || (padding > 0 && std::fwrite(Padding, padding, 1, file) != 1);
+    counters.bytes.fetch_add(sizeof(record) + record.length + padding, std::memory_order_relaxed);
+}
+
+void TraceWriter::frame(uint16_t stream, const PcmFrame &frame) {
+    TraceRecord record = {};
+    record.timeUs = uint64_t(std::max<int64_t>(frame.arrivalNs - originNs, 0) / 1000);
+    record.stream = stream;
+    record.type = TraceRecord::Frame;
+    const size_t count = size_t(frame.frames) * frame.channels;
+    bool identical = frame.channels == 2;
+    for (size_t i = 0; identical && i < count; i += 2) {
+        identical = frame.samples[i] == frame.samples[i + 1];
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (identical) {
+        for (size_t i = 0; i < frame.frames; ++i) {
+            folded[i] = frame.samples[2 * i];
+        }
+        record.flags = TraceRecord::Folded;
+        record.length = uint32_t(frame.frames * sizeof(int16_t));
+        write(record, folded.data());
+    } else {
+        record.length = uint32_t(count * sizeof(int16_t));
+        write(record, frame.samples);
+    }
+    counters.frames.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TraceWriter::event(uint16_t stream, int64_t timeNs, const TraceEvent &event) {
+    TraceRecord record = {};
+    record.timeUs = uint64_t(std::max<int64_t>(timeNs - originNs, 0) / 1000);
+    record.length = sizeof(event);
+    record.stream = stream;
+    record.type = TraceRecord::Event;
+    std::lock_guard<std::mutex> lock(mutex);
+    write(record, &event);
+    counters.events.fetch_add(1, std::memory_order_relaxed);
+}
+
+TraceRecorder::TraceRecorder(TraceWriter &writer, uint16_t stream, FrameSink &next)
+    : writer(writer), stream(stream), next(next) {}
+
+bool TraceRecorder::streamStarted(StreamFormat format, std::string *error) {
+    writer.event(stream, nowNs(), {TraceEvent::Connected, format.sampleRate, format.channels});
+    nextSequence = 0;
+    return next.streamStarted(format, error);
+}
+
+void TraceRecorder::consume(const PcmFrame &frame) {
+    next.consume(frame);
+    if (frame.sequence > nextSequence) {
+        writer.event(stream, frame.arrivalNs, {TraceEvent::Dropped, uint32_t(frame.sequence - nextSequence), 0});
+    }
+    nextSequence = frame.sequence + 1;
+    writer.frame(stream, frame);
+}
+
+void TraceRecorder::endOfStream() {
+    next.endOfStream();
+    writer.event(stream, nowNs(), {TraceEvent::Disconnected, 0, 0});
+}
+
+bool TraceReader::open(const std::string &path, std::string *error) {
+    std::string message;
+    file = MappedFile::open(path, &message);
+    if (!file) {
+        setError(error, message);
+        return false;
+    }
+    if (file->size() < sizeof(TraceFileHeader) || std::memcmp(header().magic, Magic, sizeof(Magic)) != 0) {
+        setError(error, path + ": not a pen trace");
+        return false;
+    }
+    if (header().version != TraceFileHeader::Version) {
+        setError(error, path + ": trace version " + std::to_string(header().version));
+        return false;
+    }
+    file->prefetch();
+
+    everything.clear();
+    byStream.clear();
+    const unsigned char *data = file->data();
+    size_t at = sizeof(TraceFileHeader);
+    while (at + sizeof(TraceRecord) <= file->size()) {
+        const TraceRecord *record = reinterpret_cast<const TraceRecord *>(data + at);
+        const size_t size = sizeof(TraceRecord) + padded(record->length);
+        if (size > file->size() - at) {
+            break;
+        }
+        everything.push_back(record);
+        byStream[record->stream].push_back(record);
+        at += size;
+    }
+    cutShort = at != file->size();
+    return true;
+}
+
+std::vector<uint16_t> TraceReader::streams() const {
+    std::vector<uint16_t> ids;
+    for (const auto &entry : byStream) {
+        ids.push_back(entry.first);
+    }
+    return ids;
+}
+
+const std::vector<const TraceRecord *> &TraceReader::records(uint16_t stream) const {
+    static const std::vector<const TraceRecord *> none;
+    const auto found = byStream.find(stream);
+    return found == byStream.end() ? none : found->second;
+}
+
+uint64_t TraceReader::frameCount(uint16_t stream) const {
+    const std::vector<const TraceRecord *> &list = records(stream);
+    return uint64_t(std::count_if(list.begin(), list.end(),
+                                  [](const TraceRecord *record) { return record->type == TraceRecord::Frame; }));
+}
+
+double TraceReader::audioSeconds(uint16_t stream) const {
+    double seconds = 0;
+    StreamFormat format;
+    for (const TraceRecord *record : records(stream)) {
+        if (record->type == TraceRecord::Event) {
+            const TraceEvent event = record->event();
+            if (event.code == TraceEvent::Connected && event.a > 0 && event.b > 0) {
+                format.sampleRate = event.a;
+                format.channels = uint16_t(event.b);
+            }
+        } else if (record->type == TraceRecord::Frame) {
+            const uint32_t channels = record->flags & TraceRecord::Folded ? 1 : format.channels;
+            seconds += double(record->length / (2 * channels)) / format.sampleRate;
+        }
+    }
+    return seconds;
+}
+
+TraceReplayTransport::TraceReplayTransport(const TraceReader &trace, uint16_t stream, bool realTime,
+                                           int64_t originNs)
+    : trace(trace),
+      records(trace.records(stream)),
+      stream(stream),
+      realTime(realTime),
+      originNs(originNs) {
+    pending.reserve(PcmFrame::MaxSamples);
+}
+
+std::string TraceReplayTransport::describe() const {
+    return "trace:" + trace.path() + "#" + std::to_string(stream);
+}
+
+void TraceReplayTransport::interrupt() {
+    std::lock_guard<std::mutex> lock(mutex);
+    interrupted = true;
+    wake.notify_all();
+}
+
+bool TraceReplayTransport::waitUntil(uint64_t timeUs) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (realTime) {
+        const std::chrono::steady_clock::time_point due(std::chrono::nanoseconds(originNs + int64_t(timeUs) * 1000));
+        wake.wait_until(lock, due, [this] { return interrupted; });
+    }
+    return !interrupted;
+}
+
+// The pen connects at the stream's first Connected event
+bool TraceReplayTransport::open(std::string *error) {
+    for (next = 0; next < records.size(); ++next) {
+        const TraceRecord &record = *records[next];
+        const TraceEvent event = record.type == TraceRecord::Event ? record.event() : TraceEvent{};
+        if (event.code != TraceEvent::Connected) {
+            continue;
+        }
+        if (event.a == 0 || event.b == 0 || event.b > 2) {
+            break;
+        }
+        if (!waitUntil(record.timeUs)) {
+            setError(error, "interrupted");
+            return false;
+        }
+        streamFormat.sampleRate = event.a;
+        streamFormat.channels = uint16_t(event.b);
+        ++next;
+        pending.clear();
+        pendingAt = 0;
+        return true;
+    }
+    setError(error, describe() + ": no connection in the trace");
+    return false;
+}
+
+bool TraceReplayTransport::nextFrame() {
+    for (; next < records.size(); ++next) {
+        const TraceRecord &record = *records[next];
+        if (record.type == TraceRecord::Event) {
+            const TraceEvent event = record.event();
+            if (event.code == TraceEvent::Disconnected) {
+                waitUntil(record.timeUs);
+                next = records.size();
+                return false;
+            }
+            dropped += event.code == TraceEvent::Dropped ? event.a : 0;
+            continue;
+        }
+        if (record.type != TraceRecord::Frame) {
+            continue;
+        }
+        if (!waitUntil(record.timeUs)) {
+            return false;
+        }
+        const int64_t start = nowNs();
+        const int16_t *samples = reinterpret_cast<const int16_t *>(record.payload());
+        const bool folded = record.flags & TraceRecord::Folded;
+        const size_t stored = std::min<size_t>(record.length / 2, folded ? PcmFrame::MaxSamples / 2
+                                                                          : size_t(PcmFrame::MaxSamples));
+        if (folded) {
+            pending.resize(stored * 2);
+            for (size_t i = 0; i < stored; ++i) {
+                pending[2 * i] = pending[2 * i + 1] = samples[i];
+            }
+        } else {
+            pending.assign(samples, samples + stored);
+        }
+        pendingAt = 0;
+        busy += nowNs() - start;
+        ++next;
+        return true;
+    }
+    return false;
+}
+
+ssize_t TraceReplayTransport::read(void *buffer, size_t size) {
+    char *out = static_cast<char *>(buffer);
+    size_t done = 0;
+    while (done < size) {
+        if (pendingAt == pending.size() * sizeof(int16_t)) {
+            if (!nextFrame()) {
+                break;
+            }
+        }
+        const int64_t start = nowNs();
+        const size_t n = std::min(size - done, pending.size() * sizeof(int16_t) - pendingAt);
+        std::memcpy(out + done, reinterpret_cast<const char *>(pending.data()) + pendingAt, n);
+        pendingAt += n;
+        done += n;
+        busy += nowNs() - start;
+    }
+    if (done == 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (interrupted) {
+            return -1;
+        }
+    }
+    return ssize_t(done);
+}
+
+} // namespace pen
@@ -0,0 +1,312 @@
+#include "pen/transcriptpublisher.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace pen {
+
+namespace {
+
+void setError(std::string *error, const std::string &message) {
+    if (error) {
+        *error = message;
+    }
+}
+
+std::string systemError(const std::string &what) {
+    return what + ": " + std::strerror(errno);
+}
+
+uint32_t roundUpToPowerOfTwo(uint32_t value) {
+    uint32_t power = 1;
+    while (power < value && power < (1u << 24)) {
+        power <<= 1;
+    }
+    return power;
+}
+
+void fill(TranscriptRecord &record, uint32_t stream, uint8_t kind, const char *text, size_t size, int64_t startMs,
+          int64_t endMs, float confidence) {
+    size_t length = std::min(size, TranscriptRecord::TextCapacity);
+    // Do not cut a UTF-8 sequence in two
+    if (length < size) {
+        while (length > 0 && (uint8_t(text[length]) & 0xc0) == 0x80) {
+            --length;
+        }
+    }
+    record.startMs = startMs;
+    record.endMs = endMs;
+    record.confidence = confidence;
+    record.stream = stream;
+    record.kind = kind;
+    record.flags = 0;
+    record.length = uint8_t(length);
+    std::memcpy(record.text, text, length);
+}
+
+} // namespace
+
+TranscriptPublisher::TranscriptPublisher(const std::string &path, uint32_t capacity)
+    : socketPath(path), capacity(roundUpToPowerOfTwo(std::max<uint32_t>(capacity, 64))) {}
+
+TranscriptPublisher::~TranscriptPublisher() {
+    close();
+}
+
+bool TranscriptPublisher::listen(std::string *error) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        setError(error, "socket path too long: " + socketPath);
+        return false;
+    }
+    std::strcpy(address.sun_path, socketPath.c_str());
+
+    if (::pipe2(wakePipe, O_CLOEXEC | O_NONBLOCK) != 0) {
+        setError(error, systemError("pipe"));
+        return false;
+    }
+    listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listener < 0) {
+        setError(error, systemError("socket"));
+        close();
+        return false;
+    }
+    ::unlink(socketPath.c_str()); // Left over from a crash
+    if (::bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || ::listen(listener, 4) != 0) {
+        setError(error, systemError(socketPath));
+        close();
+        return false;
+    }
+    server = std::thread(&TranscriptPublisher::serve, this);
+    return true;
+}
+
+void TranscriptPublisher::close() {
+    if (server.joinable()) {
+        const char byte = 1;
+        [[maybe_unused]] const ssize_t n = ::write(wakePipe[1], &byte, 1);
+        server.join();
+    }
+    detach();
+    if (listener >= 0) {
+        ::close(listener);
+        listener = -1;
+        ::unlink(socketPath.c_str());
+    }
+    for (int &end : wakePipe) {
+        if (end >= 0) {
+            ::close(end);
+            end = -1;
+        }
+    }
+}
+
+// Accepts viewers and notices when the current one goes away; viewers do
+// not send anything, so readable means hung up
+void TranscriptPublisher::serve() {
+    for (;;) {
+        pollfd fds[3] = {{wakePipe[0], POLLIN, 0}, {listener, POLLIN, 0}, {viewer, POLLIN, 0}};
+        const int ready = ::poll(fds, viewer >= 0 ? 3 : 2, -1);
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready < 0 || (fds[0].revents & POLLIN)) {
+            return;
+        }
+        if (fds[1].revents & POLLIN) {
+            const int connection = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+            if (connection >= 0 && !attach(connection)) {
+                ::close(connection);
+            }
+        }
+        if (viewer >= 0 && fds[2].revents) {
+            char byte;
+            const ssize_t n = ::recv(viewer, &byte, 1, MSG_DONTWAIT);
+            if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+                detach();
+            }
+        }
+    }
+}
+
+// A fresh ring per viewer, so that nothing of an earlier viewer's state
+// (its tail, a half-read run) carries over
+bool TranscriptPublisher::attach(int connection) {
+    const size_t bytes = TranscriptRingHeader::bytesFor(capacity);
+    const int memory = ::memfd_create("pen-transcript", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (memory < 0) {
+        return false;
+    }
+    // Sealed, so the viewer can trust the size it maps
+    if (::ftruncate(memory, off_t(bytes)) != 0
+        || ::fcntl(memory, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0) {
+        ::close(memory);
+        return false;
+    }
+    void *mapped = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, memory, 0);
+    const int wakeup = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (mapped == MAP_FAILED || wakeup < 0) {
+        if (mapped != MAP_FAILED) {
+            ::munmap(mapped, bytes);
+        }
+        if (wakeup >= 0) {
+            ::close(wakeup);
+        }
+        ::close(memory);
+        return false;
+    }
+    TranscriptRingHeader *header = new (mapped) TranscriptRingHeader;
+    header->magic = TranscriptRingHeader::Magic;
+    header->version = TranscriptRingHeader::Version;
+    header->capacity = capacity;
+    header->recordSize = sizeof(TranscriptRecord);
+    header->head.store(0, std::memory_order_relaxed);
+    header->dropped.store(0, std::memory_order_relaxed);
+    header->tail.store(0, std::memory_order_relaxed);
+    header->waiting.store(0, std::memory_order_relaxed);
+
+    uint32_t hello[2] = {TranscriptRingHeader::Magic, TranscriptRingHeader::Version};
+    iovec data = {hello, sizeof(hello)};
+    alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))] = {};
+    msghdr message = {};
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    cmsghdr *rights = CMSG_FIRSTHDR(&message);
+    rights->cmsg_level = SOL_SOCKET;
+    rights->cmsg_type = SCM_RIGHTS;
+    rights->cmsg_len = CMSG_LEN(2 * sizeof(int));
+    const int fds[2] = {memory, wakeup};
+    std::memcpy(CMSG_DATA(rights), fds, sizeof(fds));
+    const bool sent = ::sendmsg(connection, &message, MSG_NOSIGNAL) == ssize_t(sizeof(hello));
+    ::close(memory); // The mappings keep it
+    if (!sent) {
+        ::munmap(mapped, bytes);
+        ::close(wakeup);
+        return false;
+    }
+
+    detach();
+    std::lock_guard<std::mutex> lock(mutex);
+    viewer = connection;
+    eventFd = wakeup;
+    ring = header;
+    viewerConnected.store(true, std::memory_order_relaxed);
+    counters.viewers.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void TranscriptPublisher::detach() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (ring) {
+        ::munmap(ring, TranscriptRingHeader::bytesFor(capacity));
+        ring = nullptr;
+    }
+    for (int *fd : {&viewer, &eventFd}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+    viewerConnected.store(false, std::memory_order_relaxed);
+}
+
+TranscriptRecord *TranscriptPublisher::reserve(size_t count, uint64_t *head) {
+    if (!ring) {
+        return nullptr;
+    }
+    *head = ring->head.load(std::memory_order_relaxed);
+    const uint64_t tail = ring->tail.load(std::memory_order_acquire);
+    // tail comes from the viewer; one that is ahead of head counts as full
+    if (tail > *head || *head - tail + count > capacity) {
+        ring->dropped.fetch_add(count, std::memory_order_relaxed);
+        counters.dropped.fetch_add(count, std::memory_order_relaxed);
+        return nullptr;
+    }
+    return ring->records();
+}
+
+void TranscriptPublisher::commit(uint64_t head) {
+    ring->head.store(head, std::memory_order_release);
+    // Pairs with the fence in TranscriptRingReader::arm()
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (ring->waiting.load(std::memory_order_relaxed) != 0 && ring->waiting.exchange(0) != 0) {
+        const uint64_t one = 1;
+        [[maybe_unused]] const ssize_t n = ::write(eventFd, &one, sizeof(one));
+        counters.wakeups.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void TranscriptPublisher::publishFinal(uint32_t stream, const RecognitionResult &result) {
+    const size_t count = result.words.size();
+    if (count == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    uint64_t head;
+    TranscriptRecord *records = reserve(count, &head);
+    if (!records) {
+        return;
+    }
+    const uint64_t mask = capacity - 1;
+    for (size_t i = 0; i < count; ++i) {
+        const RecognizedWord &word = result.words[i];
+        TranscriptRecord &record = records[(head + i) & mask];
+        fill(record, stream, TranscriptRecord::Final, word.text.data(), word.text.size(), word.startMs, word.endMs,
+             word.confidence);
+        record.flags = uint8_t((i == 0 ? TranscriptRecord::First : 0) | (i + 1 == count ? TranscriptRecord::Last : 0));
+    }
+    commit(head + count);
+    counters.records.fetch_add(count, std::memory_order_relaxed);
+}
+
+void TranscriptPublisher::publishPartial(uint32_t stream, const std::string &text, int64_t audioMs) {
+    // Word boundaries first, so the run is reserved in one go; a longer
+    // hypothesis is shown up to MaxWords
+    const size_t MaxWords = 64;
+    std::pair<size_t, size_t> words[MaxWords];
+    size_t count = 0;
+    for (size_t at = 0; at < text.size() && count < MaxWords;) {
+        const size_t start = text.find_first_not_of(' ', at);
+        if (start == std::string::npos) {
+            break;
+        }
+        const size_t end = std::min(text.find(' ', start), text.size());
+        words[count++] = {start, end - start};
+        at = end;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    uint64_t head;
+    const size_t records = std::max<size_t>(count, 1); // An empty hypothesis is one empty record
+    TranscriptRecord *ringRecords = reserve(records, &head);
+    if (!ringRecords) {
+        return;
+    }
+    const uint64_t mask = capacity - 1;
+    for (size_t i = 0; i < records; ++i) {
+        TranscriptRecord &record = ringRecords[(head + i) & mask];
+        if (count) {
+            fill(record, stream, TranscriptRecord::Partial, text.data() + words[i].first, words[i].second, 0, audioMs,
+                 0);
+        } else {
+            fill(record, stream, TranscriptRecord::Partial, "", 0, 0, audioMs, 0);
+        }
+        record.flags = uint8_t((i == 0 ? TranscriptRecord::First : 0) | (i + 1 == records ? TranscriptRecord::Last : 0));
+    }
+    commit(head + records);
+    counters.records.fetch_add(records, std::memory_order_relaxed);
+}
+
+} // namespace pen
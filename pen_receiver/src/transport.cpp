@@ -0,0 +1,239 @@
+#include "pen/transport.h"
+
+#include "pen/clock.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+namespace pen {
+
+namespace {
+
+void setError(std::string *error, const std::string &message) {
+    if (error) {
+        *error = message;
+    }
+}
+
+std::string systemError(const std::string &what) {
+    return what + ": " + std::strerror(errno);
+}
+
+uint32_t u32le(const unsigned char *p) {
+    return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+}
+
+uint16_t u16le(const unsigned char *p) {
+    return uint16_t(p[0] | p[1] << 8);
+}
+
+} // namespace
+
+FdTransport::FdTransport(StreamFormat format) : streamFormat(format) {
+    if (::pipe2(wakePipe, O_CLOEXEC | O_NONBLOCK) != 0) {
+        wakePipe[0] = wakePipe[1] = -1;
+    }
+}
+
+FdTransport::~FdTransport() {
+    FdTransport::close();
+    for (int end : wakePipe) {
+        if (end >= 0) {
+            ::close(end);
+        }
+    }
+}
+
+bool FdTransport::waitReadable(int descriptor) {
+    pollfd fds[2] = {{descriptor, POLLIN, 0}, {wakePipe[0], POLLIN, 0}};
+    for (;;) {
+        const int ready = ::poll(fds, wakePipe[0] >= 0 ? 2 : 1, -1);
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready < 0 || (fds[1].revents & POLLIN)) {
+            return false;
+        }
+        return true; // Readable, hung up or failed; read() tells which
+    }
+}
+
+ssize_t FdTransport::read(void *buffer, size_t size) {
+    char *out = static_cast<char *>(buffer);
+    size_t done = 0;
+    while (done < size) {
+        if (fd < 0 || !waitReadable(fd)) {
+            return -1;
+        }
+        const ssize_t n = ::read(fd, out + done, size - done);
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN) {
+                continue;
+            }
+            return -1;
+        }
+        if (n == 0) {
+            break; // End of stream; hand out what there is
+        }
+        done += size_t(n);
+    }
+    return ssize_t(done);
+}
+
+void FdTransport::close() {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+void FdTransport::interrupt() {
+    if (wakePipe[1] >= 0) {
+        const char byte = 1;
+        [[maybe_unused]] const ssize_t n = ::write(wakePipe[1], &byte, 1);
+    }
+}
+
+UnixSocketTransport::UnixSocketTransport(const std::string &path, StreamFormat format)
+    : FdTransport(format), path(path) {}
+
+UnixSocketTransport::~UnixSocketTransport() {
+    if (listener >= 0) {
+        ::close(listener);
+        ::unlink(path.c_str());
+    }
+}
+
+bool UnixSocketTransport::open(std::string *error) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        setError(error, "socket path too long: " + path);
+        return false;
+    }
+    std::strcpy(address.sun_path, path.c_str());
+
+    if (listener < 0) {
+        listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (listener < 0) {
+            setError(error, systemError("socket"));
+            return false;
+        }
+        ::unlink(path.c_str()); // Left over from a crash
+        if (::bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0
+            || ::listen(listener, 1) != 0) {
+            setError(error, systemError(path));
+            ::close(listener);
+            listener = -1;
+            return false;
+        }
+    }
+
+    if (!waitReadable(listener)) {
+        setError(error, "interrupted");
+        return false;
+    }
+    fd = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) {
+        setError(error, systemError("accept"));
+        return false;
+    }
+    return true;
+}
+
+bool StdinTransport::open(std::string *) {
+    fd = STDIN_FILENO;
+    return true;
+}
+
+FileReplayTransport::FileReplayTransport(const std::string &path, StreamFormat format, bool realTime)
+    : FdTransport(format), path(path), realTime(realTime) {}
+
+bool FileReplayTransport::open(std::string *error) {
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        setError(error, systemError(path));
+        return false;
+    }
+    if (!readWavHeader(error)) {
+        close();
+        return false;
+    }
+    startNs = nowNs();
+    bytesRead = 0;
+    return true;
+}
+
+// Skips a RIFF/WAVE header if there is one and takes the format from it
+bool FileReplayTransport::readWavHeader(std::string *error) {
+    unsigned char riff[12];
+    if (::pread(fd, riff, sizeof(riff), 0) != ssize_t(sizeof(riff)) || std::memcmp(riff, "RIFF", 4) != 0
+        || std::memcmp(riff + 8, "WAVE", 4) != 0) {
+        return true; // Raw PCM in the configured format
+    }
+
+    off_t at = sizeof(riff);
+    bool haveFormat = false;
+    for (;;) {
+        unsigned char chunk[8];
+        if (::pread(fd, chunk, sizeof(chunk), at) != ssize_t(sizeof(chunk))) {
+            setError(error, path + ": no data chunk");
+            return false;
+        }
+        const uint32_t size = u32le(chunk + 4);
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+            unsigned char fmt[16];
+            if (::pread(fd, fmt, sizeof(fmt), at + 8) != ssize_t(sizeof(fmt))) {
+                setError(error, path + ": truncated header");
+                return false;
+            }
+            if (u16le(fmt) != 1 || u16le(fmt + 14) != 16) {
+                setError(error, path + ": only 16-bit PCM WAV is supported");
+                return false;
+            }
+            streamFormat.channels = u16le(fmt + 2);
+            streamFormat.sampleRate = u32le(fmt + 4);
+            haveFormat = true;
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            if (!haveFormat) {
+                setError(error, path + ": data before format");
+                return false;
+            }
+            dataBytes = size;
+            return ::lseek(fd, at + 8, SEEK_SET) >= 0;
+        }
+        at += 8 + size + (size & 1);
+    }
+}
+
+ssize_t FileReplayTransport::read(void *buffer, size_t size) {
+    if (dataBytes > 0) {
+        size = size_t(std::min<uint64_t>(size, dataBytes - std::min(bytesRead, dataBytes)));
+        if (size == 0) {
+            return 0;
+        }
+    }
+    if (realTime) {
+        // Release the block when the pen would have finished sending it
+        const uint64_t bytesPerSecond = uint64_t(streamFormat.sampleRate) * streamFormat.channels * 2;
+        const int64_t due = startNs + int64_t((bytesRead + size) * 1000000000ull / bytesPerSecond);
+        const int64_t wait = due - nowNs();
+        if (wait > 0) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(wait));
+        }
+    }
+    const ssize_t n = FdTransport::read(buffer, size);
+    if (n > 0) {
+        bytesRead += uint64_t(n);
+    }
+    return n;
+}
+
+} // namespace pen
@@ -0,0 +1,145 @@
+#include "pen/vad.h"
+
+#include "simd.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace pen {
+
+namespace {
+
+const double SilenceDb = -120; // For blocks of digital zero
+
+double levelDb(uint64_t energy, size_t count) {
+    if (energy == 0 || count == 0) {
+        return SilenceDb;
+    }
+    return 10 * std::log10(double(energy) / double(count) / (32768.0 * 32768.0));
+}
+
+// The detector works at whatever rate the recognizer takes
+VoiceActivityDetector::Options atRate(VoiceActivityDetector::Options options, int sampleRate) {
+    options.sampleRate = sampleRate;
+    return options;
+}
+
+} // namespace
+
+VoiceActivityDetector::VoiceActivityDetector(Options options) : options(options), floorDb(options.minimumDb) {}
+
+bool VoiceActivityDetector::process(const int16_t *samples, size_t count) {
+    const FrameFeatures features = simdKernels().frameFeatures(samples, count);
+    const double db = levelDb(features.energy, count);
+    const double crossingRate = count > 1 ? double(features.crossings) / double(count - 1) : 0;
+
+    const bool speech = db > std::max(floorDb + options.marginDb, options.minimumDb)
+                        && crossingRate < options.maxCrossingRate;
+    // The floor drops at once to anything quieter and creeps up otherwise,
+    // so speech barely moves it while a louder room lifts it in seconds
+    const double seconds = double(count) / options.sampleRate;
+    floorDb = std::max(SilenceDb, std::min(db, floorDb + options.floorRiseDbPerSecond * seconds));
+
+    if (speech) {
+        hangoverLeft = int64_t(options.sampleRate) * options.hangoverMs / 1000 + int64_t(count);
+    }
+    if (hangoverLeft <= 0) {
+        return false;
+    }
+    hangoverLeft -= int64_t(count);
+    return true;
+}
+
+const char *VoiceActivityDetector::kernelName() {
+    return simdKernels().name;
+}
+
+GatedRecognizer::GatedRecognizer(std::unique_ptr<Recognizer> recognizer, Options gateOptions)
+    : inner(std::move(recognizer)), options(gateOptions), detector(atRate(options.vad, inner->sampleRate())) {
+    options.vad.sampleRate = inner->sampleRate();
+    segments.reserve(64);
+    segments.push_back({0, 0});
+}
+
+bool GatedRecognizer::acceptPcm(const int16_t *samples, size_t count) {
+    const bool wasSpeaking = speaking;
+    speaking = detector.process(samples, count);
+    bool pass = speaking;
+    if (pass) {
+        gatedRun = 0;
+        counters.blocksPassed.fetch_add(1, std::memory_order_relaxed);
+    } else if (options.keepOneIn > 0 && ++gatedRun % uint64_t(options.keepOneIn) == 0) {
+        pass = true;
+        counters.blocksDecimated.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (!pass) {
+        passing = false;
+        streamSamples += count;
+        counters.blocksGated.fetch_add(1, std::memory_order_relaxed);
+        counters.samplesGated.fetch_add(count, std::memory_order_relaxed);
+        // Speech just ended: close the utterance instead of waiting for
+        // silence the recognizer will never be shown
+        return wasSpeaking && inner->finish();
+    }
+
+    if (!passing && streamSamples - segments.back().stream != fedSamples - segments.back().fed) {
+        segments.push_back({fedSamples, streamSamples});
+    }
+    passing = true;
+    fedSamples += count;
+    streamSamples += count;
+    counters.samplesPassed.fetch_add(count, std::memory_order_relaxed);
+    return inner->acceptPcm(samples, count);
+}
+
+bool GatedRecognizer::takeFinal(RecognitionResult *result) {
+    if (!inner->takeFinal(result)) {
+        return false;
+    }
+    int64_t lastFedMs = 0;
+    for (RecognizedWord &word : result->words) {
+        lastFedMs = std::max(lastFedMs, word.endMs);
+        word.startMs = toStreamMs(word.startMs);
+        word.endMs = toStreamMs(word.endMs);
+    }
+    // Later results start after this one, so segments before the one
+    // holding its end are done with
+    const uint64_t lastFed = uint64_t(lastFedMs) * uint64_t(sampleRate()) / 1000;
+    const auto next = std::upper_bound(segments.begin(), segments.end(), lastFed,
+                                       [](uint64_t fed, const Segment &segment) { return fed < segment.fed; });
+    if (next - segments.begin() > 1) {
+        segments.erase(segments.begin(), next - 1);
+    }
+    return true;
+}
+
+void GatedRecognizer::reset() {
+    inner->reset();
+    detector = VoiceActivityDetector(options.vad);
+    fedSamples = 0;
+    streamSamples = 0;
+    gatedRun = 0;
+    passing = false;
+    speaking = false;
+    segments.assign(1, {0, 0});
+}
+
+double GatedRecognizer::gatedFraction() const {
+    const uint64_t gated = counters.samplesGated.load();
+    const uint64_t total = gated + counters.samplesPassed.load();
+    return total > 0 ? double(gated) / double(total) : 0;
+}
+
+int64_t GatedRecognizer::toStreamMs(int64_t fedMs) const {
+    const uint64_t rate = uint64_t(sampleRate());
+    const uint64_t fed = uint64_t(std::max<int64_t>(0, fedMs)) * rate / 1000;
+    auto segment = std::upper_bound(segments.begin(), segments.end(), fed,
+                                    [](uint64_t value, const Segment &candidate) { return value < candidate.fed; });
+    if (segment != segments.begin()) {
+        --segment;
+    }
+    return int64_t((segment->stream + (fed - std::min(fed, segment->fed))) * 1000 / rate);
+}
+
+} // namespace pen
@@ -0,0 +1,289 @@
+#include "pen/voskengine.h"
+
+#include <vosk_api.h>
+
+#include <cstdlib>
+#include <cstring>
+
+namespace pen {
+
+namespace {
+
+// Just enough JSON for what VOSK returns: objects, arrays, strings and
+// numbers. Values are picked out by key while skipping everything else.
+class JsonScanner {
+public:
+    explicit JsonScanner(const char *text) : at(text) {}
+
+    bool objectBegin() { return consume('{'); }
+    bool arrayBegin() { return consume('['); }
+    // After a value: true and past the comma if another member follows
+    bool more(char close) {
+        skipSpace();
+        if (*at == ',') {
+            ++at;
+            return true;
+        }
+        if (*at == close) {
+            ++at;
+        }
+        return false;
+    }
+    bool empty(char close) {
+        skipSpace();
+        if (*at == close) {
+            ++at;
+            return true;
+        }
+        return false;
+    }
+
+    bool key(std::string *name) { return string(name) && consume(':'); }
+
+    bool string(std::string *value) {
+        if (!consume('"')) {
+            return false;
+        }
+        value->clear();
+        for (; *at && *at != '"'; ++at) {
+            if (*at == '\\' && at[1]) {
+                ++at;
+                switch (*at) {
+                case 'n':
+                    *value += '\n';
+                    break;
+                case 't':
+                    *value += '\t';
+                    break;
+                default:
+                    *value += *at; // \" \\ \/; VOSK writes other text as raw UTF-8
+                }
+            } else {
+                *value += *at;
+            }
+        }
+        return consume('"');
+    }
+
+    bool number(double *value) {
+        skipSpace();
+        char *end;
+        *value = std::strtod(at, &end);
+        if (end == at) {
+            return false;
+        }
+        at = end;
+        return true;
+    }
+
+    bool skipValue() {
+        skipSpace();
+        if (*at == '"') {
+            std::string ignored;
+            return string(&ignored);
+        }
+        if (*at == '{' || *at == '[') {
+            const char close = *at == '{' ? '}' : ']';
+            ++at;
+            if (empty(close)) {
+                return true;
+            }
+            do {
+                if (close == '}') {
+                    std::string ignored;
+                    if (!key(&ignored)) {
+                        return false;
+                    }
+                }
+                if (!skipValue()) {
+                    return false;
+                }
+            } while (more(close));
+            return true;
+        }
+        // Number, true, false or null
+        const char *start = at;
+        while (*at && !std::strchr(",}] \t\r\n", *at)) {
+            ++at;
+        }
+        return at != start;
+    }
+
+private:
+    void skipSpace() {
+        while (*at == ' ' || *at == '\t' || *at == '\r' || *at == '\n') {
+            ++at;
+        }
+    }
+    bool consume(char c) {
+        skipSpace();
+        if (*at != c) {
+            return false;
+        }
+        ++at;
+        return true;
+    }
+
+    const char *at;
+};
+
+// {"result": [{"conf": 1.0, "end": 1.11, "start": 0.87, "word": "what"}, ...], "text": "what"}
+bool parseResult(const char *json, RecognitionResult *result) {
+    JsonScanner scanner(json);
+    std::string name;
+    if (!scanner.objectBegin()) {
+        return false;
+    }
+    if (scanner.empty('}')) {
+        return true;
+    }
+    do {
+        if (!scanner.key(&name)) {
+            return false;
+        }
+        if (name != "result") {
+            if (!scanner.skipValue()) {
+                return false;
+            }
+            continue;
+        }
+        if (!scanner.arrayBegin()) {
+            return false;
+        }
+        if (scanner.empty(']')) {
+            continue;
+        }
+        do {
+            RecognizedWord word = {std::string(), 0, 0, 1.0f};
+            if (!scanner.objectBegin()) {
+                return false;
+            }
+            do {
+                double number;
+                if (!scanner.key(&name)) {
+                    return false;
+                }
+                if (name == "word") {
+                    if (!scanner.string(&word.text)) {
+                        return false;
+                    }
+                } else if (name == "start" || name == "end" || name == "conf") {
+                    if (!scanner.number(&number)) {
+                        return false;
+                    }
+                    if (name == "start") {
+                        word.startMs = int64_t(number * 1000 + 0.5);
+                    } else if (name == "end") {
+                        word.endMs = int64_t(number * 1000 + 0.5);
+                    } else {
+                        word.confidence = float(number);
+                    }
+                } else if (!scanner.skipValue()) {
+                    return false;
+                }
+            } while (scanner.more('}'));
+            if (!word.text.empty()) {
+                result->words.push_back(std::move(word));
+            }
+        } while (scanner.more(']'));
+    } while (scanner.more('}'));
+    return true;
+}
+
+// {"partial": "what zero"}
+std::string parsePartial(const char *json) {
+    JsonScanner scanner(json);
+    std::string name;
+    std::string text;
+    if (!scanner.objectBegin() || scanner.empty('}')) {
+        return text;
+    }
+    do {
+        if (!scanner.key(&name)) {
+            break;
+        }
+        if (name == "partial" ? !scanner.string(&text) : !scanner.skipValue()) {
+            break;
+        }
+    } while (scanner.more('}'));
+    return text;
+}
+
+} // namespace
+
+std::shared_ptr<VoskSharedModel> VoskSharedModel::load(const std::string &modelPath, int sampleRate,
+                                                       std::string *error) {
+    vosk_set_log_level(-1);
+    VoskModel *model = vosk_model_new(modelPath.c_str());
+    if (!model) {
+        *error = "cannot load VOSK model from " + modelPath;
+        return nullptr;
+    }
+    return std::shared_ptr<VoskSharedModel>(new VoskSharedModel(model, sampleRate));
+}
+
+VoskSharedModel::VoskSharedModel(VoskModel *model, int sampleRate) : model(model), rate(sampleRate) {}
+
+VoskSharedModel::~VoskSharedModel() {
+    vosk_model_free(model);
+}
+
+std::unique_ptr<Recognizer> VoskSharedModel::createSession(std::string *error) {
+    VoskRecognizer *recognizer = vosk_recognizer_new(model, float(rate));
+    if (!recognizer) {
+        *error = "cannot create a VOSK recognizer at " + std::to_string(rate) + " Hz";
+        return nullptr;
+    }
+    vosk_recognizer_set_words(recognizer, 1);
+    return std::unique_ptr<Recognizer>(new VoskEngine(shared_from_this(), recognizer, rate));
+}
+
+VoskEngine::VoskEngine(std::shared_ptr<const VoskSharedModel> model, VoskRecognizer *recognizer, int sampleRate)
+    : model(std::move(model)), recognizer(recognizer), rate(sampleRate) {}
+
+VoskEngine::~VoskEngine() {
+    vosk_recognizer_free(recognizer);
+}
+
+bool VoskEngine::acceptPcm(const int16_t *samples, size_t count) {
+    if (vosk_recognizer_accept_waveform_s(recognizer, samples, int(count)) != 1) {
+        return false;
+    }
+    return completeWith(vosk_recognizer_result(recognizer));
+}
+
+std::string VoskEngine::partial() {
+    return parsePartial(vosk_recognizer_partial_result(recognizer));
+}
+
+bool VoskEngine::takeFinal(RecognitionResult *result) {
+    if (!hasCompleted) {
+        return false;
+    }
+    result->words.swap(completed.words);
+    completed.words.clear();
+    hasCompleted = false;
+    return true;
+}
+
+bool VoskEngine::finish() {
+    return completeWith(vosk_recognizer_final_result(recognizer));
+}
+
+void VoskEngine::reset() {
+    vosk_recognizer_reset(recognizer);
+    completed.words.clear();
+    hasCompleted = false;
+}
+
+// Silence also ends an utterance, with no words; that is not a result
+bool VoskEngine::completeWith(const char *json) {
+    const size_t before = completed.words.size();
+    if (!parseResult(json, &completed) || completed.words.size() == before) {
+        return false;
+    }
+    hasCompleted = true;
+    return true;
+}
+
+} // namespace pen
@@ -0,0 +1,703 @@
+// pen-receiverd: receives pen PCM streams and transcribes them.
+//
+//   pen-receiverd --unix /run/pen.sock --engine vosk:/opt/vosk-model-small-en-us
+//   pen-receiverd --replay lecture.wav --realtime --engine fake:cost=0.3
+//   bluealsa-aplay --pcm=- ... | pen-receiverd --stdin
+//   pen-receiverd --hub 4 --streams 30 --unix /run/pen.sock
+//   pen-receiverd --hub 4 --streams 30 --replay lecture.wav --realtime --engine fake:cost=0.1
+//   pen-receiverd --unix /run/pen.sock --publish $XDG_RUNTIME_DIR/pen-transcript.sock
+//   pen-receiverd --hub 0 --streams 30 --unix /run/pen.sock --record class.trace
+
+#include "pen/clock.h"
+#include "pen/hub.h"
+#include "pen/receiver.h"
+#include "pen/recognizer.h"
+#include "pen/recognizerpool.h"
+#include "pen/resampler.h"
+#include "pen/trace.h"
+#include "pen/transcriptpublisher.h"
+#include "pen/transport.h"
+#include "pen/vad.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::atomic<bool> interrupted{false};
+
+void onSignal(int) {
+    interrupted.store(true);
+}
+
+struct Settings {
+    std::string unixPath;
+    std::string replayPath;
+    std::string publishPath;
+    std::string recordPath;
+    bool useStdin = false;
+    bool realTime = false;
+    bool printPartials = false;
+    std::string engine = "fake";
+    double statsInterval = 0;
+    int hubWorkers = -1; // -1: single-stream mode; 0: one worker per core
+    int streams = 1;
+    int gateKeepOneIn = -1; // -1: no VAD
+    int modelRate = 16000;
+    int warmSessions = 2;
+    pen::StreamFormat format;
+    pen::Receiver::Options options;
+};
+
+// Meters the stream and runs it through the recognizer, if there is one,
+// downmixed and resampled to the model rate. Final results go to stdout as
+// JSON lines, counters to stderr. In hub mode each line carries the stream
+// number. With a publisher, finals and partials also go to the viewer's
+// transcript ring. The recognizer session comes from the pool when the pen
+// connects and goes back to it when the stream ends.
+class SpeechSink : public pen::FrameSink {
+public:
+    SpeechSink(const Settings &settings, pen::RecognizerPool *pool, pen::TranscriptPublisher *publisher,
+               int stream = -1)
+        : pool(pool),
+          publisher(publisher),
+          printPartials(settings.printPartials),
+          gateKeepOneIn(settings.gateKeepOneIn),
+          modelRate(settings.modelRate),
+          stream(stream) {}
+
+    bool streamStarted(pen::StreamFormat format, std::string *error) override {
+        connectNs.store(pen::nowNs());
+        sampleRate = format.sampleRate;
+        if (pool) {
+            recognizer = pool->acquire(error);
+            if (!recognizer) {
+                return false;
+            }
+            const size_t maxFrames = pen::PcmFrame::MaxSamples / format.channels;
+            resampler.reset(new pen::Resampler(int(format.sampleRate), modelRate, format.channels, maxFrames));
+            mono.resize(resampler->outputCapacity(maxFrames));
+            if (gateKeepOneIn >= 0) {
+                pen::GatedRecognizer::Options gateOptions;
+                gateOptions.keepOneIn = gateKeepOneIn;
+                gate = new pen::GatedRecognizer(std::move(recognizer), gateOptions);
+                recognizer.reset(gate);
+            }
+            result.words.reserve(64);
+        }
+        readyNs.store(pen::nowNs());
+        return true;
+    }
+
+    void consume(const pen::PcmFrame &frame) override {
+        const int count = frame.frames * frame.channels;
+        for (int i = 0; i < count; ++i) {
+            const int32_t sample = frame.samples[i];
+            sumSquares += double(sample) * sample;
+            peak = std::max(peak, sample < 0 ? -sample : sample);
+        }
+        samples += uint64_t(count);
+        audioNs.fetch_add(int64_t(frame.frames) * 1000000000 / sampleRate, std::memory_order_relaxed);
+
+        if (recognizer) {
+            const int64_t start = pen::nowNs();
+            const size_t converted = resampler->process(frame.samples, frame.frames, mono.data());
+            const int64_t resampled = pen::nowNs();
+            const bool completed = recognizer->acceptPcm(mono.data(), converted);
+            resampleNs.fetch_add(resampled - start, std::memory_order_relaxed);
+            computeNs.fetch_add(pen::nowNs() - resampled, std::memory_order_relaxed);
+            if (completed) {
+                noteFirstWords();
+                printFinal();
+            } else if (printPartials || publisher || firstWordsNs.load(std::memory_order_relaxed) == 0) {
+                const std::string text = recognizer->partial();
+                if (text != lastPartial) {
+                    lastPartial = text;
+                    if (!text.empty()) {
+                        noteFirstWords();
+                    }
+                    if (publisher) {
+                        publisher->publishPartial(publishedStream(), text, audioNs.load() / 1000000);
+                    }
+                    if (printPartials) {
+                        line = "{" + streamField() + "\"partial\":\"" + escaped(text) + "\"}\n";
+                        writeLine();
+                    }
+                }
+            }
+        }
+        const int64_t delay = pen::nowNs() - frame.arrivalNs;
+        maxDelayNs.store(std::max(maxDelayNs.load(std::memory_order_relaxed), delay), std::memory_order_relaxed);
+    }
+
+    void endOfStream() override {
+        if (recognizer && recognizer->finish()) {
+            printFinal();
+        }
+        // The gate stays, for its counters
+        if (gate) {
+            pool->release(gate->releaseInner());
+        } else if (recognizer) {
+            pool->release(std::move(recognizer));
+        }
+        std::fflush(stdout);
+        ended.store(true);
+    }
+
+    double rmsDbfs() const {
+        if (samples == 0 || sumSquares == 0) {
+            return -INFINITY;
+        }
+        return 20 * std::log10(std::sqrt(sumSquares / double(samples)) / 32768.0);
+    }
+    double peakDbfs() const { return peak == 0 ? -INFINITY : 20 * std::log10(peak / 32768.0); }
+    // Recognizer time per second of audio
+    double realTimeFactor() const {
+        const int64_t audio = audioNs.load();
+        return audio > 0 ? double(computeNs.load()) / double(audio) : 0;
+    }
+    // Downmix and resampling time per hour of audio
+    double resampleSecondsPerHour() const {
+        const int64_t audio = audioNs.load();
+        return audio > 0 ? double(resampleNs.load()) / double(audio) * 3600 : 0;
+    }
+    bool recognizing() const { return pool != nullptr; }
+    // Connect to a recognizer session being ready for the stream
+    double startupMs() const { return (readyNs.load() - connectNs.load()) / 1e6; }
+    // Connect to the first partial result, less the audio it took to say
+    // it: how long the pen's user waits beyond their own speech. Only
+    // meaningful for a live stream; -1 before there are any words.
+    double firstWordsLatencyMs() const {
+        const int64_t words = firstWordsNs.load();
+        return words == 0 ? -1 : (words - connectNs.load() - firstWordsAudioNs.load()) / 1e6;
+    }
+    const pen::GatedRecognizer *voiceGate() const { return gate; }
+
+    std::atomic<int64_t> maxDelayNs{0}; // Ring arrival to consume()
+    std::atomic<uint64_t> finals{0};
+    std::atomic<uint64_t> words{0};
+    std::atomic<bool> ended{false};
+
+private:
+    // A JSON string body: quotes, backslashes and every control character
+    // escaped, so a recognizer's output can never break the line
+    static std::string escaped(const std::string &text) {
+        static const char hex[] = "0123456789abcdef";
+        std::string out;
+        for (const char c : text) {
+            const unsigned char u = static_cast<unsigned char>(c);
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += c;
+            } else if (u < 0x20) {
+                out += "\\u00";
+                out += hex[u >> 4];
+                out += hex[u & 0xf];
+            } else {
+                out += c;
+            }
+        }
+        return out;
+    }
+
+    std::string streamField() const {
+        return stream < 0 ? std::string() : "\"stream\":" + std::to_string(stream) + ",";
+    }
+
+    void noteFirstWords() {
+        if (firstWordsNs.load(std::memory_order_relaxed) == 0) {
+            firstWordsAudioNs.store(audioNs.load());
+            firstWordsNs.store(pen::nowNs());
+        }
+    }
+
+    uint32_t publishedStream() const { return stream < 0 ? 0 : uint32_t(stream); }
+
+    // One write per line, so that lines from hub workers do not interleave
+    void writeLine() {
+        std::fwrite(line.data(), 1, line.size(), stdout);
+        std::fflush(stdout);
+    }
+
+    void printFinal() {
+        if (!recognizer->takeFinal(&result)) {
+            return;
+        }
+        if (publisher) {
+            publisher->publishFinal(publishedStream(), result);
+        }
+        line = "{" + streamField() + "\"text\":\"" + escaped(result.text()) + "\",\"words\":[";
+        for (size_t i = 0; i < result.words.size(); ++i) {
+            const pen::RecognizedWord &word = result.words[i];
+            char times[96];
+            std::snprintf(times, sizeof(times), "\",\"start\":%lld,\"end\":%lld,\"conf\":%.3f}",
+                          (long long)word.startMs, (long long)word.endMs, word.confidence);
+            line += (i ? ",{\"word\":\"" : "{\"word\":\"") + escaped(word.text) + times;
+        }
+        line += "]}\n";
+        writeLine();
+        finals.fetch_add(1, std::memory_order_relaxed);
+        words.fetch_add(result.words.size(), std::memory_order_relaxed);
+        lastPartial.clear();
+    }
+
+    pen::RecognizerPool *pool; // Null without a recognizer
+    pen::TranscriptPublisher *publisher;
+    bool printPartials;
+    int gateKeepOneIn;
+    int modelRate;
+    int stream;
+    uint32_t sampleRate = 0;
+    std::unique_ptr<pen::Resampler> resampler;
+    std::unique_ptr<pen::Recognizer> recognizer;
+    pen::GatedRecognizer *gate = nullptr; // Owned through recognizer
+    pen::RecognitionResult result;
+    std::string lastPartial;
+    std::string line;
+    std::vector<int16_t> mono; // Resampler output, sized once
+
+    std::atomic<int64_t> audioNs{0};
+    std::atomic<int64_t> computeNs{0};
+    std::atomic<int64_t> resampleNs{0};
+    std::atomic<int64_t> connectNs{0};
+    std::atomic<int64_t> readyNs{0};
+    std::atomic<int64_t> firstWordsNs{0};
+    std::atomic<int64_t> firstWordsAudioNs{0};
+    double sumSquares = 0;
+    int32_t peak = 0;
+    uint64_t samples = 0;
+};
+
+void printStats(const pen::Receiver &receiver, const SpeechSink &sink, double seconds) {
+    const pen::ReceiverStats &stats = receiver.stats();
+    std::fprintf(stderr,
+                 "%.1fs: %llu frames in, %llu decoded, %llu bytes, %llu overruns, %llu underruns, "
+                 "queue %zu (max %llu), max delay %.2f ms",
+                 seconds, (unsigned long long)stats.framesReceived.load(),
+                 (unsigned long long)stats.framesDecoded.load(), (unsigned long long)stats.bytesReceived.load(),
+                 (unsigned long long)stats.overruns.load(), (unsigned long long)stats.underruns.load(),
+                 receiver.queued(), (unsigned long long)stats.maxQueued.load(), sink.maxDelayNs.load() / 1e6);
+    if (sink.recognizing()) {
+        std::fprintf(stderr, ", %llu results, %llu words, RTF %.3f, resampling %.2f s/h",
+                     (unsigned long long)sink.finals.load(), (unsigned long long)sink.words.load(),
+                     sink.realTimeFactor(), sink.resampleSecondsPerHour());
+    }
+    if (const pen::GatedRecognizer *gate = sink.voiceGate()) {
+        const pen::GatedRecognizer::Stats &gateStats = gate->stats();
+        std::fprintf(stderr, ", VAD %llu passed, %llu gated, %llu decimated (%.0f%% of audio gated)",
+                     (unsigned long long)gateStats.blocksPassed.load(), (unsigned long long)gateStats.blocksGated.load(),
+                     (unsigned long long)gateStats.blocksDecimated.load(), gate->gatedFraction() * 100);
+    }
+    std::fprintf(stderr, "\n");
+}
+
+void printChannelStats(const pen::TranscriptPublisher *publisher) {
+    if (!publisher) {
+        return;
+    }
+    const pen::TranscriptPublisher::Stats &stats = publisher->stats();
+    std::fprintf(stderr, "Transcript channel: %llu records, %llu wakeups, %llu dropped, %llu viewer(s)\n",
+                 (unsigned long long)stats.records.load(), (unsigned long long)stats.wakeups.load(),
+                 (unsigned long long)stats.dropped.load(), (unsigned long long)stats.viewers.load());
+}
+
+void printPoolStats(const pen::RecognizerPool *pool) {
+    if (!pool) {
+        return;
+    }
+    const pen::RecognizerPool::Stats &stats = pool->stats();
+    const uint64_t created = stats.created.load();
+    std::fprintf(stderr, "Sessions: %llu warm, %llu cold, %llu created (%.1f ms each)\n",
+                 (unsigned long long)stats.hits.load(), (unsigned long long)stats.misses.load(),
+                 (unsigned long long)created, created ? stats.createNs.load() / 1e6 / double(created) : 0.0);
+}
+
+// Nearest rank; values is sorted
+double percentile(const std::vector<double> &values, double p) {
+    const size_t rank = size_t(std::ceil(p / 100 * double(values.size())));
+    return values[std::min(values.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+// Time to first words is what a pen's user notices after pressing the
+// button; it should stay within a fifth of a second
+const double FirstWordsTargetMs = 200;
+
+void usage(const char *program) {
+    std::fprintf(stderr,
+                 "Usage: %s (--unix PATH | --replay FILE | --stdin) [options]\n"
+                 "  --rate HZ         sample rate of raw input (default 44100)\n"
+                 "  --channels N      channels of raw input (default 2)\n"
+                 "  --frame-ms MS     frame length (default 10)\n"
+                 "  --ring FRAMES     ring capacity (default 64)\n"
+                 "  --realtime        pace --replay at the recorded rate\n"
+                 "  --stats SECONDS   print counters periodically (default 0: only at the end)\n"
+                 "  --engine SPEC     none, fake[:rate=,word-ms=,utterance=,cost=,load=,session=,\n"
+                 "                    model=,script=]"
+#ifdef PEN_HAVE_VOSK
+                 " or vosk:MODEL_DIR"
+#endif
+                 " (default fake)\n"
+                 "  --partials        also print partial results\n"
+                 "  --model-rate HZ   recognizer input rate (default 16000)\n"
+                 "  --warm N          recognizer sessions kept ready for pens that connect\n"
+                 "                    (default 2)\n"
+                 "  --vad             drop non-speech ahead of the recognizer\n"
+                 "  --vad-keep N      with --vad, still pass one in N non-speech frames\n"
+                 "  --publish PATH    serve the transcript to a viewer (Notes) through shared\n"
+                 "                    memory; viewers connect to the UNIX socket PATH\n"
+                 "  --record FILE     write every frame as it arrives, with link events, to a\n"
+                 "                    trace for pen-replay\n"
+                 "Classroom hub:\n"
+                 "  --hub WORKERS     decode on a pool of WORKERS threads (0: one per core)\n"
+                 "  --streams N       number of pens: sockets PATH.0 ... PATH.N-1, or N\n"
+                 "                    replays of FILE for load testing\n",
+                 program);
+}
+
+// stream is -1 outside hub mode
+pen::Transport *createTransport(const Settings &settings, int stream) {
+    if (!settings.unixPath.empty()) {
+        const std::string path = stream < 0 ? settings.unixPath : settings.unixPath + "." + std::to_string(stream);
+        return new pen::UnixSocketTransport(path, settings.format);
+    }
+    if (!settings.replayPath.empty()) {
+        return new pen::FileReplayTransport(settings.replayPath, settings.format, settings.realTime);
+    }
+    return new pen::StdinTransport(settings.format);
+}
+
+void printTraceStats(const pen::TraceWriter *writer) {
+    if (!writer) {
+        return;
+    }
+    const pen::TraceWriter::Stats &stats = writer->stats();
+    std::fprintf(stderr, "Trace %s: %llu frames, %llu events, %.1f MB\n", writer->path().c_str(),
+                 (unsigned long long)stats.frames.load(), (unsigned long long)stats.events.load(),
+                 stats.bytes.load() / 1e6);
+}
+
+int runSingle(const Settings &settings, pen::RecognizerPool *pool, pen::TranscriptPublisher *publisher,
+              pen::TraceWriter *writer) {
+    std::unique_ptr<pen::Transport> transport(createTransport(settings, -1));
+    SpeechSink sink(settings, pool, publisher);
+    std::unique_ptr<pen::TraceRecorder> recorder;
+    if (writer) {
+        recorder.reset(new pen::TraceRecorder(*writer, 0, sink));
+    }
+    pen::Receiver receiver(*transport, recorder ? static_cast<pen::FrameSink &>(*recorder) : sink,
+                           settings.options);
+    // open() may block waiting for a peer; let a signal get it out of there
+    std::thread watcher([&] {
+        while (!interrupted.load() && !sink.ended.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        receiver.stop();
+    });
+
+    std::fprintf(stderr, "Waiting for %s\n", transport->describe().c_str());
+    std::string error;
+    if (!receiver.start(&error)) {
+        const bool cancelled = interrupted.exchange(true);
+        watcher.join();
+        if (cancelled) {
+            return 0;
+        }
+        std::fprintf(stderr, "%s: %s\n", transport->describe().c_str(), error.c_str());
+        return 1;
+    }
+    const pen::StreamFormat format = transport->format(); // A WAV header may have changed it
+    std::fprintf(stderr, "Receiving %u Hz, %u channel(s), %d ms frames\n", format.sampleRate,
+                 unsigned(format.channels), settings.options.frameMs);
+    if (settings.engine != "none") {
+        std::fprintf(stderr, "Recognizer input %d Hz mono, %s kernels\n", settings.modelRate,
+                     pen::Resampler::kernelName());
+    }
+
+    const int64_t started = pen::nowNs();
+    int64_t nextReport = started + int64_t(settings.statsInterval * 1e9);
+    while (receiver.running()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        if (settings.statsInterval > 0 && pen::nowNs() >= nextReport) {
+            printStats(receiver, sink, (pen::nowNs() - started) / 1e9);
+            nextReport += int64_t(settings.statsInterval * 1e9);
+        }
+    }
+    receiver.wait();
+    watcher.join();
+
+    printStats(receiver, sink, (pen::nowNs() - started) / 1e9);
+    std::fprintf(stderr, "Level: %.1f dBFS RMS, %.1f dBFS peak\n", sink.rmsDbfs(), sink.peakDbfs());
+    if (sink.recognizing()) {
+        std::fprintf(stderr, "Session ready %.1f ms after connect", sink.startupMs());
+        if (transport->live() && sink.firstWordsLatencyMs() >= 0) {
+            std::fprintf(stderr, ", first partial %.0f ms after its audio (target %.0f ms)", sink.firstWordsLatencyMs(),
+                         FirstWordsTargetMs);
+        }
+        std::fprintf(stderr, "\n");
+    }
+    printPoolStats(pool);
+    printChannelStats(publisher);
+    printTraceStats(writer);
+    return 0;
+}
+
+// Every stream on one Hub. A live stream keeps up when nothing was dropped
+// and no frame waited longer than half the ring before it was decoded; a
+// replay that is not paced cannot fall behind, so it is not judged.
+int runHub(const Settings &settings, pen::RecognizerPool *pool, pen::TranscriptPublisher *publisher,
+           pen::TraceWriter *writer) {
+    pen::Hub::Options hubOptions;
+    if (settings.hubWorkers > 0) {
+        hubOptions.workers = settings.hubWorkers;
+    }
+    // Declared before the hub, which uses them until it is gone
+    std::vector<std::unique_ptr<pen::Transport>> transports;
+    std::vector<std::unique_ptr<SpeechSink>> sinks;
+    std::vector<std::unique_ptr<pen::TraceRecorder>> recorders;
+    pen::Hub hub(hubOptions);
+    for (int i = 0; i < settings.streams; ++i) {
+        transports.emplace_back(createTransport(settings, i));
+        sinks.emplace_back(new SpeechSink(settings, pool, publisher, i));
+        if (writer) {
+            recorders.emplace_back(new pen::TraceRecorder(*writer, uint16_t(i), *sinks.back()));
+            hub.addStream(*transports.back(), *recorders.back(), settings.options);
+        } else {
+            hub.addStream(*transports.back(), *sinks.back(), settings.options);
+        }
+    }
+    std::fprintf(stderr, "Hub: %d stream(s) on %d worker(s)\n", settings.streams, hub.workerCount());
+    if (settings.engine != "none") {
+        std::fprintf(stderr, "Recognizer input %d Hz mono, %s kernels\n", settings.modelRate,
+                     pen::Resampler::kernelName());
+    }
+
+    // Sockets block in start() until their pen connects
+    std::atomic<int> failed{0};
+    std::atomic<int> settled{0}; // Started or failed
+    std::vector<std::thread> starters;
+    for (int i = 0; i < settings.streams; ++i) {
+        starters.emplace_back([&, i] {
+            std::string error;
+            if (!hub.receiver(i).start(&error)) {
+                if (!interrupted.load()) {
+                    std::fprintf(stderr, "%s: %s\n", transports[size_t(i)]->describe().c_str(), error.c_str());
+                }
+                failed.fetch_add(1);
+            }
+            settled.fetch_add(1);
+        });
+    }
+
+    const auto allEnded = [&] {
+        for (int i = 0; i < settings.streams; ++i) {
+            if (hub.receiver(i).running()) {
+                return false;
+            }
+        }
+        return true;
+    };
+    const int64_t started = pen::nowNs();
+    int64_t nextReport = started + int64_t(settings.statsInterval * 1e9);
+    bool stopped = false;
+    while (settled.load() < settings.streams || !allEnded()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        if (interrupted.load() && !stopped) {
+            for (int i = 0; i < settings.streams; ++i) {
+                hub.receiver(i).stop();
+            }
+            stopped = true;
+        }
+        if (settings.statsInterval > 0 && pen::nowNs() >= nextReport) {
+            uint64_t frames = 0;
+            uint64_t overruns = 0;
+            for (int i = 0; i < settings.streams; ++i) {
+                frames += hub.receiver(i).stats().framesDecoded.load();
+                overruns += hub.receiver(i).stats().overruns.load();
+            }
+            std::fprintf(stderr, "%.1fs: %llu frames decoded, %llu overruns\n", (pen::nowNs() - started) / 1e9,
+                         (unsigned long long)frames, (unsigned long long)overruns);
+            nextReport += int64_t(settings.statsInterval * 1e9);
+        }
+    }
+    for (std::thread &starter : starters) {
+        starter.join();
+    }
+    for (int i = 0; i < settings.streams; ++i) {
+        hub.receiver(i).wait();
+    }
+    hub.shutdown();
+    const double seconds = (pen::nowNs() - started) / 1e9;
+
+    const int64_t laggingNs = int64_t(settings.options.frameMs) * 1000000 * int64_t(settings.options.ringFrames) / 2;
+    int keepingUp = 0;
+    std::vector<double> firstWordsMs;
+    std::fprintf(stderr, "stream  frames  overruns  max delay ms     RTF  gated  ready ms  1st ms  real time\n");
+    for (int i = 0; i < settings.streams; ++i) {
+        const pen::ReceiverStats &stats = hub.receiver(i).stats();
+        const SpeechSink &sink = *sinks[size_t(i)];
+        const bool live = transports[size_t(i)]->live();
+        const bool realTime = stats.overruns.load() == 0 && sink.maxDelayNs.load() < laggingNs;
+        keepingUp += realTime ? 1 : 0;
+        const char *verdict = !live ? "-" : realTime ? "yes" : "no";
+        const double gated = sink.voiceGate() ? sink.voiceGate()->gatedFraction() * 100 : 0;
+        const double firstWords = live ? sink.firstWordsLatencyMs() : -1;
+        if (firstWords >= 0) {
+            firstWordsMs.push_back(firstWords);
+        }
+        char first[16] = "-";
+        if (firstWords >= 0) {
+            std::snprintf(first, sizeof(first), "%.0f", firstWords);
+        }
+        std::fprintf(stderr, "%6d  %6llu  %8llu  %12.2f  %6.3f  %4.0f%%  %8.1f  %6s  %s\n", i,
+                     (unsigned long long)stats.framesDecoded.load(), (unsigned long long)stats.overruns.load(),
+                     sink.maxDelayNs.load() / 1e6, sink.realTimeFactor(), gated,
+                     sink.recognizing() ? sink.startupMs() : 0.0, first, verdict);
+    }
+    std::fprintf(stderr, "worker   turns  steals  busy\n");
+    for (int i = 0; i < hub.workerCount(); ++i) {
+        const pen::Hub::WorkerStats &stats = hub.workerStats(i);
+        std::fprintf(stderr, "%6d  %6llu  %6llu  %3.0f%%\n", i, (unsigned long long)stats.turns.load(),
+                     (unsigned long long)stats.steals.load(), seconds > 0 ? stats.busyNs.load() / 1e7 / seconds : 0);
+    }
+    if (transports.front()->live()) {
+        std::fprintf(stderr, "%d of %d stream(s) kept up", keepingUp, settings.streams);
+    } else {
+        std::fprintf(stderr, "%d stream(s) decoded", settings.streams);
+    }
+    std::fprintf(stderr, " in %.1fs\n", seconds);
+    if (!firstWordsMs.empty()) {
+        std::sort(firstWordsMs.begin(), firstWordsMs.end());
+        std::fprintf(stderr,
+                     "Connect to first partial, beyond its audio: p50 %.0f, p90 %.0f, p99 %.0f, max %.0f ms "
+                     "(target %.0f ms)\n",
+                     percentile(firstWordsMs, 50), percentile(firstWordsMs, 90), percentile(firstWordsMs, 99),
+                     firstWordsMs.back(), FirstWordsTargetMs);
+    }
+    printPoolStats(pool);
+    printChannelStats(publisher);
+    printTraceStats(writer);
+    return failed.load() > 0 && !interrupted.load() ? 1 : 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    Settings settings;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--unix" && hasValue) {
+            settings.unixPath = argv[++i];
+        } else if (arg == "--replay" && hasValue) {
+            settings.replayPath = argv[++i];
+        } else if (arg == "--stdin") {
+            settings.useStdin = true;
+        } else if (arg == "--rate" && hasValue) {
+            settings.format.sampleRate = uint32_t(std::atoi(argv[++i]));
+        } else if (arg == "--channels" && hasValue) {
+            settings.format.channels = uint16_t(std::atoi(argv[++i]));
+        } else if (arg == "--frame-ms" && hasValue) {
+            settings.options.frameMs = std::atoi(argv[++i]);
+        } else if (arg == "--ring" && hasValue) {
+            settings.options.ringFrames = size_t(std::atoi(argv[++i]));
+        } else if (arg == "--realtime") {
+            settings.realTime = true;
+        } else if (arg == "--engine" && hasValue) {
+            settings.engine = argv[++i];
+        } else if (arg == "--partials") {
+            settings.printPartials = true;
+        } else if (arg == "--stats" && hasValue) {
+            settings.statsInterval = std::atof(argv[++i]);
+        } else if (arg == "--model-rate" && hasValue) {
+            settings.modelRate = std::atoi(argv[++i]);
+        } else if (arg == "--vad") {
+            settings.gateKeepOneIn = std::max(settings.gateKeepOneIn, 0);
+        } else if (arg == "--vad-keep" && hasValue) {
+            settings.gateKeepOneIn = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--warm" && hasValue) {
+            settings.warmSessions = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--publish" && hasValue) {
+            settings.publishPath = argv[++i];
+        } else if (arg == "--record" && hasValue) {
+            settings.recordPath = argv[++i];
+        } else if (arg == "--hub" && hasValue) {
+            settings.hubWorkers = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--streams" && hasValue) {
+            settings.streams = std::atoi(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    const bool hub = settings.hubWorkers >= 0 || settings.streams > 1;
+    if (int(!settings.unixPath.empty()) + int(!settings.replayPath.empty()) + int(settings.useStdin) != 1
+        || settings.format.sampleRate == 0 || settings.format.channels == 0 || settings.options.frameMs <= 0
+        || settings.options.ringFrames == 0 || settings.streams < 1 || settings.modelRate <= 0 || (hub && settings.useStdin)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // Model and warm sessions first, so that no pen waits for them
+    std::unique_ptr<pen::RecognizerPool> pool;
+    if (settings.engine != "none") {
+        const int64_t start = pen::nowNs();
+        std::string error;
+        std::shared_ptr<pen::RecognizerModel> model = pen::loadModel(settings.engine, settings.modelRate, &error);
+        if (!model) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        const int64_t loaded = pen::nowNs();
+        pen::RecognizerPool::Options poolOptions;
+        poolOptions.warm = settings.warmSessions;
+        pool.reset(new pen::RecognizerPool(model, poolOptions));
+        pool->waitUntilWarm();
+        std::fprintf(stderr, "Model %s loaded in %.0f ms, %zu session(s) warmed in %.0f ms\n", model->name().c_str(),
+                     (loaded - start) / 1e6, pool->ready(), (pen::nowNs() - loaded) / 1e6);
+    }
+
+    std::unique_ptr<pen::TranscriptPublisher> publisher;
+    if (!settings.publishPath.empty()) {
+        publisher.reset(new pen::TranscriptPublisher(settings.publishPath));
+        std::string error;
+        if (!publisher->listen(&error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        std::fprintf(stderr, "Publishing the transcript on %s\n", settings.publishPath.c_str());
+    }
+
+    std::unique_ptr<pen::TraceWriter> writer;
+    if (!settings.recordPath.empty()) {
+        writer.reset(new pen::TraceWriter(settings.recordPath, settings.options.frameMs));
+        std::string error;
+        if (!writer->open(&error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        std::fprintf(stderr, "Recording to %s\n", settings.recordPath.c_str());
+    }
+
+    int status = hub ? runHub(settings, pool.get(), publisher.get(), writer.get())
+                     : runSingle(settings, pool.get(), publisher.get(), writer.get());
+    std::string error;
+    if (writer && !writer->close(&error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        status = 1;
+    }
+    return status;
+}
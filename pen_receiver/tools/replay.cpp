@@ -0,0 +1,686 @@
+// pen-replay: puts a trace recorded with pen-receiverd --record through the
+// whole pipeline again (receiver, resampler, VAD, recognizer, and the
+// transcript channel to an editor-side reader that takes records the way
+// Notes does) and reports how long words took to reach the editor and how
+// fast each stage went.
+//
+//   pen-receiverd --hub 0 --streams 30 --unix /run/pen.sock --record class.trace
+//   pen-replay class.trace --realtime --engine vosk:/opt/vosk-model-small-en-us
+//   pen-replay class.trace --engine fake:cost=0.1 --vad --hub 4
+//   pen-replay class.trace --events
+//
+// The receiver gets the trace's frames one for one, so the transcript is
+// the same on every run; with --realtime the pens also connect, send,
+// stall and hang up on the recorded schedule.
+
+#include "pen/clock.h"
+#include "pen/hub.h"
+#include "pen/receiver.h"
+#include "pen/recognizer.h"
+#include "pen/recognizerpool.h"
+#include "pen/resampler.h"
+#include "pen/trace.h"
+#include "pen/transcriptpublisher.h"
+#include "pen/transcriptring.h"
+#include "pen/vad.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <poll.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+std::atomic<bool> interrupted{false};
+
+void onSignal(int) {
+    interrupted.store(true);
+}
+
+// The editor takes records once per display frame, as Notes does
+const auto FrameInterval = std::chrono::milliseconds(16);
+
+struct Settings {
+    std::string tracePath;
+    bool realTime = false;
+    bool printEvents = false;
+    bool printTranscript = false;
+    std::string engine = "fake";
+    int modelRate = 16000;
+    int warmSessions = 2;
+    int gateKeepOneIn = -1; // -1: no VAD
+    int hubWorkers = -1; // -1: one stream on its own decode thread
+    pen::Receiver::Options options;
+};
+
+// Times the recognizer on its own, inside the VAD gate
+class TimedRecognizer : public pen::Recognizer {
+public:
+    TimedRecognizer(std::unique_ptr<pen::Recognizer> recognizer, int64_t &ns) : inner(std::move(recognizer)), ns(ns) {}
+
+    int sampleRate() const override { return inner->sampleRate(); }
+    bool acceptPcm(const int16_t *samples, size_t count) override {
+        const int64_t start = pen::nowNs();
+        const bool completed = inner->acceptPcm(samples, count);
+        ns += pen::nowNs() - start;
+        return completed;
+    }
+    std::string partial() override {
+        const int64_t start = pen::nowNs();
+        std::string text = inner->partial();
+        ns += pen::nowNs() - start;
+        return text;
+    }
+    bool takeFinal(pen::RecognitionResult *result) override {
+        const int64_t start = pen::nowNs();
+        const bool taken = inner->takeFinal(result);
+        ns += pen::nowNs() - start;
+        return taken;
+    }
+    bool finish() override {
+        const int64_t start = pen::nowNs();
+        const bool completed = inner->finish();
+        ns += pen::nowNs() - start;
+        return completed;
+    }
+    void reset() override { inner->reset(); }
+    std::string name() const override { return inner->name(); }
+
+    // Hands back the session for the pool
+    std::unique_ptr<pen::Recognizer> release() { return std::move(inner); }
+
+private:
+    std::unique_ptr<pen::Recognizer> inner;
+    int64_t &ns;
+};
+
+// Time spent in each stage of one stream. Written by whichever worker runs
+// the stream, read once it has ended.
+struct StageTimes {
+    int64_t vadNs = 0;
+    int64_t resampleNs = 0;
+    int64_t recognizeNs = 0;
+    int64_t publishNs = 0;
+    int64_t audioNs = 0;
+};
+
+// The daemon's speech path for one replayed stream, with every stage timed
+// and the arrival time of every frame kept, so that the editor side can
+// tell how old the audio behind a word is when the word gets there.
+class ReplaySink : public pen::FrameSink {
+public:
+    ReplaySink(const Settings &settings, pen::RecognizerPool &pool, pen::TranscriptPublisher &publisher,
+               uint16_t stream, uint64_t frames)
+        : pool(pool),
+          publisher(publisher),
+          gateKeepOneIn(settings.gateKeepOneIn),
+          modelRate(settings.modelRate),
+          stream(stream),
+          arrivals(frames, 0) {
+        ringWaitNs.reserve(frames);
+    }
+
+    bool streamStarted(pen::StreamFormat format, std::string *error) override {
+        sampleRate = format.sampleRate;
+        std::unique_ptr<pen::Recognizer> session = pool.acquire(error);
+        if (!session) {
+            return false;
+        }
+        const size_t maxFrames = pen::PcmFrame::MaxSamples / format.channels;
+        resampler.reset(new pen::Resampler(int(format.sampleRate), modelRate, format.channels, maxFrames));
+        mono.resize(resampler->outputCapacity(maxFrames));
+        timed = new TimedRecognizer(std::move(session), times.recognizeNs);
+        recognizer.reset(timed);
+        if (gateKeepOneIn >= 0) {
+            pen::GatedRecognizer::Options gateOptions;
+            gateOptions.keepOneIn = gateKeepOneIn;
+            gate = new pen::GatedRecognizer(std::move(recognizer), gateOptions);
+            recognizer.reset(gate);
+        }
+        result.words.reserve(64);
+        return true;
+    }
+
+    void consume(const pen::PcmFrame &frame) override {
+        const int64_t start = pen::nowNs();
+        ringWaitNs.push_back(start - frame.arrivalNs);
+        if (consumed == 0) {
+            framePeriod = frame.frames;
+        }
+        if (consumed < arrivals.size()) {
+            arrivals[consumed] = frame.arrivalNs;
+        }
+        ++consumed;
+        times.audioNs += int64_t(frame.frames) * 1000000000 / sampleRate;
+
+        const size_t converted = resampler->process(frame.samples, frame.frames, mono.data());
+        const int64_t resampled = pen::nowNs();
+        times.resampleNs += resampled - start;
+        // The gate's share is what the recognizer inside it did not spend
+        const int64_t recognizing = times.recognizeNs;
+        const bool completed = recognizer->acceptPcm(mono.data(), converted);
+        times.vadNs += pen::nowNs() - resampled - (times.recognizeNs - recognizing);
+        if (completed) {
+            deliverFinal();
+        } else {
+            const std::string text = recognizer->partial();
+            if (text != lastPartial) {
+                lastPartial = text;
+                const int64_t publishing = pen::nowNs();
+                publisher.publishPartial(stream, text, times.audioNs / 1000000);
+                times.publishNs += pen::nowNs() - publishing;
+            }
+        }
+    }
+
+    void endOfStream() override {
+        if (recognizer && recognizer->finish()) {
+            deliverFinal();
+        }
+        if (timed) {
+            // Unwrapped from the gate and the timer; the gate stays, for
+            // its counters
+            std::unique_ptr<pen::Recognizer> wrapper = gate ? gate->releaseInner() : std::move(recognizer);
+            pool.release(timed->release());
+            timed = nullptr;
+        }
+    }
+
+    // When the frame holding the stream's audio at streamMs arrived, or 0 if
+    // it has not. Called from the editor side for records this stream
+    // published, so the frame was written before the record.
+    int64_t arrivalAt(int64_t streamMs) const {
+        if (framePeriod == 0 || arrivals.empty() || streamMs <= 0) {
+            return 0;
+        }
+        const uint64_t sample = uint64_t(streamMs) * sampleRate / 1000;
+        const size_t index = size_t((sample - 1) / framePeriod);
+        return arrivals[std::min(index, arrivals.size() - 1)];
+    }
+
+    const StageTimes &stageTimes() const { return times; }
+    const std::vector<int64_t> &ringWaits() const { return ringWaitNs; }
+
+private:
+    void deliverFinal() {
+        if (!recognizer->takeFinal(&result)) {
+            return;
+        }
+        const int64_t publishing = pen::nowNs();
+        publisher.publishFinal(stream, result);
+        times.publishNs += pen::nowNs() - publishing;
+        lastPartial.clear();
+    }
+
+    pen::RecognizerPool &pool;
+    pen::TranscriptPublisher &publisher;
+    int gateKeepOneIn;
+    int modelRate;
+    uint16_t stream;
+    uint32_t sampleRate = 0;
+    std::unique_ptr<pen::Resampler> resampler;
+    std::unique_ptr<pen::Recognizer> recognizer;
+    TimedRecognizer *timed = nullptr; // Owned through recognizer, or the gate
+    pen::GatedRecognizer *gate = nullptr; // Owned through recognizer
+    pen::RecognitionResult result;
+    std::string lastPartial;
+    std::vector<int16_t> mono;
+
+    StageTimes times;
+    std::vector<int64_t> arrivals; // Per frame consumed, sized from the trace
+    std::vector<int64_t> ringWaitNs; // Arrival to consume(), per frame
+    uint32_t framePeriod = 0; // Samples per channel in a frame
+    size_t consumed = 0;
+};
+
+// The editor's end of the transcript channel, read the way Notes'
+// TranscriptChannel does: asleep on the eventfd, then a drain per display
+// frame until the ring stays empty. A final word is timed from the arrival
+// of the audio it ends in, a partial from the audio it reaches to; of the
+// partials that come in during one frame, only the newest is shown, so
+// only that one is timed.
+class EditorSide {
+public:
+    EditorSide(const std::map<uint16_t, ReplaySink *> &sinks, bool printTranscript)
+        : sinks(sinks), printTranscript(printTranscript) {}
+
+    ~EditorSide() { stop(); }
+
+    bool connect(const std::string &path, std::string *error) { return reader.connect(path, error); }
+
+    void start() { thread = std::thread(&EditorSide::run, this); }
+
+    // Takes what is left in the ring and returns
+    void stop() {
+        stopping.store(true);
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    std::vector<double> finalWordMs;
+    std::vector<double> partialMs;
+    int64_t busyNs = 0;
+    uint64_t records = 0;
+    uint64_t wakeups = 0;
+    uint64_t dropped() const { return reader.dropped(); }
+
+private:
+    void run() {
+        while (!stopping.load()) {
+            if (reader.arm()) {
+                pollfd fds = {reader.wakeFd(), POLLIN, 0};
+                if (::poll(&fds, 1, 50) <= 0) {
+                    continue;
+                }
+                reader.acknowledge();
+                ++wakeups;
+            }
+            while (drain() > 0) {
+                std::this_thread::sleep_for(FrameInterval);
+            }
+        }
+        drain();
+    }
+
+    size_t drain() {
+        const int64_t now = pen::nowNs();
+        newestPartial.clear();
+        const size_t count = reader.drain([&](const pen::TranscriptRecord &record) { take(record, now); });
+        for (const auto &partial : newestPartial) {
+            note(partial.first, partial.second, now, partialMs);
+        }
+        records += count;
+        busyNs += pen::nowNs() - now;
+        return count;
+    }
+
+    void take(const pen::TranscriptRecord &record, int64_t now) {
+        if (record.kind == pen::TranscriptRecord::Final) {
+            if (record.length > 0) {
+                note(record.stream, record.endMs, now, finalWordMs);
+            }
+            newestPartial.erase(record.stream);
+            if (printTranscript) {
+                std::string &line = lines[record.stream];
+                if (record.flags & pen::TranscriptRecord::First) {
+                    line.clear();
+                }
+                line += (line.empty() ? "" : " ") + record.word();
+                if (record.flags & pen::TranscriptRecord::Last) {
+                    std::printf("%u: %s\n", record.stream, line.c_str());
+                }
+            }
+        } else if (record.kind == pen::TranscriptRecord::Partial && (record.flags & pen::TranscriptRecord::First)) {
+            if (record.length > 0) {
+                newestPartial[record.stream] = record.endMs;
+            } else {
+                newestPartial.erase(record.stream); // Cleared, nothing shown
+            }
+        }
+    }
+
+    void note(uint32_t stream, int64_t streamMs, int64_t now, std::vector<double> &into) {
+        const auto sink = sinks.find(uint16_t(stream));
+        if (sink == sinks.end()) {
+            return;
+        }
+        const int64_t arrival = sink->second->arrivalAt(streamMs);
+        if (arrival > 0) {
+            into.push_back((now - arrival) / 1e6);
+        }
+    }
+
+    const std::map<uint16_t, ReplaySink *> &sinks;
+    bool printTranscript;
+    pen::TranscriptRingReader reader;
+    std::map<uint32_t, int64_t> newestPartial; // Stream to endMs, within one drain
+    std::map<uint32_t, std::string> lines;
+    std::atomic<bool> stopping{false};
+    std::thread thread;
+};
+
+// Nearest rank; values is sorted
+double percentile(const std::vector<double> &values, double p) {
+    const size_t rank = size_t(std::ceil(p / 100 * double(values.size())));
+    return values[std::min(values.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+void printLatency(const char *what, std::vector<double> values) {
+    if (values.empty()) {
+        std::fprintf(stderr, "  %-12s      -\n", what);
+        return;
+    }
+    std::sort(values.begin(), values.end());
+    std::fprintf(stderr, "  %-12s %6zu  %7.1f  %7.1f  %7.1f  %7.1f\n", what, values.size(), percentile(values, 50),
+                 percentile(values, 90), percentile(values, 99), values.back());
+}
+
+void printStage(const char *what, int64_t busyNs, double audioSeconds, const char *note = "") {
+    const double busy = busyNs / 1e9;
+    char speed[32] = "-";
+    if (busy > 0) {
+        std::snprintf(speed, sizeof(speed), "%.0fx", audioSeconds / busy);
+    }
+    std::fprintf(stderr, "  %-10s %9.3f  %11s  %s\n", what, busy, speed, note);
+}
+
+const char *eventName(uint32_t code) {
+    switch (code) {
+    case pen::TraceEvent::Connected:
+        return "connected";
+    case pen::TraceEvent::Disconnected:
+        return "disconnected";
+    case pen::TraceEvent::Dropped:
+        return "dropped";
+    default:
+        return "unknown";
+    }
+}
+
+// Lists the trace's events, with a line per run of frames in between
+int printEvents(const pen::TraceReader &trace) {
+    std::map<uint16_t, uint64_t> frames; // Since the stream's last event
+    const auto flush = [&](uint16_t stream) {
+        uint64_t &count = frames[stream];
+        if (count > 0) {
+            std::printf("%12s  %5u  %llu frame(s)\n", "", unsigned(stream), (unsigned long long)count);
+            count = 0;
+        }
+    };
+    for (const pen::TraceRecord *record : trace.all()) {
+        if (record->type == pen::TraceRecord::Frame) {
+            ++frames[record->stream];
+            continue;
+        }
+        flush(record->stream);
+        const pen::TraceEvent event = record->event();
+        std::printf("%12.3f  %5u  %s", record->timeUs / 1e6, unsigned(record->stream), eventName(event.code));
+        if (event.code == pen::TraceEvent::Connected) {
+            std::printf(" %u Hz, %u channel(s)", event.a, event.b);
+        } else if (event.code == pen::TraceEvent::Dropped) {
+            std::printf(" %u frame(s)", event.a);
+        }
+        std::printf("\n");
+    }
+    for (auto &entry : frames) {
+        flush(entry.first);
+    }
+    return 0;
+}
+
+void usage(const char *program) {
+    std::fprintf(stderr,
+                 "Usage: %s TRACE [options]\n"
+                 "  --realtime        replay on the recorded schedule (default: as fast as possible)\n"
+                 "  --engine SPEC     recognizer, as for pen-receiverd (default fake)\n"
+                 "  --model-rate HZ   recognizer input rate (default 16000)\n"
+                 "  --warm N          recognizer sessions kept ready (default 2)\n"
+                 "  --vad             drop non-speech ahead of the recognizer\n"
+                 "  --vad-keep N      with --vad, still pass one in N non-speech frames\n"
+                 "  --hub WORKERS     decode on a pool of WORKERS threads (0: one per core);\n"
+                 "                    the default for traces of more than one pen\n"
+                 "  --ring FRAMES     receiver ring capacity (default 64)\n"
+                 "  --frame-ms MS     frame length (default: as recorded)\n"
+                 "  --transcript      print final results as the editor gets them\n"
+                 "  --events          list the trace's events and exit\n",
+                 program);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    Settings settings;
+    settings.options.frameMs = 0;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--realtime") {
+            settings.realTime = true;
+        } else if (arg == "--engine" && hasValue) {
+            settings.engine = argv[++i];
+        } else if (arg == "--model-rate" && hasValue) {
+            settings.modelRate = std::atoi(argv[++i]);
+        } else if (arg == "--warm" && hasValue) {
+            settings.warmSessions = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--vad") {
+            settings.gateKeepOneIn = std::max(settings.gateKeepOneIn, 0);
+        } else if (arg == "--vad-keep" && hasValue) {
+            settings.gateKeepOneIn = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--hub" && hasValue) {
+            settings.hubWorkers = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--ring" && hasValue) {
+            settings.options.ringFrames = size_t(std::atoi(argv[++i]));
+        } else if (arg == "--frame-ms" && hasValue) {
+            settings.options.frameMs = std::atoi(argv[++i]);
+        } else if (arg == "--transcript") {
+            settings.printTranscript = true;
+        } else if (arg == "--events") {
+            settings.printEvents = true;
+        } else if (settings.tracePath.empty() && arg[0] != '-') {
+            settings.tracePath = arg;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (settings.tracePath.empty() || settings.modelRate <= 0 || settings.options.ringFrames == 0
+        || settings.options.frameMs < 0 || settings.engine == "none") {
+        usage(argv[0]);
+        return 2;
+    }
+
+    pen::TraceReader trace;
+    std::string error;
+    if (!trace.open(settings.tracePath, &error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    if (settings.printEvents) {
+        return printEvents(trace);
+    }
+    if (settings.options.frameMs == 0) {
+        settings.options.frameMs = int(trace.header().frameMs);
+    }
+
+    const std::vector<uint16_t> streams = trace.streams();
+    double audioSeconds = 0;
+    uint64_t frames = 0;
+    for (const uint16_t stream : streams) {
+        audioSeconds += trace.audioSeconds(stream);
+        frames += trace.frameCount(stream);
+    }
+    const std::time_t started = std::time_t(trace.header().startedUnixMs / 1000);
+    char when[32];
+    std::strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", std::localtime(&started));
+    std::fprintf(stderr, "Trace %s, recorded %s: %zu pen(s), %.1f s of audio in %llu frames of %d ms%s\n",
+                 settings.tracePath.c_str(), when, streams.size(), audioSeconds, (unsigned long long)frames,
+                 settings.options.frameMs, trace.truncated() ? " (cut short)" : "");
+    if (streams.empty()) {
+        return 0;
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::shared_ptr<pen::RecognizerModel> model = pen::loadModel(settings.engine, settings.modelRate, &error);
+    if (!model) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    pen::RecognizerPool::Options poolOptions;
+    poolOptions.warm = settings.warmSessions;
+    pen::RecognizerPool pool(model, poolOptions);
+    pool.waitUntilWarm();
+
+    // The channel to the editor side, on a socket of our own
+    const char *runtime = std::getenv("XDG_RUNTIME_DIR");
+    const std::string socketPath = std::string(runtime && *runtime ? runtime : "/tmp") + "/pen-replay."
+                                   + std::to_string(::getpid()) + ".sock";
+    pen::TranscriptPublisher publisher(socketPath);
+    if (!publisher.listen(&error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    // Declared before the receivers, which use them until they are gone
+    std::vector<std::unique_ptr<pen::TraceReplayTransport>> transports;
+    std::vector<std::unique_ptr<ReplaySink>> sinks;
+    std::map<uint16_t, ReplaySink *> sinkOf;
+    for (const uint16_t stream : streams) {
+        // Frames may be cut shorter than recorded
+        const uint64_t cut = uint64_t(trace.audioSeconds(stream) * 1000 / settings.options.frameMs) + 1;
+        sinks.emplace_back(new ReplaySink(settings, pool, publisher, stream, std::max(cut, trace.frameCount(stream))));
+        sinkOf[stream] = sinks.back().get();
+    }
+    EditorSide editor(sinkOf, settings.printTranscript);
+    if (!editor.connect(socketPath, &error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    while (!publisher.hasViewer()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    editor.start();
+
+    const bool useHub = settings.hubWorkers >= 0 || streams.size() > 1;
+    pen::Hub::Options hubOptions;
+    if (settings.hubWorkers > 0) {
+        hubOptions.workers = settings.hubWorkers;
+    }
+    std::unique_ptr<pen::Hub> hub;
+    std::unique_ptr<pen::Receiver> single;
+    std::vector<pen::Receiver *> receivers;
+    const int64_t originNs = pen::nowNs();
+    if (useHub) {
+        hub.reset(new pen::Hub(hubOptions));
+    }
+    for (size_t i = 0; i < streams.size(); ++i) {
+        transports.emplace_back(new pen::TraceReplayTransport(trace, streams[i], settings.realTime, originNs));
+        if (hub) {
+            receivers.push_back(&hub->addStream(*transports.back(), *sinks[i], settings.options));
+        } else {
+            single.reset(new pen::Receiver(*transports.back(), *sinks[i], settings.options));
+            receivers.push_back(single.get());
+        }
+    }
+    std::fprintf(stderr, "Replaying %s through %s", settings.realTime ? "in real time" : "as fast as possible",
+                 model->name().c_str());
+    if (settings.gateKeepOneIn >= 0) {
+        std::fprintf(stderr, " behind the VAD");
+    }
+    if (hub) {
+        std::fprintf(stderr, " on %d worker(s)", hub->workerCount());
+    }
+    std::fprintf(stderr, "\n");
+
+    // With --realtime, start() waits for the pen to connect
+    std::atomic<int> failed{0};
+    std::atomic<int> settled{0};
+    std::vector<std::thread> starters;
+    for (size_t i = 0; i < receivers.size(); ++i) {
+        starters.emplace_back([&, i] {
+            std::string message;
+            if (!receivers[i]->start(&message)) {
+                if (!interrupted.load()) {
+                    std::fprintf(stderr, "%s: %s\n", transports[i]->describe().c_str(), message.c_str());
+                }
+                failed.fetch_add(1);
+            }
+            settled.fetch_add(1);
+        });
+    }
+    const auto allEnded = [&] {
+        for (pen::Receiver *receiver : receivers) {
+            if (receiver->running()) {
+                return false;
+            }
+        }
+        return true;
+    };
+    bool stopped = false;
+    while (settled.load() < int(receivers.size()) || !allEnded()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        if (interrupted.load() && !stopped) {
+            for (pen::Receiver *receiver : receivers) {
+                receiver->stop();
+            }
+            stopped = true;
+        }
+    }
+    for (std::thread &starter : starters) {
+        starter.join();
+    }
+    for (pen::Receiver *receiver : receivers) {
+        receiver->wait();
+    }
+    if (hub) {
+        hub->shutdown();
+    }
+    const double seconds = (pen::nowNs() - originNs) / 1e9;
+    editor.stop();
+
+    StageTimes total;
+    int64_t receiveNs = 0;
+    uint64_t droppedWhenRecorded = 0;
+    uint64_t overruns = 0;
+    uint64_t underruns = 0;
+    std::vector<double> ringWaitMs;
+    ringWaitMs.reserve(size_t(frames));
+    for (size_t i = 0; i < sinks.size(); ++i) {
+        const StageTimes &times = sinks[i]->stageTimes();
+        total.vadNs += times.vadNs;
+        total.resampleNs += times.resampleNs;
+        total.recognizeNs += times.recognizeNs;
+        total.publishNs += times.publishNs;
+        total.audioNs += times.audioNs;
+        for (const int64_t wait : sinks[i]->ringWaits()) {
+            ringWaitMs.push_back(wait / 1e6);
+        }
+        receiveNs += transports[i]->busyNs();
+        droppedWhenRecorded += transports[i]->droppedWhenRecorded();
+        overruns += receivers[i]->stats().overruns.load();
+        underruns += receivers[i]->stats().underruns.load();
+    }
+    const double replayed = total.audioNs / 1e9;
+
+    if (settings.realTime) {
+        std::fprintf(stderr, "Replayed %.1f s of audio from %zu pen(s) in %.1f s\n", replayed, streams.size(), seconds);
+    } else {
+        // Frames queue up behind the replay, and latency with them
+        std::fprintf(stderr, "Replayed %.1f s of audio in %.1f s (%.1fx real time); latency includes the backlog\n",
+                     replayed, seconds, seconds > 0 ? replayed / seconds : 0.0);
+    }
+    std::fprintf(stderr, "Latency, ms:           count      p50      p90      p99      max\n");
+    printLatency("final words", editor.finalWordMs);
+    printLatency("partials", editor.partialMs);
+    printLatency("ring wait", ringWaitMs);
+    std::fprintf(stderr, "Stage          busy s  x real time\n");
+    printStage("receive", receiveNs, replayed);
+    if (settings.gateKeepOneIn >= 0) {
+        printStage("vad", total.vadNs, replayed);
+    }
+    printStage("resample", total.resampleNs, replayed);
+    printStage("recognize", total.recognizeNs, replayed);
+    printStage("publish", total.publishNs, replayed);
+    char ingest[64];
+    std::snprintf(ingest, sizeof(ingest), "%llu records, %llu wakeups", (unsigned long long)editor.records,
+                  (unsigned long long)editor.wakeups);
+    printStage("ingest", editor.busyNs, replayed, ingest);
+    std::fprintf(stderr, "Frames dropped: %llu when recorded, %llu now; %llu underruns; %llu records lost on the channel\n",
+                 (unsigned long long)droppedWhenRecorded, (unsigned long long)overruns, (unsigned long long)underruns,
+                 (unsigned long long)editor.dropped());
+    return failed.load() > 0 && !interrupted.load() ? 1 : 0;
+}
@@ -0,0 +1,91 @@
+// pen-resample-bench: throughput and quality of the downmix + resampling
+// stage for the A2DP rates, on one core.
+//
+//   pen-resample-bench [--minutes N]
+//   PEN_SIMD=scalar pen-resample-bench   # compare kernels
+
+#include "pen/clock.h"
+#include "pen/resampler.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Interleaved stereo sine at the given level in dBFS
+std::vector<int16_t> tone(int rate, double hz, double seconds, double db) {
+    const double amplitude = 32767 * std::pow(10, db / 20);
+    std::vector<int16_t> samples(size_t(rate * seconds) * 2);
+    for (size_t i = 0; i < samples.size() / 2; ++i) {
+        const int16_t value = int16_t(std::lrint(amplitude * std::sin(2 * M_PI * hz * double(i) / rate)));
+        samples[2 * i] = value;
+        samples[2 * i + 1] = value;
+    }
+    return samples;
+}
+
+// Output level in dBFS of a tone after resampling, skipping the filter's
+// settling time
+double levelAfter(int inputRate, int outputRate, double hz) {
+    const std::vector<int16_t> input = tone(inputRate, hz, 1.0, -6);
+    pen::Resampler resampler(inputRate, outputRate, 2, size_t(inputRate) / 100);
+    std::vector<int16_t> output(resampler.outputCapacity(input.size() / 2));
+    output.resize(resampler.process(input.data(), input.size() / 2, output.data()));
+    double sum = 0;
+    size_t count = 0;
+    for (size_t i = output.size() / 10; i < output.size(); ++i, ++count) {
+        sum += double(output[i]) * output[i];
+    }
+    return 10 * std::log10(std::max(1e-12, sum / double(count)) / (32768.0 * 32768.0)) + 3.01; // RMS to peak
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    double minutes = 60;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--minutes") == 0 && i + 1 < argc) {
+            minutes = std::atof(argv[++i]);
+        } else {
+            std::fprintf(stderr, "Usage: %s [--minutes N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::printf("kernels: %s\n", pen::Resampler::kernelName());
+    const int rates[] = {44100, 48000};
+    for (const int rate : rates) {
+        const int outputRate = 16000;
+        pen::Resampler resampler(rate, outputRate, 2, size_t(rate) / 100);
+
+        // Ten seconds of programme, fed in 10 ms frames as the receiver does
+        const std::vector<int16_t> input = tone(rate, 440, 10.0, -12);
+        const size_t frame = size_t(rate) / 100;
+        std::vector<int16_t> output(resampler.outputCapacity(frame));
+        const int passes = std::max(1, int(std::lrint(minutes * 6)));
+        uint64_t produced = 0;
+        const int64_t start = pen::nowNs();
+        for (int pass = 0; pass < passes; ++pass) {
+            for (size_t at = 0; at + frame <= input.size() / 2; at += frame) {
+                produced += resampler.process(input.data() + 2 * at, frame, output.data());
+            }
+        }
+        const double seconds = (pen::nowNs() - start) / 1e9;
+        const double audioSeconds = passes * 10.0;
+
+        std::printf("%d Hz stereo -> %d Hz mono: %d taps/phase x %d phases\n", rate, outputRate,
+                    resampler.tapsPerPhase(), outputRate / std::gcd(rate, outputRate));
+        std::printf("  %.0f s of audio in %.3f s: %.0fx real time, %.3f s per hour, %llu samples out\n",
+                    audioSeconds, seconds, audioSeconds / seconds, seconds / audioSeconds * 3600,
+                    (unsigned long long)produced);
+        std::printf("  1 kHz %+.2f dB, 6.5 kHz %+.2f dB, alias of 12 kHz %+.1f dB, of 20 kHz %+.1f dB\n",
+                    levelAfter(rate, outputRate, 1000) + 6, levelAfter(rate, outputRate, 6500) + 6,
+                    levelAfter(rate, outputRate, 12000) + 6, levelAfter(rate, outputRate, 20000) + 6);
+    }
+    return 0;
+}
@@ -0,0 +1,118 @@
+// pen-transcript-tail: follows a pen-receiverd transcript channel the way
+// the Notes app does (woken by the eventfd at most once per frame, reading
+// records in place) and prints it.
+//
+//   pen-transcript-tail $XDG_RUNTIME_DIR/pen-transcript.sock [--partials]
+
+#include "pen/clock.h"
+#include "pen/transcriptring.h"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <poll.h>
+#include <string>
+#include <thread>
+
+namespace {
+
+std::atomic<bool> interrupted{false};
+
+void onSignal(int) {
+    interrupted.store(true);
+}
+
+const auto FrameInterval = std::chrono::milliseconds(16);
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    std::string path;
+    bool printPartials = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--partials") == 0) {
+            printPartials = true;
+        } else if (path.empty() && argv[i][0] != '-') {
+            path = argv[i];
+        } else {
+            path.clear();
+            break;
+        }
+    }
+    if (path.empty()) {
+        std::fprintf(stderr, "Usage: %s SOCKET [--partials]\n", argv[0]);
+        return 2;
+    }
+
+    pen::TranscriptRingReader reader;
+    std::string error;
+    if (!reader.connect(path, &error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    std::map<uint32_t, std::string> lines; // Final run in progress, per stream
+    std::map<uint32_t, std::string> partials;
+    uint64_t records = 0;
+    uint64_t wakeups = 0;
+    uint64_t words = 0;
+    const auto print = [&](const pen::TranscriptRecord &record) {
+        std::string &text = record.kind == pen::TranscriptRecord::Final ? lines[record.stream] : partials[record.stream];
+        if (record.flags & pen::TranscriptRecord::First) {
+            text.clear();
+        }
+        if (record.length > 0) {
+            text += (text.empty() ? "" : " ") + record.word();
+        }
+        if (!(record.flags & pen::TranscriptRecord::Last)) {
+            return;
+        }
+        if (record.kind == pen::TranscriptRecord::Final) {
+            std::printf("%u: %s\n", record.stream, text.c_str());
+            partials[record.stream].clear();
+        } else if (printPartials) {
+            std::printf("%u~ %s\n", record.stream, text.c_str());
+        }
+    };
+    const auto count = [&](const pen::TranscriptRecord &record) {
+        words += record.kind == pen::TranscriptRecord::Final ? 1 : 0;
+        print(record);
+    };
+
+    bool open = true;
+    while (open && !interrupted.load()) {
+        // Sleep until the next record, then read one frame's worth at a
+        // time until the ring stays empty for a frame
+        if (reader.arm()) {
+            pollfd fds[2] = {{reader.wakeFd(), POLLIN, 0}, {reader.socketFd(), POLLIN, 0}};
+            if (::poll(fds, 2, 200) <= 0) {
+                continue;
+            }
+            if (fds[0].revents & POLLIN) {
+                reader.acknowledge();
+                ++wakeups;
+            }
+            open = !(fds[1].revents & (POLLIN | POLLHUP));
+        }
+        size_t read;
+        do {
+            read = reader.drain(count);
+            records += read;
+            std::fflush(stdout);
+            if (read > 0) {
+                std::this_thread::sleep_for(FrameInterval);
+            }
+        } while (read > 0 && !interrupted.load());
+    }
+    records += reader.drain(count);
+
+    std::fprintf(stderr, "%llu records, %llu final words, %llu wakeups (%.1f records each), %llu dropped\n",
+                 (unsigned long long)records, (unsigned long long)words, (unsigned long long)wakeups,
+                 wakeups ? double(records) / double(wakeups) : 0.0, (unsigned long long)reader.dropped());
+    return 0;
+}